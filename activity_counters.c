@@ -0,0 +1,570 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the persisted activity counters.
+ *
+ *          File layout (all values little-endian 4-byte integers):
+ *            header:  magic[4], version[1], reserved[3]
+ *            levels:  ACTIVITY_LEVEL_COUNT x { base, capacity }
+ *            buckets: for each level in turn, capacity x { admissions,
+ *                     discharges }, the first for bucket number base
+ *
+ *          Only the bucket counts are stored; the Fenwick trees are built
+ *          from them on load in one pass. A level's buckets cover a range of
+ *          bucket numbers whose size is a power of two, doubled towards any
+ *          bucket that falls outside it, so an update rewrites one record
+ *          per level in place and only a doubling forces the whole file to
+ *          be rewritten.
+ */
+
+#include "activity_counters.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "durable_file.h"
+#include "patient_storage.h"
+
+// Private constants
+#define ACTIVITY_FILE_VERSION 2 // Version 1 also held a day level
+#define ACTIVITY_TEMP_FILE "activity_counters.tmp"
+#define MAGIC_LENGTH 4
+#define NOT_FOUND (-1)
+#define INITIAL_CAPACITY 1024
+#define MAX_CAPACITY (1 << 22) // Over 450 years of hours
+#define SECONDS_PER_HOUR 3600
+#define MONTHS_PER_YEAR 12
+#define FIRST_YEAR 1970
+#define TM_BASE_YEAR 1900
+
+#define HEADER_SIZE 8
+#define LEVEL_RECORD_SIZE 8
+#define BUCKET_RECORD_SIZE 8
+#define BUCKETS_OFFSET (HEADER_SIZE + ACTIVITY_LEVEL_COUNT * LEVEL_RECORD_SIZE)
+
+/*
+ * One level of buckets: the counts as stored, and a Fenwick tree over them
+ * in which tree[i] totals buckets i - (i & -i) up to i - 1.
+ */
+typedef struct
+{
+    int            base;     // Bucket number of buckets[0]
+    int            capacity; // 0 until the first count, then a power of two
+    ActivityCount *buckets;
+    ActivityCount *tree; // capacity + 1 entries, tree[0] unused
+} CounterLevel;
+
+static CounterLevel levels[ACTIVITY_LEVEL_COUNT];
+static FILE        *countersFile  = NULL; // NULL while updates are kept in memory
+static int          needsFullSave = 0;
+
+// Updates arrive under the patient store's lock, but the dashboard reads
+// without it, so every public function holds countersLock
+static pthread_mutex_t countersLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Function prototypes for internal helper functions
+static void          recordEvent(time_t timestamp, int admissions, int discharges);
+static int           getBucketIndex(CounterLevel *counter, int bucket);
+static int           growLevel(CounterLevel *counter, int bucket);
+static void          buildTree(CounterLevel *counter);
+static ActivityCount sumPrefix(const CounterLevel *counter, int count);
+static void          writeBucket(int level, int index);
+static void          writeValues(long offset, const int values[], int count);
+static int           putValues(FILE *file, const int values[], int count);
+static int           readValues(FILE *file, int values[], int count);
+static void          finishUpdate(void);
+static int           saveCounters(void);
+static void          clearCounters(void);
+
+/*
+ * Reads the whole counters file, builds the trees and keeps the file open
+ * for in-place updates.
+ */
+int loadActivityCounters(void)
+{
+    unsigned char header[HEADER_SIZE];
+    int           values[2];
+
+    pthread_mutex_lock(&countersLock);
+    clearCounters();
+
+    FILE *file = fopen(ACTIVITY_FILE, "r+b");
+    if(file == NULL)
+    {
+        pthread_mutex_unlock(&countersLock);
+        return ACTIVITY_FAILURE;
+    }
+
+    int ok = fread(header, 1, HEADER_SIZE, file) == HEADER_SIZE &&
+             memcmp(header, ACTIVITY_FILE_MAGIC, MAGIC_LENGTH) == 0 &&
+             header[MAGIC_LENGTH] == ACTIVITY_FILE_VERSION;
+
+    for(int level = 0; ok && level < ACTIVITY_LEVEL_COUNT; level++)
+    {
+        ok = readValues(file, values, 2) && values[1] >= 0 && values[1] <= MAX_CAPACITY &&
+             (values[1] & (values[1] - 1)) == 0 && (long long) values[0] + values[1] <= INT_MAX;
+        levels[level].base     = values[0];
+        levels[level].capacity = ok ? values[1] : 0;
+    }
+
+    for(int level = 0; ok && level < ACTIVITY_LEVEL_COUNT; level++)
+    {
+        CounterLevel *counter = &levels[level];
+        if(counter->capacity == 0)
+        {
+            continue;
+        }
+
+        counter->buckets = malloc(sizeof(ActivityCount) * (size_t) counter->capacity);
+        counter->tree    = malloc(sizeof(ActivityCount) * (size_t) (counter->capacity + 1));
+        ok               = counter->buckets != NULL && counter->tree != NULL;
+
+        for(int i = 0; ok && i < counter->capacity; i++)
+        {
+            ok                             = readValues(file, values, 2);
+            counter->buckets[i].admissions = values[0];
+            counter->buckets[i].discharges = values[1];
+        }
+        if(ok)
+        {
+            buildTree(counter);
+        }
+    }
+
+    if(!ok)
+    {
+        fclose(file);
+        clearCounters();
+        pthread_mutex_unlock(&countersLock);
+        return ACTIVITY_FAILURE;
+    }
+
+    countersFile = file;
+    pthread_mutex_unlock(&countersLock);
+    return ACTIVITY_SUCCESS;
+}
+
+/*
+ * Clears the counters and defers writes until the next save.
+ */
+void resetActivityCounters(void)
+{
+    pthread_mutex_lock(&countersLock);
+    clearCounters();
+    pthread_mutex_unlock(&countersLock);
+}
+
+/*
+ * Rewrites the counters file.
+ */
+int saveActivityCounters(void)
+{
+    pthread_mutex_lock(&countersLock);
+    int saved = saveCounters();
+    pthread_mutex_unlock(&countersLock);
+
+    return saved;
+}
+
+/*
+ * Rewrites the counters file in order through a temporary file and reopens
+ * it for in-place updates. Must be called with countersLock held.
+ */
+static int saveCounters(void)
+{
+    unsigned char header[HEADER_SIZE] = { 0 };
+
+    if(countersFile != NULL)
+    {
+        fclose(countersFile);
+        countersFile = NULL;
+    }
+    needsFullSave = 0;
+
+    FILE *file = fopen(ACTIVITY_TEMP_FILE, "wb");
+    if(file == NULL)
+    {
+        perror("Error creating " ACTIVITY_TEMP_FILE);
+        return ACTIVITY_FAILURE;
+    }
+
+    memcpy(header, ACTIVITY_FILE_MAGIC, MAGIC_LENGTH);
+    header[MAGIC_LENGTH] = ACTIVITY_FILE_VERSION;
+    int written          = fwrite(header, 1, HEADER_SIZE, file) == HEADER_SIZE;
+
+    for(int level = 0; written && level < ACTIVITY_LEVEL_COUNT; level++)
+    {
+        int values[2] = { levels[level].base, levels[level].capacity };
+        written       = putValues(file, values, 2);
+    }
+
+    for(int level = 0; written && level < ACTIVITY_LEVEL_COUNT; level++)
+    {
+        const CounterLevel *counter = &levels[level];
+        for(int i = 0; written && i < counter->capacity; i++)
+        {
+            int values[2] = { counter->buckets[i].admissions, counter->buckets[i].discharges };
+            written       = putValues(file, values, 2);
+        }
+    }
+
+    written = fclose(file) == 0 && written;
+    if(!written)
+    {
+        perror("Error saving " ACTIVITY_FILE);
+        remove(ACTIVITY_TEMP_FILE);
+        return ACTIVITY_FAILURE;
+    }
+    if(!replaceFile(ACTIVITY_TEMP_FILE, ACTIVITY_FILE))
+    {
+        return ACTIVITY_FAILURE;
+    }
+
+    countersFile = fopen(ACTIVITY_FILE, "r+b");
+    return countersFile != NULL ? ACTIVITY_SUCCESS : ACTIVITY_FAILURE;
+}
+
+/*
+ * Counts an admission.
+ */
+void recordAdmissionActivity(const Patient *patient)
+{
+    pthread_mutex_lock(&countersLock);
+    recordEvent(patient->admissionDate, 1, 0);
+    finishUpdate();
+    pthread_mutex_unlock(&countersLock);
+}
+
+/*
+ * Counts a group of discharges, pushing them to the file together.
+ */
+void recordDischargeActivity(const DischargedPatient records[], int count)
+{
+    pthread_mutex_lock(&countersLock);
+    for(int i = 0; i < count; i++)
+    {
+        recordEvent(records[i].dischargeDate, 0, 1);
+    }
+    finishUpdate();
+    pthread_mutex_unlock(&countersLock);
+}
+
+/*
+ * Totals a window of buckets as the difference of two prefix sums, after
+ * clipping it to the buckets the level holds.
+ */
+ActivityCount countActivity(int level, int firstBucket, int lastBucket)
+{
+    ActivityCount total = { 0, 0 };
+
+    if(level < 0 || level >= ACTIVITY_LEVEL_COUNT)
+    {
+        return total;
+    }
+
+    pthread_mutex_lock(&countersLock);
+
+    const CounterLevel *counter = &levels[level];
+    long long           first   = (long long) firstBucket - counter->base;
+    long long           last    = (long long) lastBucket - counter->base;
+
+    first = first < 0 ? 0 : first;
+    last  = last >= counter->capacity ? counter->capacity - 1 : last;
+    if(first <= last)
+    {
+        ActivityCount upTo   = sumPrefix(counter, (int) last + 1);
+        ActivityCount before = sumPrefix(counter, (int) first);
+        total.admissions     = upTo.admissions - before.admissions;
+        total.discharges     = upTo.discharges - before.discharges;
+    }
+
+    pthread_mutex_unlock(&countersLock);
+    return total;
+}
+
+/*
+ * Hours since the epoch, rounded down.
+ */
+int getHourNumber(time_t timestamp)
+{
+    time_t hour = timestamp / SECONDS_PER_HOUR;
+    if(timestamp < 0 && timestamp % SECONDS_PER_HOUR != 0)
+    {
+        hour--;
+    }
+    return (int) hour;
+}
+
+/*
+ * Months since January 1970.
+ */
+int getMonthNumberOfDate(const struct tm *localTime)
+{
+    return (localTime->tm_year + TM_BASE_YEAR - FIRST_YEAR) * MONTHS_PER_YEAR + localTime->tm_mon;
+}
+
+/*
+ * Closes the file and frees the counters.
+ */
+void clearActivityCounters(void)
+{
+    pthread_mutex_lock(&countersLock);
+    clearCounters();
+    pthread_mutex_unlock(&countersLock);
+}
+
+/*
+ * Closes the file and frees the counters. Must be called with countersLock
+ * held.
+ */
+static void clearCounters(void)
+{
+    if(countersFile != NULL)
+    {
+        fclose(countersFile);
+        countersFile = NULL;
+    }
+
+    for(int level = 0; level < ACTIVITY_LEVEL_COUNT; level++)
+    {
+        free(levels[level].buckets);
+        free(levels[level].tree);
+    }
+    memset(levels, 0, sizeof(levels));
+    needsFullSave = 0;
+}
+
+/*
+ * Adds to the hour and month buckets of a timestamp, updating each
+ * tree along the path from the bucket to the root.
+ */
+static void recordEvent(time_t timestamp, int admissions, int discharges)
+{
+    struct tm localTime;
+
+    localtime_r(&timestamp, &localTime);
+    int buckets[ACTIVITY_LEVEL_COUNT] = { getHourNumber(timestamp), getMonthNumberOfDate(&localTime) };
+
+    for(int level = 0; level < ACTIVITY_LEVEL_COUNT; level++)
+    {
+        CounterLevel *counter = &levels[level];
+        int           index   = getBucketIndex(counter, buckets[level]);
+        if(index == NOT_FOUND)
+        {
+            continue;
+        }
+
+        counter->buckets[index].admissions += admissions;
+        counter->buckets[index].discharges += discharges;
+        for(int i = index + 1; i <= counter->capacity; i += i & -i)
+        {
+            counter->tree[i].admissions += admissions;
+            counter->tree[i].discharges += discharges;
+        }
+
+        writeBucket(level, index);
+    }
+}
+
+/*
+ * Returns where a bucket number sits in a level, growing the level to
+ * reach it if needed.
+ */
+static int getBucketIndex(CounterLevel *counter, int bucket)
+{
+    long long index = (long long) bucket - counter->base;
+
+    if(counter->capacity == 0 || index < 0 || index >= counter->capacity)
+    {
+        if(!growLevel(counter, bucket))
+        {
+            return NOT_FOUND;
+        }
+        index = (long long) bucket - counter->base;
+    }
+
+    return (int) index;
+}
+
+/*
+ * Doubles a level's range until it covers a bucket number. Growing down
+ * keeps the top of the range, so counts already held stay inside it.
+ * Returns 1 on success, 0 if the range would be too large or memory runs
+ * out.
+ */
+static int growLevel(CounterLevel *counter, int bucket)
+{
+    long long base     = counter->capacity == 0 ? bucket : counter->base;
+    long long capacity = counter->capacity == 0 ? INITIAL_CAPACITY : counter->capacity;
+
+    while(bucket < base || bucket - base >= capacity)
+    {
+        if(capacity >= MAX_CAPACITY)
+        {
+            return 0;
+        }
+        if(bucket < base)
+        {
+            base -= capacity;
+        }
+        capacity *= 2;
+    }
+    if(base < INT_MIN || base + capacity > INT_MAX)
+    {
+        return 0;
+    }
+
+    ActivityCount *buckets = calloc((size_t) capacity, sizeof(ActivityCount));
+    ActivityCount *tree    = malloc(sizeof(ActivityCount) * (size_t) (capacity + 1));
+    if(buckets == NULL || tree == NULL)
+    {
+        free(buckets);
+        free(tree);
+        return 0;
+    }
+
+    if(counter->capacity > 0)
+    {
+        memcpy(buckets + (counter->base - base), counter->buckets, sizeof(ActivityCount) * (size_t) counter->capacity);
+    }
+    free(counter->buckets);
+    free(counter->tree);
+
+    counter->base     = (int) base;
+    counter->capacity = (int) capacity;
+    counter->buckets  = buckets;
+    counter->tree     = tree;
+    buildTree(counter);
+
+    // Later levels moved within the file
+    needsFullSave = 1;
+    return 1;
+}
+
+/*
+ * Builds a level's tree from its buckets in one pass, each entry adding
+ * itself to the next entry that covers it.
+ */
+static void buildTree(CounterLevel *counter)
+{
+    memset(counter->tree, 0, sizeof(ActivityCount) * (size_t) (counter->capacity + 1));
+
+    for(int i = 1; i <= counter->capacity; i++)
+    {
+        counter->tree[i].admissions += counter->buckets[i - 1].admissions;
+        counter->tree[i].discharges += counter->buckets[i - 1].discharges;
+
+        int parent = i + (i & -i);
+        if(parent <= counter->capacity)
+        {
+            counter->tree[parent].admissions += counter->tree[i].admissions;
+            counter->tree[parent].discharges += counter->tree[i].discharges;
+        }
+    }
+}
+
+/*
+ * Totals a level's first count buckets.
+ */
+static ActivityCount sumPrefix(const CounterLevel *counter, int count)
+{
+    ActivityCount total = { 0, 0 };
+
+    for(int i = count; i > 0; i -= i & -i)
+    {
+        total.admissions += counter->tree[i].admissions;
+        total.discharges += counter->tree[i].discharges;
+    }
+
+    return total;
+}
+
+/*
+ * Writes one bucket record in place.
+ */
+static void writeBucket(int level, int index)
+{
+    long offset = BUCKETS_OFFSET;
+
+    for(int i = 0; i < level; i++)
+    {
+        offset += (long) levels[i].capacity * BUCKET_RECORD_SIZE;
+    }
+
+    int values[2] = { levels[level].buckets[index].admissions, levels[level].buckets[index].discharges };
+    writeValues(offset + (long) index * BUCKET_RECORD_SIZE, values, 2);
+}
+
+/*
+ * Writes little-endian integers at a file offset. Does nothing while
+ * updates are deferred or a full save is pending.
+ */
+static void writeValues(long offset, const int values[], int count)
+{
+    if(countersFile == NULL || needsFullSave)
+    {
+        return;
+    }
+
+    if(fseek(countersFile, offset, SEEK_SET) != 0 || !putValues(countersFile, values, count))
+    {
+        perror("Error updating " ACTIVITY_FILE);
+    }
+}
+
+/*
+ * Writes little-endian integers at the current file position.
+ * Returns 1 on success, 0 otherwise.
+ */
+static int putValues(FILE *file, const int values[], int count)
+{
+    unsigned char bytes[4 * 2];
+
+    for(int i = 0; i < count; i++)
+    {
+        storeLittleEndian(bytes + 4 * i, (unsigned int) values[i], 4);
+    }
+
+    return fwrite(bytes, 1, (size_t) (4 * count), file) == (size_t) (4 * count);
+}
+
+/*
+ * Reads little-endian integers from the current file position.
+ */
+static int readValues(FILE *file, int values[], int count)
+{
+    unsigned char bytes[4 * 2];
+
+    if(fread(bytes, 1, (size_t) (4 * count), file) != (size_t) (4 * count))
+    {
+        return 0;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        values[i] = (int) (unsigned int) loadLittleEndian(bytes + 4 * i, 4);
+    }
+
+    return 1;
+}
+
+/*
+ * Pushes in-place writes to the file, or rewrites it if a level grew.
+ */
+static void finishUpdate(void)
+{
+    if(countersFile == NULL)
+    {
+        return;
+    }
+
+    if(needsFullSave)
+    {
+        saveCounters();
+    }
+    else
+    {
+        fflush(countersFile);
+    }
+}
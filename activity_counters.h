@@ -0,0 +1,125 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the activity counters: admissions and
+ *          discharges counted per hour and per local calendar month, and
+ *          persisted in activity_counters.dat. Days are not counted here;
+ *          the report totals' day records are the one count per day.
+ *
+ *          Each level keeps its bucket counts in a Fenwick tree (binary
+ *          indexed tree) over consecutive bucket numbers, so counting an
+ *          event and totalling any window of buckets both cost O(log n) in
+ *          the number of buckets. Hours answer short windows and months
+ *          answer long ones without walking thousands of hours.
+ *
+ *          Hours are counted in UTC, so daylight saving changes never merge
+ *          or skip one; months follow local time like the other reports.
+ *          Every public function holds the counters' own lock.
+ */
+
+#ifndef ACTIVITY_COUNTERS_H
+#define ACTIVITY_COUNTERS_H
+
+#include <time.h>
+#include "patient_management.h"
+
+#define ACTIVITY_FILE "activity_counters.dat"
+#define ACTIVITY_FILE_MAGIC "HMSK"
+
+// Bucket levels
+#define ACTIVITY_BY_HOUR 0
+#define ACTIVITY_BY_MONTH 1
+#define ACTIVITY_LEVEL_COUNT 2
+
+#define ACTIVITY_SUCCESS 1
+#define ACTIVITY_FAILURE 0
+
+/*
+ * Admissions and discharges in a bucket or window.
+ */
+typedef struct
+{
+    int admissions;
+    int discharges;
+} ActivityCount;
+
+/*
+ * Function: loadActivityCounters
+ * ------------------------------
+ * Loads the counters from ACTIVITY_FILE.
+ *
+ * Returns: ACTIVITY_SUCCESS, or ACTIVITY_FAILURE if the file is missing or
+ *          invalid, in which case the caller should rebuild the counters
+ */
+int loadActivityCounters(void);
+
+/*
+ * Function: resetActivityCounters
+ * -------------------------------
+ * Clears the counters ahead of a rebuild. Updates are kept in memory until
+ * saveActivityCounters is called.
+ */
+void resetActivityCounters(void);
+
+/*
+ * Function: saveActivityCounters
+ * ------------------------------
+ * Writes the counters to ACTIVITY_FILE. Later updates are written in place
+ * as they happen.
+ *
+ * Returns: ACTIVITY_SUCCESS, or ACTIVITY_FAILURE on a write error
+ */
+int saveActivityCounters(void);
+
+/*
+ * Function: recordAdmissionActivity
+ * ---------------------------------
+ * Counts an admission in the hour and month of its admission date.
+ */
+void recordAdmissionActivity(const Patient *patient);
+
+/*
+ * Function: recordDischargeActivity
+ * ---------------------------------
+ * Counts each discharge in the hour and month of its discharge date.
+ * The whole group is written to the file at once.
+ */
+void recordDischargeActivity(const DischargedPatient records[], int count);
+
+/*
+ * Function: countActivity
+ * -----------------------
+ * Totals the admissions and discharges in a window of buckets.
+ *
+ * level: ACTIVITY_BY_HOUR or ACTIVITY_BY_MONTH
+ * firstBucket: The first bucket number in the window
+ * lastBucket: The last bucket number in the window (inclusive)
+ *
+ * Returns: The totals, zero for buckets with nothing counted
+ */
+ActivityCount countActivity(int level, int firstBucket, int lastBucket);
+
+/*
+ * Function: getHourNumber
+ * -----------------------
+ * Returns the UTC hour of a timestamp as a count of hours since the
+ * epoch, which is its ACTIVITY_BY_HOUR bucket number.
+ */
+int getHourNumber(time_t timestamp);
+
+/*
+ * Function: getMonthNumberOfDate
+ * ------------------------------
+ * Returns the month of a broken-down local date as a count of months since
+ * January 1970, which is its ACTIVITY_BY_MONTH bucket number.
+ */
+int getMonthNumberOfDate(const struct tm *localTime);
+
+/*
+ * Function: clearActivityCounters
+ * -------------------------------
+ * Closes the counters file and frees the counters.
+ */
+void clearActivityCounters(void);
+
+#endif // ACTIVITY_COUNTERS_H
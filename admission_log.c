@@ -0,0 +1,593 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the group commit writer for admissions.
+ */
+
+#define _GNU_SOURCE // O_CLOEXEC, pwrite
+
+#include "admission_log.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "async_io.h"
+#include "durable_file.h"
+#include "patient_storage.h"
+
+// Private constants
+#define NANOSECONDS_PER_MICROSECOND 1000L
+#define NANOSECONDS_PER_SECOND 1000000000L
+#define RECORD_SLOT_SIZE (MAX_ENCODED_RECORD_SIZE + 10) // Record plus its length prefix
+#define NO_DESCRIPTOR (-1)
+#define NO_FAILURE (-1LL)
+
+/*
+ * A batch whose write has been submitted, in file order.
+ */
+typedef struct WrittenBatch
+{
+    PendingAdmission    *admissions;
+    unsigned char       *buffer;
+    size_t               length;
+    long long            offset; // Where the batch starts in patients.dat
+    int                  done;
+    int                  result; // 0 or a negative errno value
+    struct WrittenBatch *next;
+} WrittenBatch;
+
+// Queued admissions, oldest first, and the writer's state. A flush counts
+// as requested while flushRequests is non-zero.
+static PendingAdmission *queueHead         = NULL;
+static PendingAdmission *queueTail         = NULL;
+static int               queuedCount       = 0;
+static struct timespec   oldestQueuedAt;
+static int               writing           = 0;
+static int               flushRequests     = 0;
+static int               stopping          = 0;
+static int               writerRunning     = 0;
+static int               batchSize         = DEFAULT_COMMIT_BATCH_SIZE;
+static long              delayMicroseconds = DEFAULT_COMMIT_DELAY_MICROSECONDS;
+static pthread_t         writerThread;
+
+// patients.dat as the writer sees it, and the batches still being written,
+// oldest first. After a failed write, failedAt holds the offset to cut the
+// file back to once nothing is in flight.
+static int               logFd             = NO_DESCRIPTOR;
+static RecordFileHeader  logHeader;
+static long long         nextOffset        = 0;
+static long long         failedAt          = NO_FAILURE;
+static WrittenBatch     *oldestBatch       = NULL;
+static WrittenBatch     *newestBatch       = NULL;
+static int               batchesInFlight   = 0;
+static pthread_mutex_t   logLock           = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t    admissionQueued   = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t    batchCommitted    = PTHREAD_COND_INITIALIZER;
+
+// Function prototypes for internal helper functions
+static void  readCommitSettings(void);
+static long  readSetting(const char variable[], long defaultValue, long minimum, long maximum);
+static void  waitForBatch(void);
+static void *writeAdmissions(void *argument);
+static void  submitAdmissions(PendingAdmission *batch);
+static int   openLogFile(int baseId);
+static void  closeLogFile(void);
+static int   writeBatchDirectly(const WrittenBatch *batch);
+static void  finishBatch(int result, void *context);
+static int   appendAdmissions(const PendingAdmission *batch);
+static void  commitBatch(PendingAdmission *batch, int durable);
+
+/*
+ * Appends an admission to the queue and wakes the writer.
+ */
+void queueAdmission(PendingAdmission *admission, const Patient *patient)
+{
+    admission->patient   = *patient;
+    admission->committed = 0;
+    admission->durable   = 0;
+    admission->next      = NULL;
+
+    pthread_mutex_lock(&logLock);
+
+    if(!writerRunning)
+    {
+        readCommitSettings();
+        writerRunning = pthread_create(&writerThread, NULL, writeAdmissions, NULL) == 0;
+        if(!writerRunning)
+        {
+            // Without a writer, commit this admission on its own
+            pthread_mutex_unlock(&logLock);
+            puts("Error: Unable to start the admission writer. Writing the admission directly.");
+            commitBatch(admission, appendAdmissions(admission));
+            return;
+        }
+    }
+
+    if(queueTail == NULL)
+    {
+        queueHead = admission;
+        clock_gettime(CLOCK_REALTIME, &oldestQueuedAt);
+    }
+    else
+    {
+        queueTail->next = admission;
+    }
+    queueTail = admission;
+    queuedCount++;
+    pthread_cond_signal(&admissionQueued);
+
+    pthread_mutex_unlock(&logLock);
+}
+
+/*
+ * Sleeps until the writer marks the admission committed.
+ */
+int waitForAdmission(PendingAdmission *admission)
+{
+    pthread_mutex_lock(&logLock);
+    while(!admission->committed)
+    {
+        pthread_cond_wait(&batchCommitted, &logLock);
+    }
+    int durable = admission->durable;
+    pthread_mutex_unlock(&logLock);
+
+    return durable;
+}
+
+/*
+ * Asks the writer to skip the batch delay, waits for an empty queue and
+ * pipeline, and lets go of patients.dat so it can be replaced.
+ */
+void flushAdmissionLog(void)
+{
+    pthread_mutex_lock(&logLock);
+
+    flushRequests++;
+    pthread_cond_signal(&admissionQueued);
+    while(queueHead != NULL || writing || batchesInFlight > 0)
+    {
+        pthread_cond_wait(&batchCommitted, &logLock);
+    }
+    flushRequests--;
+    closeLogFile();
+
+    pthread_mutex_unlock(&logLock);
+}
+
+/*
+ * Stops the writer, which drains the queue before it exits.
+ */
+void stopAdmissionLog(void)
+{
+    pthread_mutex_lock(&logLock);
+    int running = writerRunning;
+    stopping    = 1;
+    pthread_cond_signal(&admissionQueued);
+    pthread_mutex_unlock(&logLock);
+
+    if(running)
+    {
+        pthread_join(writerThread, NULL);
+    }
+
+    pthread_mutex_lock(&logLock);
+    stopping      = 0;
+    writerRunning = 0;
+    pthread_mutex_unlock(&logLock);
+}
+
+/*
+ * Reads the batch size and delay from the environment. Must be called with
+ * logLock held.
+ */
+static void readCommitSettings(void)
+{
+    batchSize         = (int) readSetting(COMMIT_BATCH_VARIABLE, DEFAULT_COMMIT_BATCH_SIZE, 1, 1 << 20);
+    delayMicroseconds = readSetting(COMMIT_DELAY_VARIABLE, DEFAULT_COMMIT_DELAY_MICROSECONDS,
+                                    0, MAX_COMMIT_DELAY_MICROSECONDS);
+}
+
+/*
+ * Returns a whole number from the environment, or the default if it is
+ * unset or outside [minimum, maximum].
+ */
+static long readSetting(const char variable[], long defaultValue, long minimum, long maximum)
+{
+    const char *text = getenv(variable);
+    char       *end;
+
+    if(text == NULL || text[0] == '\0')
+    {
+        return defaultValue;
+    }
+
+    long value = strtol(text, &end, 10);
+    if(*end != '\0' || value < minimum || value > maximum)
+    {
+        printf("Warning: Ignoring %s=%s; using %ld.\n", variable, text, defaultValue);
+        return defaultValue;
+    }
+    return value;
+}
+
+/*
+ * Lets the queued batch fill until it reaches the batch size or its oldest
+ * admission has waited the delay, unless a flush or stop wants it now.
+ * Must be called with logLock held and the queue non-empty.
+ */
+static void waitForBatch(void)
+{
+    struct timespec deadline = oldestQueuedAt;
+
+    deadline.tv_nsec += delayMicroseconds * NANOSECONDS_PER_MICROSECOND;
+    deadline.tv_sec  += deadline.tv_nsec / NANOSECONDS_PER_SECOND;
+    deadline.tv_nsec %= NANOSECONDS_PER_SECOND;
+
+    while(queuedCount < batchSize && flushRequests == 0 && !stopping)
+    {
+        if(pthread_cond_timedwait(&admissionQueued, &logLock, &deadline) == ETIMEDOUT)
+        {
+            break;
+        }
+    }
+}
+
+/*
+ * Writer thread: takes up to a batch of admissions at a time and submits
+ * its write, keeping up to MAX_BATCHES_IN_FLIGHT batches being written and
+ * synced at once, until stopped with an empty queue and pipeline.
+ */
+static void *writeAdmissions(void *argument)
+{
+    (void) argument;
+    pthread_mutex_lock(&logLock);
+
+    for(;;)
+    {
+        while(queueHead == NULL && !stopping)
+        {
+            pthread_cond_wait(&admissionQueued, &logLock);
+        }
+        if(queueHead == NULL)
+        {
+            break;
+        }
+
+        waitForBatch();
+
+        // Wait for room in the pipeline, or for a failed write to drain so
+        // the file can be cut back before anything else is appended
+        while(batchesInFlight >= MAX_BATCHES_IN_FLIGHT || (failedAt != NO_FAILURE && batchesInFlight > 0))
+        {
+            pthread_cond_wait(&batchCommitted, &logLock);
+        }
+        if(failedAt != NO_FAILURE)
+        {
+            closeLogFile();
+        }
+
+        // Detach the oldest batchSize admissions
+        PendingAdmission *batch = queueHead;
+        PendingAdmission *last  = queueHead;
+        int               taken = 1;
+        while(taken < batchSize && last->next != NULL)
+        {
+            last = last->next;
+            taken++;
+        }
+        queueHead    = last->next;
+        last->next   = NULL;
+        queuedCount -= taken;
+        if(queueHead == NULL)
+        {
+            queueTail = NULL;
+        }
+        // Leftovers keep oldestQueuedAt, so they go out as soon as the
+        // writer is free
+        writing = 1;
+        pthread_mutex_unlock(&logLock);
+
+        submitAdmissions(batch);
+
+        pthread_mutex_lock(&logLock);
+        writing = 0;
+        pthread_cond_broadcast(&batchCommitted);
+    }
+
+    while(batchesInFlight > 0)
+    {
+        pthread_cond_wait(&batchCommitted, &logLock);
+    }
+    closeLogFile();
+
+    pthread_mutex_unlock(&logLock);
+    return NULL;
+}
+
+/*
+ * Encodes a batch into one buffer and submits it as a single write at the
+ * end of patients.dat, followed by a sync when patients.dat is
+ * DURABILITY_SYNC. The batch is committed by finishBatch, or here if it
+ * cannot be submitted.
+ */
+static void submitAdmissions(PendingAdmission *batch)
+{
+    size_t count = 0;
+    for(const PendingAdmission *admission = batch; admission != NULL; admission = admission->next)
+    {
+        count++;
+    }
+
+    WrittenBatch  *written = malloc(sizeof(WrittenBatch));
+    unsigned char *buffer  = malloc(count * RECORD_SLOT_SIZE);
+    if(written == NULL || buffer == NULL)
+    {
+        free(written);
+        free(buffer);
+        puts("\nError: Unable to allocate the admission batch. Patient not added to file.");
+        commitBatch(batch, 0);
+        return;
+    }
+
+    // Only this thread and a flush, which waits for it, open or close the
+    // file
+    if(logFd == NO_DESCRIPTOR && !openLogFile(batch->patient.patientId))
+    {
+        free(written);
+        free(buffer);
+        puts("\nUnable to find patients.dat. Patient not added to file.");
+        commitBatch(batch, 0);
+        return;
+    }
+
+    size_t length = 0;
+    for(const PendingAdmission *admission = batch; admission != NULL; admission = admission->next)
+    {
+        length += encodePatientRecord(&logHeader, &admission->patient, 0, 0, buffer + length);
+    }
+
+    written->admissions = batch;
+    written->buffer     = buffer;
+    written->length     = length;
+    written->offset     = nextOffset;
+    written->done       = 0;
+    written->result     = 0;
+    written->next       = NULL;
+    nextOffset         += (long long) length;
+
+    pthread_mutex_lock(&logLock);
+    if(newestBatch == NULL)
+    {
+        oldestBatch = written;
+    }
+    else
+    {
+        newestBatch->next = written;
+    }
+    newestBatch = written;
+    batchesInFlight++;
+    pthread_mutex_unlock(&logLock);
+
+    int sync = getFileDurability("patients.dat") == DURABILITY_SYNC;
+    if(!submitWrite(logFd, buffer, length, written->offset, sync, finishBatch, written))
+    {
+        finishBatch(writeBatchDirectly(written), written);
+    }
+}
+
+/*
+ * Opens patients.dat for the writer, writing a header if it is new, and
+ * reads the header records are encoded against.
+ * Returns 1 on success, 0 otherwise.
+ */
+static int openLogFile(int baseId)
+{
+    RecordWriter writer;
+
+    if(!openRecordWriter(&writer, "patients.dat", PATIENT_FILE_MAGIC, 0, baseId))
+    {
+        return 0;
+    }
+    logHeader = writer.header;
+    if(!closeRecordWriter(&writer))
+    {
+        return 0;
+    }
+
+    logFd = open("patients.dat", O_WRONLY | O_CLOEXEC);
+    if(logFd < 0)
+    {
+        logFd = NO_DESCRIPTOR;
+        return 0;
+    }
+
+    nextOffset = lseek(logFd, 0, SEEK_END);
+    if(nextOffset < 0)
+    {
+        close(logFd);
+        logFd = NO_DESCRIPTOR;
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Cuts patients.dat back to its last good batch after a failed write and
+ * closes it. Must be called with logLock held and nothing in flight.
+ */
+static void closeLogFile(void)
+{
+    if(logFd == NO_DESCRIPTOR)
+    {
+        return;
+    }
+
+    if(failedAt != NO_FAILURE && ftruncate(logFd, (off_t) failedAt) != 0)
+    {
+        perror("Error removing a partly written batch from patients.dat");
+    }
+
+    close(logFd);
+    logFd    = NO_DESCRIPTOR;
+    failedAt = NO_FAILURE;
+}
+
+/*
+ * Writes a batch in place when no asynchronous backend runs.
+ * Returns 0 on success or a negative errno value.
+ */
+static int writeBatchDirectly(const WrittenBatch *batch)
+{
+    size_t written = 0;
+
+    while(written < batch->length)
+    {
+        ssize_t result = pwrite(logFd, batch->buffer + written, batch->length - written,
+                                (off_t) (batch->offset + (long long) written));
+        if(result < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(result <= 0)
+        {
+            return result < 0 ? -errno : -EIO;
+        }
+        written += (size_t) result;
+    }
+
+    return syncFile(logFd, "patients.dat") ? 0 : -EIO;
+}
+
+/*
+ * Completion of a batch write. Batches commit in file order: each finished
+ * batch at the front of the pipeline is committed, durable only if it and
+ * every batch before it were written. After a failure the rest of the
+ * pipeline fails too, as its records will be cut from the file.
+ */
+static void finishBatch(int result, void *context)
+{
+    WrittenBatch *finished = context;
+    WrittenBatch *ready    = NULL;
+    WrittenBatch *readyEnd = NULL;
+    int           count    = 0;
+
+    pthread_mutex_lock(&logLock);
+
+    finished->done   = 1;
+    finished->result = result;
+    while(oldestBatch != NULL && oldestBatch->done)
+    {
+        WrittenBatch *batch = oldestBatch;
+        oldestBatch         = batch->next;
+        batch->next         = NULL;
+        if(failedAt == NO_FAILURE && batch->result != 0)
+        {
+            failedAt = batch->offset;
+        }
+        batch->result = failedAt == NO_FAILURE ? 0 : (batch->result != 0 ? batch->result : -ECANCELED);
+
+        if(readyEnd == NULL)
+        {
+            ready = batch;
+        }
+        else
+        {
+            readyEnd->next = batch;
+        }
+        readyEnd = batch;
+        count++;
+    }
+    if(oldestBatch == NULL)
+    {
+        newestBatch = NULL;
+    }
+
+    pthread_mutex_unlock(&logLock);
+
+    while(ready != NULL)
+    {
+        WrittenBatch *next = ready->next;
+
+        if(ready->result != 0)
+        {
+            printf("\nError writing patients.dat (%s). Patient not added to file.\n", strerror(-ready->result));
+        }
+        commitBatch(ready->admissions, ready->result == 0);
+        free(ready->buffer);
+        free(ready);
+
+        ready = next;
+    }
+
+    if(count > 0)
+    {
+        pthread_mutex_lock(&logLock);
+        batchesInFlight -= count;
+        pthread_cond_broadcast(&batchCommitted);
+        pthread_mutex_unlock(&logLock);
+    }
+}
+
+/*
+ * Appends a batch to patients.dat in one buffered write and syncs it, for
+ * when the writer could not be started.
+ * Returns 1 if every record is durable, 0 with a message otherwise.
+ */
+static int appendAdmissions(const PendingAdmission *batch)
+{
+    RecordWriter writer;
+
+    if(!openRecordWriter(&writer, "patients.dat", PATIENT_FILE_MAGIC, 0, batch->patient.patientId))
+    {
+        puts("\nUnable to find patients.dat. Patient not added to file.");
+        return 0;
+    }
+
+    int written = 1;
+    for(const PendingAdmission *admission = batch; admission != NULL && written; admission = admission->next)
+    {
+        written = writePatientRecord(&writer, &admission->patient);
+    }
+    written = syncRecordWriter(&writer, "patients.dat") && written;
+
+    if(!closeRecordWriter(&writer) || !written)
+    {
+        puts("\nError writing patients.dat. Patient not added to file.");
+        return 0;
+    }
+    return 1;
+}
+
+/*
+ * Marks every admission in a batch committed. Callbacks run without the
+ * lock, on whichever thread finished the write; waiters are woken under it. An admission is not touched once it
+ * is committed, as its owner may free it.
+ */
+static void commitBatch(PendingAdmission *batch, int durable)
+{
+    while(batch != NULL)
+    {
+        PendingAdmission *next = batch->next;
+
+        batch->durable = durable;
+        if(batch->onCommit != NULL)
+        {
+            batch->committed = 1;
+            batch->onCommit(batch);
+        }
+        else
+        {
+            pthread_mutex_lock(&logLock);
+            batch->committed = 1;
+            pthread_cond_broadcast(&batchCommitted);
+            pthread_mutex_unlock(&logLock);
+        }
+
+        batch = next;
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the admission log, which makes new admissions
+ *          durable in patients.dat with group commit.
+ *
+ *          Syncing patients.dat once per admission would cap admissions at
+ *          the disk's sync rate. Instead, admissions are queued in the order
+ *          they were made and a writer thread appends everything queued in
+ *          one write followed by one fdatasync. A batch is written once it
+ *          holds the batch size, or once its oldest admission has waited the
+ *          commit delay, so a lone admission is never held longer than that.
+ *
+ *          Writes go through the asynchronous backend (see async_io.h), so
+ *          the writer hands a batch's write and sync to the kernel and moves
+ *          straight on to the next batch, keeping up to
+ *          MAX_BATCHES_IN_FLIGHT of them on their way to disk. Batches land
+ *          at fixed offsets and commit strictly in order; if one fails, it
+ *          and every batch after it are reported not durable and cut from
+ *          the file. Admissions queued while the pipeline is full form the
+ *          next batch, so batches grow with the load.
+ *
+ *          The batch size and delay default to DEFAULT_COMMIT_BATCH_SIZE and
+ *          DEFAULT_COMMIT_DELAY_MICROSECONDS and can be set through the
+ *          HOSPITAL_COMMIT_BATCH and HOSPITAL_COMMIT_DELAY_US environment
+ *          variables. A delay of 0 writes whatever is queued as soon as the
+ *          writer is free. Setting patients.dat to DURABILITY_ATOMIC (see
+ *          durable_file.h) skips the sync.
+ */
+
+#ifndef ADMISSION_LOG_H
+#define ADMISSION_LOG_H
+
+#include "patient_data.h"
+
+#define DEFAULT_COMMIT_BATCH_SIZE 256
+#define DEFAULT_COMMIT_DELAY_MICROSECONDS 1000
+#define MAX_COMMIT_DELAY_MICROSECONDS 1000000
+#define MAX_BATCHES_IN_FLIGHT 4
+#define COMMIT_BATCH_VARIABLE "HOSPITAL_COMMIT_BATCH"
+#define COMMIT_DELAY_VARIABLE "HOSPITAL_COMMIT_DELAY_US"
+
+/*
+ * An admission waiting to be committed. The caller owns the storage and
+ * must keep it alive until the admission is committed.
+ */
+typedef struct PendingAdmission
+{
+    Patient patient;
+    int     committed; // Set once the batch holding it has been written
+    int     durable;   // 1 if the record was written and synced, 0 if not
+
+    // Called on a writer thread once committed, or NULL to wait with
+    // waitForAdmission. The callback takes over the storage.
+    void (*onCommit)(struct PendingAdmission *admission);
+    void *context;
+
+    struct PendingAdmission *next;
+} PendingAdmission;
+
+/*
+ * Function: queueAdmission
+ * ------------------------
+ * Queues a new patient to be appended to patients.dat, starting the writer
+ * on first use. Admissions are written in the order they are queued, so
+ * callers queue them under the same lock that orders the patient list.
+ *
+ * admission: Storage for the queued admission; onCommit and context must
+ *            already be set
+ * patient: The patient to append
+ */
+void queueAdmission(PendingAdmission *admission, const Patient *patient);
+
+/*
+ * Function: waitForAdmission
+ * --------------------------
+ * Waits until an admission queued without a callback has been committed.
+ *
+ * Returns: 1 if the record is durable, 0 if it could not be written
+ */
+int waitForAdmission(PendingAdmission *admission);
+
+/*
+ * Function: flushAdmissionLog
+ * ---------------------------
+ * Writes every queued admission now, waits until they are committed and
+ * closes patients.dat, so it can be read or replaced. Callers hold the patient store
+ * lock, which keeps new admissions from being queued meanwhile.
+ */
+void flushAdmissionLog(void);
+
+/*
+ * Function: stopAdmissionLog
+ * --------------------------
+ * Commits every queued admission and stops the writer.
+ */
+void stopAdmissionLog(void);
+
+#endif // ADMISSION_LOG_H
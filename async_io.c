@@ -0,0 +1,545 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements asynchronous file writes on io_uring, with
+ *          a thread pool for kernels or sandboxes without it.
+ *
+ *          The ring is driven through the raw system calls. Submitters
+ *          fill submission entries under asyncLock and advance the tail
+ *          with a release store; the completion thread is the only reader
+ *          of the completion queue and hands each entry's slot back with a
+ *          release store of the head. A write that asks for a sync takes
+ *          two entries, the write linked to an IORING_OP_FSYNC, so the
+ *          sync only starts once the write has succeeded.
+ */
+
+#define _GNU_SOURCE // MAP_POPULATE, syscall
+
+#include "async_io.h"
+#include <errno.h>
+#include <linux/io_uring.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// Private constants
+#define BACKEND_NONE 0
+#define BACKEND_IO_URING 1
+#define BACKEND_THREADS 2
+#define STOP_USER_DATA NULL // Marks the no-op that stops the completion thread
+#define NO_DESCRIPTOR (-1)
+
+/*
+ * One submitted write and, optionally, its sync.
+ */
+typedef struct AsyncOperation
+{
+    int             fd;
+    const void     *data;
+    size_t          length;
+    long long       offset;
+    int             sync;
+    int             pendingEntries; // Completions still expected from the ring
+    int             result;         // First error seen, or 0
+    AsyncIoCallback callback;
+    void           *context;
+
+    struct AsyncOperation *next;    // Thread pool queue
+} AsyncOperation;
+
+/*
+ * The mapped submission and completion rings.
+ */
+typedef struct
+{
+    int                  fd;
+    void                *ringMemory;
+    size_t               ringSize;
+    struct io_uring_sqe *entries;
+    size_t               entriesSize;
+    unsigned            *submitTail;
+    unsigned             submitMask;
+    unsigned            *submitArray;
+    unsigned            *completeHead;
+    unsigned            *completeTail;
+    unsigned             completeMask;
+    struct io_uring_cqe *completions;
+} Ring;
+
+// Backend state. inFlight counts operations whose callbacks have not yet
+// returned.
+static int             backend         = BACKEND_NONE;
+static int             inFlight        = 0;
+static int             stopping        = 0;
+static Ring            ring            = { .fd = NO_DESCRIPTOR };
+static AsyncOperation *queueHead       = NULL;
+static AsyncOperation *queueTail       = NULL;
+static pthread_t       threads[ASYNC_IO_THREADS];
+static int             threadCount     = 0;
+static pthread_mutex_t asyncLock       = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  operationQueued = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  operationDone   = PTHREAD_COND_INITIALIZER;
+
+// Function prototypes for internal helper functions
+static int   startBackend(void);
+static int   openRing(void);
+static void  closeRing(void);
+static void  pushEntry(unsigned char opcode, int fd, const void *data, size_t length,
+                       long long offset, unsigned flags, unsigned fsyncFlags, void *userData);
+static int   enterRing(unsigned submitCount, unsigned waitCount);
+static void *reapCompletions(void *argument);
+static void *runWriteWorker(void *argument);
+static int   writeAndSync(const AsyncOperation *operation);
+static void  finishOperation(AsyncOperation *operation);
+
+/*
+ * Queues a write, and its sync, on the running backend.
+ */
+int submitWrite(int fd,
+                const void *data,
+                size_t length,
+                long long offset,
+                int sync,
+                AsyncIoCallback callback,
+                void *context)
+{
+    AsyncOperation *operation = malloc(sizeof(AsyncOperation));
+    if(operation == NULL)
+    {
+        return ASYNC_IO_FAILURE;
+    }
+
+    operation->fd             = fd;
+    operation->data           = data;
+    operation->length         = length;
+    operation->offset         = offset;
+    operation->sync           = sync;
+    operation->pendingEntries = sync ? 2 : 1;
+    operation->result         = 0;
+    operation->callback       = callback;
+    operation->context        = context;
+    operation->next           = NULL;
+
+    pthread_mutex_lock(&asyncLock);
+
+    if(backend == BACKEND_NONE && !startBackend())
+    {
+        pthread_mutex_unlock(&asyncLock);
+        free(operation);
+        return ASYNC_IO_FAILURE;
+    }
+
+    while(inFlight >= ASYNC_IO_RING_ENTRIES)
+    {
+        pthread_cond_wait(&operationDone, &asyncLock);
+    }
+    inFlight++;
+
+    if(backend == BACKEND_IO_URING)
+    {
+        pushEntry(IORING_OP_WRITE, fd, data, length, offset, sync ? IOSQE_IO_LINK : 0, 0, operation);
+        if(sync)
+        {
+            pushEntry(IORING_OP_FSYNC, fd, NULL, 0, 0, 0, IORING_FSYNC_DATASYNC, operation);
+        }
+
+        if(!enterRing(sync ? 2 : 1, 0))
+        {
+            // The entries stay in the ring and go out with the next submit
+            perror("Error submitting to io_uring");
+        }
+    }
+    else
+    {
+        if(queueTail == NULL)
+        {
+            queueHead = operation;
+        }
+        else
+        {
+            queueTail->next = operation;
+        }
+        queueTail = operation;
+        pthread_cond_signal(&operationQueued);
+    }
+
+    pthread_mutex_unlock(&asyncLock);
+    return ASYNC_IO_SUCCESS;
+}
+
+/*
+ * Sleeps until nothing is in flight.
+ */
+void waitForAsyncIo(void)
+{
+    pthread_mutex_lock(&asyncLock);
+    while(inFlight > 0)
+    {
+        pthread_cond_wait(&operationDone, &asyncLock);
+    }
+    pthread_mutex_unlock(&asyncLock);
+}
+
+/*
+ * Drains the backend, then stops its threads and releases the ring.
+ */
+void stopAsyncIo(void)
+{
+    pthread_mutex_lock(&asyncLock);
+
+    while(inFlight > 0)
+    {
+        pthread_cond_wait(&operationDone, &asyncLock);
+    }
+
+    if(backend == BACKEND_IO_URING)
+    {
+        pushEntry(IORING_OP_NOP, NO_DESCRIPTOR, NULL, 0, 0, 0, 0, STOP_USER_DATA);
+        enterRing(1, 0);
+    }
+    stopping = 1;
+    pthread_cond_broadcast(&operationQueued);
+    int stoppedBackend = backend;
+    pthread_mutex_unlock(&asyncLock);
+
+    for(int i = 0; i < threadCount; i++)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    pthread_mutex_lock(&asyncLock);
+    if(stoppedBackend == BACKEND_IO_URING)
+    {
+        closeRing();
+    }
+    threadCount = 0;
+    stopping    = 0;
+    backend     = BACKEND_NONE;
+    pthread_mutex_unlock(&asyncLock);
+}
+
+/*
+ * Names the running backend.
+ */
+const char *getAsyncIoBackend(void)
+{
+    pthread_mutex_lock(&asyncLock);
+    int current = backend;
+    pthread_mutex_unlock(&asyncLock);
+
+    return current == BACKEND_IO_URING ? "io_uring" : current == BACKEND_THREADS ? "threads" : "none";
+}
+
+/*
+ * Starts io_uring and its completion thread, or the thread pool when
+ * io_uring is unavailable or HOSPITAL_ASYNC_IO asks for threads. Must be
+ * called with asyncLock held.
+ * Returns 1 once a backend runs, 0 otherwise.
+ */
+static int startBackend(void)
+{
+    const char *choice = getenv(ASYNC_IO_VARIABLE);
+
+    if((choice == NULL || strcmp(choice, "threads") != 0) && openRing())
+    {
+        if(pthread_create(&threads[0], NULL, reapCompletions, NULL) == 0)
+        {
+            threadCount = 1;
+            backend     = BACKEND_IO_URING;
+            return 1;
+        }
+        closeRing();
+    }
+
+    while(threadCount < ASYNC_IO_THREADS && pthread_create(&threads[threadCount], NULL, runWriteWorker, NULL) == 0)
+    {
+        threadCount++;
+    }
+    if(threadCount == 0)
+    {
+        puts("Error: Unable to start the asynchronous writer.");
+        return 0;
+    }
+
+    backend = BACKEND_THREADS;
+    return 1;
+}
+
+/*
+ * Sets up a ring with room for every operation to take two entries and
+ * maps its queues.
+ * Returns 1 on success, 0 if io_uring is unavailable.
+ */
+static int openRing(void)
+{
+    struct io_uring_params params;
+
+    memset(&params, 0, sizeof(params));
+    ring.fd = (int) syscall(__NR_io_uring_setup, 2 * ASYNC_IO_RING_ENTRIES, &params);
+    if(ring.fd < 0)
+    {
+        ring.fd = NO_DESCRIPTOR;
+        return 0;
+    }
+
+    // Kernels before 5.6 lack IORING_OP_WRITE and are left to the thread
+    // pool; IORING_FEAT_RW_CUR_POS arrived with it
+    size_t submitSize   = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    size_t completeSize = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if(!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_RW_CUR_POS))
+    {
+        closeRing();
+        return 0;
+    }
+
+    ring.ringSize    = submitSize > completeSize ? submitSize : completeSize;
+    ring.entriesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring.ringMemory  = mmap(NULL, ring.ringSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring.fd, IORING_OFF_SQ_RING);
+    ring.entries     = mmap(NULL, ring.entriesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring.fd, IORING_OFF_SQES);
+    if(ring.ringMemory == MAP_FAILED || ring.entries == MAP_FAILED)
+    {
+        closeRing();
+        return 0;
+    }
+
+    unsigned char *base = ring.ringMemory;
+    ring.submitTail     = (unsigned *) (base + params.sq_off.tail);
+    ring.submitMask     = *(unsigned *) (base + params.sq_off.ring_mask);
+    ring.submitArray    = (unsigned *) (base + params.sq_off.array);
+    ring.completeHead   = (unsigned *) (base + params.cq_off.head);
+    ring.completeTail   = (unsigned *) (base + params.cq_off.tail);
+    ring.completeMask   = *(unsigned *) (base + params.cq_off.ring_mask);
+    ring.completions    = (struct io_uring_cqe *) (base + params.cq_off.cqes);
+    return 1;
+}
+
+/*
+ * Unmaps and closes the ring, whatever part of it was set up.
+ */
+static void closeRing(void)
+{
+    if(ring.ringMemory != NULL && ring.ringMemory != MAP_FAILED)
+    {
+        munmap(ring.ringMemory, ring.ringSize);
+    }
+    if(ring.entries != NULL && ring.entries != MAP_FAILED)
+    {
+        munmap(ring.entries, ring.entriesSize);
+    }
+    if(ring.fd != NO_DESCRIPTOR)
+    {
+        close(ring.fd);
+    }
+
+    memset(&ring, 0, sizeof(ring));
+    ring.fd = NO_DESCRIPTOR;
+}
+
+/*
+ * Fills the next submission entry and publishes it to the kernel. There is
+ * always a free entry, as operations in flight are capped at half the
+ * ring. Must be called with asyncLock held.
+ */
+static void pushEntry(unsigned char opcode, int fd, const void *data, size_t length,
+                      long long offset, unsigned flags, unsigned fsyncFlags, void *userData)
+{
+    unsigned             tail  = *ring.submitTail;
+    unsigned             index = tail & ring.submitMask;
+    struct io_uring_sqe *entry = &ring.entries[index];
+
+    memset(entry, 0, sizeof(*entry));
+    entry->opcode      = opcode;
+    entry->flags       = (unsigned char) flags;
+    entry->fd          = fd;
+    entry->addr        = (unsigned long long) (uintptr_t) data;
+    entry->len         = (unsigned) length;
+    entry->off         = (unsigned long long) offset;
+    entry->fsync_flags = fsyncFlags;
+    entry->user_data   = (unsigned long long) (uintptr_t) userData;
+
+    ring.submitArray[index] = index;
+    atomic_store_explicit((_Atomic unsigned *) ring.submitTail, tail + 1, memory_order_release);
+}
+
+/*
+ * Hands submitCount entries to the kernel, optionally waiting for
+ * waitCount completions, retrying interrupted calls.
+ * Returns 1 on success, 0 with errno set otherwise.
+ */
+static int enterRing(unsigned submitCount, unsigned waitCount)
+{
+    unsigned flags = waitCount > 0 ? IORING_ENTER_GETEVENTS : 0;
+
+    for(;;)
+    {
+        long entered = syscall(__NR_io_uring_enter, ring.fd, submitCount, waitCount, flags, NULL, 0);
+        if(entered >= 0 && (unsigned) entered >= submitCount)
+        {
+            return 1;
+        }
+        if(entered >= 0)
+        {
+            submitCount -= (unsigned) entered;
+        }
+        else if(errno != EINTR && errno != EAGAIN)
+        {
+            return 0;
+        }
+    }
+}
+
+/*
+ * Completion thread: waits for completions and finishes each operation
+ * once its last entry is back, until the stop no-op arrives.
+ */
+static void *reapCompletions(void *argument)
+{
+    (void) argument;
+
+    for(;;)
+    {
+        if(!enterRing(0, 1))
+        {
+            perror("Error waiting on io_uring");
+            return NULL;
+        }
+
+        unsigned head = *ring.completeHead;
+        unsigned tail = atomic_load_explicit((_Atomic unsigned *) ring.completeTail, memory_order_acquire);
+
+        // Every completion was submitted under asyncLock, so passing through
+        // it orders this thread after the submitters' writes to the
+        // operations rather than relying on the kernel's ordering alone
+        pthread_mutex_lock(&asyncLock);
+        pthread_mutex_unlock(&asyncLock);
+
+        for(; head != tail; head++)
+        {
+            struct io_uring_cqe *completion = &ring.completions[head & ring.completeMask];
+            AsyncOperation      *operation  = (AsyncOperation *) (uintptr_t) completion->user_data;
+            int                  result     = completion->res;
+
+            if(operation == STOP_USER_DATA)
+            {
+                atomic_store_explicit((_Atomic unsigned *) ring.completeHead, head + 1, memory_order_release);
+                return NULL;
+            }
+
+            // The write completes before its linked sync, and a failed
+            // write cancels the sync, so keep the first error
+            if(operation->result == 0)
+            {
+                if(result < 0)
+                {
+                    operation->result = result;
+                }
+                else if(operation->pendingEntries == (operation->sync ? 2 : 1) && (size_t) result != operation->length)
+                {
+                    operation->result = -EIO; // Short write
+                }
+            }
+
+            if(--operation->pendingEntries == 0)
+            {
+                finishOperation(operation);
+            }
+        }
+
+        atomic_store_explicit((_Atomic unsigned *) ring.completeHead, head, memory_order_release);
+    }
+}
+
+/*
+ * Thread pool worker: writes and syncs queued operations until stopped
+ * with an empty queue.
+ */
+static void *runWriteWorker(void *argument)
+{
+    (void) argument;
+    pthread_mutex_lock(&asyncLock);
+
+    for(;;)
+    {
+        while(queueHead == NULL && !stopping)
+        {
+            pthread_cond_wait(&operationQueued, &asyncLock);
+        }
+        if(queueHead == NULL)
+        {
+            break;
+        }
+
+        AsyncOperation *operation = queueHead;
+        queueHead                 = operation->next;
+        if(queueHead == NULL)
+        {
+            queueTail = NULL;
+        }
+        pthread_mutex_unlock(&asyncLock);
+
+        operation->result = writeAndSync(operation);
+        finishOperation(operation);
+
+        pthread_mutex_lock(&asyncLock);
+    }
+
+    pthread_mutex_unlock(&asyncLock);
+    return NULL;
+}
+
+/*
+ * Writes an operation's whole buffer, then syncs it if asked.
+ * Returns 0 on success or a negative errno value.
+ */
+static int writeAndSync(const AsyncOperation *operation)
+{
+    const unsigned char *data   = operation->data;
+    size_t               length = operation->length;
+    long long            offset = operation->offset;
+
+    while(length > 0)
+    {
+        ssize_t written = pwrite(operation->fd, data, length, (off_t) offset);
+        if(written < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(written <= 0)
+        {
+            return written < 0 ? -errno : -EIO;
+        }
+
+        data   += written;
+        length -= (size_t) written;
+        offset += written;
+    }
+
+    if(operation->sync && fdatasync(operation->fd) != 0)
+    {
+        return -errno;
+    }
+    return 0;
+}
+
+/*
+ * Runs an operation's callback, frees it and wakes anyone waiting for
+ * room or for the backend to drain.
+ */
+static void finishOperation(AsyncOperation *operation)
+{
+    operation->callback(operation->result, operation->context);
+    free(operation);
+
+    pthread_mutex_lock(&asyncLock);
+    inFlight--;
+    pthread_cond_broadcast(&operationDone);
+    pthread_mutex_unlock(&asyncLock);
+}
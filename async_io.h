@@ -0,0 +1,88 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines asynchronous file writes, which let a caller
+ *          hand a write and its sync to the kernel and carry on, learning
+ *          the outcome through a callback.
+ *
+ *          The io_uring backend submits each write, linked to an fdatasync
+ *          when asked for, straight from the caller's thread, and a
+ *          completion thread runs the callbacks. Where io_uring is missing
+ *          or disabled, a small thread pool does the same work with pwrite
+ *          and fdatasync. Setting HOSPITAL_ASYNC_IO to "threads" forces the
+ *          pool. The backend starts on first use.
+ *
+ *          Separate writes may complete in any order, so callers that need
+ *          an order give each write its own offset and act on completions
+ *          in the order they want.
+ */
+
+#ifndef ASYNC_IO_H
+#define ASYNC_IO_H
+
+#include <stddef.h>
+
+#define ASYNC_IO_RING_ENTRIES 64 // Writes in flight at once
+#define ASYNC_IO_THREADS 2
+#define ASYNC_IO_VARIABLE "HOSPITAL_ASYNC_IO"
+
+#define ASYNC_IO_SUCCESS 1
+#define ASYNC_IO_FAILURE 0
+
+/*
+ * Called once a write and its sync have finished, on a backend thread.
+ * result is 0 on success or a negative errno value. Callbacks must not
+ * submit or wait for more writes.
+ */
+typedef void (*AsyncIoCallback)(int result, void *context);
+
+/*
+ * Function: submitWrite
+ * ---------------------
+ * Starts writing a buffer to a file, optionally followed by fdatasync.
+ * Blocks only while ASYNC_IO_RING_ENTRIES operations are already in
+ * flight.
+ *
+ * fd: The file, which must stay open until the callback runs
+ * data: The bytes to write, which must stay valid until the callback runs
+ * length: The number of bytes
+ * offset: Where to write; ignored for files opened with O_APPEND
+ * sync: Non-zero to sync the file's data once the write is done
+ * callback: Called with the outcome
+ * context: Passed to the callback
+ *
+ * Returns: ASYNC_IO_SUCCESS once submitted, or ASYNC_IO_FAILURE if no
+ *          backend could be started, in which case the callback never
+ *          runs and the caller should write synchronously
+ */
+int submitWrite(int fd,
+                const void *data,
+                size_t length,
+                long long offset,
+                int sync,
+                AsyncIoCallback callback,
+                void *context);
+
+/*
+ * Function: waitForAsyncIo
+ * ------------------------
+ * Waits until every submitted write has finished and its callback has run.
+ */
+void waitForAsyncIo(void);
+
+/*
+ * Function: stopAsyncIo
+ * ---------------------
+ * Waits for every submitted write, then stops the backend.
+ */
+void stopAsyncIo(void);
+
+/*
+ * Function: getAsyncIoBackend
+ * ---------------------------
+ * Returns the name of the running backend, "io_uring" or "threads", or
+ * "none" before the first write.
+ */
+const char *getAsyncIoBackend(void);
+
+#endif // ASYNC_IO_H
@@ -0,0 +1,319 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the interned diagnosis dictionary.
+ *          Diagnoses are kept in an ID-ordered array with an open-addressing
+ *          hash table for text lookups, and persisted to diagnoses.dat as
+ *          length-prefixed strings in ID order.
+ *
+ *          Lookups share a reader-writer lock and interning a new text takes
+ *          it exclusively. Texts are allocated one at a time and never move,
+ *          so a returned text stays valid while the ID array grows.
+ */
+
+#define _GNU_SOURCE // pthread_rwlock_t
+
+#include "diagnosis_dictionary.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "durable_file.h"
+#include "patient_data.h"
+
+#define DIAGNOSIS_FILE "diagnoses.dat"
+
+// Private constants
+#define INITIAL_TABLE_CAPACITY 64
+#define EMPTY_SLOT (-1)
+
+static const char *UNKNOWN_DIAGNOSIS = "Unknown";
+
+// Dictionary data
+static char **diagnosisTexts    = NULL; // Indexed by diagnosis ID
+static int    diagnosisCount    = 0;
+static int    diagnosisCapacity = 0;
+static int   *hashSlots         = NULL; // Holds diagnosis IDs
+static int    hashCapacity      = 0;
+
+static pthread_rwlock_t dictionaryLock = PTHREAD_RWLOCK_INITIALIZER;
+
+// Function prototypes for internal helper functions
+static unsigned int hashText(const char text[]);
+static int          lookupSlot(const char text[]);
+static int          growHashTable(void);
+static int          addDiagnosis(const char text[]);
+static int          appendDiagnosisToFile(const char text[]);
+static int          findDiagnosisIdLocked(const char diagnosis[]);
+
+/*
+ * Loads all diagnoses from diagnoses.dat in ID order.
+ */
+void initializeDiagnosisDictionary(void)
+{
+    clearDiagnosisDictionary();
+
+    FILE *file = fopen(DIAGNOSIS_FILE, "rb");
+    if(file == NULL)
+    {
+        puts("Unable to read diagnoses.dat. Diagnosis dictionary initialized empty.");
+        return;
+    }
+
+    char text[MAX_DIAGNOSIS_LENGTH];
+    int  length;
+
+    while((length = fgetc(file)) != EOF)
+    {
+        if(length >= MAX_DIAGNOSIS_LENGTH ||
+           fread(text, 1, (size_t) length, file) != (size_t) length)
+        {
+            puts("Warning: diagnoses.dat is truncated. Remaining entries ignored.");
+            break;
+        }
+        text[length] = '\0';
+
+        if(addDiagnosis(text) == INVALID_DIAGNOSIS_ID)
+        {
+            puts("Error: Unable to load diagnosis dictionary.");
+            break;
+        }
+    }
+
+    fclose(file);
+}
+
+/*
+ * Returns the ID of a diagnosis, adding it to the dictionary if needed.
+ */
+int internDiagnosis(const char diagnosis[])
+{
+    int existingId = findDiagnosisId(diagnosis);
+    if(existingId != INVALID_DIAGNOSIS_ID)
+    {
+        return existingId;
+    }
+
+    if(strlen(diagnosis) >= MAX_DIAGNOSIS_LENGTH)
+    {
+        return INVALID_DIAGNOSIS_ID;
+    }
+
+    pthread_rwlock_wrlock(&dictionaryLock);
+
+    // Another thread may have added it since the shared lookup
+    int diagnosisId = findDiagnosisIdLocked(diagnosis);
+
+    // Persist first so no record can reference an ID missing from the file
+    if(diagnosisId == INVALID_DIAGNOSIS_ID && appendDiagnosisToFile(diagnosis))
+    {
+        diagnosisId = addDiagnosis(diagnosis);
+    }
+
+    pthread_rwlock_unlock(&dictionaryLock);
+    return diagnosisId;
+}
+
+/*
+ * Returns the ID of a known diagnosis without modifying the dictionary.
+ */
+int findDiagnosisId(const char diagnosis[])
+{
+    pthread_rwlock_rdlock(&dictionaryLock);
+    int diagnosisId = findDiagnosisIdLocked(diagnosis);
+    pthread_rwlock_unlock(&dictionaryLock);
+
+    return diagnosisId;
+}
+
+/*
+ * Returns the text for the given diagnosis ID.
+ */
+const char *getDiagnosisText(int diagnosisId)
+{
+    const char *text = UNKNOWN_DIAGNOSIS;
+
+    pthread_rwlock_rdlock(&dictionaryLock);
+    if(diagnosisId >= 0 && diagnosisId < diagnosisCount)
+    {
+        text = diagnosisTexts[diagnosisId];
+    }
+    pthread_rwlock_unlock(&dictionaryLock);
+
+    return text;
+}
+
+/*
+ * Returns the number of interned diagnoses.
+ */
+int getDiagnosisCount(void)
+{
+    pthread_rwlock_rdlock(&dictionaryLock);
+    int count = diagnosisCount;
+    pthread_rwlock_unlock(&dictionaryLock);
+
+    return count;
+}
+
+/*
+ * Frees the dictionary strings and hash table.
+ */
+void clearDiagnosisDictionary(void)
+{
+    for(int i = 0; i < diagnosisCount; i++)
+    {
+        free(diagnosisTexts[i]);
+    }
+    free(diagnosisTexts);
+    free(hashSlots);
+
+    diagnosisTexts    = NULL;
+    diagnosisCount    = 0;
+    diagnosisCapacity = 0;
+    hashSlots         = NULL;
+    hashCapacity      = 0;
+}
+
+/*
+ * Looks up a diagnosis with dictionaryLock already held.
+ */
+static int findDiagnosisIdLocked(const char diagnosis[])
+{
+    if(diagnosis == NULL || hashCapacity == 0)
+    {
+        return INVALID_DIAGNOSIS_ID;
+    }
+
+    return hashSlots[lookupSlot(diagnosis)];
+}
+
+/*
+ * FNV-1a hash of a diagnosis string.
+ */
+static unsigned int hashText(const char text[])
+{
+    unsigned int hash = 2166136261u;
+
+    for(const unsigned char *p = (const unsigned char *) text; *p != '\0'; p++)
+    {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/*
+ * Returns the slot holding the given text, or the empty slot where it
+ * would be inserted. The table is never full, so probing terminates.
+ */
+static int lookupSlot(const char text[])
+{
+    unsigned int mask = (unsigned int) hashCapacity - 1;
+    unsigned int slot = hashText(text) & mask;
+
+    while(hashSlots[slot] != EMPTY_SLOT &&
+          strcmp(diagnosisTexts[hashSlots[slot]], text) != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return (int) slot;
+}
+
+/*
+ * Doubles the hash table and reinserts every diagnosis ID.
+ * Returns 1 on success, 0 on allocation failure.
+ */
+static int growHashTable(void)
+{
+    int  newCapacity = hashCapacity == 0 ? INITIAL_TABLE_CAPACITY : hashCapacity * 2;
+    int *newSlots    = malloc(sizeof(int) * (size_t) newCapacity);
+    if(newSlots == NULL)
+    {
+        return 0;
+    }
+
+    for(int i = 0; i < newCapacity; i++)
+    {
+        newSlots[i] = EMPTY_SLOT;
+    }
+
+    free(hashSlots);
+    hashSlots    = newSlots;
+    hashCapacity = newCapacity;
+
+    for(int id = 0; id < diagnosisCount; id++)
+    {
+        hashSlots[lookupSlot(diagnosisTexts[id])] = id;
+    }
+
+    return 1;
+}
+
+/*
+ * Adds a diagnosis to the in-memory dictionary and returns its new ID.
+ */
+static int addDiagnosis(const char text[])
+{
+    // Keep the load factor at or below one half
+    if((diagnosisCount + 1) * 2 > hashCapacity && !growHashTable())
+    {
+        return INVALID_DIAGNOSIS_ID;
+    }
+
+    if(diagnosisCount == diagnosisCapacity)
+    {
+        int    newCapacity = diagnosisCapacity == 0 ? INITIAL_TABLE_CAPACITY : diagnosisCapacity * 2;
+        char **newTexts    = realloc(diagnosisTexts, sizeof(char *) * (size_t) newCapacity);
+        if(newTexts == NULL)
+        {
+            return INVALID_DIAGNOSIS_ID;
+        }
+        diagnosisTexts    = newTexts;
+        diagnosisCapacity = newCapacity;
+    }
+
+    size_t length = strlen(text);
+    char  *copy   = malloc(length + 1);
+    if(copy == NULL)
+    {
+        return INVALID_DIAGNOSIS_ID;
+    }
+    memcpy(copy, text, length + 1);
+
+    int id                      = diagnosisCount;
+    diagnosisTexts[id]          = copy;
+    hashSlots[lookupSlot(copy)] = id;
+    diagnosisCount++;
+
+    return id;
+}
+
+/*
+ * Appends a length-prefixed diagnosis to diagnoses.dat, synced before any
+ * record can refer to its ID.
+ * Returns 1 on success, 0 on failure.
+ */
+static int appendDiagnosisToFile(const char text[])
+{
+    FILE *file = fopen(DIAGNOSIS_FILE, "ab");
+    if(file == NULL)
+    {
+        perror("Error opening diagnoses.dat");
+        return 0;
+    }
+
+    unsigned char length = (unsigned char) strlen(text);
+    int           ok     = fputc(length, file) != EOF &&
+                           fwrite(text, 1, length, file) == length &&
+                           fflush(file) == 0 && syncFile(fileno(file), DIAGNOSIS_FILE);
+
+    if(fclose(file) != 0 || !ok)
+    {
+        perror("Error writing to diagnoses.dat");
+        return 0;
+    }
+
+    return 1;
+}
@@ -0,0 +1,64 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the interned diagnosis dictionary. Each distinct
+ *          diagnosis text is stored once and patients refer to it by ID.
+ */
+
+#ifndef DIAGNOSIS_DICTIONARY_H
+#define DIAGNOSIS_DICTIONARY_H
+
+#define INVALID_DIAGNOSIS_ID (-1)
+
+/*
+ * Function: initializeDiagnosisDictionary
+ * ---------------------------------------
+ * Loads the diagnosis dictionary from diagnoses.dat. Starts with an
+ * empty dictionary if the file does not exist.
+ */
+void initializeDiagnosisDictionary(void);
+
+/*
+ * Function: internDiagnosis
+ * -------------------------
+ * Looks up a diagnosis text and returns its ID. New texts are added to
+ * the dictionary and appended to diagnoses.dat.
+ *
+ * diagnosis: The diagnosis text to intern
+ *
+ * Returns: The diagnosis ID, or INVALID_DIAGNOSIS_ID on failure
+ */
+int internDiagnosis(const char diagnosis[]);
+
+/*
+ * Function: findDiagnosisId
+ * -------------------------
+ * Looks up a diagnosis text without adding it to the dictionary.
+ *
+ * Returns: The diagnosis ID, or INVALID_DIAGNOSIS_ID if it is unknown
+ */
+int findDiagnosisId(const char diagnosis[]);
+
+/*
+ * Function: getDiagnosisText
+ * --------------------------
+ * Returns the text for a diagnosis ID, or "Unknown" for invalid IDs.
+ */
+const char *getDiagnosisText(int diagnosisId);
+
+/*
+ * Function: getDiagnosisCount
+ * ---------------------------
+ * Returns the number of distinct diagnoses in the dictionary.
+ * Valid IDs range from 0 to getDiagnosisCount() - 1.
+ */
+int getDiagnosisCount(void);
+
+/*
+ * Function: clearDiagnosisDictionary
+ * ----------------------------------
+ * Frees all memory used by the diagnosis dictionary.
+ */
+void clearDiagnosisDictionary(void);
+
+#endif // DIAGNOSIS_DICTIONARY_H
@@ -0,0 +1,1365 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the inverted index over diagnosis text.
+ *
+ *          Each posting list is a table of blocks of up to POSTING_BLOCK_SIZE
+ *          ascending IDs. A block stores its first and last ID uncompressed
+ *          and the gaps between the remaining IDs as varints. The block table
+ *          doubles as a skip list: intersections gallop over block last IDs,
+ *          decode only the block that can contain the target, and gallop
+ *          again inside it.
+ */
+
+#include "diagnosis_index.h"
+#include <ctype.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+#include "diagnosis_dictionary.h"
+#include "discharge_archive.h"
+#include "patient_data.h"
+#include "patient_storage.h"
+
+// Private constants
+#define POSTING_BLOCK_SIZE 128
+#define MAX_VARINT_GAP_BYTES 5
+#define MAX_QUERY_OPERANDS 16
+#define INITIAL_CAPACITY 16
+#define EMPTY_SLOT (-1)
+#define CURSOR_END INT_MAX
+#define SAVED_ALIGNMENT 4
+
+/*
+ * A run of ascending patient IDs with varint-coded gaps after firstId.
+ */
+typedef struct
+{
+    int            firstId;
+    int            lastId;
+    int            count;
+    int            byteLength;
+    int            byteCapacity;
+    unsigned char *bytes;
+} PostingBlock;
+
+typedef struct
+{
+    PostingBlock *blocks;
+    int           blockCount;
+    int           blockCapacity;
+    int           totalIds;
+} PostingList;
+
+typedef struct
+{
+    char       *text;
+    PostingList postings[INDEX_SCOPE_COUNT];
+} IndexTerm;
+
+/*
+ * Cached term IDs of one interned diagnosis.
+ */
+typedef struct
+{
+    int *termIds;
+    int  termCount;
+    int  tokenized;
+} DiagnosisTerms;
+
+typedef struct
+{
+    int *ids;
+    int  count;
+    int  capacity;
+} IdList;
+
+/*
+ * Layout of one scope in a checkpoint section: a SavedScope, then for each
+ * term with postings a SavedTerm, its text padded to SAVED_ALIGNMENT, its
+ * SavedBlocks and their bytes, again padded.
+ */
+typedef struct
+{
+    int termCount;
+} SavedScope;
+
+typedef struct
+{
+    int textLength; // Including the terminator
+    int blockCount;
+    int totalIds;
+} SavedTerm;
+
+typedef struct
+{
+    int firstId;
+    int lastId;
+    int count;
+    int byteLength;
+} SavedBlock;
+
+/*
+ * Forward iterator over a posting list, or over a plain ascending array
+ * when list is NULL.
+ */
+typedef struct
+{
+    const PostingList *list;
+    int                blockIndex;
+    const int         *values;
+    int                valueCount;
+    int                position;
+    int                decoded[POSTING_BLOCK_SIZE];
+} PostingCursor;
+
+/*
+ * A parsed query word.
+ */
+typedef struct
+{
+    char text[MAX_DIAGNOSIS_LENGTH];
+    int  isPrefix;
+} QueryOperand;
+
+// Index data
+static IndexTerm      *terms                  = NULL;
+static int             termCount              = 0;
+static int             termCapacity           = 0;
+static int            *termSlots              = NULL; // Hash table of term IDs
+static int             termSlotCapacity       = 0;
+static int            *sortedTermIds          = NULL; // Term IDs in text order
+static int             sortedTermCount        = 0;
+static DiagnosisTerms *diagnosisTerms         = NULL; // Indexed by diagnosis ID
+static int             diagnosisTermsCapacity = 0;
+
+// Function prototypes for internal helper functions
+static unsigned int    hashTerm(const char text[]);
+static int             findTermSlot(const char text[]);
+static int             findTerm(const char text[]);
+static int             addTerm(const char text[]);
+static DiagnosisTerms *getDiagnosisTerms(int diagnosisId);
+static int             nextWord(const char **text, char word[]);
+static int             encodeBlock(PostingBlock *block, const int ids[], int count);
+static int             decodeBlock(const PostingBlock *block, int ids[]);
+static int             findBlock(const PostingList *list, int patientId);
+static int             postingInsert(PostingList *list, int patientId);
+static void            postingRemove(PostingList *list, int patientId);
+static void            freePostingList(PostingList *list);
+static void            cursorOpenList(PostingCursor *cursor, const PostingList *list);
+static void            cursorOpenArray(PostingCursor *cursor, const int ids[], int count);
+static void            cursorLoadBlock(PostingCursor *cursor, int blockIndex);
+static int             cursorCurrent(const PostingCursor *cursor);
+static void            cursorNext(PostingCursor *cursor);
+static int             cursorAdvanceTo(PostingCursor *cursor, int target);
+static int             idListAppend(IdList *list, int id);
+static void            idListSortUnique(IdList *list);
+static int             collectPrefix(int scope, const char prefix[], IdList *out);
+static int             evaluateGroup(int scope, QueryOperand operands[], int operandCount, IdList *out);
+static int             compareIds(const void *a, const void *b);
+static int             compareTermText(const void *a, const void *b);
+static void            ensureSortedTerms(void);
+static int             indexDischargedRecord(const DischargedPatient *dischargedPatient, void *context);
+static int             writePadding(FILE *file, size_t length);
+static int             loadSavedTerm(int scope, const unsigned char *bytes, size_t length, size_t *position);
+
+/*
+ * Rebuilds the index and loads the discharge archive into it.
+ */
+void initializeDiagnosisIndex(void)
+{
+    clearDiagnosisIndex();
+    scanDischargeArchive(ARCHIVE_BEGINNING_OF_TIME, ARCHIVE_END_OF_TIME, indexDischargedRecord, NULL);
+}
+
+/*
+ * Adds a patient to the posting list of each of their diagnosis terms.
+ */
+int addToDiagnosisIndex(int scope, int patientId, int diagnosisId)
+{
+    DiagnosisTerms *entry = getDiagnosisTerms(diagnosisId);
+    if(entry == NULL)
+    {
+        return INDEX_FAILURE;
+    }
+
+    for(int i = 0; i < entry->termCount; i++)
+    {
+        if(!postingInsert(&terms[entry->termIds[i]].postings[scope], patientId))
+        {
+            return INDEX_FAILURE;
+        }
+    }
+
+    return INDEX_SUCCESS;
+}
+
+/*
+ * Removes a patient from the posting lists of their diagnosis terms.
+ */
+void removeFromDiagnosisIndex(int scope, int patientId, int diagnosisId)
+{
+    DiagnosisTerms *entry = getDiagnosisTerms(diagnosisId);
+    if(entry == NULL)
+    {
+        return;
+    }
+
+    for(int i = 0; i < entry->termCount; i++)
+    {
+        postingRemove(&terms[entry->termIds[i]].postings[scope], patientId);
+    }
+}
+
+/*
+ * Parses the query into OR-separated groups of ANDed operands and
+ * returns the union of each group's intersection.
+ */
+int queryDiagnosisIndex(int scope, const char query[], int **patientIds, int *matchCount)
+{
+    QueryOperand operands[MAX_QUERY_OPERANDS];
+    int          operandCount = 0;
+    int          groupCount   = 0;
+    int          ok           = 1;
+    IdList       results      = { NULL, 0, 0 };
+    char         word[MAX_DIAGNOSIS_LENGTH];
+    const char  *cursor       = query;
+
+    *patientIds = NULL;
+    *matchCount = 0;
+
+    for(;;)
+    {
+        int hasWord = nextWord(&cursor, word);
+
+        if(!hasWord || strcmp(word, "OR") == 0 || strcmp(word, "or") == 0)
+        {
+            if(operandCount > 0)
+            {
+                ok = ok && evaluateGroup(scope, operands, operandCount, &results);
+                groupCount++;
+            }
+            operandCount = 0;
+
+            if(!hasWord)
+            {
+                break;
+            }
+            continue;
+        }
+
+        if(strcmp(word, "AND") == 0 || strcmp(word, "and") == 0 || operandCount == MAX_QUERY_OPERANDS)
+        {
+            continue;
+        }
+
+        // Keep letters only, matching how diagnoses are tokenized
+        QueryOperand *operand = &operands[operandCount];
+        size_t        length  = 0;
+        for(const char *p = word; *p != '\0'; p++)
+        {
+            if(isalpha((unsigned char) *p))
+            {
+                operand->text[length++] = (char) tolower((unsigned char) *p);
+            }
+        }
+        operand->text[length] = '\0';
+        operand->isPrefix     = word[strlen(word) - 1] == '*';
+
+        if(length > 0)
+        {
+            operandCount++;
+        }
+    }
+
+    if(!ok || groupCount == 0)
+    {
+        free(results.ids);
+        return INDEX_FAILURE;
+    }
+
+    if(groupCount > 1)
+    {
+        idListSortUnique(&results);
+    }
+
+    *patientIds = results.ids;
+    *matchCount = results.count;
+    return INDEX_SUCCESS;
+}
+
+/*
+ * Empties every posting list of one scope.
+ */
+void clearDiagnosisIndexScope(int scope)
+{
+    for(int i = 0; i < termCount; i++)
+    {
+        freePostingList(&terms[i].postings[scope]);
+    }
+}
+
+/*
+ * Writes each term of the scope that has postings, with its blocks as
+ * they are.
+ */
+int saveDiagnosisIndexScope(int scope, FILE *file)
+{
+    SavedScope header = { 0 };
+
+    for(int i = 0; i < termCount; i++)
+    {
+        header.termCount += terms[i].postings[scope].blockCount > 0;
+    }
+
+    int written = fwrite(&header, sizeof(header), 1, file) == 1;
+    for(int i = 0; written && i < termCount; i++)
+    {
+        const PostingList *list = &terms[i].postings[scope];
+        if(list->blockCount == 0)
+        {
+            continue;
+        }
+
+        SavedTerm saved = { (int) strlen(terms[i].text) + 1, list->blockCount, list->totalIds };
+        written = fwrite(&saved, sizeof(saved), 1, file) == 1 &&
+                  fwrite(terms[i].text, 1, (size_t) saved.textLength, file) == (size_t) saved.textLength &&
+                  writePadding(file, (size_t) saved.textLength);
+
+        size_t byteTotal = 0;
+        for(int b = 0; written && b < list->blockCount; b++)
+        {
+            const PostingBlock *block      = &list->blocks[b];
+            SavedBlock          savedBlock = { block->firstId, block->lastId, block->count, block->byteLength };
+            written    = fwrite(&savedBlock, sizeof(savedBlock), 1, file) == 1;
+            byteTotal += (size_t) block->byteLength;
+        }
+        for(int b = 0; written && b < list->blockCount; b++)
+        {
+            const PostingBlock *block = &list->blocks[b];
+            written = fwrite(block->bytes, 1, (size_t) block->byteLength, file) == (size_t) block->byteLength;
+        }
+        written = written && writePadding(file, byteTotal);
+    }
+
+    return written ? INDEX_SUCCESS : INDEX_FAILURE;
+}
+
+/*
+ * Empties the scope, then gives each saved term its posting list back.
+ */
+int loadDiagnosisIndexScope(int scope, const void *section, size_t length)
+{
+    const unsigned char *bytes    = section;
+    size_t               position = sizeof(SavedScope);
+    SavedScope           header;
+
+    clearDiagnosisIndexScope(scope);
+    if(length < sizeof(header))
+    {
+        return INDEX_FAILURE;
+    }
+    memcpy(&header, bytes, sizeof(header));
+
+    for(int i = 0; i < header.termCount; i++)
+    {
+        if(!loadSavedTerm(scope, bytes, length, &position))
+        {
+            clearDiagnosisIndexScope(scope);
+            return INDEX_FAILURE;
+        }
+    }
+
+    if(position != length)
+    {
+        clearDiagnosisIndexScope(scope);
+        return INDEX_FAILURE;
+    }
+
+    return INDEX_SUCCESS;
+}
+
+/*
+ * Frees the vocabulary, posting lists and diagnosis term cache.
+ */
+void clearDiagnosisIndex(void)
+{
+    for(int i = 0; i < termCount; i++)
+    {
+        for(int scope = 0; scope < INDEX_SCOPE_COUNT; scope++)
+        {
+            freePostingList(&terms[i].postings[scope]);
+        }
+        free(terms[i].text);
+    }
+
+    for(int i = 0; i < diagnosisTermsCapacity; i++)
+    {
+        free(diagnosisTerms[i].termIds);
+    }
+
+    free(terms);
+    free(termSlots);
+    free(sortedTermIds);
+    free(diagnosisTerms);
+
+    terms                  = NULL;
+    termCount              = 0;
+    termCapacity           = 0;
+    termSlots              = NULL;
+    termSlotCapacity       = 0;
+    sortedTermIds          = NULL;
+    sortedTermCount        = 0;
+    diagnosisTerms         = NULL;
+    diagnosisTermsCapacity = 0;
+}
+
+/*
+ * FNV-1a hash of a term.
+ */
+static unsigned int hashTerm(const char text[])
+{
+    unsigned int hash = 2166136261u;
+
+    for(const unsigned char *p = (const unsigned char *) text; *p != '\0'; p++)
+    {
+        hash ^= *p;
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+
+/*
+ * Returns the hash slot holding the term, or the empty slot for it.
+ */
+static int findTermSlot(const char text[])
+{
+    unsigned int mask = (unsigned int) termSlotCapacity - 1;
+    unsigned int slot = hashTerm(text) & mask;
+
+    while(termSlots[slot] != EMPTY_SLOT && strcmp(terms[termSlots[slot]].text, text) != 0)
+    {
+        slot = (slot + 1) & mask;
+    }
+
+    return (int) slot;
+}
+
+/*
+ * Returns the ID of a known term, or EMPTY_SLOT.
+ */
+static int findTerm(const char text[])
+{
+    return termSlotCapacity == 0 ? EMPTY_SLOT : termSlots[findTermSlot(text)];
+}
+
+/*
+ * Returns the ID of a term, adding it to the vocabulary if needed.
+ */
+static int addTerm(const char text[])
+{
+    int existing = findTerm(text);
+    if(existing != EMPTY_SLOT)
+    {
+        return existing;
+    }
+
+    if((termCount + 1) * 2 > termSlotCapacity)
+    {
+        int  newCapacity = termSlotCapacity == 0 ? INITIAL_CAPACITY * 4 : termSlotCapacity * 2;
+        int *newSlots    = malloc(sizeof(int) * (size_t) newCapacity);
+        if(newSlots == NULL)
+        {
+            return EMPTY_SLOT;
+        }
+        for(int i = 0; i < newCapacity; i++)
+        {
+            newSlots[i] = EMPTY_SLOT;
+        }
+        free(termSlots);
+        termSlots        = newSlots;
+        termSlotCapacity = newCapacity;
+        for(int id = 0; id < termCount; id++)
+        {
+            termSlots[findTermSlot(terms[id].text)] = id;
+        }
+    }
+
+    if(termCount == termCapacity)
+    {
+        int        newCapacity = termCapacity == 0 ? INITIAL_CAPACITY : termCapacity * 2;
+        IndexTerm *newTerms    = realloc(terms, sizeof(IndexTerm) * (size_t) newCapacity);
+        if(newTerms == NULL)
+        {
+            return EMPTY_SLOT;
+        }
+        terms        = newTerms;
+        termCapacity = newCapacity;
+    }
+
+    size_t length = strlen(text);
+    char  *copy   = malloc(length + 1);
+    if(copy == NULL)
+    {
+        return EMPTY_SLOT;
+    }
+    memcpy(copy, text, length + 1);
+
+    IndexTerm *term = &terms[termCount];
+    memset(term, 0, sizeof(IndexTerm));
+    term->text = copy;
+
+    termSlots[findTermSlot(copy)] = termCount;
+    return termCount++;
+}
+
+/*
+ * Returns the cached terms of a diagnosis, tokenizing it on first use.
+ */
+static DiagnosisTerms *getDiagnosisTerms(int diagnosisId)
+{
+    if(diagnosisId < 0 || diagnosisId >= getDiagnosisCount())
+    {
+        return NULL;
+    }
+
+    if(diagnosisId >= diagnosisTermsCapacity)
+    {
+        int             newCapacity = getDiagnosisCount() + INITIAL_CAPACITY;
+        DiagnosisTerms *grown       = realloc(diagnosisTerms, sizeof(DiagnosisTerms) * (size_t) newCapacity);
+        if(grown == NULL)
+        {
+            return NULL;
+        }
+        memset(grown + diagnosisTermsCapacity, 0,
+               sizeof(DiagnosisTerms) * (size_t) (newCapacity - diagnosisTermsCapacity));
+        diagnosisTerms         = grown;
+        diagnosisTermsCapacity = newCapacity;
+    }
+
+    DiagnosisTerms *entry = &diagnosisTerms[diagnosisId];
+    if(entry->tokenized)
+    {
+        return entry;
+    }
+
+    const char *text = getDiagnosisText(diagnosisId);
+    char        word[MAX_DIAGNOSIS_LENGTH];
+
+    entry->termIds = malloc(sizeof(int) * (strlen(text) / 2 + 1));
+    if(entry->termIds == NULL)
+    {
+        return NULL;
+    }
+
+    // Split on anything that is not a letter and fold to lower case
+    for(const char *p = text; *p != '\0';)
+    {
+        size_t length = 0;
+        while(*p != '\0' && !isalpha((unsigned char) *p))
+        {
+            p++;
+        }
+        while(isalpha((unsigned char) *p))
+        {
+            word[length++] = (char) tolower((unsigned char) *p++);
+        }
+        if(length == 0)
+        {
+            continue;
+        }
+        word[length] = '\0';
+
+        int termId = addTerm(word);
+        if(termId == EMPTY_SLOT)
+        {
+            return NULL;
+        }
+
+        int duplicate = 0;
+        for(int i = 0; i < entry->termCount; i++)
+        {
+            duplicate |= entry->termIds[i] == termId;
+        }
+        if(!duplicate)
+        {
+            entry->termIds[entry->termCount++] = termId;
+        }
+    }
+
+    entry->tokenized = 1;
+    return entry;
+}
+
+/*
+ * Copies the next whitespace-separated word of a query.
+ * Returns 1 if a word was found, 0 at the end of the text.
+ */
+static int nextWord(const char **text, char word[])
+{
+    const char *p      = *text;
+    size_t      length = 0;
+
+    while(isspace((unsigned char) *p))
+    {
+        p++;
+    }
+    while(*p != '\0' && !isspace((unsigned char) *p))
+    {
+        if(length < MAX_DIAGNOSIS_LENGTH - 1)
+        {
+            word[length++] = *p;
+        }
+        p++;
+    }
+
+    word[length] = '\0';
+    *text        = p;
+    return length > 0;
+}
+
+/*
+ * Replaces a block's contents with the given ascending IDs.
+ */
+static int encodeBlock(PostingBlock *block, const int ids[], int count)
+{
+    int            capacity = count * MAX_VARINT_GAP_BYTES;
+    unsigned char *bytes    = malloc((size_t) capacity);
+    if(bytes == NULL)
+    {
+        return 0;
+    }
+
+    size_t length = 0;
+    for(int i = 1; i < count; i++)
+    {
+        length += encodeVarint((unsigned int) (ids[i] - ids[i - 1]), bytes + length);
+    }
+
+    free(block->bytes);
+    block->bytes        = bytes;
+    block->byteLength   = (int) length;
+    block->byteCapacity = capacity;
+    block->firstId      = ids[0];
+    block->lastId       = ids[count - 1];
+    block->count        = count;
+    return 1;
+}
+
+/*
+ * Expands a block into ids, which must hold POSTING_BLOCK_SIZE entries.
+ * Returns the number of IDs decoded.
+ */
+static int decodeBlock(const PostingBlock *block, int ids[])
+{
+    size_t position = 0;
+    int    id       = block->firstId;
+
+    ids[0] = id;
+    for(int i = 1; i < block->count; i++)
+    {
+        unsigned long long gap = 0;
+        decodeVarint(block->bytes, (size_t) block->byteLength, &position, &gap);
+        id    += (int) gap;
+        ids[i] = id;
+    }
+
+    return block->count;
+}
+
+/*
+ * Returns the last block whose first ID is at most patientId, or 0 if
+ * patientId precedes every block.
+ */
+static int findBlock(const PostingList *list, int patientId)
+{
+    int low  = 0;
+    int high = list->blockCount - 1;
+
+    while(low < high)
+    {
+        int middle = (low + high + 1) / 2;
+        if(list->blocks[middle].firstId <= patientId)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    return low;
+}
+
+/*
+ * Inserts an ID into a posting list. Appends to the last block cost O(1);
+ * out-of-order inserts re-encode one block, splitting it when full.
+ */
+static int postingInsert(PostingList *list, int patientId)
+{
+    if(list->blockCount > 0)
+    {
+        PostingBlock *last = &list->blocks[list->blockCount - 1];
+
+        if(patientId > last->lastId && last->count < POSTING_BLOCK_SIZE)
+        {
+            if(last->byteLength + MAX_VARINT_GAP_BYTES > last->byteCapacity)
+            {
+                int            newCapacity = last->byteCapacity * 2 + MAX_VARINT_GAP_BYTES;
+                unsigned char *grown       = realloc(last->bytes, (size_t) newCapacity);
+                if(grown == NULL)
+                {
+                    return 0;
+                }
+                last->bytes        = grown;
+                last->byteCapacity = newCapacity;
+            }
+
+            last->byteLength += (int) encodeVarint((unsigned int) (patientId - last->lastId),
+                                                   last->bytes + last->byteLength);
+            last->lastId = patientId;
+            last->count++;
+            list->totalIds++;
+            return 1;
+        }
+    }
+
+    int blockIndex = list->blockCount == 0 || patientId > list->blocks[list->blockCount - 1].lastId
+                             ? list->blockCount
+                             : findBlock(list, patientId);
+
+    if(blockIndex == list->blockCount)
+    {
+        // Start a new block at the end of the list
+        if(list->blockCount == list->blockCapacity)
+        {
+            int           newCapacity = list->blockCapacity == 0 ? 1 : list->blockCapacity * 2;
+            PostingBlock *grown       = realloc(list->blocks, sizeof(PostingBlock) * (size_t) newCapacity);
+            if(grown == NULL)
+            {
+                return 0;
+            }
+            list->blocks        = grown;
+            list->blockCapacity = newCapacity;
+        }
+
+        PostingBlock *block = &list->blocks[list->blockCount];
+        memset(block, 0, sizeof(PostingBlock));
+        if(!encodeBlock(block, &patientId, 1))
+        {
+            return 0;
+        }
+        list->blockCount++;
+        list->totalIds++;
+        return 1;
+    }
+
+    int ids[POSTING_BLOCK_SIZE + 1];
+    int count    = decodeBlock(&list->blocks[blockIndex], ids);
+    int position = 0;
+
+    while(position < count && ids[position] < patientId)
+    {
+        position++;
+    }
+    if(position < count && ids[position] == patientId)
+    {
+        return 1;
+    }
+
+    memmove(ids + position + 1, ids + position, sizeof(int) * (size_t) (count - position));
+    ids[position] = patientId;
+    count++;
+
+    if(count <= POSTING_BLOCK_SIZE)
+    {
+        if(!encodeBlock(&list->blocks[blockIndex], ids, count))
+        {
+            return 0;
+        }
+        list->totalIds++;
+        return 1;
+    }
+
+    // Split the overflowing block in two
+    if(list->blockCount == list->blockCapacity)
+    {
+        int           newCapacity = list->blockCapacity * 2;
+        PostingBlock *grown       = realloc(list->blocks, sizeof(PostingBlock) * (size_t) newCapacity);
+        if(grown == NULL)
+        {
+            return 0;
+        }
+        list->blocks        = grown;
+        list->blockCapacity = newCapacity;
+    }
+
+    memmove(&list->blocks[blockIndex + 2], &list->blocks[blockIndex + 1],
+            sizeof(PostingBlock) * (size_t) (list->blockCount - blockIndex - 1));
+    memset(&list->blocks[blockIndex + 1], 0, sizeof(PostingBlock));
+    list->blockCount++;
+
+    int half = count / 2;
+    if(!encodeBlock(&list->blocks[blockIndex], ids, half) ||
+       !encodeBlock(&list->blocks[blockIndex + 1], ids + half, count - half))
+    {
+        return 0;
+    }
+
+    list->totalIds++;
+    return 1;
+}
+
+/*
+ * Removes an ID from a posting list, dropping its block if it empties.
+ */
+static void postingRemove(PostingList *list, int patientId)
+{
+    if(list->blockCount == 0)
+    {
+        return;
+    }
+
+    int           blockIndex = findBlock(list, patientId);
+    PostingBlock *block      = &list->blocks[blockIndex];
+    if(patientId < block->firstId || patientId > block->lastId)
+    {
+        return;
+    }
+
+    int ids[POSTING_BLOCK_SIZE];
+    int count    = decodeBlock(block, ids);
+    int position = 0;
+
+    while(position < count && ids[position] != patientId)
+    {
+        position++;
+    }
+    if(position == count)
+    {
+        return;
+    }
+
+    memmove(ids + position, ids + position + 1, sizeof(int) * (size_t) (count - position - 1));
+    count--;
+    list->totalIds--;
+
+    if(count > 0)
+    {
+        encodeBlock(block, ids, count);
+        return;
+    }
+
+    free(block->bytes);
+    memmove(&list->blocks[blockIndex], &list->blocks[blockIndex + 1],
+            sizeof(PostingBlock) * (size_t) (list->blockCount - blockIndex - 1));
+    list->blockCount--;
+}
+
+/*
+ * Frees all blocks of a posting list and leaves it empty.
+ */
+static void freePostingList(PostingList *list)
+{
+    for(int i = 0; i < list->blockCount; i++)
+    {
+        free(list->blocks[i].bytes);
+    }
+    free(list->blocks);
+    memset(list, 0, sizeof(PostingList));
+}
+
+/*
+ * Positions a cursor on the first ID of a posting list.
+ */
+static void cursorOpenList(PostingCursor *cursor, const PostingList *list)
+{
+    cursor->list       = list;
+    cursor->values     = cursor->decoded;
+    cursor->valueCount = 0;
+    cursor->position   = 0;
+    cursor->blockIndex = list->blockCount;
+
+    if(list->blockCount > 0)
+    {
+        cursorLoadBlock(cursor, 0);
+    }
+}
+
+/*
+ * Positions a cursor on the first ID of a plain ascending array.
+ */
+static void cursorOpenArray(PostingCursor *cursor, const int ids[], int count)
+{
+    cursor->list       = NULL;
+    cursor->values     = ids;
+    cursor->valueCount = count;
+    cursor->position   = 0;
+    cursor->blockIndex = 0;
+}
+
+/*
+ * Decodes a block of the cursor's list and moves to its first ID.
+ */
+static void cursorLoadBlock(PostingCursor *cursor, int blockIndex)
+{
+    cursor->blockIndex = blockIndex;
+    cursor->valueCount = decodeBlock(&cursor->list->blocks[blockIndex], cursor->decoded);
+    cursor->position   = 0;
+}
+
+/*
+ * Returns the ID under the cursor, or CURSOR_END when exhausted.
+ */
+static int cursorCurrent(const PostingCursor *cursor)
+{
+    return cursor->position < cursor->valueCount ? cursor->values[cursor->position] : CURSOR_END;
+}
+
+/*
+ * Moves the cursor to the following ID.
+ */
+static void cursorNext(PostingCursor *cursor)
+{
+    cursor->position++;
+
+    if(cursor->position >= cursor->valueCount && cursor->list != NULL &&
+       cursor->blockIndex + 1 < cursor->list->blockCount)
+    {
+        cursorLoadBlock(cursor, cursor->blockIndex + 1);
+    }
+}
+
+/*
+ * Moves the cursor to the first ID at or after target using galloping
+ * (exponential then binary) search, first over the block table and then
+ * within the decoded block. Returns the new current ID.
+ */
+static int cursorAdvanceTo(PostingCursor *cursor, int target)
+{
+    if(cursor->list != NULL &&
+       (cursor->valueCount == 0 || cursor->values[cursor->valueCount - 1] < target))
+    {
+        const PostingBlock *blocks     = cursor->list->blocks;
+        int                 blockCount = cursor->list->blockCount;
+        int                 low        = cursor->blockIndex + 1;
+        int                 high       = low;
+        int                 step       = 1;
+
+        while(high < blockCount && blocks[high].lastId < target)
+        {
+            low   = high + 1;
+            high += step;
+            step *= 2;
+        }
+        if(high >= blockCount)
+        {
+            high = blockCount - 1;
+        }
+        if(low > high)
+        {
+            cursor->blockIndex = blockCount;
+            cursor->valueCount = 0;
+            cursor->position   = 0;
+            return CURSOR_END;
+        }
+
+        while(low < high)
+        {
+            int middle = (low + high) / 2;
+            if(blocks[middle].lastId < target)
+            {
+                low = middle + 1;
+            }
+            else
+            {
+                high = middle;
+            }
+        }
+        cursorLoadBlock(cursor, low);
+    }
+
+    const int *values = cursor->values;
+    int        count  = cursor->valueCount;
+    int        low    = cursor->position;
+
+    if(low >= count || values[low] >= target)
+    {
+        return cursorCurrent(cursor);
+    }
+
+    int high = low + 1;
+    int step = 1;
+    while(high < count && values[high] < target)
+    {
+        low   = high;
+        high += step;
+        step *= 2;
+    }
+    if(high > count)
+    {
+        high = count;
+    }
+
+    low++;
+    while(low < high)
+    {
+        int middle = (low + high) / 2;
+        if(values[middle] < target)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    cursor->position = low;
+    return cursorCurrent(cursor);
+}
+
+/*
+ * Appends an ID to a growable list.
+ */
+static int idListAppend(IdList *list, int id)
+{
+    if(list->count == list->capacity)
+    {
+        int  newCapacity = list->capacity == 0 ? INITIAL_CAPACITY : list->capacity * 2;
+        int *grown       = realloc(list->ids, sizeof(int) * (size_t) newCapacity);
+        if(grown == NULL)
+        {
+            return 0;
+        }
+        list->ids      = grown;
+        list->capacity = newCapacity;
+    }
+
+    list->ids[list->count++] = id;
+    return 1;
+}
+
+/*
+ * Sorts a list and drops duplicate IDs.
+ */
+static void idListSortUnique(IdList *list)
+{
+    if(list->count < 2)
+    {
+        return;
+    }
+
+    qsort(list->ids, (size_t) list->count, sizeof(int), compareIds);
+
+    int unique = 1;
+    for(int i = 1; i < list->count; i++)
+    {
+        if(list->ids[i] != list->ids[unique - 1])
+        {
+            list->ids[unique++] = list->ids[i];
+        }
+    }
+    list->count = unique;
+}
+
+/*
+ * Collects the union of every posting list whose term starts with prefix.
+ */
+static int collectPrefix(int scope, const char prefix[], IdList *out)
+{
+    ensureSortedTerms();
+
+    size_t prefixLength = strlen(prefix);
+    int    low          = 0;
+    int    high         = sortedTermCount;
+
+    while(low < high)
+    {
+        int middle = (low + high) / 2;
+        if(strcmp(terms[sortedTermIds[middle]].text, prefix) < 0)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    int matchedTerms = 0;
+    for(int i = low; i < sortedTermCount && strncmp(terms[sortedTermIds[i]].text, prefix, prefixLength) == 0; i++)
+    {
+        const PostingList *list = &terms[sortedTermIds[i]].postings[scope];
+        int                ids[POSTING_BLOCK_SIZE];
+
+        for(int b = 0; b < list->blockCount; b++)
+        {
+            int count = decodeBlock(&list->blocks[b], ids);
+            for(int k = 0; k < count; k++)
+            {
+                if(!idListAppend(out, ids[k]))
+                {
+                    return 0;
+                }
+            }
+        }
+        matchedTerms++;
+    }
+
+    if(matchedTerms > 1)
+    {
+        idListSortUnique(out);
+    }
+    return 1;
+}
+
+/*
+ * Intersects the operands of one AND group and appends the matches to out.
+ * Operands are visited smallest first; the others leapfrog to each
+ * candidate with cursorAdvanceTo.
+ */
+static int evaluateGroup(int scope, QueryOperand operands[], int operandCount, IdList *out)
+{
+    PostingCursor *cursors     = malloc(sizeof(PostingCursor) * (size_t) operandCount);
+    IdList        *prefixLists = calloc((size_t) operandCount, sizeof(IdList));
+    int            sizes[MAX_QUERY_OPERANDS];
+    int            ok          = cursors != NULL && prefixLists != NULL;
+    int            empty       = 0;
+
+    for(int i = 0; ok && i < operandCount; i++)
+    {
+        if(operands[i].isPrefix)
+        {
+            ok = collectPrefix(scope, operands[i].text, &prefixLists[i]);
+            cursorOpenArray(&cursors[i], prefixLists[i].ids, prefixLists[i].count);
+            sizes[i] = prefixLists[i].count;
+        }
+        else
+        {
+            int termId = findTerm(operands[i].text);
+            if(termId == EMPTY_SLOT)
+            {
+                empty = 1;
+                break;
+            }
+            cursorOpenList(&cursors[i], &terms[termId].postings[scope]);
+            sizes[i] = terms[termId].postings[scope].totalIds;
+        }
+
+        if(sizes[i] == 0)
+        {
+            empty = 1;
+            break;
+        }
+    }
+
+    if(ok && !empty)
+    {
+        // Drive the intersection from the shortest list
+        int smallest = 0;
+        for(int i = 1; i < operandCount; i++)
+        {
+            if(sizes[i] < sizes[smallest])
+            {
+                smallest = i;
+            }
+        }
+        PostingCursor swap = cursors[0];
+        cursors[0]         = cursors[smallest];
+        cursors[smallest]  = swap;
+
+        // Cursors over decoded blocks point into themselves; fix after the swap
+        if(cursors[0].list != NULL)
+        {
+            cursors[0].values = cursors[0].decoded;
+        }
+        if(cursors[smallest].list != NULL)
+        {
+            cursors[smallest].values = cursors[smallest].decoded;
+        }
+
+        int candidate = cursorCurrent(&cursors[0]);
+        while(ok && candidate != CURSOR_END)
+        {
+            int matched = 1;
+            for(int i = 1; i < operandCount; i++)
+            {
+                int found = cursorAdvanceTo(&cursors[i], candidate);
+                if(found != candidate)
+                {
+                    matched   = 0;
+                    candidate = found;
+                    break;
+                }
+            }
+
+            if(matched)
+            {
+                ok = idListAppend(out, candidate);
+                cursorNext(&cursors[0]);
+                candidate = cursorCurrent(&cursors[0]);
+            }
+            else if(candidate != CURSOR_END)
+            {
+                candidate = cursorAdvanceTo(&cursors[0], candidate);
+            }
+        }
+    }
+
+    for(int i = 0; prefixLists != NULL && i < operandCount; i++)
+    {
+        free(prefixLists[i].ids);
+    }
+    free(prefixLists);
+    free(cursors);
+    return ok;
+}
+
+/*
+ * qsort comparator for patient IDs.
+ */
+static int compareIds(const void *a, const void *b)
+{
+    int left  = *(const int *) a;
+    int right = *(const int *) b;
+    return (left > right) - (left < right);
+}
+
+/*
+ * qsort comparator ordering term IDs by their text.
+ */
+static int compareTermText(const void *a, const void *b)
+{
+    return strcmp(terms[*(const int *) a].text, terms[*(const int *) b].text);
+}
+
+/*
+ * Re-sorts the vocabulary for prefix lookups when terms were added.
+ */
+static void ensureSortedTerms(void)
+{
+    if(sortedTermCount == termCount)
+    {
+        return;
+    }
+
+    int *grown = realloc(sortedTermIds, sizeof(int) * (size_t) termCount);
+    if(grown == NULL)
+    {
+        return;
+    }
+
+    sortedTermIds = grown;
+    for(int i = 0; i < termCount; i++)
+    {
+        sortedTermIds[i] = i;
+    }
+    qsort(sortedTermIds, (size_t) termCount, sizeof(int), compareTermText);
+    sortedTermCount = termCount;
+}
+
+/*
+ * Archive scan callback that indexes one discharged patient.
+ */
+static int indexDischargedRecord(const DischargedPatient *dischargedPatient, void *context)
+{
+    (void) context;
+    return addToDiagnosisIndex(INDEX_SCOPE_DISCHARGED,
+                               dischargedPatient->patient.patientId,
+                               dischargedPatient->patient.diagnosisId);
+}
+
+/*
+ * Pads a section out to SAVED_ALIGNMENT after length bytes.
+ */
+static int writePadding(FILE *file, size_t length)
+{
+    static const unsigned char zeros[SAVED_ALIGNMENT] = { 0 };
+    size_t                     padding                = (SAVED_ALIGNMENT - length % SAVED_ALIGNMENT) % SAVED_ALIGNMENT;
+
+    return fwrite(zeros, 1, padding, file) == padding;
+}
+
+/*
+ * Reads one saved term at *position, checking every length and ID bound
+ * against the section before using it, and advances past it.
+ */
+static int loadSavedTerm(int scope, const unsigned char *bytes, size_t length, size_t *position)
+{
+    SavedTerm saved;
+
+    if(length - *position < sizeof(saved))
+    {
+        return 0;
+    }
+    memcpy(&saved, bytes + *position, sizeof(saved));
+    *position += sizeof(saved);
+
+    size_t textSpace = ((size_t) saved.textLength + SAVED_ALIGNMENT - 1) / SAVED_ALIGNMENT * SAVED_ALIGNMENT;
+    if(saved.textLength < 2 || saved.textLength > MAX_DIAGNOSIS_LENGTH || saved.blockCount <= 0 ||
+       length - *position < textSpace || bytes[*position + (size_t) saved.textLength - 1] != '\0')
+    {
+        return 0;
+    }
+
+    int termId = addTerm((const char *) bytes + *position);
+    *position += textSpace;
+    if(termId == EMPTY_SLOT || terms[termId].postings[scope].blockCount > 0 ||
+       (length - *position) / sizeof(SavedBlock) < (size_t) saved.blockCount)
+    {
+        return 0;
+    }
+
+    PostingList *list = &terms[termId].postings[scope];
+    list->blocks      = calloc((size_t) saved.blockCount, sizeof(PostingBlock));
+    if(list->blocks == NULL)
+    {
+        return 0;
+    }
+    list->blockCapacity = saved.blockCount;
+
+    const unsigned char *savedBlocks = bytes + *position;
+    size_t               byteTotal   = 0;
+    *position += sizeof(SavedBlock) * (size_t) saved.blockCount;
+
+    for(int b = 0; b < saved.blockCount; b++)
+    {
+        SavedBlock    savedBlock;
+        PostingBlock *block = &list->blocks[b];
+        memcpy(&savedBlock, savedBlocks + sizeof(savedBlock) * (size_t) b, sizeof(savedBlock));
+
+        if(savedBlock.count <= 0 || savedBlock.count > POSTING_BLOCK_SIZE || savedBlock.byteLength < 0 ||
+           savedBlock.byteLength > savedBlock.count * MAX_VARINT_GAP_BYTES || savedBlock.firstId > savedBlock.lastId ||
+           (b > 0 && savedBlock.firstId <= list->blocks[b - 1].lastId) ||
+           length - *position - byteTotal < (size_t) savedBlock.byteLength)
+        {
+            return 0;
+        }
+
+        block->bytes = malloc((size_t) savedBlock.byteLength + MAX_VARINT_GAP_BYTES);
+        if(block->bytes == NULL)
+        {
+            return 0;
+        }
+        memcpy(block->bytes, bytes + *position + byteTotal, (size_t) savedBlock.byteLength);
+        block->firstId      = savedBlock.firstId;
+        block->lastId       = savedBlock.lastId;
+        block->count        = savedBlock.count;
+        block->byteLength   = savedBlock.byteLength;
+        block->byteCapacity = savedBlock.byteLength + MAX_VARINT_GAP_BYTES;
+        list->blockCount++;
+        list->totalIds += savedBlock.count;
+        byteTotal      += (size_t) savedBlock.byteLength;
+    }
+
+    size_t byteSpace = (byteTotal + SAVED_ALIGNMENT - 1) / SAVED_ALIGNMENT * SAVED_ALIGNMENT;
+    if(list->totalIds != saved.totalIds || length - *position < byteSpace)
+    {
+        return 0;
+    }
+    *position += byteSpace;
+    return 1;
+}
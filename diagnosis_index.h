@@ -0,0 +1,111 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the in-memory inverted index over diagnosis text.
+ *          Diagnoses are split into lower-case word terms, and each term keeps
+ *          a compressed, sorted posting list of patient IDs for active and for
+ *          discharged patients.
+ *
+ *          Queries are whitespace-separated terms. Terms are ANDed together,
+ *          OR separates alternatives (AND binds tighter), and a trailing '*'
+ *          matches every term with that prefix, e.g. "viral pneu* OR flu".
+ */
+
+#ifndef DIAGNOSIS_INDEX_H
+#define DIAGNOSIS_INDEX_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+// Index scopes
+#define INDEX_SCOPE_ACTIVE 0
+#define INDEX_SCOPE_DISCHARGED 1
+#define INDEX_SCOPE_COUNT 2
+
+#define INDEX_SUCCESS 1
+#define INDEX_FAILURE 0
+
+/*
+ * Function: initializeDiagnosisIndex
+ * ----------------------------------
+ * Clears the index and indexes every patient in the discharge archive.
+ * Active patients are indexed as they are loaded or admitted.
+ */
+void initializeDiagnosisIndex(void);
+
+/*
+ * Function: addToDiagnosisIndex
+ * -----------------------------
+ * Adds a patient to the posting lists of every term in their diagnosis.
+ *
+ * scope: INDEX_SCOPE_ACTIVE or INDEX_SCOPE_DISCHARGED
+ * patientId: The patient's ID
+ * diagnosisId: The patient's interned diagnosis ID
+ *
+ * Returns: INDEX_SUCCESS, or INDEX_FAILURE on allocation failure
+ */
+int addToDiagnosisIndex(int scope, int patientId, int diagnosisId);
+
+/*
+ * Function: removeFromDiagnosisIndex
+ * ----------------------------------
+ * Removes a patient from the posting lists of their diagnosis terms.
+ */
+void removeFromDiagnosisIndex(int scope, int patientId, int diagnosisId);
+
+/*
+ * Function: queryDiagnosisIndex
+ * -----------------------------
+ * Evaluates a query against one scope.
+ *
+ * scope: INDEX_SCOPE_ACTIVE or INDEX_SCOPE_DISCHARGED
+ * query: The query text
+ * patientIds: Receives a malloc'd, ascending array of matching IDs, which
+ *             the caller must free (NULL when there are no matches)
+ * matchCount: Receives the number of matching IDs
+ *
+ * Returns: INDEX_SUCCESS, or INDEX_FAILURE on an empty query or
+ *          allocation failure
+ */
+int queryDiagnosisIndex(int scope, const char query[], int **patientIds, int *matchCount);
+
+/*
+ * Function: clearDiagnosisIndexScope
+ * ----------------------------------
+ * Empties every posting list of one scope, keeping the vocabulary.
+ */
+void clearDiagnosisIndexScope(int scope);
+
+/*
+ * Function: saveDiagnosisIndexScope
+ * ---------------------------------
+ * Writes one scope's posting lists as a checkpoint section (see
+ * store_checkpoint.h), keeping their compressed blocks as they are.
+ *
+ * Returns: INDEX_SUCCESS, or INDEX_FAILURE on a write error
+ */
+int saveDiagnosisIndexScope(int scope, FILE *file);
+
+/*
+ * Function: loadDiagnosisIndexScope
+ * ---------------------------------
+ * Replaces one scope's posting lists with those written by
+ * saveDiagnosisIndexScope, copying each block's bytes rather than
+ * re-inserting its IDs.
+ *
+ * section: The saved scope, typically inside a mapped checkpoint
+ * length: The section's length in bytes
+ *
+ * Returns: INDEX_SUCCESS, or INDEX_FAILURE (leaving the scope empty) if the
+ *          section is malformed or memory runs out
+ */
+int loadDiagnosisIndexScope(int scope, const void *section, size_t length);
+
+/*
+ * Function: clearDiagnosisIndex
+ * -----------------------------
+ * Frees all memory used by the diagnosis index.
+ */
+void clearDiagnosisIndex(void);
+
+#endif // DIAGNOSIS_INDEX_H
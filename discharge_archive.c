@@ -0,0 +1,983 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the block-compressed discharge archive.
+ *
+ *          Only the last (tail) block is ever modified. It stays uncompressed
+ *          while records are appended to it and is sealed once full. Sealed
+ *          blocks are never rewritten, so block offsets are stable.
+ *
+ *          Sealing compresses the tail block in two synced steps. The
+ *          compressed block is first staged just past the raw one, where it
+ *          overwrites nothing; then it is copied over the raw payload and
+ *          header, and the file truncated behind it. Until the copy is
+ *          synced, the staged block is a complete copy of the tail, so a
+ *          crash at any point leaves either the raw records or the staged
+ *          block intact. The next append finishes an interrupted seal, and
+ *          scans read the staged block in the meantime.
+ *
+ *          Scans read the archive through a read-only mapping, advised as
+ *          sequential and prefetched a window ahead, and decode records
+ *          straight out of it: sealed blocks are never copied, and
+ *          uncompressed ones are decoded in place. Only the last two blocks'
+ *          worth of the mapping, where the tail block and its staged copy
+ *          may still be rewritten and truncated by an append, are read with
+ *          pread instead, since touching a truncated page would fault.
+ */
+
+#define _GNU_SOURCE // madvise, pread
+
+#include "discharge_archive.h"
+#include <limits.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include "durable_file.h"
+#include "lz_codec.h"
+#include "patient_storage.h"
+
+// Private constants
+#define BLOCK_HEADER_SIZE 32
+#define BLOCK_SEALED 0x01
+#define BLOCK_COMPRESSED 0x02
+#define PREFETCH_WINDOW (4 * ARCHIVE_BLOCK_SIZE) // Bytes asked for ahead of the scan
+
+static const unsigned char BLOCK_MAGIC[2] = { 'B', 'K' };
+
+/*
+ * In-memory form of a block header. On disk the layout is:
+ * magic[2], flags[1], reserved[1], recordCount[4], rawLength[4],
+ * storedLength[4], minDischarge[8], maxDischarge[8], all little-endian.
+ */
+typedef struct
+{
+    int          flags;
+    unsigned int recordCount;
+    unsigned int rawLength;    // Uncompressed payload size
+    unsigned int storedLength; // Payload size on disk
+    time_t       minDischarge;
+    time_t       maxDischarge;
+} BlockHeader;
+
+/*
+ * A read-only mapping of the archive for scans.
+ */
+typedef struct
+{
+    FILE                *file;
+    int                  fd;
+    const unsigned char *memory;
+    long                 size;         // Bytes mapped
+    long                 stableEnd;    // Block headers before this are read in place
+    long                 prefetchedTo; // End of the range already asked for
+    RecordFileHeader     header;
+} ArchiveView;
+
+/*
+ * One block's payload as a scan sees it: in the mapping where possible,
+ * otherwise in scratch buffers owned by the scan.
+ */
+typedef struct
+{
+    unsigned char *stored;
+    unsigned char *raw;
+    size_t         storedCapacity;
+    size_t         rawCapacity;
+} BlockScratch;
+
+// Location of the tail block from the last append, reused while the file
+// size is unchanged so appends need not walk every block header
+static long        cachedFileEnd    = -1;
+static long        cachedTailOffset = -1;
+static BlockHeader cachedTail;
+
+// Held for writing while an append changes the tail block, and for reading
+// while a scan or lookup reads a block near the end of the file, so no
+// reader sees a tail half sealed or a staged copy being truncated
+static pthread_rwlock_t tailLock = PTHREAD_RWLOCK_INITIALIZER;
+
+// Function prototypes for internal helper functions
+static int  readBlockHeader(FILE *file, BlockHeader *block);
+static int  parseBlockHeader(const unsigned char bytes[], BlockHeader *block);
+static int  openArchiveView(ArchiveView *view);
+static void closeArchiveView(ArchiveView *view);
+static int  viewBlockHeader(ArchiveView *view, long offset, BlockHeader *block);
+static const unsigned char *viewBlockPayload(ArchiveView *view, long offset, const BlockHeader *block,
+                                             BlockScratch *scratch);
+static int  writeBlockHeaderAt(FILE *file, long offset, const BlockHeader *block);
+static int  findTailBlock(FILE *file, long fileEnd, long *tailOffset, BlockHeader *tail, long *dataEnd);
+static int  flushPendingRecords(FILE *file, long tailOffset, const BlockHeader *tail,
+                                const unsigned char pending[], size_t pendingLength);
+static int  sealBlock(FILE *file, long offset, BlockHeader *block);
+static int  commitSeal(FILE *file, long offset, const BlockHeader *sealed, const unsigned char stored[]);
+static int  resumeSeal(FILE *file, long offset, BlockHeader *block, long fileEnd);
+static int  readStagedSeal(int fd, long offset, const BlockHeader *block, BlockHeader *staged);
+static int  ensureCapacity(unsigned char **buffer, size_t *capacity, size_t required);
+static int  scanArchive(long startOffset, long endOffset, time_t fromTime, time_t toTime,
+                        DischargeLocationVisitor visitor, void *context);
+static int  sumMatchingBlocks(ArchiveView *view, time_t fromTime, time_t toTime, long *totalBytes);
+static int  blockOverlaps(const BlockHeader *block, time_t fromTime, time_t toTime);
+static int  visitWithoutLocation(const DischargedPatient *dischargedPatient,
+                                 const ArchiveLocation *location,
+                                 void *context);
+
+/*
+ * Adapts a plain DischargeVisitor to the location-aware scan.
+ */
+typedef struct
+{
+    DischargeVisitor visitor;
+    void            *context;
+} PlainScan;
+
+/*
+ * Appends records to the tail block, starting new blocks as each fills.
+ */
+int appendDischargedPatients(const DischargedPatient records[], int count, ArchiveLocation locations[])
+{
+    if(count <= 0)
+    {
+        return ARCHIVE_SUCCESS;
+    }
+
+    FILE *file = fopen(ARCHIVE_FILE, "r+b");
+    if(file == NULL)
+    {
+        file = fopen(ARCHIVE_FILE, "w+b");
+    }
+    if(file == NULL)
+    {
+        perror("Error opening discharged_patients.dat");
+        return ARCHIVE_FAILURE;
+    }
+
+    pthread_rwlock_wrlock(&tailLock);
+
+    RecordFileHeader header;
+    BlockHeader      tail;
+    long             tailOffset = -1;
+    long             dataEnd    = RECORD_HEADER_SIZE;
+    int              hasTail    = 0;
+
+    fseek(file, 0, SEEK_END);
+    long fileEnd = ftell(file);
+
+    if(fileEnd == 0)
+    {
+        header.baseId   = records[0].patient.patientId;
+        header.baseTime = time(NULL);
+        if(!writeRecordFileHeader(file, ARCHIVE_FILE_MAGIC, &header))
+        {
+            perror("Error writing discharged_patients.dat");
+            pthread_rwlock_unlock(&tailLock);
+            fclose(file);
+            return ARCHIVE_FAILURE;
+        }
+    }
+    else
+    {
+        rewind(file);
+        if(!readRecordFileHeader(file, ARCHIVE_FILE_MAGIC, &header))
+        {
+            fprintf(stderr, "Error: discharged_patients.dat is not in the expected format.\n");
+            pthread_rwlock_unlock(&tailLock);
+            fclose(file);
+            return ARCHIVE_FAILURE;
+        }
+        hasTail = findTailBlock(file, fileEnd, &tailOffset, &tail, &dataEnd);
+
+        // Anything past the last block is left over from a seal or append
+        // a crash interrupted
+        if(hasTail && dataEnd < fileEnd && !resumeSeal(file, tailOffset, &tail, fileEnd))
+        {
+            perror("Error recovering discharged_patients.dat");
+            pthread_rwlock_unlock(&tailLock);
+            fclose(file);
+            return ARCHIVE_FAILURE;
+        }
+    }
+
+    unsigned char *pending = malloc(ARCHIVE_BLOCK_SIZE);
+    size_t         pendingLength = 0;
+    int            ok            = pending != NULL;
+
+    for(int i = 0; ok && i < count; i++)
+    {
+        unsigned char encoded[MAX_ENCODED_RECORD_SIZE + 16];
+        size_t        length = encodePatientRecord(&header,
+                                                   &records[i].patient,
+                                                   1,
+                                                   records[i].dischargeDate,
+                                                   encoded);
+
+        // Start a new block when the tail is sealed or would overflow
+        if(!hasTail || (tail.flags & BLOCK_SEALED) || tail.rawLength + length > ARCHIVE_BLOCK_SIZE)
+        {
+            if(hasTail && !(tail.flags & BLOCK_SEALED))
+            {
+                ok = flushPendingRecords(file, tailOffset, &tail, pending, pendingLength) &&
+                     sealBlock(file, tailOffset, &tail);
+                pendingLength = 0;
+            }
+            if(hasTail)
+            {
+                dataEnd = tailOffset + BLOCK_HEADER_SIZE + (long) tail.storedLength;
+            }
+
+            tailOffset = dataEnd;
+            tail       = (BlockHeader) { 0, 0, 0, 0, records[i].dischargeDate, records[i].dischargeDate };
+            hasTail    = 1;
+        }
+
+        if(locations != NULL)
+        {
+            locations[i].blockOffset  = tailOffset;
+            locations[i].recordOffset = tail.rawLength;
+        }
+
+        memcpy(pending + pendingLength, encoded, length);
+        pendingLength += length;
+
+        tail.recordCount++;
+        tail.rawLength   += (unsigned int) length;
+        tail.storedLength = tail.rawLength;
+        if(records[i].dischargeDate < tail.minDischarge)
+        {
+            tail.minDischarge = records[i].dischargeDate;
+        }
+        if(records[i].dischargeDate > tail.maxDischarge)
+        {
+            tail.maxDischarge = records[i].dischargeDate;
+        }
+    }
+
+    if(ok)
+    {
+        ok = flushPendingRecords(file, tailOffset, &tail, pending, pendingLength);
+    }
+
+    // Seal as soon as another record may not fit
+    if(ok && tail.rawLength + MAX_ENCODED_RECORD_SIZE > ARCHIVE_BLOCK_SIZE)
+    {
+        ok = sealBlock(file, tailOffset, &tail);
+    }
+
+    free(pending);
+
+    // Readers only need the bytes in the file, not on disk
+    ok = ok && fflush(file) == 0;
+    pthread_rwlock_unlock(&tailLock);
+
+    // Discharged patients leave patients.dat next, so they must be safe here first
+    ok = ok && syncFile(fileno(file), ARCHIVE_FILE);
+
+    if(fclose(file) != 0 || !ok)
+    {
+        perror("Error writing to discharged_patients.dat");
+        cachedFileEnd = -1;
+        return ARCHIVE_FAILURE;
+    }
+
+    cachedTailOffset = tailOffset;
+    cachedTail       = tail;
+    cachedFileEnd    = tailOffset + BLOCK_HEADER_SIZE + (long) tail.storedLength;
+
+    return ARCHIVE_SUCCESS;
+}
+
+/*
+ * Visits every record in blocks that overlap the requested time range.
+ */
+int scanDischargeArchive(time_t fromTime,
+                         time_t toTime,
+                         DischargeVisitor visitor,
+                         void *context)
+{
+    PlainScan scan = { visitor, context };
+    return scanArchive(RECORD_HEADER_SIZE, LONG_MAX, fromTime, toTime, visitWithoutLocation, &scan);
+}
+
+/*
+ * Visits every record with its location.
+ */
+int scanDischargeLocations(DischargeLocationVisitor visitor, void *context)
+{
+    return scanArchive(RECORD_HEADER_SIZE, LONG_MAX, ARCHIVE_BEGINNING_OF_TIME, ARCHIVE_END_OF_TIME,
+                       visitor, context);
+}
+
+/*
+ * Walks the block headers twice: once to total the stored bytes of the
+ * blocks in range, then again to cut them into runs of about equal size.
+ * Only headers are read, in place in the mapping.
+ */
+int splitDischargeArchive(time_t fromTime, time_t toTime, ArchiveChunk chunks[], int maxChunks)
+{
+    ArchiveView view;
+    if(!openArchiveView(&view))
+    {
+        return 0;
+    }
+
+    long totalBytes;
+    if(maxChunks <= 0 || !sumMatchingBlocks(&view, fromTime, toTime, &totalBytes) || totalBytes == 0)
+    {
+        closeArchiveView(&view);
+        return 0;
+    }
+
+    BlockHeader block;
+    long        blockOffset = RECORD_HEADER_SIZE;
+    long        bytesSoFar  = 0;
+    int         chunkCount  = 0;
+
+    while(viewBlockHeader(&view, blockOffset, &block))
+    {
+        long nextOffset = blockOffset + BLOCK_HEADER_SIZE + (long) block.storedLength;
+
+        if(blockOverlaps(&block, fromTime, toTime))
+        {
+            // Open a chunk at the first block in range after the last cut
+            if(chunkCount == 0 || chunks[chunkCount - 1].endOffset != LONG_MAX)
+            {
+                chunks[chunkCount].startOffset = blockOffset;
+                chunks[chunkCount].endOffset   = LONG_MAX;
+                chunkCount++;
+            }
+
+            // Close it once it holds its share of the bytes
+            bytesSoFar += (long) block.storedLength;
+            if(chunkCount < maxChunks && bytesSoFar >= totalBytes / maxChunks * chunkCount)
+            {
+                chunks[chunkCount - 1].endOffset = nextOffset;
+            }
+        }
+
+        // Only the tail block can be unsealed, and a staged seal may follow it
+        if(!(block.flags & BLOCK_SEALED))
+        {
+            break;
+        }
+        blockOffset = nextOffset;
+    }
+
+    closeArchiveView(&view);
+    return chunkCount;
+}
+
+/*
+ * Visits the records of one chunk, with its own file handle.
+ */
+int scanDischargeChunk(const ArchiveChunk *chunk,
+                       time_t fromTime,
+                       time_t toTime,
+                       DischargeVisitor visitor,
+                       void *context)
+{
+    PlainScan scan = { visitor, context };
+    return scanArchive(chunk->startOffset, chunk->endOffset, fromTime, toTime, visitWithoutLocation, &scan);
+}
+
+/*
+ * Seeks once to the record's block. An uncompressed block is read from the
+ * record onwards; a compressed one has to be read and decompressed whole.
+ */
+int readDischargedPatientAt(const ArchiveLocation *location, DischargedPatient *record)
+{
+    FILE *file = fopen(ARCHIVE_FILE, "rb");
+    if(file == NULL)
+    {
+        return ARCHIVE_FAILURE;
+    }
+
+    // The record may be in the tail block, which an append could be sealing
+    pthread_rwlock_rdlock(&tailLock);
+
+    RecordFileHeader header;
+    BlockHeader      block;
+    unsigned char   *stored = NULL;
+    unsigned char   *raw    = NULL;
+    int              ok     = readRecordFileHeader(file, ARCHIVE_FILE_MAGIC, &header) &&
+                              fseek(file, location->blockOffset, SEEK_SET) == 0 &&
+                              readBlockHeader(file, &block) &&
+                              location->recordOffset < block.rawLength;
+
+    const unsigned char *payload       = NULL;
+    size_t               payloadLength = 0;
+
+    if(ok && (block.flags & BLOCK_COMPRESSED))
+    {
+        stored = malloc(block.storedLength);
+        raw    = malloc(block.rawLength);
+        ok     = stored != NULL && raw != NULL &&
+                 fread(stored, 1, block.storedLength, file) == block.storedLength &&
+                 lzDecompress(stored, block.storedLength, raw, block.rawLength);
+
+        payload       = raw + location->recordOffset;
+        payloadLength = block.rawLength - location->recordOffset;
+    }
+    else if(ok)
+    {
+        // The record and its length prefix fit in one maximum-size read
+        payloadLength = block.rawLength - location->recordOffset;
+        if(payloadLength > MAX_ENCODED_RECORD_SIZE + 16)
+        {
+            payloadLength = MAX_ENCODED_RECORD_SIZE + 16;
+        }
+
+        raw = malloc(payloadLength);
+        ok  = raw != NULL &&
+              fseek(file, (long) location->recordOffset, SEEK_CUR) == 0 &&
+              fread(raw, 1, payloadLength, file) == payloadLength;
+
+        payload = raw;
+    }
+
+    if(ok)
+    {
+        unsigned long long recordLength;
+        size_t             position = 0;
+
+        ok = decodeVarint(payload, payloadLength, &position, &recordLength) &&
+             recordLength <= payloadLength - position &&
+             decodePatientRecord(&header, payload + position, (size_t) recordLength, 1,
+                                 &record->patient, &record->dischargeDate);
+    }
+
+    pthread_rwlock_unlock(&tailLock);
+    free(stored);
+    free(raw);
+    fclose(file);
+
+    return ok ? ARCHIVE_SUCCESS : ARCHIVE_FAILURE;
+}
+
+/*
+ * Walks the blocks from startOffset up to endOffset that overlap the time
+ * range, decoding each record straight from the block's payload and
+ * passing it to the visitor with its location.
+ */
+static int scanArchive(long startOffset, long endOffset, time_t fromTime, time_t toTime,
+                       DischargeLocationVisitor visitor, void *context)
+{
+    ArchiveView view;
+    if(!openArchiveView(&view))
+    {
+        return ARCHIVE_FAILURE;
+    }
+
+    BlockScratch scratch      = { NULL, NULL, 0, 0 };
+    int          keepScanning = 1;
+    BlockHeader  block;
+    long         blockOffset  = startOffset;
+
+    while(keepScanning && blockOffset < endOffset && viewBlockHeader(&view, blockOffset, &block))
+    {
+        ArchiveLocation      location = { blockOffset, 0 };
+        const unsigned char *payload  = NULL;
+        int                  nearEnd  = blockOffset > view.stableEnd;
+
+        // Blocks near the end may be mid-seal, so read them again under the
+        // lock; their payloads land in scratch, which no append can touch
+        if(nearEnd)
+        {
+            pthread_rwlock_rdlock(&tailLock);
+            if(!viewBlockHeader(&view, blockOffset, &block))
+            {
+                pthread_rwlock_unlock(&tailLock);
+                break;
+            }
+        }
+
+        int overlaps = blockOverlaps(&block, fromTime, toTime);
+        if(overlaps)
+        {
+            payload = viewBlockPayload(&view, blockOffset, &block, &scratch);
+        }
+        if(nearEnd)
+        {
+            pthread_rwlock_unlock(&tailLock);
+        }
+
+        blockOffset += BLOCK_HEADER_SIZE + (long) block.storedLength;
+
+        if(overlaps && payload == NULL)
+        {
+            if(block.flags & BLOCK_COMPRESSED)
+            {
+                fprintf(stderr, "Warning: Skipping corrupt block in discharged_patients.dat\n");
+                continue;
+            }
+            break;
+        }
+
+        size_t position = 0;
+        for(unsigned int i = 0; overlaps && i < block.recordCount && keepScanning; i++)
+        {
+            unsigned long long recordLength;
+            DischargedPatient  record;
+
+            location.recordOffset = (unsigned int) position;
+            if(!decodeVarint(payload, block.rawLength, &position, &recordLength) ||
+               recordLength > block.rawLength - position ||
+               !decodePatientRecord(&view.header, payload + position, (size_t) recordLength, 1,
+                                    &record.patient, &record.dischargeDate))
+            {
+                break;
+            }
+            position += (size_t) recordLength;
+
+            keepScanning = visitor(&record, &location, context);
+        }
+
+        // Only the tail block can be unsealed, and nothing follows it yet
+        if(!(block.flags & BLOCK_SEALED))
+        {
+            break;
+        }
+    }
+
+    free(scratch.stored);
+    free(scratch.raw);
+    closeArchiveView(&view);
+
+    return ARCHIVE_SUCCESS;
+}
+
+/*
+ * Totals the stored bytes of the blocks overlapping the time range,
+ * reading only block headers.
+ */
+static int sumMatchingBlocks(ArchiveView *view, time_t fromTime, time_t toTime, long *totalBytes)
+{
+    BlockHeader block;
+    long        offset = RECORD_HEADER_SIZE;
+
+    *totalBytes = 0;
+    while(viewBlockHeader(view, offset, &block))
+    {
+        if(blockOverlaps(&block, fromTime, toTime))
+        {
+            *totalBytes += (long) block.storedLength;
+        }
+        if(!(block.flags & BLOCK_SEALED))
+        {
+            break;
+        }
+        offset += BLOCK_HEADER_SIZE + (long) block.storedLength;
+    }
+
+    return 1;
+}
+
+/*
+ * Reads the archive's file header and maps the whole archive read-only.
+ */
+static int openArchiveView(ArchiveView *view)
+{
+    struct stat status;
+
+    memset(view, 0, sizeof(ArchiveView));
+    view->file = fopen(ARCHIVE_FILE, "rb");
+    if(view->file == NULL)
+    {
+        return 0;
+    }
+    view->fd = fileno(view->file);
+
+    void *memory = MAP_FAILED;
+    if(readRecordFileHeader(view->file, ARCHIVE_FILE_MAGIC, &view->header) && fstat(view->fd, &status) == 0)
+    {
+        memory = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_SHARED, view->fd, 0);
+    }
+    if(memory == MAP_FAILED)
+    {
+        fclose(view->file);
+        return 0;
+    }
+    madvise(memory, (size_t) status.st_size, MADV_SEQUENTIAL);
+
+    view->memory    = memory;
+    view->size      = (long) status.st_size;
+    view->stableEnd = view->size - 2 * (BLOCK_HEADER_SIZE + ARCHIVE_BLOCK_SIZE);
+    return 1;
+}
+
+/*
+ * Unmaps the archive and closes it.
+ */
+static void closeArchiveView(ArchiveView *view)
+{
+    if(view->memory != NULL)
+    {
+        munmap((void *) view->memory, (size_t) view->size);
+    }
+    fclose(view->file);
+    memset(view, 0, sizeof(ArchiveView));
+}
+
+/*
+ * Reads the block header at an offset: in place within the stable part of
+ * the mapping, with pread near the end of the file. Asks for the next
+ * window of the file whenever the scan gets within a window of the end of
+ * the last one. Returns 1 on success, 0 past the last block.
+ */
+static int viewBlockHeader(ArchiveView *view, long offset, BlockHeader *block)
+{
+    unsigned char bytes[BLOCK_HEADER_SIZE];
+
+    if(offset <= view->stableEnd)
+    {
+        if(offset + PREFETCH_WINDOW > view->prefetchedTo && view->prefetchedTo < view->size)
+        {
+            long pageSize = sysconf(_SC_PAGESIZE);
+            long start    = (offset > view->prefetchedTo ? offset : view->prefetchedTo) / pageSize * pageSize;
+            long end      = start + 2 * PREFETCH_WINDOW < view->size ? start + 2 * PREFETCH_WINDOW : view->size;
+
+            madvise((void *) (view->memory + start), (size_t) (end - start), MADV_WILLNEED);
+            view->prefetchedTo = end;
+        }
+        return parseBlockHeader(view->memory + offset, block);
+    }
+
+    return pread(view->fd, bytes, BLOCK_HEADER_SIZE, offset) == BLOCK_HEADER_SIZE && parseBlockHeader(bytes, block);
+}
+
+/*
+ * Returns a block's uncompressed payload. A sealed block lies wholly
+ * within the file for good, so its stored bytes are used from the mapping;
+ * the unsealed tail is read into scratch. Compressed payloads are expanded
+ * into scratch. A block near the end that is followed by its staged seal
+ * is read from the staged copy, since its own payload may be half
+ * overwritten. Returns NULL if the block cannot be read or decompressed.
+ */
+static const unsigned char *viewBlockPayload(ArchiveView *view, long offset, const BlockHeader *block,
+                                             BlockScratch *scratch)
+{
+    long                 payloadOffset = offset + BLOCK_HEADER_SIZE;
+    const unsigned char *stored;
+    BlockHeader          staged;
+
+    if(offset > view->stableEnd && readStagedSeal(view->fd, offset, block, &staged) &&
+       ensureCapacity(&scratch->stored, &scratch->storedCapacity, staged.storedLength) &&
+       ensureCapacity(&scratch->raw, &scratch->rawCapacity, staged.rawLength) &&
+       pread(view->fd, scratch->stored, staged.storedLength, payloadOffset + (long) block->rawLength +
+             BLOCK_HEADER_SIZE) == (ssize_t) staged.storedLength &&
+       lzDecompress(scratch->stored, staged.storedLength, scratch->raw, staged.rawLength))
+    {
+        return scratch->raw;
+    }
+
+    if((block->flags & BLOCK_SEALED) && offset <= view->stableEnd &&
+       payloadOffset + (long) block->storedLength <= view->size)
+    {
+        stored = view->memory + payloadOffset;
+    }
+    else
+    {
+        if(!ensureCapacity(&scratch->stored, &scratch->storedCapacity, block->storedLength) ||
+           pread(view->fd, scratch->stored, block->storedLength, payloadOffset) != (ssize_t) block->storedLength)
+        {
+            return NULL;
+        }
+        stored = scratch->stored;
+    }
+
+    if(!(block->flags & BLOCK_COMPRESSED))
+    {
+        return stored;
+    }
+
+    if(!ensureCapacity(&scratch->raw, &scratch->rawCapacity, block->rawLength) ||
+       !lzDecompress(stored, block->storedLength, scratch->raw, block->rawLength))
+    {
+        return NULL;
+    }
+    return scratch->raw;
+}
+
+/*
+ * Checks whether a block holds records and its discharge time range
+ * overlaps [fromTime, toTime].
+ */
+static int blockOverlaps(const BlockHeader *block, time_t fromTime, time_t toTime)
+{
+    return block->recordCount > 0 && block->maxDischarge >= fromTime && block->minDischarge <= toTime;
+}
+
+/*
+ * Forwards a record to a plain DischargeVisitor.
+ */
+static int visitWithoutLocation(const DischargedPatient *dischargedPatient,
+                                const ArchiveLocation *location,
+                                void *context)
+{
+    const PlainScan *scan = context;
+
+    (void) location;
+    return scan->visitor(dischargedPatient, scan->context);
+}
+
+/*
+ * Reads and validates the block header at the current position.
+ * Returns 1 on success, 0 at end of file or on a damaged header.
+ */
+static int readBlockHeader(FILE *file, BlockHeader *block)
+{
+    unsigned char bytes[BLOCK_HEADER_SIZE];
+
+    return fread(bytes, 1, BLOCK_HEADER_SIZE, file) == BLOCK_HEADER_SIZE && parseBlockHeader(bytes, block);
+}
+
+/*
+ * Decodes and validates an on-disk block header.
+ * Returns 1 on success, 0 on a damaged header.
+ */
+static int parseBlockHeader(const unsigned char bytes[], BlockHeader *block)
+{
+    if(memcmp(bytes, BLOCK_MAGIC, sizeof(BLOCK_MAGIC)) != 0)
+    {
+        return 0;
+    }
+
+    block->flags        = bytes[2];
+    block->recordCount  = (unsigned int) loadLittleEndian(bytes + 4, 4);
+    block->rawLength    = (unsigned int) loadLittleEndian(bytes + 8, 4);
+    block->storedLength = (unsigned int) loadLittleEndian(bytes + 12, 4);
+    block->minDischarge = (time_t) (long long) loadLittleEndian(bytes + 16, 8);
+    block->maxDischarge = (time_t) (long long) loadLittleEndian(bytes + 24, 8);
+
+    return block->rawLength <= ARCHIVE_BLOCK_SIZE;
+}
+
+/*
+ * Writes a block header at the given file offset.
+ */
+static int writeBlockHeaderAt(FILE *file, long offset, const BlockHeader *block)
+{
+    unsigned char bytes[BLOCK_HEADER_SIZE];
+
+    memcpy(bytes, BLOCK_MAGIC, sizeof(BLOCK_MAGIC));
+    bytes[2] = (unsigned char) block->flags;
+    bytes[3] = 0;
+    storeLittleEndian(bytes + 4, block->recordCount, 4);
+    storeLittleEndian(bytes + 8, block->rawLength, 4);
+    storeLittleEndian(bytes + 12, block->storedLength, 4);
+    storeLittleEndian(bytes + 16, (unsigned long long) (long long) block->minDischarge, 8);
+    storeLittleEndian(bytes + 24, (unsigned long long) (long long) block->maxDischarge, 8);
+
+    return fseek(file, offset, SEEK_SET) == 0 &&
+           fwrite(bytes, 1, BLOCK_HEADER_SIZE, file) == BLOCK_HEADER_SIZE;
+}
+
+/*
+ * Locates the last valid block. Returns 1 if one exists, 0 if the archive
+ * has no blocks. dataEnd receives the offset just past the last block.
+ */
+static int findTailBlock(FILE *file, long fileEnd, long *tailOffset, BlockHeader *tail, long *dataEnd)
+{
+    if(fileEnd == cachedFileEnd && cachedTailOffset >= 0)
+    {
+        *tailOffset = cachedTailOffset;
+        *tail       = cachedTail;
+        *dataEnd    = cachedFileEnd;
+        return 1;
+    }
+
+    long        offset = RECORD_HEADER_SIZE;
+    int         found  = 0;
+    BlockHeader block;
+
+    fseek(file, offset, SEEK_SET);
+    while(offset + BLOCK_HEADER_SIZE <= fileEnd && readBlockHeader(file, &block))
+    {
+        long blockEnd = offset + BLOCK_HEADER_SIZE + (long) block.storedLength;
+        if(blockEnd > fileEnd)
+        {
+            break; // Partially written block
+        }
+
+        *tailOffset = offset;
+        *tail       = block;
+        found       = 1;
+
+        offset = blockEnd;
+        if(!(block.flags & BLOCK_SEALED))
+        {
+            break; // Only a staged seal can follow an unsealed block
+        }
+        fseek(file, offset, SEEK_SET);
+    }
+
+    *dataEnd = offset;
+    return found;
+}
+
+/*
+ * Writes buffered records to the end of the tail block payload, then
+ * rewrites the tail header to cover them.
+ */
+static int flushPendingRecords(FILE *file, long tailOffset, const BlockHeader *tail,
+                               const unsigned char pending[], size_t pendingLength)
+{
+    long payloadEnd = tailOffset + BLOCK_HEADER_SIZE + (long) tail->rawLength;
+
+    if(pendingLength > 0 &&
+       (fseek(file, payloadEnd - (long) pendingLength, SEEK_SET) != 0 ||
+        fwrite(pending, 1, pendingLength, file) != pendingLength))
+    {
+        return 0;
+    }
+
+    return writeBlockHeaderAt(file, tailOffset, tail);
+}
+
+/*
+ * Seals a full tail block, compressed if that makes it smaller. The
+ * compressed block is staged past the raw one and synced before the raw
+ * payload is overwritten.
+ */
+static int sealBlock(FILE *file, long offset, BlockHeader *block)
+{
+    size_t         bound      = lzCompressBound(block->rawLength);
+    unsigned char *raw        = malloc(block->rawLength);
+    unsigned char *compressed = malloc(bound);
+    int            ok         = raw != NULL && compressed != NULL;
+
+    if(ok)
+    {
+        ok = fseek(file, offset + BLOCK_HEADER_SIZE, SEEK_SET) == 0 &&
+             fread(raw, 1, block->rawLength, file) == block->rawLength;
+    }
+
+    if(ok)
+    {
+        size_t      compressedLength = lzCompress(raw, block->rawLength, compressed, bound);
+        BlockHeader sealed           = *block;
+
+        sealed.flags |= BLOCK_SEALED;
+        if(compressedLength > 0 && compressedLength < block->rawLength)
+        {
+            long stagedOffset = offset + BLOCK_HEADER_SIZE + (long) block->rawLength;
+
+            sealed.storedLength = (unsigned int) compressedLength;
+            sealed.flags       |= BLOCK_COMPRESSED;
+
+            ok = writeBlockHeaderAt(file, stagedOffset, &sealed) &&
+                 fwrite(compressed, 1, compressedLength, file) == compressedLength &&
+                 fflush(file) == 0 && syncFile(fileno(file), ARCHIVE_FILE) &&
+                 commitSeal(file, offset, &sealed, compressed);
+        }
+        else
+        {
+            ok = commitSeal(file, offset, &sealed, raw);
+        }
+
+        if(ok)
+        {
+            *block = sealed;
+        }
+    }
+
+    free(raw);
+    free(compressed);
+    return ok;
+}
+
+/*
+ * Writes a sealed block's stored payload and header over the tail block,
+ * syncs them, and only then truncates away whatever followed it.
+ */
+static int commitSeal(FILE *file, long offset, const BlockHeader *sealed, const unsigned char stored[])
+{
+    return fseek(file, offset + BLOCK_HEADER_SIZE, SEEK_SET) == 0 &&
+           fwrite(stored, 1, sealed->storedLength, file) == sealed->storedLength &&
+           writeBlockHeaderAt(file, offset, sealed) && fflush(file) == 0 &&
+           syncFile(fileno(file), ARCHIVE_FILE) &&
+           ftruncate(fileno(file), offset + BLOCK_HEADER_SIZE + (long) sealed->storedLength) == 0;
+}
+
+/*
+ * Finishes a seal a crash interrupted. A staged copy of the tail block
+ * that decompresses is copied into place; anything else past the tail
+ * block was never committed and is truncated away.
+ */
+static int resumeSeal(FILE *file, long offset, BlockHeader *block, long fileEnd)
+{
+    BlockHeader staged;
+    long        stagedOffset = offset + BLOCK_HEADER_SIZE + (long) block->rawLength;
+
+    if(!readStagedSeal(fileno(file), offset, block, &staged) ||
+       stagedOffset + BLOCK_HEADER_SIZE + (long) staged.storedLength > fileEnd)
+    {
+        return ftruncate(fileno(file), offset + BLOCK_HEADER_SIZE + (long) block->storedLength) == 0;
+    }
+
+    unsigned char *stored = malloc(staged.storedLength);
+    unsigned char *raw    = malloc(staged.rawLength);
+    int            ok     = stored != NULL && raw != NULL;
+
+    // Never truncate the staged copy unless it was unusable
+    if(ok)
+    {
+        if(pread(fileno(file), stored, staged.storedLength, stagedOffset + BLOCK_HEADER_SIZE) ==
+               (ssize_t) staged.storedLength &&
+           lzDecompress(stored, staged.storedLength, raw, staged.rawLength))
+        {
+            ok = commitSeal(file, offset, &staged, stored);
+            if(ok)
+            {
+                *block = staged;
+            }
+        }
+        else
+        {
+            ok = ftruncate(fileno(file), offset + BLOCK_HEADER_SIZE + (long) block->storedLength) == 0;
+        }
+    }
+
+    free(stored);
+    free(raw);
+    return ok;
+}
+
+/*
+ * Reads the header just past a block's raw payload, where sealBlock stages
+ * the compressed block. Returns 1 if it is a staged seal of that block.
+ */
+static int readStagedSeal(int fd, long offset, const BlockHeader *block, BlockHeader *staged)
+{
+    unsigned char bytes[BLOCK_HEADER_SIZE];
+    long          stagedOffset = offset + BLOCK_HEADER_SIZE + (long) block->rawLength;
+
+    return pread(fd, bytes, BLOCK_HEADER_SIZE, stagedOffset) == BLOCK_HEADER_SIZE &&
+           parseBlockHeader(bytes, staged) && staged->flags == (BLOCK_SEALED | BLOCK_COMPRESSED) &&
+           staged->recordCount == block->recordCount && staged->rawLength == block->rawLength &&
+           staged->minDischarge == block->minDischarge && staged->maxDischarge == block->maxDischarge;
+}
+
+/*
+ * Grows a scratch buffer to at least the required size.
+ */
+static int ensureCapacity(unsigned char **buffer, size_t *capacity, size_t required)
+{
+    if(*capacity >= required)
+    {
+        return 1;
+    }
+
+    unsigned char *grown = realloc(*buffer, required);
+    if(grown == NULL)
+    {
+        return 0;
+    }
+
+    *buffer   = grown;
+    *capacity = required;
+    return 1;
+}
@@ -0,0 +1,149 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the block-compressed discharge archive stored in
+ *          discharged_patients.dat.
+ *
+ *          The file starts with a record file header (see patient_storage.h)
+ *          followed by a sequence of blocks. Each block has a fixed-size
+ *          header carrying its record count, raw and stored sizes, and the
+ *          minimum and maximum discharge time of its records, followed by
+ *          compact records that are LZ-compressed once the block is full.
+ *          Scans use the block time range to skip blocks that cannot match.
+ */
+
+#ifndef DISCHARGE_ARCHIVE_H
+#define DISCHARGE_ARCHIVE_H
+
+#include <time.h>
+#include "patient_management.h"
+
+#define ARCHIVE_FILE "discharged_patients.dat"
+#define ARCHIVE_FILE_MAGIC "HMSA"
+
+#define ARCHIVE_BLOCK_SIZE 65536 // Raw bytes per block before it is sealed
+
+#define ARCHIVE_SUCCESS 1
+#define ARCHIVE_FAILURE 0
+
+#define ARCHIVE_BEGINNING_OF_TIME ((time_t) 0)
+#define ARCHIVE_END_OF_TIME ((time_t) 0x7FFFFFFFFFFFFFFFLL)
+
+/*
+ * Position of one record in the archive: the offset of its block and the
+ * offset of the record within the block's uncompressed payload. Both stay
+ * valid when the block is sealed.
+ */
+typedef struct
+{
+    long         blockOffset;
+    unsigned int recordOffset;
+} ArchiveLocation;
+
+/*
+ * A run of consecutive blocks that can be scanned independently of the
+ * rest of the archive: the offset of its first block and the offset just
+ * past its last.
+ */
+typedef struct
+{
+    long startOffset;
+    long endOffset;
+} ArchiveChunk;
+
+/*
+ * Callback invoked for each record visited by scanDischargeArchive.
+ * Returning 0 stops the scan early.
+ */
+typedef int (*DischargeVisitor)(const DischargedPatient *dischargedPatient, void *context);
+
+/*
+ * Callback invoked for each record visited by scanDischargeLocations.
+ * Returning 0 stops the scan early.
+ */
+typedef int (*DischargeLocationVisitor)(const DischargedPatient *dischargedPatient,
+                                        const ArchiveLocation *location,
+                                        void *context);
+
+/*
+ * Function: appendDischargedPatients
+ * ----------------------------------
+ * Appends discharged patient records to the archive, creating it if
+ * needed. Records are added to the open tail block, which is compressed
+ * and sealed once it reaches ARCHIVE_BLOCK_SIZE.
+ *
+ * records: The records to append
+ * count: Number of records
+ * locations: Receives where each record was written; may be NULL
+ *
+ * Returns: ARCHIVE_SUCCESS, or ARCHIVE_FAILURE on error
+ */
+int appendDischargedPatients(const DischargedPatient records[], int count, ArchiveLocation locations[]);
+
+/*
+ * Function: scanDischargeArchive
+ * ------------------------------
+ * Visits archived records in append order. Blocks whose discharge time
+ * range lies entirely outside [fromTime, toTime] are skipped without being
+ * read or decompressed; records inside visited blocks are not filtered.
+ *
+ * Returns: ARCHIVE_SUCCESS, or ARCHIVE_FAILURE if the archive is missing
+ *          or unreadable
+ */
+int scanDischargeArchive(time_t fromTime,
+                         time_t toTime,
+                         DischargeVisitor visitor,
+                         void *context);
+
+/*
+ * Function: scanDischargeLocations
+ * --------------------------------
+ * Visits every archived record in append order along with its location.
+ *
+ * Returns: ARCHIVE_SUCCESS, or ARCHIVE_FAILURE if the archive is missing
+ *          or unreadable
+ */
+int scanDischargeLocations(DischargeLocationVisitor visitor, void *context);
+
+/*
+ * Function: splitDischargeArchive
+ * -------------------------------
+ * Divides the blocks overlapping [fromTime, toTime] into at most maxChunks
+ * runs of roughly equal stored size, so they can be scanned in parallel.
+ *
+ * chunks: Receives the runs, in archive order
+ * maxChunks: Capacity of chunks
+ *
+ * Returns: The number of chunks, 0 if no block is in range or the archive
+ *          is missing or unreadable
+ */
+int splitDischargeArchive(time_t fromTime, time_t toTime, ArchiveChunk chunks[], int maxChunks);
+
+/*
+ * Function: scanDischargeChunk
+ * ----------------------------
+ * Visits the records of one chunk from splitDischargeArchive, skipping
+ * blocks outside [fromTime, toTime] like scanDischargeArchive. Each call
+ * opens its own file handle, so chunks may be scanned concurrently.
+ *
+ * Returns: ARCHIVE_SUCCESS, or ARCHIVE_FAILURE if the archive is missing
+ *          or unreadable
+ */
+int scanDischargeChunk(const ArchiveChunk *chunk,
+                       time_t fromTime,
+                       time_t toTime,
+                       DischargeVisitor visitor,
+                       void *context);
+
+/*
+ * Function: readDischargedPatientAt
+ * ---------------------------------
+ * Reads the single record at a location returned by an append or scan.
+ * Only the record's own block is read; records in the open tail block are
+ * read directly without loading the rest of the block.
+ *
+ * Returns: ARCHIVE_SUCCESS, or ARCHIVE_FAILURE if the location is invalid
+ */
+int readDischargedPatientAt(const ArchiveLocation *location, DischargedPatient *record);
+
+#endif // DISCHARGE_ARCHIVE_H
@@ -0,0 +1,508 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the on-disk patient ID index over the
+ *          discharge archive.
+ *
+ *          File layout (little-endian):
+ *            header: magic[4], version[1], reserved[3], capacity[4],
+ *                    count[4], highestId[4], reserved[4], archiveSize[8]
+ *            slots:  capacity x { patientId[4], recordOffset[4],
+ *                    blockOffset[8] }, patientId 0 marking an empty slot
+ *
+ *          Slots use linear probing and the table doubles once it is half
+ *          full. archiveSize is the archive's size when the index was last
+ *          updated, so an append the index missed is detected on open.
+ *          Lookups and updates share one file position, so they take
+ *          indexLock in turn.
+ */
+
+#include "discharge_index.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "durable_file.h"
+#include "patient_storage.h"
+
+// Private constants
+#define DISCHARGE_INDEX_VERSION 1
+#define DISCHARGE_INDEX_TEMP_FILE "discharged_patients.idx.tmp"
+#define MAGIC_LENGTH 4
+#define INDEX_HEADER_SIZE 32
+#define SLOT_SIZE 16
+#define MIN_CAPACITY 1024u
+#define EMPTY_SLOT 0
+
+typedef struct
+{
+    int             patientId;
+    ArchiveLocation location;
+} IndexSlot;
+
+/*
+ * State for rebuilding the index in memory from an archive scan.
+ */
+typedef struct
+{
+    IndexSlot   *slots;
+    unsigned int capacity;
+    int          failed;
+} IndexBuild;
+
+// Open index state
+static FILE        *indexFile = NULL;
+static unsigned int capacity  = 0;
+static unsigned int slotCount = 0;
+static int          highestId = 0;
+
+static pthread_mutex_t indexLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Function prototypes for internal helper functions
+static int          rebuildDischargeIndex(void);
+static int          indexArchiveRecord(const DischargedPatient *dischargedPatient,
+                                       const ArchiveLocation *location,
+                                       void *context);
+static int          growDischargeIndex(void);
+static int          insertSlot(IndexSlot slots[], unsigned int slotCapacity, int patientId,
+                               const ArchiveLocation *location);
+static int          writeIndexFile(const IndexSlot slots[], unsigned int slotCapacity);
+static int          writeIndexHeader(FILE *file, unsigned int slotCapacity);
+static int          findSlot(int patientId, long *slotOffset, IndexSlot *slot);
+static void         encodeSlot(const IndexSlot *slot, unsigned char bytes[]);
+static void         decodeSlot(const unsigned char bytes[], IndexSlot *slot);
+static unsigned int hashPatientId(int patientId, unsigned int slotCapacity);
+static long         getArchiveSize(void);
+static void         addSlots(const DischargedPatient records[], const ArchiveLocation locations[], int count);
+
+/*
+ * Opens and validates the index file, rebuilding it when stale.
+ */
+int openDischargeIndex(void)
+{
+    unsigned char header[INDEX_HEADER_SIZE];
+
+    closeDischargeIndex();
+
+    FILE *file = fopen(DISCHARGE_INDEX_FILE, "r+b");
+    if(file != NULL)
+    {
+        int ok = fread(header, 1, INDEX_HEADER_SIZE, file) == INDEX_HEADER_SIZE &&
+                 memcmp(header, DISCHARGE_INDEX_MAGIC, MAGIC_LENGTH) == 0 &&
+                 header[MAGIC_LENGTH] == DISCHARGE_INDEX_VERSION;
+
+        capacity  = ok ? (unsigned int) loadLittleEndian(header + 8, 4) : 0;
+        slotCount = ok ? (unsigned int) loadLittleEndian(header + 12, 4) : 0;
+        highestId = ok ? (int) loadLittleEndian(header + 16, 4) : 0;
+
+        ok = ok && capacity >= MIN_CAPACITY && (capacity & (capacity - 1)) == 0 && slotCount < capacity &&
+             (long) loadLittleEndian(header + 24, 8) == getArchiveSize() &&
+             fseek(file, 0, SEEK_END) == 0 &&
+             ftell(file) == INDEX_HEADER_SIZE + (long) capacity * SLOT_SIZE;
+
+        if(ok)
+        {
+            indexFile = file;
+            return DISCHARGE_INDEX_SUCCESS;
+        }
+        fclose(file);
+    }
+
+    return rebuildDischargeIndex();
+}
+
+/*
+ * Adds the records' slots while holding indexLock.
+ */
+void addToDischargeIndex(const DischargedPatient records[], const ArchiveLocation locations[], int count)
+{
+    pthread_mutex_lock(&indexLock);
+    addSlots(records, locations, count);
+    pthread_mutex_unlock(&indexLock);
+}
+
+/*
+ * Probes the table for the patient, then reads their record.
+ */
+int findDischargedPatient(int patientId, DischargedPatient *record)
+{
+    IndexSlot slot;
+    long      slotOffset;
+
+    pthread_mutex_lock(&indexLock);
+    int found = indexFile != NULL && patientId != EMPTY_SLOT && findSlot(patientId, &slotOffset, &slot);
+    pthread_mutex_unlock(&indexLock);
+
+    if(!found)
+    {
+        return DISCHARGE_INDEX_FAILURE;
+    }
+
+    return readDischargedPatientAt(&slot.location, record) && record->patient.patientId == patientId
+               ? DISCHARGE_INDEX_SUCCESS
+               : DISCHARGE_INDEX_FAILURE;
+}
+
+/*
+ * Returns the number of indexed patients.
+ */
+int getDischargedPatientTotal(void)
+{
+    pthread_mutex_lock(&indexLock);
+    int total = (int) slotCount;
+    pthread_mutex_unlock(&indexLock);
+
+    return total;
+}
+
+/*
+ * Returns the highest indexed patient ID.
+ */
+int getHighestDischargedId(void)
+{
+    pthread_mutex_lock(&indexLock);
+    int highest = highestId;
+    pthread_mutex_unlock(&indexLock);
+
+    return highest;
+}
+
+/*
+ * Closes the index file.
+ */
+void closeDischargeIndex(void)
+{
+    if(indexFile != NULL)
+    {
+        fclose(indexFile);
+        indexFile = NULL;
+    }
+    capacity  = 0;
+    slotCount = 0;
+    highestId = 0;
+}
+
+/*
+ * Writes each new record's slot in place, then the header once. Must be
+ * called with indexLock held.
+ */
+static void addSlots(const DischargedPatient records[], const ArchiveLocation locations[], int count)
+{
+    unsigned char bytes[SLOT_SIZE];
+
+    if(indexFile == NULL && !openDischargeIndex())
+    {
+        return;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        if((slotCount + 1) * 2 > capacity && !growDischargeIndex())
+        {
+            return;
+        }
+
+        IndexSlot slot;
+        long      slotOffset;
+        int       existing = findSlot(records[i].patient.patientId, &slotOffset, &slot);
+
+        slot.patientId = records[i].patient.patientId;
+        slot.location  = locations[i];
+        encodeSlot(&slot, bytes);
+
+        if(slotOffset < 0 ||
+           fseek(indexFile, slotOffset, SEEK_SET) != 0 ||
+           fwrite(bytes, 1, SLOT_SIZE, indexFile) != SLOT_SIZE)
+        {
+            perror("Error updating " DISCHARGE_INDEX_FILE);
+            return;
+        }
+
+        if(!existing)
+        {
+            slotCount++;
+        }
+        if(slot.patientId > highestId)
+        {
+            highestId = slot.patientId;
+        }
+    }
+
+    if(!writeIndexHeader(indexFile, capacity) || fflush(indexFile) != 0)
+    {
+        perror("Error updating " DISCHARGE_INDEX_FILE);
+    }
+}
+
+/*
+ * Builds the table in memory from a full archive scan and writes it out.
+ * A missing archive gives an empty index.
+ */
+static int rebuildDischargeIndex(void)
+{
+    IndexBuild build;
+
+    build.capacity = MIN_CAPACITY;
+    build.slots    = calloc(build.capacity, sizeof(IndexSlot));
+    build.failed   = build.slots == NULL;
+    slotCount      = 0;
+    highestId      = 0;
+
+    if(!build.failed)
+    {
+        scanDischargeLocations(indexArchiveRecord, &build);
+    }
+
+    int result = !build.failed && writeIndexFile(build.slots, build.capacity);
+    free(build.slots);
+
+    if(!result)
+    {
+        puts("Error: Unable to build " DISCHARGE_INDEX_FILE ".");
+        closeDischargeIndex();
+        return DISCHARGE_INDEX_FAILURE;
+    }
+
+    return DISCHARGE_INDEX_SUCCESS;
+}
+
+/*
+ * Adds one scanned record to the in-memory table, doubling it when half full.
+ */
+static int indexArchiveRecord(const DischargedPatient *dischargedPatient,
+                              const ArchiveLocation *location,
+                              void *context)
+{
+    IndexBuild *build = context;
+
+    if((slotCount + 1) * 2 > build->capacity)
+    {
+        unsigned int grownCapacity = build->capacity * 2;
+        IndexSlot   *grown         = calloc(grownCapacity, sizeof(IndexSlot));
+        if(grown == NULL)
+        {
+            build->failed = 1;
+            return 0;
+        }
+
+        for(unsigned int i = 0; i < build->capacity; i++)
+        {
+            if(build->slots[i].patientId != EMPTY_SLOT)
+            {
+                insertSlot(grown, grownCapacity, build->slots[i].patientId, &build->slots[i].location);
+            }
+        }
+        free(build->slots);
+        build->slots    = grown;
+        build->capacity = grownCapacity;
+    }
+
+    if(dischargedPatient->patient.patientId == EMPTY_SLOT)
+    {
+        return 1;
+    }
+
+    slotCount += insertSlot(build->slots, build->capacity, dischargedPatient->patient.patientId, location);
+    if(dischargedPatient->patient.patientId > highestId)
+    {
+        highestId = dischargedPatient->patient.patientId;
+    }
+
+    return 1;
+}
+
+/*
+ * Reads the whole table, rehashes it at twice the size and replaces the file.
+ */
+static int growDischargeIndex(void)
+{
+    unsigned char bytes[SLOT_SIZE];
+    unsigned int  grownCapacity = capacity * 2;
+    IndexSlot    *grown         = calloc(grownCapacity, sizeof(IndexSlot));
+    int           ok            = grown != NULL && fseek(indexFile, INDEX_HEADER_SIZE, SEEK_SET) == 0;
+
+    for(unsigned int i = 0; ok && i < capacity; i++)
+    {
+        IndexSlot slot;
+
+        ok = fread(bytes, 1, SLOT_SIZE, indexFile) == SLOT_SIZE;
+        decodeSlot(bytes, &slot);
+        if(ok && slot.patientId != EMPTY_SLOT)
+        {
+            insertSlot(grown, grownCapacity, slot.patientId, &slot.location);
+        }
+    }
+
+    ok = ok && writeIndexFile(grown, grownCapacity);
+    free(grown);
+
+    if(!ok)
+    {
+        perror("Error growing " DISCHARGE_INDEX_FILE);
+    }
+    return ok;
+}
+
+/*
+ * Inserts or replaces a slot in an in-memory table.
+ * Returns 1 if the patient was new to the table.
+ */
+static int insertSlot(IndexSlot slots[], unsigned int slotCapacity, int patientId,
+                      const ArchiveLocation *location)
+{
+    unsigned int position = hashPatientId(patientId, slotCapacity);
+
+    while(slots[position].patientId != EMPTY_SLOT && slots[position].patientId != patientId)
+    {
+        position = (position + 1) & (slotCapacity - 1);
+    }
+
+    int isNew                 = slots[position].patientId == EMPTY_SLOT;
+    slots[position].patientId = patientId;
+    slots[position].location  = *location;
+
+    return isNew;
+}
+
+/*
+ * Writes a complete table through a durably replaced temporary file and
+ * reopens it.
+ */
+static int writeIndexFile(const IndexSlot slots[], unsigned int slotCapacity)
+{
+    unsigned char bytes[SLOT_SIZE];
+
+    if(indexFile != NULL)
+    {
+        fclose(indexFile);
+        indexFile = NULL;
+    }
+
+    FILE *file = fopen(DISCHARGE_INDEX_TEMP_FILE, "wb");
+    if(file == NULL)
+    {
+        return DISCHARGE_INDEX_FAILURE;
+    }
+
+    int ok = writeIndexHeader(file, slotCapacity);
+    for(unsigned int i = 0; ok && i < slotCapacity; i++)
+    {
+        encodeSlot(&slots[i], bytes);
+        ok = fwrite(bytes, 1, SLOT_SIZE, file) == SLOT_SIZE;
+    }
+
+    if(fclose(file) != 0 || !ok)
+    {
+        remove(DISCHARGE_INDEX_TEMP_FILE);
+        return DISCHARGE_INDEX_FAILURE;
+    }
+    if(!replaceFile(DISCHARGE_INDEX_TEMP_FILE, DISCHARGE_INDEX_FILE))
+    {
+        return DISCHARGE_INDEX_FAILURE;
+    }
+
+    indexFile = fopen(DISCHARGE_INDEX_FILE, "r+b");
+    capacity  = slotCapacity;
+    return indexFile != NULL ? DISCHARGE_INDEX_SUCCESS : DISCHARGE_INDEX_FAILURE;
+}
+
+/*
+ * Writes the header, stamped with the current archive size.
+ */
+static int writeIndexHeader(FILE *file, unsigned int slotCapacity)
+{
+    unsigned char header[INDEX_HEADER_SIZE] = { 0 };
+
+    memcpy(header, DISCHARGE_INDEX_MAGIC, MAGIC_LENGTH);
+    header[MAGIC_LENGTH] = DISCHARGE_INDEX_VERSION;
+    storeLittleEndian(header + 8, slotCapacity, 4);
+    storeLittleEndian(header + 12, slotCount, 4);
+    storeLittleEndian(header + 16, (unsigned int) highestId, 4);
+    storeLittleEndian(header + 24, (unsigned long long) getArchiveSize(), 8);
+
+    return fseek(file, 0, SEEK_SET) == 0 &&
+           fwrite(header, 1, INDEX_HEADER_SIZE, file) == INDEX_HEADER_SIZE;
+}
+
+/*
+ * Probes the on-disk table from the patient's home slot. slotOffset
+ * receives the offset of the patient's slot, or of the empty slot where
+ * they would go.
+ *
+ * Returns 1 if the patient was found, 0 otherwise.
+ */
+static int findSlot(int patientId, long *slotOffset, IndexSlot *slot)
+{
+    unsigned char bytes[SLOT_SIZE];
+    unsigned int  position = hashPatientId(patientId, capacity);
+
+    *slotOffset = -1;
+    if(fseek(indexFile, INDEX_HEADER_SIZE + (long) position * SLOT_SIZE, SEEK_SET) != 0)
+    {
+        return 0;
+    }
+
+    // The table is never more than half full, so an empty slot always ends the probe
+    for(unsigned int probes = 0; probes < capacity; probes++)
+    {
+        if(fread(bytes, 1, SLOT_SIZE, indexFile) != SLOT_SIZE)
+        {
+            return 0;
+        }
+        decodeSlot(bytes, slot);
+
+        if(slot->patientId == EMPTY_SLOT || slot->patientId == patientId)
+        {
+            *slotOffset = INDEX_HEADER_SIZE + (long) position * SLOT_SIZE;
+            return slot->patientId == patientId;
+        }
+
+        position = (position + 1) & (capacity - 1);
+        if(position == 0 && fseek(indexFile, INDEX_HEADER_SIZE, SEEK_SET) != 0)
+        {
+            return 0;
+        }
+    }
+
+    return 0;
+}
+
+/*
+ * Converts a slot to its on-disk bytes.
+ */
+static void encodeSlot(const IndexSlot *slot, unsigned char bytes[])
+{
+    storeLittleEndian(bytes, (unsigned int) slot->patientId, 4);
+    storeLittleEndian(bytes + 4, slot->location.recordOffset, 4);
+    storeLittleEndian(bytes + 8, (unsigned long long) slot->location.blockOffset, 8);
+}
+
+/*
+ * Converts on-disk bytes to a slot.
+ */
+static void decodeSlot(const unsigned char bytes[], IndexSlot *slot)
+{
+    slot->patientId             = (int) loadLittleEndian(bytes, 4);
+    slot->location.recordOffset = (unsigned int) loadLittleEndian(bytes + 4, 4);
+    slot->location.blockOffset  = (long) loadLittleEndian(bytes + 8, 8);
+}
+
+/*
+ * Multiplicative hash of a patient ID onto a power-of-two table, with the
+ * high bits folded down so the mask sees all of them.
+ */
+static unsigned int hashPatientId(int patientId, unsigned int slotCapacity)
+{
+    unsigned int hash = (unsigned int) patientId * 2654435769u;
+    return (hash ^ (hash >> 16)) & (slotCapacity - 1);
+}
+
+/*
+ * Returns the archive's size in bytes, or 0 if it does not exist.
+ */
+static long getArchiveSize(void)
+{
+    struct stat status;
+    return stat(ARCHIVE_FILE, &status) == 0 ? (long) status.st_size : 0;
+}
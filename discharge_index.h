@@ -0,0 +1,84 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the on-disk index from patient ID to record
+ *          location in the discharge archive, stored in
+ *          discharged_patients.idx.
+ *
+ *          The index is an open-addressing hash table kept on disk, so a
+ *          lookup reads one short probe run and then seeks straight to the
+ *          record's archive block instead of scanning the archive. It is
+ *          updated in place on every archive append and rebuilt from the
+ *          archive whenever the two are out of step.
+ */
+
+#ifndef DISCHARGE_INDEX_H
+#define DISCHARGE_INDEX_H
+
+#include "discharge_archive.h"
+#include "patient_management.h"
+
+#define DISCHARGE_INDEX_FILE "discharged_patients.idx"
+#define DISCHARGE_INDEX_MAGIC "HMSI"
+
+#define DISCHARGE_INDEX_SUCCESS 1
+#define DISCHARGE_INDEX_FAILURE 0
+
+/*
+ * Function: openDischargeIndex
+ * ----------------------------
+ * Opens DISCHARGE_INDEX_FILE, rebuilding it from the archive if it is
+ * missing, damaged, or does not cover the whole archive.
+ *
+ * Returns: DISCHARGE_INDEX_SUCCESS, or DISCHARGE_INDEX_FAILURE if the index
+ *          cannot be written
+ */
+int openDischargeIndex(void);
+
+/*
+ * Function: addToDischargeIndex
+ * -----------------------------
+ * Records where newly appended archive records were written. A patient ID
+ * that is already indexed is pointed at the newer record.
+ *
+ * records: The records just appended
+ * locations: Their locations, as returned by appendDischargedPatients
+ * count: Number of records
+ */
+void addToDischargeIndex(const DischargedPatient records[], const ArchiveLocation locations[], int count);
+
+/*
+ * Function: findDischargedPatient
+ * -------------------------------
+ * Looks up a patient's discharge record.
+ *
+ * patientId: The patient's ID
+ * record: Receives the archived record when found
+ *
+ * Returns: DISCHARGE_INDEX_SUCCESS, or DISCHARGE_INDEX_FAILURE if the
+ *          patient has not been discharged
+ */
+int findDischargedPatient(int patientId, DischargedPatient *record);
+
+/*
+ * Function: getDischargedPatientTotal
+ * -----------------------------------
+ * Returns the number of patients in the index.
+ */
+int getDischargedPatientTotal(void);
+
+/*
+ * Function: getHighestDischargedId
+ * --------------------------------
+ * Returns the highest patient ID ever discharged, or 0 if none has been.
+ */
+int getHighestDischargedId(void);
+
+/*
+ * Function: closeDischargeIndex
+ * -----------------------------
+ * Closes the index file.
+ */
+void closeDischargeIndex(void);
+
+#endif // DISCHARGE_INDEX_H
@@ -5,14 +5,15 @@
  */
 
 #include "doctor_schedule.h"
+#include <pthread.h>
 #include <stdio.h>
 #include <string.h>
 #include "doctor_data.h"
+#include "durable_file.h"
+#include "report_aggregates.h"
+#include "report_export.h"
 #include "utils.h"
 
-#define DAYS_IN_WEEK 7
-#define TIMES_OF_DAY 3
-
 #define NO_DOCTOR 0
 
 // Private constants
@@ -23,12 +24,22 @@ static const int MIN_INDEX     = 0;
 /* Weekly schedule matrix organized by day and time slot */
 static Doctor weeklyDoctorSchedule[DAYS_IN_WEEK][TIMES_OF_DAY];
 
+/* Guards the schedule and its file once requests can arrive concurrently */
+static pthread_mutex_t scheduleLock = PTHREAD_MUTEX_INITIALIZER;
+
 /* Array of day names for display purposes */
 static const char *daysOfWeek[] = { "Monday", "Tuesday", "Wednesday", "Thursday", "Friday", "Saturday", "Sunday" };
 
 /* Array of time slot names for display purposes */
 static const char *timesOfDay[] = { "Morning", "Afternoon", "Evening" };
 
+// Doctors listed in the utilization report
+static const Doctor reportedDoctors[] = {
+    {RAYMOND_ID, "Raymond", 40},
+    {GEORGE_ID, "George", 45},
+    {SOFIA_ID, "Sofia", 35}
+};
+
 /* Function prototypes for internal helper functions */
 static int chooseDay(void);
 static int chooseTime(void);
@@ -36,6 +47,8 @@ static int dayExists(int);
 static int timeExists(int);
 static void writeScheduleToFile(void);
 static void updateScheduleFile(void);
+static int countDoctorShifts(int doctorId);
+static void syncDoctorShiftTotals(void);
 
 /*
  * Initializes the weekly schedule from file or with default values
@@ -59,6 +72,7 @@ void initializeSchedule(void)
 
         fclose(pSchedule);
         puts("\nSchedule successfully loaded from file.");
+        syncDoctorShiftTotals();
     }
     else
     {
@@ -82,14 +96,16 @@ void initializeScheduleDefault(void)
     
     // Create initial schedule file
     writeScheduleToFile();
+    syncDoctorShiftTotals();
 }
 
 /*
- * Updates the schedule file with current assignments
+ * Updates the schedule file with current assignments, writing schedule.tmp
+ * and durably replacing schedule.dat with it
  */
 static void writeScheduleToFile(void)
 {
-    FILE *pSchedule = fopen("schedule.dat", "wb");
+    FILE *pSchedule = fopen("schedule.tmp", "wb");
     
     if(pSchedule == NULL)
     {
@@ -99,17 +115,17 @@ static void writeScheduleToFile(void)
 
     size_t written = fwrite(weeklyDoctorSchedule, sizeof(Doctor), 
                            DAYS_IN_WEEK * TIMES_OF_DAY, pSchedule);
+    int    closed  = fclose(pSchedule) == 0;
     
-    if(written == DAYS_IN_WEEK * TIMES_OF_DAY)
+    if(written == DAYS_IN_WEEK * TIMES_OF_DAY && closed && replaceFile("schedule.tmp", "schedule.dat"))
     {
         puts("\nSchedule successfully saved to file.");
     }
     else
     {
+        remove("schedule.tmp"); // Already gone if the replace failed
         puts("\nError saving schedule to file.");
     }
-    
-    fclose(pSchedule);
 }
 
 /*
@@ -128,7 +144,7 @@ void assignDoctor(void)
 
     printf("Assigning Dr.%s for %s %s.\n", doctor->name, daysOfWeek[dayIndex], timesOfDay[timeIndex]);
 
-    if(weeklyDoctorSchedule[dayIndex][timeIndex].id != UNASSIGNED_ID)
+    if(assignDoctorToShift(doctorId, dayIndex, timeIndex, 0) == SCHEDULE_SLOT_TAKEN)
     {
         printf("Another Doctor Already Assigned. Would You Like To Proceed? (y / n)\n");
 
@@ -138,13 +154,44 @@ void assignDoctor(void)
             clearInputBuffer();
         }
         while(proceed != YES && proceed != NO);
+
+        if(proceed == YES)
+        {
+            assignDoctorToShift(doctorId, dayIndex, timeIndex, 1);
+        }
+    }
+}
+
+/*
+ * Assigns a doctor to a slot, refusing to replace another doctor unless
+ * asked. Checking and assigning under one lock keeps two requests for the
+ * same slot from both succeeding.
+ */
+int assignDoctorToShift(int doctorId, int dayIndex, int timeIndex, int replace)
+{
+    const Doctor *doctor = getDoctorWithId(doctorId);
+
+    if(doctor == NULL || dayIndex < MIN_INDEX || dayIndex >= DAYS_IN_WEEK ||
+       timeIndex < MIN_INDEX || timeIndex >= TIMES_OF_DAY)
+    {
+        return SCHEDULE_FAILURE;
     }
 
-    if(proceed == YES)
+    pthread_mutex_lock(&scheduleLock);
+
+    Doctor *slot = &weeklyDoctorSchedule[dayIndex][timeIndex];
+    if(slot->id != UNASSIGNED_ID && slot->id != doctor->id && !replace)
     {
-        weeklyDoctorSchedule[dayIndex][timeIndex] = *doctor;
-        writeScheduleToFile();  // Update file after assignment
+        pthread_mutex_unlock(&scheduleLock);
+        return SCHEDULE_SLOT_TAKEN;
     }
+
+    recordShiftChange(slot->id, doctor->id);
+    *slot = *doctor;
+    writeScheduleToFile();  // Update file after assignment
+
+    pthread_mutex_unlock(&scheduleLock);
+    return SCHEDULE_SUCCESS;
 }
 
 /*
@@ -154,6 +201,8 @@ void assignDoctor(void)
  */
 void printFullSchedule(void)
 {
+    pthread_mutex_lock(&scheduleLock);
+
     for(int dayIndex = 0; dayIndex < DAYS_IN_WEEK; dayIndex++)
     {
         printf("---%s---\n", daysOfWeek[dayIndex]);
@@ -172,6 +221,8 @@ void printFullSchedule(void)
             }
         }
     }
+
+    pthread_mutex_unlock(&scheduleLock);
 }
 
 /*
@@ -285,6 +336,17 @@ static int countDoctorShifts(int doctorId) {
     return shiftCount;
 }
 
+/*
+ * Brings the running shift totals in line with the loaded schedule.
+ */
+static void syncDoctorShiftTotals(void)
+{
+    for(size_t i = 0; i < sizeof(reportedDoctors) / sizeof(reportedDoctors[0]); i++)
+    {
+        setDoctorShiftTotal(reportedDoctors[i].id, countDoctorShifts(reportedDoctors[i].id));
+    }
+}
+
 /*
  * Prints out a doctor utilization report and overwrites to
  * doctor_utilization_report.txt showcasing number of shifts
@@ -304,18 +366,12 @@ void printDoctorUtilizationReport() {
     fprintf(reportFile, "==========================\n");
 
     // Iterate over all doctors and count their shifts
-    const Doctor doctors[] = {
-        {RAYMOND_ID, "Raymond", 40},
-        {GEORGE_ID, "George", 45},
-        {SOFIA_ID, "Sofia", 35}
-    };
-
     for (int i = 0; i < 3; i++) {
-        int shiftCount = countDoctorShifts(doctors[i].id);
+        int shiftCount = getDoctorShiftTotal(reportedDoctors[i].id);
 
         // Print doctor details and shift count
-        printf("Dr.%s - Shifts Covered: %d\n", doctors[i].name, shiftCount);
-        fprintf(reportFile, "Dr.%s - Shifts Covered: %d\n", doctors[i].name, shiftCount);
+        printf("Dr.%s - Shifts Covered: %d\n", reportedDoctors[i].name, shiftCount);
+        fprintf(reportFile, "Dr.%s - Shifts Covered: %d\n", reportedDoctors[i].name, shiftCount);
     }
 
     // Close the report file
@@ -323,3 +379,22 @@ void printDoctorUtilizationReport() {
     printf("\nReport successfully written to doctor_utilization_report.txt\n");
 }
 
+/*
+ * Writes the shifts covered by each doctor as CSV or JSON rows.
+ */
+void exportDoctorUtilizationReport(ReportWriter *writer, int format) {
+    static const char *const columns[] = { "doctor_id", "doctor_name", "shifts_covered", "shifts_in_week" };
+
+    ExportWriter exporter;
+    beginExport(&exporter, writer, format, columns, 4);
+
+    for (int i = 0; i < 3; i++) {
+        exportInteger(&exporter, reportedDoctors[i].id);
+        exportText(&exporter, reportedDoctors[i].name);
+        exportInteger(&exporter, getDoctorShiftTotal(reportedDoctors[i].id));
+        exportInteger(&exporter, DAYS_IN_WEEK * TIMES_OF_DAY);
+        endExportRow(&exporter);
+    }
+
+    endExport(&exporter);
+}
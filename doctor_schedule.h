@@ -9,6 +9,15 @@
 #ifndef SCHEDULE_H
 #define SCHEDULE_H
 
+#include "report_writer.h"
+
+#define DAYS_IN_WEEK 7
+#define TIMES_OF_DAY 3
+
+#define SCHEDULE_SUCCESS 1
+#define SCHEDULE_FAILURE 0
+#define SCHEDULE_SLOT_TAKEN (-1)
+
 /*
  * Function: initializeSchedule
  * ----------------------------
@@ -30,6 +39,23 @@ void initializeScheduleDefault(void);
  */
 void assignDoctor(void);
 
+/*
+ * Function: assignDoctorToShift
+ * -----------------------------
+ * Assigns a doctor to a time slot without prompting, and updates the
+ * schedule file.
+ *
+ * doctorId: The doctor to assign
+ * dayIndex: 0 (Monday) to DAYS_IN_WEEK - 1
+ * timeIndex: 0 (Morning) to TIMES_OF_DAY - 1
+ * replace: Non-zero to replace a doctor already in the slot
+ *
+ * Returns: SCHEDULE_SUCCESS, SCHEDULE_SLOT_TAKEN if another doctor holds
+ *          the slot and replace is zero, or SCHEDULE_FAILURE if the doctor,
+ *          day or time does not exist
+ */
+int assignDoctorToShift(int doctorId, int dayIndex, int timeIndex, int replace);
+
 /*
  * Function: printFullSchedule
  * --------------------------
@@ -45,4 +71,14 @@ void printFullSchedule(void);
  */
 void printDoctorUtilizationReport();
 
+/*
+ * Function: exportDoctorUtilizationReport
+ * ---------------------------------------
+ * Writes the number of shifts covered by each doctor as CSV or JSON rows.
+ *
+ * writer: Report writer with its sinks attached
+ * format: EXPORT_FORMAT_CSV or EXPORT_FORMAT_JSON (see report_export.h)
+ */
+void exportDoctorUtilizationReport(ReportWriter *writer, int format);
+
 #endif // SCHEDULE_H
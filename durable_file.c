@@ -0,0 +1,338 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the durable replace and its benchmark.
+ */
+
+#define _GNU_SOURCE // O_CLOEXEC, O_DIRECTORY
+
+#include "durable_file.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+// Private constants
+#define MAX_DURABILITY_NAME_LENGTH 64
+#define BENCHMARK_FILE "durability_benchmark.dat"
+#define BENCHMARK_TEMP_FILE "durability_benchmark.tmp"
+#define SMALL_BENCHMARK_SIZE 4096
+#define LARGE_BENCHMARK_SIZE (1024 * 1024)
+#define BENCHMARK_IN_PLACE (-1) // Benchmark mode: overwrite without a replace
+
+/*
+ * A durability level given to one file.
+ */
+typedef struct
+{
+    char fileName[MAX_DURABILITY_NAME_LENGTH];
+    int  durability;
+} DurabilitySetting;
+
+// Per-file levels, read from the environment on first use
+static DurabilitySetting settings[MAX_DURABILITY_SETTINGS];
+static int               settingCount      = 0;
+static int               defaultDurability = DURABILITY_SYNC;
+static pthread_once_t    settingsLoaded    = PTHREAD_ONCE_INIT;
+static pthread_mutex_t   settingsLock      = PTHREAD_MUTEX_INITIALIZER;
+
+// Function prototypes for internal helper functions
+static void   loadDurabilitySettings(void);
+static int    parseDurability(const char text[]);
+static int    storeDurability(const char fileName[], int durability);
+static int    syncDirectory(const char fileName[]);
+static double timeReplacements(int mode, const unsigned char data[], size_t size, int iterations);
+
+/*
+ * Syncs the new version, renames it into place and syncs the directory.
+ */
+int replaceFile(const char tempName[], const char fileName[])
+{
+    int durable = getFileDurability(fileName) == DURABILITY_SYNC;
+
+    if(durable)
+    {
+        // Data first, so the rename can never expose an unwritten file
+        int fd     = open(tempName, O_RDONLY | O_CLOEXEC);
+        int synced = fd >= 0 && fdatasync(fd) == 0;
+        if(fd >= 0)
+        {
+            close(fd);
+        }
+        if(!synced)
+        {
+            perror("Error syncing temporary file");
+            remove(tempName);
+            return DURABLE_FAILURE;
+        }
+    }
+
+    if(rename(tempName, fileName) != 0)
+    {
+        perror("Error replacing data file");
+        remove(tempName);
+        return DURABLE_FAILURE;
+    }
+
+    // The rename itself is only durable once the directory is synced
+    if(durable && !syncDirectory(fileName))
+    {
+        perror("Error syncing data directory");
+        return DURABLE_FAILURE;
+    }
+
+    return DURABLE_SUCCESS;
+}
+
+/*
+ * Syncs the file's data unless its level is DURABILITY_ATOMIC.
+ */
+int syncFile(int fd, const char fileName[])
+{
+    if(getFileDurability(fileName) != DURABILITY_SYNC)
+    {
+        return DURABLE_SUCCESS;
+    }
+    return fdatasync(fd) == 0 ? DURABLE_SUCCESS : DURABLE_FAILURE;
+}
+
+/*
+ * Records a level for one file, or the default.
+ */
+int setFileDurability(const char fileName[], int durability)
+{
+    pthread_once(&settingsLoaded, loadDurabilitySettings);
+
+    pthread_mutex_lock(&settingsLock);
+    int stored = storeDurability(fileName, durability);
+    pthread_mutex_unlock(&settingsLock);
+
+    return stored;
+}
+
+/*
+ * Looks up a file's own level, falling back to the default.
+ */
+int getFileDurability(const char fileName[])
+{
+    pthread_once(&settingsLoaded, loadDurabilitySettings);
+
+    pthread_mutex_lock(&settingsLock);
+    int durability = defaultDurability;
+    for(int i = 0; i < settingCount; i++)
+    {
+        if(strcmp(settings[i].fileName, fileName) == 0)
+        {
+            durability = settings[i].durability;
+            break;
+        }
+    }
+    pthread_mutex_unlock(&settingsLock);
+
+    return durability;
+}
+
+/*
+ * Times each way of replacing a small and a large file.
+ */
+void benchmarkDurability(int iterations)
+{
+    static const size_t sizes[] = { SMALL_BENCHMARK_SIZE, LARGE_BENCHMARK_SIZE };
+
+    unsigned char *data = malloc(LARGE_BENCHMARK_SIZE);
+    if(data == NULL)
+    {
+        puts("Error: Unable to allocate benchmark data.");
+        return;
+    }
+    for(size_t i = 0; i < LARGE_BENCHMARK_SIZE; i++)
+    {
+        data[i] = (unsigned char) (i * 31);
+    }
+
+    pthread_once(&settingsLoaded, loadDurabilitySettings); // Any warnings go before the table
+    printf("Average cost of writing one file version (%d runs each):\n\n", iterations);
+    printf("%-10s %14s %14s %14s\n", "Size", "In place", "Atomic", "Sync");
+
+    for(size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+    {
+        double inPlace = timeReplacements(BENCHMARK_IN_PLACE, data, sizes[i], iterations);
+        double atomic  = timeReplacements(DURABILITY_ATOMIC, data, sizes[i], iterations);
+        double synced  = timeReplacements(DURABILITY_SYNC, data, sizes[i], iterations);
+
+        if(inPlace < 0 || atomic < 0 || synced < 0)
+        {
+            puts("Error: Unable to write the benchmark file.");
+            break;
+        }
+        char sizeLabel[24];
+        snprintf(sizeLabel, sizeof(sizeLabel), "%zu KB", sizes[i] / 1024);
+        printf("%-10s %11.1f us %11.1f us %11.1f us\n", sizeLabel, inPlace, atomic, synced);
+    }
+
+    remove(BENCHMARK_FILE);
+    remove(BENCHMARK_TEMP_FILE);
+    free(data);
+}
+
+/*
+ * Reads HOSPITAL_DURABILITY, ignoring entries it cannot make sense of.
+ */
+static void loadDurabilitySettings(void)
+{
+    const char *text = getenv(DURABILITY_VARIABLE);
+    char        entry[MAX_DURABILITY_NAME_LENGTH + 16];
+
+    while(text != NULL && *text != '\0')
+    {
+        size_t length = strcspn(text, ",");
+        if(length < sizeof(entry))
+        {
+            memcpy(entry, text, length);
+            entry[length] = '\0';
+
+            char *separator  = strchr(entry, '=');
+            int   durability = parseDurability(separator != NULL ? separator + 1 : entry);
+            if(separator != NULL)
+            {
+                *separator = '\0';
+            }
+
+            if(durability < 0 || (separator != NULL && entry[0] == '\0') ||
+               !storeDurability(separator != NULL ? entry : NULL, durability))
+            {
+                printf("Warning: Ignoring %s entry \"%.*s\".\n", DURABILITY_VARIABLE, (int) length, text);
+            }
+        }
+
+        text += length;
+        text += *text == ',';
+    }
+}
+
+/*
+ * Returns the level a name stands for, or -1 if it is not one.
+ */
+static int parseDurability(const char text[])
+{
+    if(strcmp(text, "sync") == 0)
+    {
+        return DURABILITY_SYNC;
+    }
+    if(strcmp(text, "atomic") == 0)
+    {
+        return DURABILITY_ATOMIC;
+    }
+    return -1;
+}
+
+/*
+ * Sets the default, or adds or updates one file's level. Must be called
+ * with settingsLock held, or before any other thread can read the levels.
+ * Returns 1 on success, 0 if the table is full or the name too long.
+ */
+static int storeDurability(const char fileName[], int durability)
+{
+    if(fileName == NULL)
+    {
+        defaultDurability = durability;
+        return DURABLE_SUCCESS;
+    }
+    if(strlen(fileName) >= MAX_DURABILITY_NAME_LENGTH)
+    {
+        return DURABLE_FAILURE;
+    }
+
+    int i = 0;
+    while(i < settingCount && strcmp(settings[i].fileName, fileName) != 0)
+    {
+        i++;
+    }
+    if(i == MAX_DURABILITY_SETTINGS)
+    {
+        return DURABLE_FAILURE;
+    }
+    if(i == settingCount)
+    {
+        strcpy(settings[settingCount++].fileName, fileName);
+    }
+
+    settings[i].durability = durability;
+    return DURABLE_SUCCESS;
+}
+
+/*
+ * Syncs the directory holding a file, so a rename in it is durable.
+ * Returns 1 on success, 0 otherwise.
+ */
+static int syncDirectory(const char fileName[])
+{
+    char        directory[4096];
+    const char *slash = strrchr(fileName, '/');
+
+    if(slash == NULL)
+    {
+        strcpy(directory, ".");
+    }
+    else if((size_t) (slash - fileName) >= sizeof(directory))
+    {
+        return 0;
+    }
+    else
+    {
+        size_t length = slash == fileName ? 1 : (size_t) (slash - fileName); // Keep "/" itself
+        memcpy(directory, fileName, length);
+        directory[length] = '\0';
+    }
+
+    int fd = open(directory, O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return 0;
+    }
+    int synced = fsync(fd) == 0;
+    close(fd);
+
+    return synced;
+}
+
+/*
+ * Writes size bytes iterations times, either over the benchmark file in
+ * place or through replaceFile at a durability level.
+ * Returns the average microseconds per write, or -1 on error.
+ */
+static double timeReplacements(int mode, const unsigned char data[], size_t size, int iterations)
+{
+    struct timespec start;
+    struct timespec end;
+
+    if(mode != BENCHMARK_IN_PLACE && !setFileDurability(BENCHMARK_FILE, mode))
+    {
+        return -1;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    for(int i = 0; i < iterations; i++)
+    {
+        const char *target = mode == BENCHMARK_IN_PLACE ? BENCHMARK_FILE : BENCHMARK_TEMP_FILE;
+        FILE       *file   = fopen(target, "wb");
+        if(file == NULL)
+        {
+            return -1;
+        }
+
+        int written = fwrite(data, 1, size, file) == size;
+        if(fclose(file) != 0 || !written ||
+           (mode != BENCHMARK_IN_PLACE && !replaceFile(BENCHMARK_TEMP_FILE, BENCHMARK_FILE)))
+        {
+            return -1;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    double elapsed = (double) (end.tv_sec - start.tv_sec) * 1e6 + (double) (end.tv_nsec - start.tv_nsec) / 1e3;
+    return elapsed / iterations;
+}
@@ -0,0 +1,95 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the durable replace used by every path that
+ *          rewrites a data file as a whole.
+ *
+ *          A new version is written to a temporary file and closed by the
+ *          caller, then replaceFile syncs its data, renames it over the old
+ *          file and syncs the directory, so after a crash or power loss the
+ *          file holds either the old version or the new one, never a torn
+ *          mix or nothing at all.
+ *
+ *          Each file can trade some of that for speed. DURABILITY_SYNC, the
+ *          default, survives power loss. DURABILITY_ATOMIC skips both syncs:
+ *          a crash of the program still leaves the old or the new version,
+ *          but a power loss may lose the newest version. Levels are set with
+ *          setFileDurability or the HOSPITAL_DURABILITY environment
+ *          variable, a comma-separated list such as
+ *          "atomic,patients.dat=sync", where a bare level sets the default
+ *          and FILE=LEVEL overrides it for one file.
+ */
+
+#ifndef DURABLE_FILE_H
+#define DURABLE_FILE_H
+
+#define DURABILITY_ATOMIC 0
+#define DURABILITY_SYNC 1
+
+#define MAX_DURABILITY_SETTINGS 16
+#define DEFAULT_DURABILITY_BENCHMARK_RUNS 50
+#define DURABILITY_VARIABLE "HOSPITAL_DURABILITY"
+
+#define DURABLE_SUCCESS 1
+#define DURABLE_FAILURE 0
+
+/*
+ * Function: replaceFile
+ * ---------------------
+ * Moves a fully written and closed temporary file over a data file, with
+ * the syncs fileName's durability level asks for. The temporary file must
+ * be in the same directory. On failure it is removed and the old file is
+ * left as it was.
+ *
+ * tempName: The new version
+ * fileName: The file to replace
+ *
+ * Returns: DURABLE_SUCCESS, or DURABLE_FAILURE on error
+ */
+int replaceFile(const char tempName[], const char fileName[]);
+
+/*
+ * Function: syncFile
+ * ------------------
+ * Syncs an open file's data if its durability level asks for it, for
+ * files that are appended to or updated in place.
+ *
+ * fd: The open file
+ * fileName: The file's name, to look up its level
+ *
+ * Returns: DURABLE_SUCCESS, or DURABLE_FAILURE on error
+ */
+int syncFile(int fd, const char fileName[]);
+
+/*
+ * Function: setFileDurability
+ * ---------------------------
+ * Sets the durability level of one file, overriding the environment.
+ *
+ * fileName: The file, or NULL to set the default for every other file
+ * durability: DURABILITY_SYNC or DURABILITY_ATOMIC
+ *
+ * Returns: DURABLE_SUCCESS, or DURABLE_FAILURE if MAX_DURABILITY_SETTINGS
+ *          files already have levels of their own
+ */
+int setFileDurability(const char fileName[], int durability);
+
+/*
+ * Function: getFileDurability
+ * ---------------------------
+ * Returns the durability level of a file.
+ */
+int getFileDurability(const char fileName[]);
+
+/*
+ * Function: benchmarkDurability
+ * -----------------------------
+ * Times replacing a scratch file in the current directory at each level,
+ * against overwriting it in place, for a small and a large file, and
+ * prints the average cost of one replacement.
+ *
+ * iterations: Replacements timed per measurement
+ */
+void benchmarkDurability(int iterations);
+
+#endif // DURABLE_FILE_H
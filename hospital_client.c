@@ -0,0 +1,369 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the thin client.
+ */
+
+#include "hospital_client.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "report_export.h"
+#include "server_protocol.h"
+
+// Private constants
+#define CLIENT_REQUEST_TAG 1 // One request per run, so any tag will do
+#define NO_CONNECTION (-1)
+
+// Function prototypes for internal helper functions
+static int  buildRequest(int argc, char *argv[], ProtocolMessage *request);
+static int  parseNumber(const char text[], int *value);
+static int  findWord(const char word[], const char *const words[], int count);
+static int  connectToServer(const char socketPath[]);
+static int  printResponse(int type, const ProtocolMessage *response);
+static void printProtocolPatient(const ProtocolPatient *patient);
+static void printUsage(void);
+
+/*
+ * Builds the request, exchanges it with the server and prints the result.
+ */
+int runClient(const char socketPath[], int argc, char *argv[])
+{
+    ProtocolMessage request  = { NULL, 0, 0, 0 };
+    ProtocolMessage response = { NULL, 0, 0, 0 };
+
+    if(!buildRequest(argc, argv, &request))
+    {
+        freeMessage(&request);
+        printUsage();
+        return CLIENT_FAILURE;
+    }
+    if(request.failed)
+    {
+        freeMessage(&request);
+        puts("Error: Unable to allocate request.");
+        return CLIENT_FAILURE;
+    }
+
+    int serverFd = connectToServer(socketPath);
+    if(serverFd < 0)
+    {
+        freeMessage(&request);
+        return CLIENT_FAILURE;
+    }
+
+    int exchanged = sendMessage(serverFd, &request) && receiveMessage(serverFd, &response, MAX_RESPONSE_SIZE);
+    close(serverFd);
+
+    int result = CLIENT_FAILURE;
+    if(!exchanged)
+    {
+        puts("Error: The server closed the connection.");
+    }
+    else
+    {
+        result = printResponse(request.data[0], &response);
+    }
+
+    freeMessage(&request);
+    freeMessage(&response);
+    return result;
+}
+
+/*
+ * Encodes a command line as a request.
+ * Returns 1 on success, 0 if the command or its arguments are invalid.
+ */
+static int buildRequest(int argc, char *argv[], ProtocolMessage *request)
+{
+    static const char *const reports[]    = { "admissions", "discharges", "rooms", "doctors" };
+    static const char *const formats[]    = { "csv", "json" };
+    static const char *const timeframes[] = { "daily", "weekly", "monthly" };
+
+    int number;
+
+    if(argc < 1)
+    {
+        return 0;
+    }
+
+    if(strcmp(argv[0], "admit") == 0 && argc == 5)
+    {
+        int age;
+        int room;
+        if(!parseNumber(argv[2], &age) || !parseNumber(argv[4], &room) ||
+           strlen(argv[1]) >= MAX_PATIENT_NAME_LENGTH || strlen(argv[3]) >= MAX_DIAGNOSIS_LENGTH)
+        {
+            return 0;
+        }
+
+        putByte(request, REQUEST_ADMIT);
+        putVarint(request, CLIENT_REQUEST_TAG);
+        putString(request, argv[1]);
+        putVarint(request, (unsigned long long) age);
+        putString(request, argv[3]);
+        putVarint(request, (unsigned long long) room);
+        return 1;
+    }
+
+    if(strcmp(argv[0], "discharge") == 0 && argc >= 2 && argc - 1 <= MAX_DISCHARGE_REQUEST_IDS)
+    {
+        putByte(request, REQUEST_DISCHARGE);
+        putVarint(request, CLIENT_REQUEST_TAG);
+        putVarint(request, (unsigned long long) (argc - 1));
+        for(int i = 1; i < argc; i++)
+        {
+            if(!parseNumber(argv[i], &number))
+            {
+                return 0;
+            }
+            putVarint(request, (unsigned long long) number);
+        }
+        return 1;
+    }
+
+    if(strcmp(argv[0], "lookup") == 0 && argc == 2 && parseNumber(argv[1], &number))
+    {
+        putByte(request, REQUEST_LOOKUP);
+        putVarint(request, CLIENT_REQUEST_TAG);
+        putVarint(request, (unsigned long long) number);
+        return 1;
+    }
+
+    if(strcmp(argv[0], "report") == 0 && argc >= 2 && argc <= 4)
+    {
+        int report    = findWord(argv[1], reports, 4);
+        int format    = argc >= 3 ? findWord(argv[2], formats, 2) : EXPORT_FORMAT_CSV;
+        int timeframe = argc >= 4 ? findWord(argv[3], timeframes, 3) : 1;
+        if(report == 0 || format == 0 || timeframe == 0)
+        {
+            return 0;
+        }
+
+        putByte(request, REQUEST_REPORT);
+        putVarint(request, CLIENT_REQUEST_TAG);
+        putByte(request, report);
+        putByte(request, format);
+        putByte(request, timeframe);
+        return 1;
+    }
+
+    if(strcmp(argv[0], "assign") == 0 && (argc == 4 || (argc == 5 && strcmp(argv[4], "replace") == 0)))
+    {
+        int doctorId;
+        int day;
+        int time;
+        if(!parseNumber(argv[1], &doctorId) || !parseNumber(argv[2], &day) || !parseNumber(argv[3], &time) ||
+           day > 255 || time > 255)
+        {
+            return 0;
+        }
+
+        putByte(request, REQUEST_ASSIGN);
+        putVarint(request, CLIENT_REQUEST_TAG);
+        putVarint(request, (unsigned long long) doctorId);
+        putByte(request, day);
+        putByte(request, time);
+        putByte(request, argc == 5);
+        return 1;
+    }
+
+    return 0;
+}
+
+/*
+ * Parses a whole non-negative decimal number.
+ * Returns 1 on success, 0 otherwise.
+ */
+static int parseNumber(const char text[], int *value)
+{
+    char *end;
+    long  parsed = strtol(text, &end, 10);
+
+    if(end == text || *end != '\0' || parsed < 0 || parsed > 0x7fffffffL)
+    {
+        return 0;
+    }
+
+    *value = (int) parsed;
+    return 1;
+}
+
+/*
+ * Returns the 1-based position of a word in a list, or 0 if absent.
+ */
+static int findWord(const char word[], const char *const words[], int count)
+{
+    for(int i = 0; i < count; i++)
+    {
+        if(strcmp(word, words[i]) == 0)
+        {
+            return i + 1;
+        }
+    }
+    return 0;
+}
+
+/*
+ * Connects to the server socket.
+ * Returns the connected descriptor, or -1 with a message.
+ */
+static int connectToServer(const char socketPath[])
+{
+    struct sockaddr_un address;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(strlen(socketPath) >= sizeof(address.sun_path))
+    {
+        printf("Error: Socket path %s is too long.\n", socketPath);
+        return NO_CONNECTION;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    int serverFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(serverFd < 0 || connect(serverFd, (struct sockaddr *) &address, sizeof(address)) != 0)
+    {
+        printf("Error: No server is running on %s.\n", socketPath);
+        if(serverFd >= 0)
+        {
+            close(serverFd);
+        }
+        return NO_CONNECTION;
+    }
+
+    return serverFd;
+}
+
+/*
+ * Prints the server's answer to a request of the given type.
+ * Returns CLIENT_SUCCESS if the request was carried out.
+ */
+static int printResponse(int type, const ProtocolMessage *response)
+{
+    ProtocolReader  reader;
+    ProtocolPatient patient;
+
+    openReader(&reader, response);
+    int status = getByte(&reader);
+    getVarint(&reader); // Tag
+
+    if(reader.failed)
+    {
+        puts("Error: The server sent a malformed response.");
+        return CLIENT_FAILURE;
+    }
+
+    switch(status)
+    {
+        case RESPONSE_OK:
+            break;
+        case RESPONSE_NOT_FOUND:
+            puts(type == REQUEST_DISCHARGE ? "None of those patients are admitted." : "Patient doesn't exist!");
+            return CLIENT_FAILURE;
+        case RESPONSE_INVALID:
+            puts("Invalid details. Request not carried out.");
+            return CLIENT_FAILURE;
+        case RESPONSE_CONFLICT:
+            puts(type == REQUEST_ASSIGN ? "Another doctor is already assigned. Add 'replace' to proceed."
+                                        : "Room already occupied. Patient not added.");
+            return CLIENT_FAILURE;
+        case RESPONSE_FAILED:
+            puts("Error: The server was unable to carry out the request.");
+            return CLIENT_FAILURE;
+        default:
+            puts("Error: The server did not understand the request.");
+            return CLIENT_FAILURE;
+    }
+
+    if(type == REQUEST_ADMIT)
+    {
+        getPatient(&reader, &patient);
+        int previousPatientId  = (int) getVarint(&reader);
+        int daysSinceDischarge = (int) getVarint(&reader);
+        int withinWindow       = getByte(&reader);
+
+        printf("--- Patient Added ---\n");
+        printProtocolPatient(&patient);
+        if(!reader.failed && previousPatientId != 0)
+        {
+            printf("%s: previously discharged %d day(s) ago as patient ID %d\n",
+                   withinWindow ? "30-day readmission" : "Returning patient", daysSinceDischarge, previousPatientId);
+        }
+    }
+    else if(type == REQUEST_DISCHARGE)
+    {
+        printf("%d patient(s) discharged.\n", (int) getVarint(&reader));
+    }
+    else if(type == REQUEST_LOOKUP)
+    {
+        int discharged = getByte(&reader);
+        getPatient(&reader, &patient);
+        printProtocolPatient(&patient);
+        if(discharged)
+        {
+            time_t dischargeDate = (time_t) getVarint(&reader);
+            char   dischargeDateStr[20];
+            strftime(dischargeDateStr, sizeof(dischargeDateStr), "%Y-%m-%d", localtime(&dischargeDate));
+            printf("Discharged: %s\n", dischargeDateStr);
+        }
+    }
+    else if(type == REQUEST_REPORT)
+    {
+        fwrite(response->data + reader.position, 1, response->length - reader.position, stdout);
+    }
+    else
+    {
+        puts("Doctor assigned.");
+    }
+
+    if(reader.failed)
+    {
+        puts("Error: The server sent a malformed response.");
+        return CLIENT_FAILURE;
+    }
+    return CLIENT_SUCCESS;
+}
+
+/*
+ * Prints a patient the way printPatient does.
+ */
+static void printProtocolPatient(const ProtocolPatient *patient)
+{
+    struct tm admissionTime;
+    char      admissionStr[32];
+
+    localtime_r(&patient->admissionDate, &admissionTime);
+    strftime(admissionStr, sizeof(admissionStr), "%a %b %e %H:%M:%S %Y", &admissionTime);
+
+    printf("---------------------------------------\n"
+           "Patient ID: %d\n"
+           "Patient Name: %s\n"
+           "Age: %d\n"
+           "Diagnosis: %s\n"
+           "Room Number: %d\n"
+           "Time Admitted: %s\n"
+           "---------------------------------------\n",
+           patient->patientId,
+           patient->name,
+           patient->ageInYears,
+           patient->diagnosis,
+           patient->roomNumber,
+           admissionStr);
+}
+
+/*
+ * Lists the client commands.
+ */
+static void printUsage(void)
+{
+    puts("Usage: hospital client COMMAND\n"
+         "  admit NAME AGE DIAGNOSIS ROOM\n"
+         "  discharge ID [ID...]\n"
+         "  lookup ID\n"
+         "  report admissions|discharges|rooms|doctors [csv|json] [daily|weekly|monthly]\n"
+         "  assign DOCTOR_ID DAY(0-6) TIME(0-2) [replace]");
+}
@@ -0,0 +1,40 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the thin client, which sends one request to
+ *          a running hospital server and prints the answer. It loads no
+ *          data files of its own, so it starts instantly however large the
+ *          records grow.
+ *
+ *          Commands (days 0-6 start on Monday, times 0-2 are Morning,
+ *          Afternoon and Evening, as in the doctor menu):
+ *
+ *            admit NAME AGE DIAGNOSIS ROOM
+ *            discharge ID [ID...]
+ *            lookup ID
+ *            report admissions|discharges|rooms|doctors [csv|json]
+ *                   [daily|weekly|monthly]
+ *            assign DOCTOR_ID DAY TIME [replace]
+ */
+
+#ifndef HOSPITAL_CLIENT_H
+#define HOSPITAL_CLIENT_H
+
+#define CLIENT_SUCCESS 1
+#define CLIENT_FAILURE 0
+
+/*
+ * Function: runClient
+ * -------------------
+ * Runs one client command against the server.
+ *
+ * socketPath: The server's socket
+ * argc: The number of command words
+ * argv: The command name followed by its arguments
+ *
+ * Returns: CLIENT_SUCCESS if the server carried out the request, or
+ *          CLIENT_FAILURE otherwise
+ */
+int runClient(const char socketPath[], int argc, char *argv[]);
+
+#endif // HOSPITAL_CLIENT_H
@@ -0,0 +1,1281 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the hospital server.
+ *
+ *          One thread runs an epoll loop over every connection. Sockets are
+ *          non-blocking, and each read is split into as many complete frames
+ *          as it holds, so a client may pipeline requests. Reports can take
+ *          seconds on a large store, so they are queued for a small pool of
+ *          workers, which hand the finished response back through an
+ *          eventfd. A lookup sent after a monthly report is therefore
+ *          answered before it, and clients match responses to requests by
+ *          tag. Discharges and doctor assignments rewrite and sync files, so
+ *          they go in order to a single store worker and are answered the
+ *          same way. Admissions and lookups are carried out on the loop,
+ *          except that while store updates are outstanding an admission is
+ *          queued behind them rather than wait for the store lock, and so is
+ *          a lookup from a connection with its own updates outstanding, so
+ *          that it sees them. An admission is answered once the admission
+ *          log has made it durable, so admissions from every connection
+ *          share one sync. The loop itself waits on the disk only when a
+ *          lookup reads the discharge archive's tail block while it is being
+ *          sealed.
+ *
+ *          SIGINT and SIGTERM are blocked in every thread and read from a
+ *          signalfd by the loop, so a stop request is never lost between
+ *          checks. On a stop the listener is closed, no further requests are
+ *          read, and answers already owed are delivered for a few seconds
+ *          before the remaining connections are closed.
+ */
+
+#define _GNU_SOURCE // accept4
+
+#include "hospital_server.h"
+#include <errno.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <time.h>
+#include <unistd.h>
+#include "admission_log.h"
+#include "discharge_index.h"
+#include "doctor_schedule.h"
+#include "patient_management.h"
+#include "patient_storage.h"
+#include "readmission.h"
+#include "report_export.h"
+#include "report_writer.h"
+#include "server_protocol.h"
+
+// Private constants
+#define NO_DESCRIPTOR (-1)
+#define LISTENER_TOKEN MAX_SERVER_CONNECTIONS // Event tokens below this are connection slots
+#define SIGNAL_TOKEN (MAX_SERVER_CONNECTIONS + 1)
+#define COMPLETION_TOKEN (MAX_SERVER_CONNECTIONS + 2)
+#define MAX_SERVER_EVENTS 64
+#define READ_CHUNK_SIZE 16384
+#define OUTPUT_HIGH_WATER (1024 * 1024) // Stop reading while this much is unsent
+#define MAX_CONNECTION_ANSWERS 8        // Stop reading while this many answers are deferred
+#define STOP_GRACE_MILLISECONDS 5000
+#define ANSWER_DEFERRED 2 // Handler result: the response waits for a group commit
+
+// A client connection. The generation changes whenever the slot is reused,
+// so an answer finishing after its connection closed is dropped.
+typedef struct Connection
+{
+    int             fd;
+    unsigned int    generation;
+    uint32_t        events;         // The events epoll is watching for
+    ProtocolMessage input;          // Received bytes not yet split into frames
+    ProtocolMessage output;         // Framed responses not yet sent
+    size_t          outputSent;
+    int             pendingAnswers; // Reports, admissions and updates not yet answered
+    int             pendingUpdates; // Requests with the store worker not yet answered
+    int             readClosed;     // The client will send nothing more
+    int             hungUp;         // The client is gone; answers are dropped
+} Connection;
+
+// A request whose answer is deferred: a report or store update waiting for
+// or returned by a worker, or an admission waiting for its group commit
+typedef struct ServerJob
+{
+    int               slot;
+    unsigned int      generation;
+    int               storeUpdate; // Queued for the store worker
+    ProtocolMessage   request;
+    ProtocolMessage   response;
+    PendingAdmission  commit;
+    struct ServerJob *next;
+} ServerJob;
+
+// Jobs waiting for a worker, oldest first
+typedef struct JobQueue
+{
+    ServerJob      *first;
+    ServerJob      *last;
+    pthread_cond_t  ready;
+} JobQueue;
+
+// Event loop state, used only by the loop thread
+static Connection      connections[MAX_SERVER_CONNECTIONS];
+static int             openConnections = 0;
+static int             epollFd         = NO_DESCRIPTOR;
+static int             listenFd        = NO_DESCRIPTOR;
+static int             signalFd        = NO_DESCRIPTOR;
+static int             completionFd    = NO_DESCRIPTOR;
+static int             stopping        = 0;
+static ProtocolMessage inlineResponse  = { NULL, 0, 0, 0 };
+static int             storeUpdates    = 0; // Jobs given to the store worker and not yet delivered
+
+// Report workers, then the store worker
+static pthread_t       workers[SERVER_REPORT_WORKERS + 1];
+static int             workerCount     = 0;
+static JobQueue        reportJobs      = { NULL, NULL, PTHREAD_COND_INITIALIZER };
+static JobQueue        storeJobs       = { NULL, NULL, PTHREAD_COND_INITIALIZER };
+static ServerJob      *finishedJobs    = NULL; // Newest first
+static int             workersStopping = 0;
+static pthread_mutex_t jobsLock        = PTHREAD_MUTEX_INITIALIZER;
+
+// Function prototypes for internal helper functions
+static int        openListener(const char socketPath[]);
+static int        openEventLoop(const sigset_t *stopSignals);
+static void       closeEventLoop(void);
+static int        watchDescriptor(int fd, uint32_t events, int token);
+static void       runEventLoop(void);
+static void       beginStop(void);
+static int        millisecondsUntil(const struct timespec *deadline);
+static void       acceptConnections(void);
+static void       closeConnection(int slot);
+static void       abandonConnection(int slot);
+static int        readConnection(int slot);
+static int        processInput(int slot);
+static void       dispatchRequest(int slot, const ProtocolMessage *request);
+static int        isThrottled(const Connection *connection);
+static int        flushOutput(int slot);
+static void       updateConnection(int slot);
+static int        startWorkers(void);
+static void       stopWorkers(void);
+static ServerJob *createServerJob(int slot);
+static int        queueJob(int slot, const ProtocolMessage *request, JobQueue *queue);
+static void       finishAdmission(PendingAdmission *admission);
+static void       finishJob(ServerJob *job);
+static void       deliverAnswers(void);
+static void       freeServerJob(ServerJob *job);
+static void      *runJobs(void *argument);
+static int        handleRequest(const ProtocolMessage *request, ProtocolMessage *response, PendingAdmission *commit);
+static void       beginResponse(ProtocolMessage *response, int status, unsigned long long tag);
+static int        handleAdmit(ProtocolReader *reader,
+                              ProtocolMessage *response,
+                              unsigned long long tag,
+                              PendingAdmission *commit);
+static int        handleDischarge(ProtocolReader *reader, ProtocolMessage *response, unsigned long long tag);
+static int        handleLookup(ProtocolReader *reader, ProtocolMessage *response, unsigned long long tag);
+static int        handleReport(ProtocolReader *reader, ProtocolMessage *response, unsigned long long tag);
+static int        handleAssign(ProtocolReader *reader, ProtocolMessage *response, unsigned long long tag);
+static int        writeToResponse(void *target, const char data[], size_t length);
+
+/*
+ * Sets up the listener, event loop and workers, serves until a stop is
+ * requested, then tears everything down.
+ */
+int runServer(const char socketPath[])
+{
+    sigset_t stopSignals;
+
+    // Block the stop signals everywhere; the workers created below inherit this
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, NULL);
+
+    listenFd = openListener(socketPath);
+    if(listenFd < 0)
+    {
+        return SERVER_FAILURE;
+    }
+
+    if(!openEventLoop(&stopSignals) || !startWorkers())
+    {
+        closeEventLoop();
+        unlink(socketPath);
+        return SERVER_FAILURE;
+    }
+
+    printf("Serving requests on %s. Press Ctrl+C to stop.\n", socketPath);
+    runEventLoop();
+
+    puts("Stopping server.");
+    unlink(socketPath);
+    stopWorkers();
+    for(int slot = 0; slot < MAX_SERVER_CONNECTIONS; slot++)
+    {
+        closeConnection(slot);
+    }
+    closeEventLoop();
+    freeMessage(&inlineResponse);
+
+    return SERVER_SUCCESS;
+}
+
+/*
+ * Creates, binds and listens on a non-blocking socket. A socket file left
+ * behind by a server that is no longer running is replaced.
+ * Returns the listening descriptor, or -1 on error.
+ */
+static int openListener(const char socketPath[])
+{
+    struct sockaddr_un address;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(strlen(socketPath) >= sizeof(address.sun_path))
+    {
+        printf("Error: Socket path %s is too long.\n", socketPath);
+        return NO_DESCRIPTOR;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    if(isServerRunning(socketPath))
+    {
+        printf("Error: A server is already running on %s.\n", socketPath);
+        return NO_DESCRIPTOR;
+    }
+    unlink(socketPath);
+
+    int socketFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if(socketFd < 0)
+    {
+        perror("Error creating server socket");
+        return NO_DESCRIPTOR;
+    }
+
+    if(bind(socketFd, (struct sockaddr *) &address, sizeof(address)) != 0 ||
+       listen(socketFd, SERVER_LISTEN_BACKLOG) != 0)
+    {
+        perror("Error listening on server socket");
+        close(socketFd);
+        return NO_DESCRIPTOR;
+    }
+
+    return socketFd;
+}
+
+/*
+ * Tries to connect to the socket path.
+ */
+int isServerRunning(const char socketPath[])
+{
+    struct sockaddr_un address;
+
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    if(strlen(socketPath) >= sizeof(address.sun_path))
+    {
+        return 0;
+    }
+    strcpy(address.sun_path, socketPath);
+
+    int probeFd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if(probeFd < 0)
+    {
+        return 0;
+    }
+
+    int running = connect(probeFd, (struct sockaddr *) &address, sizeof(address)) == 0;
+    close(probeFd);
+    return running;
+}
+
+/*
+ * Creates the epoll instance, the signalfd and the worker eventfd, and
+ * watches them together with the listener.
+ * Returns SERVER_SUCCESS, or SERVER_FAILURE with a message.
+ */
+static int openEventLoop(const sigset_t *stopSignals)
+{
+    for(int slot = 0; slot < MAX_SERVER_CONNECTIONS; slot++)
+    {
+        connections[slot].fd = NO_DESCRIPTOR;
+    }
+    stopping = 0;
+
+    epollFd      = epoll_create1(EPOLL_CLOEXEC);
+    signalFd     = signalfd(-1, stopSignals, SFD_NONBLOCK | SFD_CLOEXEC);
+    completionFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if(epollFd < 0 || signalFd < 0 || completionFd < 0 ||
+       !watchDescriptor(listenFd, EPOLLIN, LISTENER_TOKEN) ||
+       !watchDescriptor(signalFd, EPOLLIN, SIGNAL_TOKEN) ||
+       !watchDescriptor(completionFd, EPOLLIN, COMPLETION_TOKEN))
+    {
+        perror("Error setting up the server event loop");
+        return SERVER_FAILURE;
+    }
+
+    return SERVER_SUCCESS;
+}
+
+/*
+ * Closes whichever of the loop's own descriptors are open.
+ */
+static void closeEventLoop(void)
+{
+    int *descriptors[] = { &listenFd, &signalFd, &completionFd, &epollFd };
+
+    for(size_t i = 0; i < sizeof(descriptors) / sizeof(descriptors[0]); i++)
+    {
+        if(*descriptors[i] >= 0)
+        {
+            close(*descriptors[i]);
+            *descriptors[i] = NO_DESCRIPTOR;
+        }
+    }
+}
+
+/*
+ * Adds a descriptor to the epoll set under a token.
+ * Returns 1 on success, 0 otherwise.
+ */
+static int watchDescriptor(int fd, uint32_t events, int token)
+{
+    struct epoll_event event;
+
+    memset(&event, 0, sizeof(event));
+    event.events   = events;
+    event.data.u32 = (uint32_t) token;
+    return epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+/*
+ * Waits for and dispatches events until a stop has been requested and
+ * every connection has been answered or the grace period has run out.
+ */
+static void runEventLoop(void)
+{
+    struct epoll_event events[MAX_SERVER_EVENTS];
+    struct timespec    deadline;
+
+    for(;;)
+    {
+        int timeout = -1;
+        if(stopping)
+        {
+            timeout = millisecondsUntil(&deadline);
+            if(openConnections == 0 || timeout == 0)
+            {
+                return;
+            }
+        }
+
+        int eventCount = epoll_wait(epollFd, events, MAX_SERVER_EVENTS, timeout);
+        if(eventCount < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            perror("Error waiting for server events");
+            return;
+        }
+
+        for(int i = 0; i < eventCount; i++)
+        {
+            uint32_t token = events[i].data.u32;
+
+            if(token == LISTENER_TOKEN)
+            {
+                acceptConnections();
+            }
+            else if(token == SIGNAL_TOKEN)
+            {
+                struct signalfd_siginfo signalInfo;
+                if(read(signalFd, &signalInfo, sizeof(signalInfo)) == sizeof(signalInfo) && !stopping)
+                {
+                    clock_gettime(CLOCK_MONOTONIC, &deadline);
+                    deadline.tv_sec += STOP_GRACE_MILLISECONDS / 1000;
+                    beginStop();
+                }
+            }
+            else if(token == COMPLETION_TOKEN)
+            {
+                uint64_t completions;
+                if(read(completionFd, &completions, sizeof(completions)) == sizeof(completions))
+                {
+                    deliverAnswers();
+                }
+            }
+            else if(connections[token].fd != NO_DESCRIPTOR)
+            {
+                if(events[i].events & (EPOLLHUP | EPOLLERR))
+                {
+                    abandonConnection((int) token);
+                    continue;
+                }
+                if((events[i].events & EPOLLIN) && readConnection((int) token) < 0)
+                {
+                    continue;
+                }
+                updateConnection((int) token);
+            }
+        }
+    }
+}
+
+/*
+ * Stops accepting connections and reading requests. Connections with
+ * nothing owed are closed by updateConnection straight away.
+ */
+static void beginStop(void)
+{
+    stopping = 1;
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, listenFd, NULL);
+    close(listenFd);
+    listenFd = NO_DESCRIPTOR;
+
+    for(int slot = 0; slot < MAX_SERVER_CONNECTIONS; slot++)
+    {
+        updateConnection(slot);
+    }
+}
+
+/*
+ * Returns the milliseconds left until a monotonic deadline, or 0 once it
+ * has passed.
+ */
+static int millisecondsUntil(const struct timespec *deadline)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long long remaining = (long long) (deadline->tv_sec - now.tv_sec) * 1000 +
+                          (deadline->tv_nsec - now.tv_nsec) / 1000000;
+    return remaining > 0 ? (int) remaining : 0;
+}
+
+/*
+ * Accepts every waiting connection into a free slot.
+ */
+static void acceptConnections(void)
+{
+    for(;;)
+    {
+        int clientFd = accept4(listenFd, NULL, NULL, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if(clientFd < 0)
+        {
+            if(errno == EINTR || errno == ECONNABORTED)
+            {
+                continue;
+            }
+            return;
+        }
+
+        int slot = 0;
+        while(slot < MAX_SERVER_CONNECTIONS && connections[slot].fd != NO_DESCRIPTOR)
+        {
+            slot++;
+        }
+
+        if(slot == MAX_SERVER_CONNECTIONS || !watchDescriptor(clientFd, EPOLLIN, slot))
+        {
+            puts("Error: Unable to serve another connection. Connection refused.");
+            close(clientFd);
+            continue;
+        }
+
+        Connection *connection = &connections[slot];
+        memset(&connection->input, 0, sizeof(connection->input));
+        memset(&connection->output, 0, sizeof(connection->output));
+        connection->fd             = clientFd;
+        connection->events         = EPOLLIN;
+        connection->outputSent     = 0;
+        connection->pendingAnswers = 0;
+        connection->pendingUpdates = 0;
+        connection->readClosed     = 0;
+        connection->hungUp         = 0;
+        openConnections++;
+    }
+}
+
+/*
+ * Closes a connection and frees its slot. Any of its reports still with a
+ * worker are dropped when they finish.
+ */
+static void closeConnection(int slot)
+{
+    Connection *connection = &connections[slot];
+
+    if(connection->fd == NO_DESCRIPTOR)
+    {
+        return;
+    }
+
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, connection->fd, NULL);
+    close(connection->fd);
+    freeMessage(&connection->input);
+    freeMessage(&connection->output);
+    connection->fd = NO_DESCRIPTOR;
+    connection->generation++;
+    openConnections--;
+}
+
+/*
+ * Handles a client that has hung up: carries out the requests it sent
+ * before going, without answering them, and closes the connection.
+ */
+static void abandonConnection(int slot)
+{
+    int received;
+
+    connections[slot].hungUp = 1;
+    do
+    {
+        received = readConnection(slot);
+    } while(received > 0);
+
+    if(received == 0)
+    {
+        closeConnection(slot);
+    }
+}
+
+/*
+ * Reads what the socket has and splits it into requests.
+ * Returns 1 if data was read, 0 if there was none or the client finished
+ * sending, or -1 if the connection was closed.
+ */
+static int readConnection(int slot)
+{
+    Connection   *connection = &connections[slot];
+    unsigned char buffer[READ_CHUNK_SIZE];
+
+    ssize_t received = read(connection->fd, buffer, sizeof(buffer));
+    if(received < 0)
+    {
+        if(errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR)
+        {
+            return 0;
+        }
+        closeConnection(slot);
+        return -1;
+    }
+    if(received == 0)
+    {
+        connection->readClosed = 1;
+        return 0;
+    }
+
+    putBytes(&connection->input, buffer, (size_t) received);
+    if(connection->input.failed)
+    {
+        closeConnection(slot);
+        return -1;
+    }
+
+    return processInput(slot) ? 1 : -1;
+}
+
+/*
+ * Carries out every complete request in the input buffer, pausing while
+ * the connection is throttled, and keeps any partial frame for later.
+ * Returns 1, or 0 if a frame was too large and the connection was closed.
+ */
+static int processInput(int slot)
+{
+    Connection *connection = &connections[slot];
+    size_t      position   = 0;
+
+    while(!isThrottled(connection) && connection->input.length - position >= FRAME_HEADER_SIZE)
+    {
+        size_t length = (size_t) loadLittleEndian(connection->input.data + position, FRAME_HEADER_SIZE);
+        if(length > MAX_REQUEST_SIZE)
+        {
+            closeConnection(slot);
+            return 0;
+        }
+        if(connection->input.length - position - FRAME_HEADER_SIZE < length)
+        {
+            break;
+        }
+
+        ProtocolMessage request = { connection->input.data + position + FRAME_HEADER_SIZE, length, length, 0 };
+        dispatchRequest(slot, &request);
+        position += FRAME_HEADER_SIZE + length;
+    }
+
+    if(position > 0)
+    {
+        memmove(connection->input.data, connection->input.data + position, connection->input.length - position);
+        connection->input.length -= position;
+    }
+    return 1;
+}
+
+/*
+ * Queues a report for the report workers or a store update for the store
+ * worker, carries out an admission and defers its answer until the
+ * admission is durable, or answers a lookup inline. An admission waits
+ * behind outstanding store updates, and a lookup behind its own
+ * connection's. A request that cannot be deferred is answered inline
+ * instead.
+ */
+static void dispatchRequest(int slot, const ProtocolMessage *request)
+{
+    Connection *connection  = &connections[slot];
+    int         type        = request->length > 0 ? request->data[0] : 0;
+    int         storeUpdate = type == REQUEST_DISCHARGE || type == REQUEST_ASSIGN ||
+                              (type == REQUEST_ADMIT && storeUpdates > 0) ||
+                              (type == REQUEST_LOOKUP && connection->pendingUpdates > 0);
+
+    if(type == REQUEST_REPORT && connection->hungUp)
+    {
+        return; // Nobody is left to read it
+    }
+    if(type == REQUEST_REPORT && queueJob(slot, request, &reportJobs))
+    {
+        connection->pendingAnswers++;
+        return;
+    }
+    if(storeUpdate && queueJob(slot, request, &storeJobs))
+    {
+        connection->pendingAnswers++;
+        connection->pendingUpdates++;
+        storeUpdates++;
+        return;
+    }
+
+    // An admission's answer is held in a job until the group commit calls
+    // finishAdmission
+    ServerJob *job = type == REQUEST_ADMIT ? createServerJob(slot) : NULL;
+
+    ProtocolMessage *response = job != NULL ? &job->response : &inlineResponse;
+    if(handleRequest(request, response, job != NULL ? &job->commit : NULL))
+    {
+        connection->pendingAnswers++;
+        return;
+    }
+
+    if(!connection->hungUp)
+    {
+        appendFrame(&connection->output, response);
+    }
+    if(job != NULL)
+    {
+        freeServerJob(job);
+    }
+}
+
+/*
+ * Returns 1 if the connection already owes enough that it should not be
+ * sent more work until some of it is delivered.
+ */
+static int isThrottled(const Connection *connection)
+{
+    return !connection->hungUp &&
+           (connection->pendingAnswers >= MAX_CONNECTION_ANSWERS ||
+            connection->output.length - connection->outputSent >= OUTPUT_HIGH_WATER);
+}
+
+/*
+ * Sends as much pending output as the socket accepts.
+ * Returns 1, or 0 if the connection failed and was closed.
+ */
+static int flushOutput(int slot)
+{
+    Connection      *connection = &connections[slot];
+    ProtocolMessage *output     = &connection->output;
+
+    if(output->failed)
+    {
+        closeConnection(slot);
+        return 0;
+    }
+
+    while(connection->outputSent < output->length)
+    {
+        ssize_t written = send(connection->fd, output->data + connection->outputSent,
+                               output->length - connection->outputSent, MSG_NOSIGNAL);
+        if(written < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            if(errno == EAGAIN || errno == EWOULDBLOCK)
+            {
+                break;
+            }
+            closeConnection(slot);
+            return 0;
+        }
+        connection->outputSent += (size_t) written;
+    }
+
+    if(connection->outputSent == output->length)
+    {
+        // Give back the memory of a large report once it is sent
+        if(output->capacity > OUTPUT_HIGH_WATER)
+        {
+            freeMessage(output);
+        }
+        resetMessage(output);
+        connection->outputSent = 0;
+    }
+    else if(connection->outputSent >= output->length / 2)
+    {
+        // Compacting only once half is sent keeps this linear overall
+        memmove(output->data, output->data + connection->outputSent, output->length - connection->outputSent);
+        output->length        -= connection->outputSent;
+        connection->outputSent = 0;
+    }
+
+    return 1;
+}
+
+/*
+ * Brings a connection up to date after anything has happened to it:
+ * carries out requests a lifted throttle has released, sends what it can,
+ * closes the connection once it is finished, and otherwise watches for
+ * exactly the events it is ready for.
+ */
+static void updateConnection(int slot)
+{
+    Connection *connection = &connections[slot];
+
+    if(connection->fd == NO_DESCRIPTOR || !processInput(slot) || !flushOutput(slot))
+    {
+        return;
+    }
+
+    int owesNothing = connection->pendingAnswers == 0 && connection->output.length == 0;
+    if((connection->readClosed || stopping) && owesNothing)
+    {
+        closeConnection(slot);
+        return;
+    }
+
+    uint32_t events = 0;
+    if(!connection->readClosed && !stopping && !isThrottled(connection))
+    {
+        events |= EPOLLIN;
+    }
+    if(connection->output.length > 0)
+    {
+        events |= EPOLLOUT;
+    }
+
+    if(events != connection->events)
+    {
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events   = events;
+        event.data.u32 = (uint32_t) slot;
+        epoll_ctl(epollFd, EPOLL_CTL_MOD, connection->fd, &event);
+        connection->events = events;
+    }
+}
+
+/*
+ * Starts the report workers and the store worker.
+ * Returns SERVER_SUCCESS, or SERVER_FAILURE with a message.
+ */
+static int startWorkers(void)
+{
+    workersStopping = 0;
+    storeUpdates    = 0;
+
+    while(workerCount <= SERVER_REPORT_WORKERS)
+    {
+        JobQueue *queue = workerCount < SERVER_REPORT_WORKERS ? &reportJobs : &storeJobs;
+        if(pthread_create(&workers[workerCount], NULL, runJobs, queue) != 0)
+        {
+            puts("Error: Unable to start the server workers.");
+            stopWorkers();
+            return SERVER_FAILURE;
+        }
+        workerCount++;
+    }
+
+    return SERVER_SUCCESS;
+}
+
+/*
+ * Stops the report workers once they finish the report they are on and
+ * the store worker once it has carried out every update it was given,
+ * waits for the last admissions to commit, and frees every job that was
+ * not delivered.
+ */
+static void stopWorkers(void)
+{
+    pthread_mutex_lock(&jobsLock);
+    workersStopping = 1;
+    pthread_cond_broadcast(&reportJobs.ready);
+    pthread_cond_broadcast(&storeJobs.ready);
+    pthread_mutex_unlock(&jobsLock);
+
+    for(int i = 0; i < workerCount; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+    workerCount = 0;
+    flushAdmissionLog(); // No commit callback may still be running
+
+    ServerJob *lists[] = { reportJobs.first, finishedJobs };
+    for(int i = 0; i < 2; i++)
+    {
+        while(lists[i] != NULL)
+        {
+            ServerJob *next = lists[i]->next;
+            freeServerJob(lists[i]);
+            lists[i] = next;
+        }
+    }
+    reportJobs.first = NULL;
+    reportJobs.last  = NULL;
+    finishedJobs     = NULL;
+}
+
+/*
+ * Allocates a job answering to a connection's current generation. An
+ * admission carried out with the job's commit storage hands its answer
+ * back through finishAdmission.
+ * Returns the job, or NULL if memory ran out.
+ */
+static ServerJob *createServerJob(int slot)
+{
+    ServerJob *job = calloc(1, sizeof(ServerJob));
+    if(job != NULL)
+    {
+        job->slot            = slot;
+        job->generation      = connections[slot].generation;
+        job->commit.onCommit = finishAdmission;
+        job->commit.context  = job;
+    }
+    return job;
+}
+
+/*
+ * Copies a request into a job and hands it to a queue's workers.
+ * Returns 1 on success, 0 if the job could not be allocated.
+ */
+static int queueJob(int slot, const ProtocolMessage *request, JobQueue *queue)
+{
+    ServerJob *job = createServerJob(slot);
+    if(job == NULL)
+    {
+        return 0;
+    }
+
+    job->storeUpdate = queue == &storeJobs;
+    putBytes(&job->request, request->data, request->length);
+    if(job->request.failed)
+    {
+        freeServerJob(job);
+        return 0;
+    }
+
+    pthread_mutex_lock(&jobsLock);
+    if(queue->last == NULL)
+    {
+        queue->first = job;
+    }
+    else
+    {
+        queue->last->next = job;
+    }
+    queue->last = job;
+    pthread_cond_signal(&queue->ready);
+    pthread_mutex_unlock(&jobsLock);
+
+    return 1;
+}
+
+/*
+ * Group commit callback: hands an admission's answer back to the loop.
+ * The record stays admitted if its write failed; the admission log has
+ * reported that.
+ */
+static void finishAdmission(PendingAdmission *admission)
+{
+    finishJob(admission->context);
+}
+
+/*
+ * Puts a job on the finished list and wakes the event loop.
+ */
+static void finishJob(ServerJob *job)
+{
+    const uint64_t completion = 1;
+
+    pthread_mutex_lock(&jobsLock);
+    job->next    = finishedJobs;
+    finishedJobs = job;
+    pthread_mutex_unlock(&jobsLock);
+
+    if(write(completionFd, &completion, sizeof(completion)) != sizeof(completion))
+    {
+        perror("Error waking the server event loop");
+    }
+}
+
+/*
+ * Appends deferred answers to their connections' output, oldest first,
+ * dropping those whose connection has since closed.
+ */
+static void deliverAnswers(void)
+{
+    pthread_mutex_lock(&jobsLock);
+    ServerJob *finished = finishedJobs;
+    finishedJobs        = NULL;
+    pthread_mutex_unlock(&jobsLock);
+
+    // The list is newest first
+    ServerJob *oldestFirst = NULL;
+    while(finished != NULL)
+    {
+        ServerJob *next = finished->next;
+        finished->next  = oldestFirst;
+        oldestFirst     = finished;
+        finished        = next;
+    }
+
+    while(oldestFirst != NULL)
+    {
+        ServerJob  *job        = oldestFirst;
+        Connection *connection = &connections[job->slot];
+        oldestFirst            = job->next;
+
+        storeUpdates -= job->storeUpdate;
+        if(connection->fd != NO_DESCRIPTOR && connection->generation == job->generation)
+        {
+            connection->pendingAnswers--;
+            connection->pendingUpdates -= job->storeUpdate;
+            if(!connection->hungUp)
+            {
+                appendFrame(&connection->output, &job->response);
+            }
+            updateConnection(job->slot);
+        }
+        freeServerJob(job);
+    }
+}
+
+/*
+ * Frees a job and its messages.
+ */
+static void freeServerJob(ServerJob *job)
+{
+    freeMessage(&job->request);
+    freeMessage(&job->response);
+    free(job);
+}
+
+/*
+ * Worker thread: runs the jobs of the queue it is given until the workers
+ * are stopped, waking the event loop as each answer is ready. The store
+ * worker first finishes every update it was given, since the clients may
+ * already count on them.
+ */
+static void *runJobs(void *argument)
+{
+    JobQueue *queue = argument;
+    pthread_mutex_lock(&jobsLock);
+
+    for(;;)
+    {
+        while(queue->first == NULL && !workersStopping)
+        {
+            pthread_cond_wait(&queue->ready, &jobsLock);
+        }
+        if(workersStopping && (queue != &storeJobs || queue->first == NULL))
+        {
+            break;
+        }
+
+        ServerJob *job = queue->first;
+        queue->first   = job->next;
+        if(queue->first == NULL)
+        {
+            queue->last = NULL;
+        }
+        pthread_mutex_unlock(&jobsLock);
+
+        if(!handleRequest(&job->request, &job->response, &job->commit))
+        {
+            finishJob(job);
+        }
+
+        pthread_mutex_lock(&jobsLock);
+    }
+
+    pthread_mutex_unlock(&jobsLock);
+    return NULL;
+}
+
+/*
+ * Decodes a request and builds its response. An admission given commit
+ * storage is answered once it is durable; otherwise the call waits for it.
+ * Returns 1 if the admission was queued on commit and the response must be
+ * held until its callback runs, 0 if the response is ready.
+ */
+static int handleRequest(const ProtocolMessage *request, ProtocolMessage *response, PendingAdmission *commit)
+{
+    ProtocolReader reader;
+
+    openReader(&reader, request);
+    int                type = getByte(&reader);
+    unsigned long long tag  = getVarint(&reader);
+    int                handled;
+
+    resetMessage(response);
+
+    switch(type)
+    {
+        case REQUEST_ADMIT:
+            handled = handleAdmit(&reader, response, tag, commit);
+            break;
+        case REQUEST_DISCHARGE:
+            handled = handleDischarge(&reader, response, tag);
+            break;
+        case REQUEST_LOOKUP:
+            handled = handleLookup(&reader, response, tag);
+            break;
+        case REQUEST_REPORT:
+            handled = handleReport(&reader, response, tag);
+            break;
+        case REQUEST_ASSIGN:
+            handled = handleAssign(&reader, response, tag);
+            break;
+        default:
+            handled = 0;
+    }
+
+    if(!handled)
+    {
+        resetMessage(response);
+        beginResponse(response, RESPONSE_BAD_REQUEST, tag);
+    }
+    else if(response->failed)
+    {
+        resetMessage(response);
+        beginResponse(response, RESPONSE_FAILED, tag);
+    }
+
+    return handled == ANSWER_DEFERRED;
+}
+
+/*
+ * Writes the status and tag every response starts with.
+ */
+static void beginResponse(ProtocolMessage *response, int status, unsigned long long tag)
+{
+    putByte(response, status);
+    putVarint(response, tag);
+}
+
+/*
+ * Admits a patient. With commit storage, a successful admission returns
+ * ANSWER_DEFERRED at once instead of waiting for its group commit.
+ * Each handler returns 1 once it has built a response, or 0 if the
+ * request could not be decoded.
+ */
+static int handleAdmit(ProtocolReader *reader,
+                       ProtocolMessage *response,
+                       unsigned long long tag,
+                       PendingAdmission *commit)
+{
+    char             name[MAX_PATIENT_NAME_LENGTH];
+    char             diagnosis[MAX_DIAGNOSIS_LENGTH];
+    Patient          admitted;
+    ReadmissionMatch readmission;
+
+    getString(reader, name, sizeof(name));
+    int age = (int) getVarint(reader);
+    getString(reader, diagnosis, sizeof(diagnosis));
+    int room = (int) getVarint(reader);
+    if(reader->failed)
+    {
+        return 0;
+    }
+
+    switch(admitPatient(name, age, diagnosis, room, &admitted, &readmission, commit))
+    {
+        case ADMIT_SUCCESS:
+            beginResponse(response, RESPONSE_OK, tag);
+            putPatient(response, &admitted);
+            putVarint(response, (unsigned long long) readmission.previousPatientId);
+            putVarint(response, (unsigned long long) readmission.daysSinceDischarge);
+            putByte(response, readmission.withinWindow);
+            return commit != NULL ? ANSWER_DEFERRED : 1;
+        case ADMIT_INVALID:
+            beginResponse(response, RESPONSE_INVALID, tag);
+            break;
+        case ADMIT_ROOM_TAKEN:
+            beginResponse(response, RESPONSE_CONFLICT, tag);
+            break;
+        default:
+            beginResponse(response, RESPONSE_FAILED, tag);
+    }
+
+    return 1;
+}
+
+/*
+ * Discharges a batch of patients; IDs that are not admitted are skipped.
+ */
+static int handleDischarge(ProtocolReader *reader, ProtocolMessage *response, unsigned long long tag)
+{
+    int patientIds[MAX_DISCHARGE_REQUEST_IDS];
+
+    unsigned long long count = getVarint(reader);
+    if(count == 0 || count > MAX_DISCHARGE_REQUEST_IDS)
+    {
+        return 0;
+    }
+    for(unsigned long long i = 0; i < count; i++)
+    {
+        patientIds[i] = (int) getVarint(reader);
+    }
+    if(reader->failed)
+    {
+        return 0;
+    }
+
+    int discharged = dischargePatientsById(patientIds, (int) count);
+
+    beginResponse(response, discharged > 0 ? RESPONSE_OK : RESPONSE_NOT_FOUND, tag);
+    if(discharged > 0)
+    {
+        putVarint(response, (unsigned long long) discharged);
+    }
+    return 1;
+}
+
+/*
+ * Looks up an admitted patient, then the discharge history.
+ */
+static int handleLookup(ProtocolReader *reader, ProtocolMessage *response, unsigned long long tag)
+{
+    Patient           patient;
+    DischargedPatient dischargedPatient;
+
+    int patientId = (int) getVarint(reader);
+    if(reader->failed)
+    {
+        return 0;
+    }
+
+    if(findActivePatient(patientId, &patient))
+    {
+        beginResponse(response, RESPONSE_OK, tag);
+        putByte(response, 0);
+        putPatient(response, &patient);
+    }
+    else if(findDischargedPatient(patientId, &dischargedPatient))
+    {
+        beginResponse(response, RESPONSE_OK, tag);
+        putByte(response, 1);
+        putPatient(response, &dischargedPatient.patient);
+        putVarint(response, (unsigned long long) dischargedPatient.dischargeDate);
+    }
+    else
+    {
+        beginResponse(response, RESPONSE_NOT_FOUND, tag);
+    }
+
+    return 1;
+}
+
+/*
+ * Writes an export report straight into the response. A report that would
+ * outgrow MAX_RESPONSE_SIZE is answered with RESPONSE_FAILED.
+ */
+static int handleReport(ProtocolReader *reader, ProtocolMessage *response, unsigned long long tag)
+{
+    ReportWriter writer;
+
+    int report    = getByte(reader);
+    int format    = getByte(reader);
+    int timeframe = getByte(reader);
+    if(reader->failed)
+    {
+        return 0;
+    }
+
+    if(report < PROTOCOL_REPORT_ADMISSIONS || report > PROTOCOL_REPORT_DOCTOR_UTILIZATION ||
+       (format != EXPORT_FORMAT_CSV && format != EXPORT_FORMAT_JSON) ||
+       ((report == PROTOCOL_REPORT_ADMISSIONS || report == PROTOCOL_REPORT_DISCHARGES) &&
+        (timeframe < 1 || timeframe > 3)))
+    {
+        beginResponse(response, RESPONSE_INVALID, tag);
+        return 1;
+    }
+
+    if(!openReportWriter(&writer))
+    {
+        beginResponse(response, RESPONSE_FAILED, tag);
+        return 1;
+    }
+
+    // The report is written straight into the response, after its status
+    beginResponse(response, RESPONSE_OK, tag);
+    addReportSink(&writer, writeToResponse, response);
+
+    switch(report)
+    {
+        case PROTOCOL_REPORT_ADMISSIONS:
+            exportAdmissionReport(&writer, format, timeframe);
+            break;
+        case PROTOCOL_REPORT_DISCHARGES:
+            exportDischargeReport(&writer, format, timeframe);
+            break;
+        case PROTOCOL_REPORT_ROOM_USAGE:
+            exportRoomUsageReport(&writer, format);
+            break;
+        default:
+            exportDoctorUtilizationReport(&writer, format);
+    }
+
+    if(!closeReportWriter(&writer))
+    {
+        resetMessage(response);
+        beginResponse(response, RESPONSE_FAILED, tag);
+    }
+
+    return 1;
+}
+
+/*
+ * Assigns a doctor to a shift.
+ */
+static int handleAssign(ProtocolReader *reader, ProtocolMessage *response, unsigned long long tag)
+{
+    int doctorId = (int) getVarint(reader);
+    int day      = getByte(reader);
+    int time     = getByte(reader);
+    int replace  = getByte(reader);
+    if(reader->failed)
+    {
+        return 0;
+    }
+
+    switch(assignDoctorToShift(doctorId, day, time, replace))
+    {
+        case SCHEDULE_SUCCESS:
+            beginResponse(response, RESPONSE_OK, tag);
+            break;
+        case SCHEDULE_SLOT_TAKEN:
+            beginResponse(response, RESPONSE_CONFLICT, tag);
+            break;
+        default:
+            beginResponse(response, RESPONSE_INVALID, tag);
+    }
+
+    return 1;
+}
+
+/*
+ * Report sink that appends to a response, failing instead once the
+ * response would outgrow MAX_RESPONSE_SIZE, which clients refuse.
+ */
+static int writeToResponse(void *target, const char data[], size_t length)
+{
+    ProtocolMessage *response = target;
+
+    if(length > MAX_RESPONSE_SIZE - response->length)
+    {
+        return REPORT_FAILURE;
+    }
+
+    putBytes(response, data, length);
+    return response->failed ? REPORT_FAILURE : REPORT_SUCCESS;
+}
@@ -0,0 +1,45 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the hospital server, which keeps the patient
+ *          store, doctor registry and schedule loaded in one long-running
+ *          process and serves requests from many clients over a Unix domain
+ *          socket (see server_protocol.h).
+ */
+
+#ifndef HOSPITAL_SERVER_H
+#define HOSPITAL_SERVER_H
+
+#define MAX_SERVER_CONNECTIONS 128
+#define SERVER_LISTEN_BACKLOG 64
+#define SERVER_REPORT_WORKERS 2 // Threads that run reports off the event loop
+
+#define SERVER_SUCCESS 1
+#define SERVER_FAILURE 0
+
+/*
+ * Function: isServerRunning
+ * -------------------------
+ * Checks whether a server already answers on a socket, so a second one can
+ * refuse to start before touching the data files.
+ *
+ * Returns: 1 if a server is running there, 0 otherwise
+ */
+int isServerRunning(const char socketPath[]);
+
+/*
+ * Function: runServer
+ * -------------------
+ * Listens on a socket and serves requests until SIGINT or SIGTERM, then
+ * delivers the answers already owed, closes every connection and removes
+ * the socket. The systems must already be initialized; the caller clears
+ * them afterwards.
+ *
+ * socketPath: Where to create the socket
+ *
+ * Returns: SERVER_SUCCESS after a clean stop, or SERVER_FAILURE if the
+ *          socket could not be created or another server is using it
+ */
+int runServer(const char socketPath[]);
+
+#endif // HOSPITAL_SERVER_H
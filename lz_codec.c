@@ -0,0 +1,251 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the LZ77 block codec described in lz_codec.h.
+ *
+ *          Each sequence is a token byte whose high nibble is the literal
+ *          count and low nibble is the match length minus MIN_MATCH, followed
+ *          by extra length bytes when a nibble is 15, the literals, and a
+ *          two-byte little-endian match offset. The final sequence carries
+ *          literals only.
+ */
+
+#include "lz_codec.h"
+#include <string.h>
+
+// Private constants
+#define MIN_MATCH 4
+#define MAX_OFFSET 65535
+#define HASH_BITS 12
+#define HASH_SIZE (1 << HASH_BITS)
+#define NIBBLE_MAX 15
+#define LAST_LITERALS 5    // Trailing bytes always emitted as literals
+#define MATCH_SAFE_END 12  // No match may start this close to the end
+
+// Function prototypes for internal helper functions
+static unsigned int   readWord(const unsigned char *p);
+static unsigned int   hashWord(unsigned int word);
+static unsigned char *writeLength(unsigned char *out, const unsigned char *outEnd, size_t length);
+static int            readLength(const unsigned char **in, const unsigned char *inEnd, size_t *length);
+
+/*
+ * Worst case is all literals plus one extra length byte per 255 bytes.
+ */
+size_t lzCompressBound(size_t inputLength)
+{
+    return inputLength + inputLength / 255 + 16;
+}
+
+/*
+ * Greedy single-pass compressor using a 4 KiB hash table of positions.
+ */
+size_t lzCompress(const unsigned char input[],
+                  size_t inputLength,
+                  unsigned char output[],
+                  size_t outputCapacity)
+{
+    size_t               table[HASH_SIZE];
+    const unsigned char *inEnd       = input + inputLength;
+    const unsigned char *matchLimit  = inputLength > MATCH_SAFE_END ? inEnd - MATCH_SAFE_END : input;
+    const unsigned char *ip          = input;
+    const unsigned char *anchor      = input;
+    unsigned char       *op          = output;
+    unsigned char       *outEnd      = output + outputCapacity;
+
+    memset(table, 0, sizeof(table));
+
+    while(ip < matchLimit)
+    {
+        unsigned int         hash      = hashWord(readWord(ip));
+        const unsigned char *candidate = input + table[hash];
+        table[hash]                    = (size_t) (ip - input);
+
+        if(candidate >= ip || ip - candidate > MAX_OFFSET || readWord(candidate) != readWord(ip))
+        {
+            ip++;
+            continue;
+        }
+
+        // Extend the match forward, keeping LAST_LITERALS bytes for the tail
+        const unsigned char *matchEnd = ip + MIN_MATCH;
+        const unsigned char *ref      = candidate + MIN_MATCH;
+        while(matchEnd < inEnd - LAST_LITERALS && *matchEnd == *ref)
+        {
+            matchEnd++;
+            ref++;
+        }
+
+        size_t literalLength = (size_t) (ip - anchor);
+        size_t matchLength   = (size_t) (matchEnd - ip) - MIN_MATCH;
+
+        if(op + 1 + literalLength + literalLength / 255 + 2 + matchLength / 255 + 2 > outEnd)
+        {
+            return 0;
+        }
+
+        unsigned char *token = op++;
+        *token = (unsigned char) ((literalLength >= NIBBLE_MAX ? NIBBLE_MAX : literalLength) << 4);
+        if(literalLength >= NIBBLE_MAX)
+        {
+            op = writeLength(op, outEnd, literalLength - NIBBLE_MAX);
+        }
+        memcpy(op, anchor, literalLength);
+        op += literalLength;
+
+        size_t offset = (size_t) (ip - candidate);
+        *op++         = (unsigned char) (offset & 0xFF);
+        *op++         = (unsigned char) (offset >> 8);
+
+        *token |= (unsigned char) (matchLength >= NIBBLE_MAX ? NIBBLE_MAX : matchLength);
+        if(matchLength >= NIBBLE_MAX)
+        {
+            op = writeLength(op, outEnd, matchLength - NIBBLE_MAX);
+        }
+
+        ip     = matchEnd;
+        anchor = ip;
+    }
+
+    // Final literal-only sequence
+    size_t literalLength = (size_t) (inEnd - anchor);
+    if(op + 1 + literalLength + literalLength / 255 + 1 > outEnd)
+    {
+        return 0;
+    }
+
+    unsigned char *token = op++;
+    *token = (unsigned char) ((literalLength >= NIBBLE_MAX ? NIBBLE_MAX : literalLength) << 4);
+    if(literalLength >= NIBBLE_MAX)
+    {
+        op = writeLength(op, outEnd, literalLength - NIBBLE_MAX);
+    }
+    memcpy(op, anchor, literalLength);
+    op += literalLength;
+
+    return (size_t) (op - output);
+}
+
+/*
+ * Decompresses a block with full bounds checking on input and output.
+ */
+int lzDecompress(const unsigned char input[],
+                 size_t inputLength,
+                 unsigned char output[],
+                 size_t outputLength)
+{
+    const unsigned char *ip     = input;
+    const unsigned char *inEnd  = input + inputLength;
+    unsigned char       *op     = output;
+    unsigned char       *outEnd = output + outputLength;
+
+    while(ip < inEnd)
+    {
+        unsigned char token         = *ip++;
+        size_t        literalLength = token >> 4;
+
+        if(literalLength == NIBBLE_MAX && !readLength(&ip, inEnd, &literalLength))
+        {
+            return 0;
+        }
+
+        if(literalLength > (size_t) (inEnd - ip) || literalLength > (size_t) (outEnd - op))
+        {
+            return 0;
+        }
+        memcpy(op, ip, literalLength);
+        ip += literalLength;
+        op += literalLength;
+
+        // The last sequence has no match part
+        if(ip == inEnd)
+        {
+            break;
+        }
+
+        if(inEnd - ip < 2)
+        {
+            return 0;
+        }
+        size_t offset = (size_t) ip[0] | ((size_t) ip[1] << 8);
+        ip += 2;
+
+        size_t matchLength = token & NIBBLE_MAX;
+        if(matchLength == NIBBLE_MAX && !readLength(&ip, inEnd, &matchLength))
+        {
+            return 0;
+        }
+        matchLength += MIN_MATCH;
+
+        if(offset == 0 || offset > (size_t) (op - output) || matchLength > (size_t) (outEnd - op))
+        {
+            return 0;
+        }
+
+        // Byte-wise copy so overlapping matches replicate correctly
+        const unsigned char *ref = op - offset;
+        for(size_t i = 0; i < matchLength; i++)
+        {
+            op[i] = ref[i];
+        }
+        op += matchLength;
+    }
+
+    return op == outEnd;
+}
+
+/*
+ * Reads four bytes without alignment requirements.
+ */
+static unsigned int readWord(const unsigned char *p)
+{
+    unsigned int word;
+    memcpy(&word, p, sizeof(word));
+    return word;
+}
+
+/*
+ * Multiplicative hash of a four-byte word into HASH_BITS bits.
+ */
+static unsigned int hashWord(unsigned int word)
+{
+    return (word * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/*
+ * Writes the remainder of a length that overflowed its nibble.
+ */
+static unsigned char *writeLength(unsigned char *out, const unsigned char *outEnd, size_t length)
+{
+    while(length >= 255 && out < outEnd)
+    {
+        *out++ = 255;
+        length -= 255;
+    }
+    if(out < outEnd)
+    {
+        *out++ = (unsigned char) length;
+    }
+    return out;
+}
+
+/*
+ * Adds the extra length bytes that follow a saturated nibble.
+ * Returns 1 on success, 0 if the input ends first.
+ */
+static int readLength(const unsigned char **in, const unsigned char *inEnd, size_t *length)
+{
+    unsigned char byte;
+
+    do
+    {
+        if(*in >= inEnd)
+        {
+            return 0;
+        }
+        byte = *(*in)++;
+        *length += byte;
+    }
+    while(byte == 255);
+
+    return 1;
+}
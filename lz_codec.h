@@ -0,0 +1,53 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines a small in-tree LZ77 block codec. The format
+ *          follows the LZ4 block layout (token, literals, 16-bit offset,
+ *          match length) so blocks compress and decompress quickly without
+ *          an external library.
+ */
+
+#ifndef LZ_CODEC_H
+#define LZ_CODEC_H
+
+#include <stddef.h>
+
+/*
+ * Function: lzCompressBound
+ * -------------------------
+ * Returns the largest size lzCompress can produce for inputLength bytes.
+ */
+size_t lzCompressBound(size_t inputLength);
+
+/*
+ * Function: lzCompress
+ * --------------------
+ * Compresses input into output.
+ *
+ * input: The bytes to compress
+ * inputLength: Number of input bytes
+ * output: Destination buffer
+ * outputCapacity: Size of the destination buffer
+ *
+ * Returns: The compressed size, or 0 if output is too small
+ */
+size_t lzCompress(const unsigned char input[],
+                  size_t inputLength,
+                  unsigned char output[],
+                  size_t outputCapacity);
+
+/*
+ * Function: lzDecompress
+ * ----------------------
+ * Decompresses a block that is known to expand to exactly outputLength
+ * bytes. Malformed input is rejected rather than read or written out of
+ * bounds.
+ *
+ * Returns: 1 on success, 0 if the block is malformed
+ */
+int lzDecompress(const unsigned char input[],
+                 size_t inputLength,
+                 unsigned char output[],
+                 size_t outputLength);
+
+#endif // LZ_CODEC_H
@@ -3,15 +3,32 @@
  * Date: Jan 30, 2025
  * Purpose: Main driver of the hospital system project.
  *          This file provides a menu-driven interface for managing patient records.
+ *          Run as "hospital serve" it instead serves requests over a socket, and
+ *          as "hospital client COMMAND" it sends one request to that server.
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include "activity_counters.h"
+#include "admission_log.h"
+#include "async_io.h"
+#include "diagnosis_dictionary.h"
+#include "diagnosis_index.h"
+#include "discharge_index.h"
 #include "doctor_data.h"
+#include "durable_file.h"
 #include "doctor_schedule.h"
+#include "hospital_client.h"
+#include "hospital_server.h"
 #include "patient_data.h"
 #include "patient_management.h"
+#include "readmission.h"
+#include "report_aggregates.h"
+#include "report_engine.h"
+#include "report_export.h"
+#include "report_writer.h"
+#include "server_protocol.h"
 #include "utils.h"
 
 // Constants representing menu options
@@ -26,7 +43,22 @@
 #define PATIENT_DISCHARGE_REPORT 9
 #define DOC_SCHE_REPORT 10
 #define ROOM_USAGE_REPORT 11
-#define EXIT_PROGRAM 12
+#define DIAGNOSIS_REPORT 12
+#define DIAGNOSIS_SEARCH 13
+#define NAME_SEARCH 14
+#define EXPORT_REPORT 15
+#define READMISSION_REPORT 16
+#define TRANSFER_PATIENT 17
+#define BATCH_DISCHARGE 18
+#define ACTIVITY_REPORT 19
+#define LENGTH_OF_STAY_REPORT 20
+#define EXIT_PROGRAM 21
+
+// Constants representing exportable reports
+#define EXPORT_ADMISSIONS 1
+#define EXPORT_DISCHARGES 2
+#define EXPORT_ROOM_USAGE 3
+#define EXPORT_DOCTOR_UTILIZATION 4
 
 #define DEFAULT_VALUE (-1)
 #define VALID_INPUT 1
@@ -35,26 +67,88 @@
 void menu();
 void doctorMenu();
 int  getPatientReportChoice();
+void exportReportMenu();
 static void handleRestoreConfirmation(void);
+static void initializeSystems(void);
+static void shutdownSystems(void);
 
 /*
  * Function: main
  * --------------
  * Entry point of the hospital management system.
- * Calls the menu function to interact with the user.
+ * Calls the menu function to interact with the user, or runs the server,
+ * the client or the durability benchmark when asked to on the command line.
  */
-int main(void)
+int main(int argc, char *argv[])
 {
-    // Initialize systems
-    initializePatientSystem();
-    initializeDoctors();
-    initializeSchedule();
+    // The client loads nothing; the server holds it all
+    if(argc >= 2 && strcmp(argv[1], "client") == 0)
+    {
+        return runClient(getSocketPath(), argc - 2, argv + 2) == CLIENT_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
+
+    if(argc >= 2 && strcmp(argv[1], "serve") == 0)
+    {
+        if(isServerRunning(getSocketPath()))
+        {
+            printf("Error: A server is already running on %s.\n", getSocketPath());
+            return EXIT_FAILURE;
+        }
+
+        initializeSystems();
+        int served = runServer(getSocketPath());
+        shutdownSystems();
+        return served == SERVER_SUCCESS ? EXIT_SUCCESS : EXIT_FAILURE;
+    }
 
+    // Measures the cost of each durability level in this folder
+    if(argc >= 2 && strcmp(argv[1], "benchmark-durability") == 0)
+    {
+        int runs = argc >= 3 ? atoi(argv[2]) : 0;
+        benchmarkDurability(runs > 0 ? runs : DEFAULT_DURABILITY_BENCHMARK_RUNS);
+        return EXIT_SUCCESS;
+    }
+
+    initializeSystems();
     menu();
 
     return 0;
 }
 
+/*
+ * Loads every data file and builds the in-memory indexes.
+ */
+static void initializeSystems(void)
+{
+    initializeDiagnosisDictionary();
+    initializeDiagnosisIndex();
+    openDischargeIndex();
+    initializeReadmissionIndex();
+    initializePatientSystem();
+    initializeDoctors();
+    initializeSchedule();
+}
+
+/*
+ * Commits queued admissions, checkpoints the patient store, waits for
+ * outstanding writes, frees the in-memory state and stops the report
+ * workers.
+ */
+static void shutdownSystems(void)
+{
+    stopAdmissionLog();
+    checkpointPatientSystem();
+    stopAsyncIo();
+    clearMemory();
+    clearDiagnosisIndex();
+    closeDischargeIndex();
+    clearReadmissionIndex();
+    clearReportAggregates();
+    clearActivityCounters();
+    clearDiagnosisDictionary();
+    stopReportEngine();
+}
+
 /*
  * Function: menu
  * --------------
@@ -84,8 +178,17 @@ void menu()
                "9: Patient Discharge Report Menu\n"
                "10: Doctor Schedule Report\n"
                "11: Room Usage Report\n"
+               "12: Patients by Diagnosis Report\n"
+               "13: Search Patients by Diagnosis\n"
+               "14: Search Patients by Name\n"
+               "15: Export Report (CSV/JSON)\n"
+               "16: Readmission Report\n"
+               "17: Transfer Patient to Another Room\n"
+               "18: Discharge Multiple Patients\n"
+               "19: Activity Report (Hourly to Monthly)\n"
+               "20: Length of Stay Report\n"
                "\n"
-               "12: Exit.\n");
+               "21: Exit.\n");
 
         // Read user input and validate
         if(scanf("%d", &userInput) != VALID_INPUT)
@@ -142,12 +245,48 @@ void menu()
                 clearInputBuffer();
                 displayRoomUsageReport();
                 break;
+            case DIAGNOSIS_REPORT:
+                clearInputBuffer();
+                displayDiagnosisReport();
+                break;
+            case DIAGNOSIS_SEARCH:
+                clearInputBuffer();
+                searchPatientsByDiagnosis();
+                break;
+            case NAME_SEARCH:
+                clearInputBuffer();
+                searchPatientsByName();
+                break;
+            case EXPORT_REPORT:
+                clearInputBuffer();
+                exportReportMenu();
+                break;
+            case READMISSION_REPORT:
+                clearInputBuffer();
+                displayReadmissionReport();
+                break;
+            case TRANSFER_PATIENT:
+                clearInputBuffer();
+                transferPatient();
+                break;
+            case BATCH_DISCHARGE:
+                clearInputBuffer();
+                dischargePatientBatch();
+                break;
+            case ACTIVITY_REPORT:
+                clearInputBuffer();
+                displayActivityReport();
+                break;
+            case LENGTH_OF_STAY_REPORT:
+                clearInputBuffer();
+                displayLengthOfStayReport();
+                break;
             case EXIT_PROGRAM:
                 puts("Exiting program, have a nice day!\n");
-                clearMemory();
+                shutdownSystems();
                 return;
             default:
-                printf("Invalid option. Please enter a number between 1 and 6.\n");
+                printf("Invalid option. Please enter a number between 1 and %d.\n", EXIT_PROGRAM);
         }
     }
     while(userInput != EXIT_PROGRAM);
@@ -236,6 +375,87 @@ int getPatientReportChoice()
     return choice;
 }
 
+/*
+ * Function: exportReportMenu
+ * --------------------------
+ * Prompts for a report and a format (CSV or JSON), then streams the report
+ * into a file named after both, e.g. admission_report.csv. The file is
+ * replaced on every export.
+ */
+void exportReportMenu()
+{
+    static const char *baseNames[] = { "admission_report", "discharge_report",
+                                       "room_usage_report", "doctor_utilization_report" };
+    int          report;
+    int          format;
+    int          timeframe = 0;
+    char         fileName[64];
+    ReportWriter writer;
+
+    printf("Export 1: Admissions, 2: Discharges, 3: Room Usage, 4: Doctor Utilization\n");
+    if(scanf("%d", &report) != VALID_INPUT || report < EXPORT_ADMISSIONS || report > EXPORT_DOCTOR_UTILIZATION)
+    {
+        printf("Invalid report.\n");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+
+    printf("Format 1: CSV, 2: JSON\n");
+    if(scanf("%d", &format) != VALID_INPUT || (format != EXPORT_FORMAT_CSV && format != EXPORT_FORMAT_JSON))
+    {
+        printf("Invalid format.\n");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+
+    if(report == EXPORT_ADMISSIONS || report == EXPORT_DISCHARGES)
+    {
+        timeframe = getPatientReportChoice();
+    }
+
+    snprintf(fileName, sizeof(fileName), "%s.%s", baseNames[report - 1],
+             format == EXPORT_FORMAT_CSV ? "csv" : "json");
+
+    FILE *file = fopen(fileName, "w");
+    if(file == NULL)
+    {
+        printf("Error opening %s for writing!\n", fileName);
+        return;
+    }
+    if(!openReportWriter(&writer))
+    {
+        printf("Error: Unable to allocate report buffer.\n");
+        fclose(file);
+        return;
+    }
+    addFileSink(&writer, file);
+
+    switch(report)
+    {
+        case EXPORT_ADMISSIONS:
+            exportAdmissionReport(&writer, format, timeframe);
+            break;
+        case EXPORT_DISCHARGES:
+            exportDischargeReport(&writer, format, timeframe);
+            break;
+        case EXPORT_ROOM_USAGE:
+            exportRoomUsageReport(&writer, format);
+            break;
+        default:
+            exportDoctorUtilizationReport(&writer, format);
+    }
+
+    int written = closeReportWriter(&writer);
+    if(fclose(file) != 0 || !written)
+    {
+        printf("Error writing %s.\n", fileName);
+        return;
+    }
+    printf("Report exported to %s\n", fileName);
+}
+
 /*
  * Handles the user confirmation process for restoring patient data from file.
  * Prompts the user and proceeds with restoration only if confirmed.
@@ -0,0 +1,803 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the name index over active patients.
+ *
+ *          Each distinct folded name is stored once as an entry holding the
+ *          IDs of every patient with that name. Entries are reachable from
+ *          the trie (first-child/next-sibling nodes kept in character order)
+ *          and double as BK-tree nodes, where each child hangs off its parent
+ *          by their edit distance. Entries whose patients all leave stay in
+ *          both structures with no IDs, so neither tree needs rebalancing.
+ */
+
+#include "name_index.h"
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "patient_data.h"
+
+// Private constants
+#define NO_NODE (-1)
+#define INITIAL_CAPACITY 16
+#define TRIE_ROOT 0
+
+/*
+ * A distinct folded name and the patients who have it.
+ */
+typedef struct
+{
+    char *text;
+    int  *patientIds;
+    int   count;
+    int   capacity;
+    int   bkDistance;    // Edit distance to the BK-tree parent
+    int   bkFirstChild;
+    int   bkNextSibling;
+} NameEntry;
+
+typedef struct
+{
+    int  firstChild;
+    int  nextSibling;
+    int  entry;
+    char key;
+} TrieNode;
+
+typedef struct
+{
+    int entry;
+    int distance;
+} SimilarName;
+
+/*
+ * The layout of a saved index: this header, the trie nodes as they are,
+ * one SavedNameEntry per entry, every entry's patient IDs and then every
+ * entry's terminated text.
+ */
+typedef struct
+{
+    int entryCount;
+    int trieNodeCount;
+    int idCount;
+    int textLength;
+} SavedNameIndex;
+
+typedef struct
+{
+    int textOffset;
+    int idOffset;
+    int count;
+    int bkDistance;
+    int bkFirstChild;
+    int bkNextSibling;
+} SavedNameEntry;
+
+// Index data
+static NameEntry *entries       = NULL;
+static int        entryCount    = 0;
+static int        entryCapacity = 0;
+static TrieNode  *trieNodes     = NULL;
+static int        trieNodeCount = 0;
+static int        trieCapacity  = 0;
+
+// Texts and ID lists of a loaded index, shared by its entries until an
+// entry's list outgrows its share
+static char      *loadedText       = NULL;
+static int        loadedTextLength = 0;
+static int       *loadedIds        = NULL;
+static int        loadedIdCount    = 0;
+
+// Function prototypes for internal helper functions
+static int  findTrieNode(const char text[]);
+static int  addTrieNode(char key);
+static int  findOrAddChild(int parent, char key);
+static int  addEntry(const char text[]);
+static void addToBkTree(int entry);
+static int  editDistance(const char a[], int aLength, const char b[], int bLength);
+static int  pushNode(int **stack, int *stackSize, int *stackCapacity, int node);
+static int  visitEntry(int entry, int distance, NameMatchVisitor visitor, void *context, int *visited);
+static int  compareSimilarNames(const void *a, const void *b);
+static int  ownsPatientIds(const NameEntry *entry);
+static int  validSavedEntry(const SavedNameEntry *saved, const SavedNameIndex *header);
+
+/*
+ * Adds a patient to the entry for their folded name.
+ */
+int addToNameIndex(int patientId, const char name[])
+{
+    char folded[MAX_PATIENT_NAME_LENGTH];
+    foldPatientName(name, folded);
+
+    int node = findTrieNode(folded);
+    int entry;
+
+    if(node != NO_NODE && trieNodes[node].entry != NO_NODE)
+    {
+        entry = trieNodes[node].entry;
+    }
+    else
+    {
+        entry = addEntry(folded);
+        if(entry == NO_NODE)
+        {
+            return NAME_INDEX_FAILURE;
+        }
+    }
+
+    NameEntry *nameEntry = &entries[entry];
+    if(nameEntry->count == nameEntry->capacity)
+    {
+        int  newCapacity = nameEntry->capacity == 0 ? 1 : nameEntry->capacity * 2;
+        int  owned       = ownsPatientIds(nameEntry);
+        int *grown       = owned ? realloc(nameEntry->patientIds, sizeof(int) * (size_t) newCapacity)
+                                 : malloc(sizeof(int) * (size_t) newCapacity);
+        if(grown == NULL)
+        {
+            return NAME_INDEX_FAILURE;
+        }
+        if(!owned && nameEntry->count > 0)
+        {
+            memcpy(grown, nameEntry->patientIds, sizeof(int) * (size_t) nameEntry->count);
+        }
+        nameEntry->patientIds = grown;
+        nameEntry->capacity   = newCapacity;
+    }
+
+    nameEntry->patientIds[nameEntry->count++] = patientId;
+    return NAME_INDEX_SUCCESS;
+}
+
+/*
+ * Removes a patient from the entry for their folded name.
+ */
+void removeFromNameIndex(int patientId, const char name[])
+{
+    char folded[MAX_PATIENT_NAME_LENGTH];
+    foldPatientName(name, folded);
+
+    int node = findTrieNode(folded);
+    if(node == NO_NODE || trieNodes[node].entry == NO_NODE)
+    {
+        return;
+    }
+
+    NameEntry *nameEntry = &entries[trieNodes[node].entry];
+    for(int i = 0; i < nameEntry->count; i++)
+    {
+        if(nameEntry->patientIds[i] == patientId)
+        {
+            memmove(nameEntry->patientIds + i, nameEntry->patientIds + i + 1,
+                    sizeof(int) * (size_t) (nameEntry->count - i - 1));
+            nameEntry->count--;
+            return;
+        }
+    }
+}
+
+/*
+ * Walks the trie subtree under the prefix in pre-order, which visits
+ * names alphabetically.
+ */
+int visitNamePrefix(const char prefix[], NameMatchVisitor visitor, void *context)
+{
+    char folded[MAX_PATIENT_NAME_LENGTH];
+    foldPatientName(prefix, folded);
+
+    int start   = findTrieNode(folded);
+    int visited = 0;
+    if(start == NO_NODE)
+    {
+        return 0;
+    }
+
+    if(!visitEntry(trieNodes[start].entry, 0, visitor, context, &visited))
+    {
+        return visited;
+    }
+
+    int *stack         = NULL;
+    int  stackSize     = 0;
+    int  stackCapacity = 0;
+
+    if(trieNodes[start].firstChild != NO_NODE)
+    {
+        pushNode(&stack, &stackSize, &stackCapacity, trieNodes[start].firstChild);
+    }
+
+    while(stackSize > 0)
+    {
+        int node = stack[--stackSize];
+
+        if(!visitEntry(trieNodes[node].entry, 0, visitor, context, &visited))
+        {
+            break;
+        }
+
+        // Push the sibling first so the child subtree is visited before it
+        if((trieNodes[node].nextSibling != NO_NODE &&
+            !pushNode(&stack, &stackSize, &stackCapacity, trieNodes[node].nextSibling)) ||
+           (trieNodes[node].firstChild != NO_NODE &&
+            !pushNode(&stack, &stackSize, &stackCapacity, trieNodes[node].firstChild)))
+        {
+            break;
+        }
+    }
+
+    free(stack);
+    return visited;
+}
+
+/*
+ * Searches the BK-tree. By the triangle inequality, a child at edge
+ * distance e from a node at distance d from the query can only lead to
+ * matches when |e - d| <= maxDistance, so every other subtree is pruned.
+ */
+int visitSimilarNames(const char name[], int maxDistance, NameMatchVisitor visitor, void *context)
+{
+    char folded[MAX_PATIENT_NAME_LENGTH];
+    int  length  = foldPatientName(name, folded);
+    int  visited = 0;
+
+    if(entryCount == 0)
+    {
+        return 0;
+    }
+
+    if(maxDistance < 0)
+    {
+        maxDistance = 0;
+    }
+    if(maxDistance > MAX_NAME_EDIT_DISTANCE)
+    {
+        maxDistance = MAX_NAME_EDIT_DISTANCE;
+    }
+
+    int         *stack         = NULL;
+    int          stackSize     = 0;
+    int          stackCapacity = 0;
+    SimilarName *matches       = NULL;
+    int          matchCount    = 0;
+    int          matchCapacity = 0;
+    int          ok            = pushNode(&stack, &stackSize, &stackCapacity, 0);
+
+    while(ok && stackSize > 0)
+    {
+        int        entry     = stack[--stackSize];
+        NameEntry *nameEntry = &entries[entry];
+        int        distance  = editDistance(folded, length, nameEntry->text, (int) strlen(nameEntry->text));
+
+        if(distance <= maxDistance && nameEntry->count > 0)
+        {
+            if(matchCount == matchCapacity)
+            {
+                int          newCapacity = matchCapacity == 0 ? INITIAL_CAPACITY : matchCapacity * 2;
+                SimilarName *grown       = realloc(matches, sizeof(SimilarName) * (size_t) newCapacity);
+                if(grown == NULL)
+                {
+                    ok = 0;
+                    break;
+                }
+                matches       = grown;
+                matchCapacity = newCapacity;
+            }
+            matches[matchCount].entry    = entry;
+            matches[matchCount].distance = distance;
+            matchCount++;
+        }
+
+        for(int child = nameEntry->bkFirstChild; ok && child != NO_NODE; child = entries[child].bkNextSibling)
+        {
+            if(abs(entries[child].bkDistance - distance) <= maxDistance)
+            {
+                ok = pushNode(&stack, &stackSize, &stackCapacity, child);
+            }
+        }
+    }
+
+    if(ok && matchCount > 0)
+    {
+        qsort(matches, (size_t) matchCount, sizeof(SimilarName), compareSimilarNames);
+        for(int i = 0; i < matchCount; i++)
+        {
+            if(!visitEntry(matches[i].entry, matches[i].distance, visitor, context, &visited))
+            {
+                break;
+            }
+        }
+    }
+
+    free(stack);
+    free(matches);
+    return ok ? visited : -1;
+}
+
+/*
+ * Frees all entries and trie nodes.
+ */
+void clearNameIndex(void)
+{
+    for(int i = 0; i < entryCount; i++)
+    {
+        if(entries[i].text < loadedText || entries[i].text >= loadedText + loadedTextLength)
+        {
+            free(entries[i].text);
+        }
+        if(ownsPatientIds(&entries[i]))
+        {
+            free(entries[i].patientIds);
+        }
+    }
+
+    free(entries);
+    free(trieNodes);
+    free(loadedText);
+    free(loadedIds);
+
+    entries       = NULL;
+    entryCount    = 0;
+    entryCapacity = 0;
+    trieNodes     = NULL;
+    trieNodeCount = 0;
+    trieCapacity  = 0;
+
+    loadedText       = NULL;
+    loadedTextLength = 0;
+    loadedIds        = NULL;
+    loadedIdCount    = 0;
+}
+
+/*
+ * Writes the header, the trie nodes, the entries with their pointers as
+ * offsets, the ID lists and the texts.
+ */
+int saveNameIndex(FILE *file)
+{
+    SavedNameIndex header = { entryCount, trieNodeCount, 0, 0 };
+    SavedNameEntry saved;
+
+    for(int i = 0; i < entryCount; i++)
+    {
+        header.idCount    += entries[i].count;
+        header.textLength += (int) strlen(entries[i].text) + 1;
+    }
+
+    int written = fwrite(&header, sizeof(header), 1, file) == 1 &&
+                  fwrite(trieNodes, sizeof(TrieNode), (size_t) trieNodeCount, file) == (size_t) trieNodeCount;
+
+    int idOffset   = 0;
+    int textOffset = 0;
+    for(int i = 0; written && i < entryCount; i++)
+    {
+        saved.textOffset    = textOffset;
+        saved.idOffset      = idOffset;
+        saved.count         = entries[i].count;
+        saved.bkDistance    = entries[i].bkDistance;
+        saved.bkFirstChild  = entries[i].bkFirstChild;
+        saved.bkNextSibling = entries[i].bkNextSibling;
+        written             = fwrite(&saved, sizeof(saved), 1, file) == 1;
+
+        idOffset   += entries[i].count;
+        textOffset += (int) strlen(entries[i].text) + 1;
+    }
+
+    // Entries whose patients have all left stay in the tree, with no IDs
+    for(int i = 0; written && i < entryCount; i++)
+    {
+        written = entries[i].count == 0 ||
+                  fwrite(entries[i].patientIds, sizeof(int), (size_t) entries[i].count, file) ==
+                      (size_t) entries[i].count;
+    }
+    for(int i = 0; written && i < entryCount; i++)
+    {
+        size_t length = strlen(entries[i].text) + 1;
+        written       = fwrite(entries[i].text, 1, length, file) == length;
+    }
+
+    return written ? NAME_INDEX_SUCCESS : NAME_INDEX_FAILURE;
+}
+
+/*
+ * Copies the trie nodes, texts and ID lists out of a saved index in one
+ * piece each, then points the entries into them.
+ */
+int loadNameIndex(const void *section, size_t length)
+{
+    const unsigned char *bytes = section;
+    SavedNameIndex       header;
+
+    clearNameIndex();
+    if(length < sizeof(header))
+    {
+        return NAME_INDEX_FAILURE;
+    }
+    memcpy(&header, bytes, sizeof(header));
+
+    size_t nodeBytes  = sizeof(TrieNode) * (size_t) header.trieNodeCount;
+    size_t entryBytes = sizeof(SavedNameEntry) * (size_t) header.entryCount;
+    size_t idBytes    = sizeof(int) * (size_t) header.idCount;
+    if(header.entryCount < 0 || header.trieNodeCount < 0 || header.idCount < 0 || header.textLength < 0 ||
+       length != sizeof(header) + nodeBytes + entryBytes + idBytes + (size_t) header.textLength ||
+       (header.entryCount > 0 && header.trieNodeCount == 0))
+    {
+        return NAME_INDEX_FAILURE;
+    }
+
+    const unsigned char *savedEntries = bytes + sizeof(header) + nodeBytes;
+
+    entries    = malloc(sizeof(NameEntry) * (size_t) (header.entryCount > 0 ? header.entryCount : 1));
+    trieNodes  = malloc(nodeBytes > 0 ? nodeBytes : 1);
+    loadedIds  = malloc(idBytes > 0 ? idBytes : 1);
+    loadedText = malloc(header.textLength > 0 ? (size_t) header.textLength : 1);
+    if(entries == NULL || trieNodes == NULL || loadedIds == NULL || loadedText == NULL)
+    {
+        clearNameIndex();
+        return NAME_INDEX_FAILURE;
+    }
+
+    memcpy(trieNodes, bytes + sizeof(header), nodeBytes);
+    memcpy(loadedIds, savedEntries + entryBytes, idBytes);
+    memcpy(loadedText, savedEntries + entryBytes + idBytes, (size_t) header.textLength);
+    entryCapacity    = header.entryCount > 0 ? header.entryCount : 1;
+    trieNodeCount    = header.trieNodeCount;
+    trieCapacity     = header.trieNodeCount;
+    loadedTextLength = header.textLength;
+    loadedIdCount    = header.idCount;
+
+    for(int i = 0; i < trieNodeCount; i++)
+    {
+        const TrieNode *node = &trieNodes[i];
+        if(node->firstChild < NO_NODE || node->firstChild >= trieNodeCount || node->nextSibling < NO_NODE ||
+           node->nextSibling >= trieNodeCount || node->entry < NO_NODE || node->entry >= header.entryCount)
+        {
+            clearNameIndex();
+            return NAME_INDEX_FAILURE;
+        }
+    }
+
+    for(int i = 0; i < header.entryCount; i++)
+    {
+        SavedNameEntry saved;
+        memcpy(&saved, savedEntries + sizeof(saved) * (size_t) i, sizeof(saved));
+        if(!validSavedEntry(&saved, &header))
+        {
+            clearNameIndex();
+            return NAME_INDEX_FAILURE;
+        }
+
+        NameEntry *entry     = &entries[i];
+        entry->text          = loadedText + saved.textOffset;
+        entry->patientIds    = saved.count > 0 ? loadedIds + saved.idOffset : NULL;
+        entry->count         = saved.count;
+        entry->capacity      = saved.count;
+        entry->bkDistance    = saved.bkDistance;
+        entry->bkFirstChild  = saved.bkFirstChild;
+        entry->bkNextSibling = saved.bkNextSibling;
+        entryCount++;
+    }
+
+    return NAME_INDEX_SUCCESS;
+}
+
+/*
+ * Lower-cases a name, trims it and collapses internal whitespace.
+ */
+int foldPatientName(const char name[], char folded[])
+{
+    int length       = 0;
+    int pendingSpace = 0;
+
+    for(const char *p = name; *p != '\0' && length < MAX_PATIENT_NAME_LENGTH - 1; p++)
+    {
+        if(isspace((unsigned char) *p))
+        {
+            pendingSpace = length > 0;
+            continue;
+        }
+        if(pendingSpace && length < MAX_PATIENT_NAME_LENGTH - 2)
+        {
+            folded[length++] = ' ';
+        }
+        pendingSpace     = 0;
+        folded[length++] = (char) tolower((unsigned char) *p);
+    }
+
+    folded[length] = '\0';
+    return length;
+}
+
+/*
+ * Returns the trie node spelling text, or NO_NODE.
+ */
+static int findTrieNode(const char text[])
+{
+    if(trieNodeCount == 0)
+    {
+        return NO_NODE;
+    }
+
+    int node = TRIE_ROOT;
+    for(const char *p = text; *p != '\0' && node != NO_NODE; p++)
+    {
+        int child = trieNodes[node].firstChild;
+        while(child != NO_NODE && (unsigned char) trieNodes[child].key < (unsigned char) *p)
+        {
+            child = trieNodes[child].nextSibling;
+        }
+        node = child != NO_NODE && trieNodes[child].key == *p ? child : NO_NODE;
+    }
+
+    return node;
+}
+
+/*
+ * Appends an unlinked trie node.
+ */
+static int addTrieNode(char key)
+{
+    if(trieNodeCount == trieCapacity)
+    {
+        int       newCapacity = trieCapacity == 0 ? INITIAL_CAPACITY : trieCapacity * 2;
+        TrieNode *grown       = realloc(trieNodes, sizeof(TrieNode) * (size_t) newCapacity);
+        if(grown == NULL)
+        {
+            return NO_NODE;
+        }
+        trieNodes    = grown;
+        trieCapacity = newCapacity;
+    }
+
+    TrieNode *node    = &trieNodes[trieNodeCount];
+    node->firstChild  = NO_NODE;
+    node->nextSibling = NO_NODE;
+    node->entry       = NO_NODE;
+    node->key         = key;
+    return trieNodeCount++;
+}
+
+/*
+ * Returns the child of parent labelled key, inserting it in key order
+ * if needed.
+ */
+static int findOrAddChild(int parent, char key)
+{
+    int previous = NO_NODE;
+    int child    = trieNodes[parent].firstChild;
+
+    while(child != NO_NODE && (unsigned char) trieNodes[child].key < (unsigned char) key)
+    {
+        previous = child;
+        child    = trieNodes[child].nextSibling;
+    }
+    if(child != NO_NODE && trieNodes[child].key == key)
+    {
+        return child;
+    }
+
+    int node = addTrieNode(key);
+    if(node == NO_NODE)
+    {
+        return NO_NODE;
+    }
+
+    trieNodes[node].nextSibling = child;
+    if(previous == NO_NODE)
+    {
+        trieNodes[parent].firstChild = node;
+    }
+    else
+    {
+        trieNodes[previous].nextSibling = node;
+    }
+
+    return node;
+}
+
+/*
+ * Creates an entry for a new folded name and links it into the trie and
+ * the BK-tree.
+ */
+static int addEntry(const char text[])
+{
+    if(trieNodeCount == 0 && addTrieNode('\0') == NO_NODE)
+    {
+        return NO_NODE;
+    }
+
+    if(entryCount == entryCapacity)
+    {
+        int        newCapacity = entryCapacity == 0 ? INITIAL_CAPACITY : entryCapacity * 2;
+        NameEntry *grown       = realloc(entries, sizeof(NameEntry) * (size_t) newCapacity);
+        if(grown == NULL)
+        {
+            return NO_NODE;
+        }
+        entries       = grown;
+        entryCapacity = newCapacity;
+    }
+
+    int node = TRIE_ROOT;
+    for(const char *p = text; *p != '\0'; p++)
+    {
+        node = findOrAddChild(node, *p);
+        if(node == NO_NODE)
+        {
+            return NO_NODE;
+        }
+    }
+
+    size_t length = strlen(text);
+    char  *copy   = malloc(length + 1);
+    if(copy == NULL)
+    {
+        return NO_NODE;
+    }
+    memcpy(copy, text, length + 1);
+
+    NameEntry *entry     = &entries[entryCount];
+    memset(entry, 0, sizeof(NameEntry));
+    entry->text          = copy;
+    entry->bkFirstChild  = NO_NODE;
+    entry->bkNextSibling = NO_NODE;
+
+    trieNodes[node].entry = entryCount;
+    addToBkTree(entryCount);
+
+    return entryCount++;
+}
+
+/*
+ * Hangs an entry off the BK-tree rooted at entry 0.
+ */
+static void addToBkTree(int entry)
+{
+    if(entry == 0)
+    {
+        return;
+    }
+
+    const char *text   = entries[entry].text;
+    int         length = (int) strlen(text);
+    int         node   = 0;
+
+    for(;;)
+    {
+        int distance = editDistance(text, length, entries[node].text, (int) strlen(entries[node].text));
+        int child    = entries[node].bkFirstChild;
+
+        while(child != NO_NODE && entries[child].bkDistance != distance)
+        {
+            child = entries[child].bkNextSibling;
+        }
+
+        if(child == NO_NODE)
+        {
+            entries[entry].bkDistance    = distance;
+            entries[entry].bkNextSibling = entries[node].bkFirstChild;
+            entries[node].bkFirstChild   = entry;
+            return;
+        }
+        node = child;
+    }
+}
+
+/*
+ * Levenshtein distance using a single row of the dynamic programming table.
+ */
+static int editDistance(const char a[], int aLength, const char b[], int bLength)
+{
+    int row[MAX_PATIENT_NAME_LENGTH + 1];
+
+    for(int j = 0; j <= bLength; j++)
+    {
+        row[j] = j;
+    }
+
+    for(int i = 1; i <= aLength; i++)
+    {
+        int diagonal = row[0];
+        row[0]       = i;
+
+        for(int j = 1; j <= bLength; j++)
+        {
+            int above = row[j];
+            int cost  = diagonal + (a[i - 1] != b[j - 1]);
+
+            if(above + 1 < cost)
+            {
+                cost = above + 1;
+            }
+            if(row[j - 1] + 1 < cost)
+            {
+                cost = row[j - 1] + 1;
+            }
+
+            row[j]   = cost;
+            diagonal = above;
+        }
+    }
+
+    return row[bLength];
+}
+
+/*
+ * Pushes a node onto a growable traversal stack.
+ */
+static int pushNode(int **stack, int *stackSize, int *stackCapacity, int node)
+{
+    if(*stackSize == *stackCapacity)
+    {
+        int  newCapacity = *stackCapacity == 0 ? INITIAL_CAPACITY : *stackCapacity * 2;
+        int *grown       = realloc(*stack, sizeof(int) * (size_t) newCapacity);
+        if(grown == NULL)
+        {
+            return 0;
+        }
+        *stack         = grown;
+        *stackCapacity = newCapacity;
+    }
+
+    (*stack)[(*stackSize)++] = node;
+    return 1;
+}
+
+/*
+ * Passes every patient of an entry to the visitor.
+ * Returns 0 if the visitor asked to stop.
+ */
+static int visitEntry(int entry, int distance, NameMatchVisitor visitor, void *context, int *visited)
+{
+    if(entry == NO_NODE)
+    {
+        return 1;
+    }
+
+    for(int i = 0; i < entries[entry].count; i++)
+    {
+        (*visited)++;
+        if(!visitor(entries[entry].patientIds[i], distance, context))
+        {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+/*
+ * qsort comparator ordering matches by distance, then by name.
+ */
+static int compareSimilarNames(const void *a, const void *b)
+{
+    const SimilarName *left  = a;
+    const SimilarName *right = b;
+
+    if(left->distance != right->distance)
+    {
+        return left->distance - right->distance;
+    }
+    return strcmp(entries[left->entry].text, entries[right->entry].text);
+}
+
+/*
+ * Returns 1 if an entry's ID list is its own allocation rather than a
+ * share of a loaded index.
+ */
+static int ownsPatientIds(const NameEntry *entry)
+{
+    return loadedIds == NULL || entry->patientIds < loadedIds || entry->patientIds >= loadedIds + loadedIdCount;
+}
+
+/*
+ * Checks that a saved entry stays inside the saved texts, IDs and
+ * entries, and that its text is terminated.
+ */
+static int validSavedEntry(const SavedNameEntry *saved, const SavedNameIndex *header)
+{
+    return saved->textOffset >= 0 && saved->textOffset < header->textLength &&
+           memchr(loadedText + saved->textOffset, '\0', (size_t) (header->textLength - saved->textOffset)) != NULL &&
+           saved->idOffset >= 0 && saved->count >= 0 && saved->count <= header->idCount - saved->idOffset &&
+           saved->bkFirstChild >= NO_NODE && saved->bkFirstChild < header->entryCount &&
+           saved->bkNextSibling >= NO_NODE && saved->bkNextSibling < header->entryCount;
+}
@@ -0,0 +1,117 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the in-memory name index over active patients.
+ *          Names are case-folded with runs of whitespace collapsed. A trie
+ *          over the folded names answers prefix searches in name order, and a
+ *          BK-tree over the same names answers misspelled searches within a
+ *          bounded edit distance.
+ */
+
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#define NAME_INDEX_SUCCESS 1
+#define NAME_INDEX_FAILURE 0
+
+#define MAX_NAME_EDIT_DISTANCE 3
+
+/*
+ * Callback invoked for each patient matched by a name search, with the
+ * edit distance between their name and the query (0 for prefix matches).
+ * Returning 0 stops the search early.
+ */
+typedef int (*NameMatchVisitor)(int patientId, int distance, void *context);
+
+/*
+ * Function: addToNameIndex
+ * ------------------------
+ * Adds a patient under their name.
+ *
+ * patientId: The patient's ID
+ * name: The patient's name as entered
+ *
+ * Returns: NAME_INDEX_SUCCESS, or NAME_INDEX_FAILURE on allocation failure
+ */
+int addToNameIndex(int patientId, const char name[]);
+
+/*
+ * Function: removeFromNameIndex
+ * -----------------------------
+ * Removes a patient from the index.
+ */
+void removeFromNameIndex(int patientId, const char name[]);
+
+/*
+ * Function: visitNamePrefix
+ * -------------------------
+ * Visits every patient whose folded name starts with the folded prefix,
+ * in alphabetical order of name. Matches are produced as the trie is
+ * walked, so stopping early costs nothing for the remaining names.
+ *
+ * Returns: The number of patients visited
+ */
+int visitNamePrefix(const char prefix[], NameMatchVisitor visitor, void *context);
+
+/*
+ * Function: visitSimilarNames
+ * ---------------------------
+ * Visits every patient whose folded name is within maxDistance edits
+ * (insertions, deletions or substitutions) of the folded query, closest
+ * names first.
+ *
+ * maxDistance: 0 to MAX_NAME_EDIT_DISTANCE
+ *
+ * Returns: The number of patients visited, or -1 on allocation failure
+ */
+int visitSimilarNames(const char name[], int maxDistance, NameMatchVisitor visitor, void *context);
+
+/*
+ * Function: foldPatientName
+ * -------------------------
+ * Folds a name the way the index compares names.
+ *
+ * name: The name as entered
+ * folded: Receives the folded name; must hold MAX_PATIENT_NAME_LENGTH bytes
+ *
+ * Returns: The length of the folded name
+ */
+int foldPatientName(const char name[], char folded[]);
+
+/*
+ * Function: saveNameIndex
+ * -----------------------
+ * Writes the index as a checkpoint section (see store_checkpoint.h): the
+ * trie nodes as they are and the entries with offsets in place of their
+ * text and ID list pointers.
+ *
+ * Returns: NAME_INDEX_SUCCESS, or NAME_INDEX_FAILURE on a write error
+ */
+int saveNameIndex(FILE *file);
+
+/*
+ * Function: loadNameIndex
+ * -----------------------
+ * Replaces the index with one written by saveNameIndex. The trie, the
+ * texts and the ID lists are each copied out of the section in one piece,
+ * so loading costs a pass over the entries, not an insert per patient.
+ *
+ * section: The saved index, typically inside a mapped checkpoint
+ * length: The section's length in bytes
+ *
+ * Returns: NAME_INDEX_SUCCESS, or NAME_INDEX_FAILURE (leaving the index
+ *          empty) if the section is malformed or memory runs out
+ */
+int loadNameIndex(const void *section, size_t length);
+
+/*
+ * Function: clearNameIndex
+ * ------------------------
+ * Frees all memory used by the name index.
+ */
+void clearNameIndex(void);
+
+#endif // NAME_INDEX_H
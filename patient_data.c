@@ -8,6 +8,7 @@
 #include <string.h>
 #include <ctype.h>
 #include <time.h>
+#include "diagnosis_dictionary.h"
 #include "patient_data.h"
 #include "utils.h"
 
@@ -32,7 +33,7 @@ static const int HAS_LETTERS = 1;
  */
 Patient createPatient(const char patientName[],
                       int patientAge,
-                      const char patientDiagnosis[],
+                      int diagnosisId,
                       int roomNumber,
                       int patientId)
 {
@@ -40,7 +41,7 @@ Patient createPatient(const char patientName[],
     newPatient.patientId = patientId;
     strcpy(newPatient.name, patientName);
     newPatient.ageInYears = patientAge;
-    strcpy(newPatient.diagnosis, patientDiagnosis);
+    newPatient.diagnosisId = diagnosisId;
     newPatient.roomNumber = roomNumber;
     newPatient.admissionDate = time(NULL);
     return newPatient;
@@ -159,13 +160,40 @@ int validateRoomNumber(int roomNumber)
  */
 void printPatient(const Patient patient)
 {
-    printf("---------------------------------------\n");
-    printf("Patient ID: %d\n", patient.patientId);
-    printf("Patient Name: %s\n", patient.name);
-    printf("Age: %d\n", patient.ageInYears);
-    printf("Diagnosis: %s\n", patient.diagnosis);
-    printf("Room Number: %d\n", patient.roomNumber);
-    printf("Time Admitted: %s", ctime(&patient.admissionDate));
-    printf("---------------------------------------\n");
+    char buffer[FORMATTED_PATIENT_SIZE];
+
+    formatPatient(&patient, buffer);
+    fputs(buffer, stdout);
+}
+
+/*
+ * Formats a patient with a single snprintf. The admission time uses the
+ * same layout as ctime().
+ */
+int formatPatient(const Patient *patient, char buffer[])
+{
+    struct tm admissionTime;
+    char      admissionStr[32];
+
+    localtime_r(&patient->admissionDate, &admissionTime);
+    strftime(admissionStr, sizeof(admissionStr), "%a %b %e %H:%M:%S %Y", &admissionTime);
+
+    int length = snprintf(buffer, FORMATTED_PATIENT_SIZE,
+                          "---------------------------------------\n"
+                          "Patient ID: %d\n"
+                          "Patient Name: %s\n"
+                          "Age: %d\n"
+                          "Diagnosis: %s\n"
+                          "Room Number: %d\n"
+                          "Time Admitted: %s\n"
+                          "---------------------------------------\n",
+                          patient->patientId,
+                          patient->name,
+                          patient->ageInYears,
+                          getDiagnosisText(patient->diagnosisId),
+                          patient->roomNumber,
+                          admissionStr);
+
+    return length < FORMATTED_PATIENT_SIZE ? length : FORMATTED_PATIENT_SIZE - 1;
 }
 
@@ -12,6 +12,8 @@
 // Constants for patient data
 #define MAX_PATIENT_NAME_LENGTH 100
 #define MAX_DIAGNOSIS_LENGTH 255
+#define MAX_ROOMS 50
+#define FORMATTED_PATIENT_SIZE 640 // Upper bound of formatPatient output
 
 /*
  * Structure representing a patient in the system.
@@ -22,7 +24,7 @@ typedef struct
     int patientId;
     char name[MAX_PATIENT_NAME_LENGTH];
     int ageInYears;
-    char diagnosis[MAX_DIAGNOSIS_LENGTH];
+    int diagnosisId; // Interned ID, see diagnosis_dictionary.h
     int roomNumber;
     time_t admissionDate;
 } Patient;
@@ -34,7 +36,7 @@ typedef struct
  * 
  * patientName: The name of the patient
  * patientAge: The age of the patient in years
- * patientDiagnosis: The medical diagnosis
+ * diagnosisId: The interned ID of the medical diagnosis
  * roomNumber: The assigned room number
  * patientId: The unique identifier for the patient
  * 
@@ -42,7 +44,7 @@ typedef struct
  */
 Patient createPatient(const char patientName[], 
                       int patientAge,
-                      const char patientDiagnosis[], 
+                      int diagnosisId,
                       int roomNumber,
                       int patientId);
 
@@ -99,6 +101,19 @@ int validateRoomNumber(int roomNumber);
  */
 void printPatient(const Patient patient);
 
+/*
+ * Function: formatPatient
+ * -----------------------
+ * Formats the same text printPatient displays into a buffer, so callers
+ * can build many patients into one block and write it at once.
+ *
+ * patient: Pointer to the patient to format
+ * buffer: Destination of at least FORMATTED_PATIENT_SIZE bytes
+ *
+ * Returns: Number of characters written, excluding the terminator
+ */
+int formatPatient(const Patient *patient, char buffer[]);
+
 /*
  * Function: isRoomOccupied
  * -----------------------
@@ -4,608 +4,2674 @@
  * Purpose: This file implements functions for managing patient records in a hospital system.
  */
 
+#define _GNU_SOURCE // pthread_rwlock_t, open_memstream
+
 #include "patient_management.h"
 #include <errno.h>
+#include <fcntl.h>
+#include <limits.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <strings.h>
 #include <time.h>
+#include <unistd.h>
+#include "activity_counters.h"
+#include "admission_log.h"
+#include "async_io.h"
+#include "diagnosis_dictionary.h"
+#include "diagnosis_index.h"
+#include "discharge_archive.h"
+#include "discharge_index.h"
+#include "durable_file.h"
+#include "name_index.h"
 #include "patient_data.h"
+#include "patient_snapshot.h"
+#include "patient_storage.h"
+#include "readmission.h"
+#include "report_aggregates.h"
+#include "report_engine.h"
+#include "report_export.h"
+#include "report_writer.h"
+#include "stay_analytics.h"
+#include "store_checkpoint.h"
+#include "transfer_log.h"
 #include "utils.h"
 
 // Private constants
 #define INITIAL_CAPACITY 1
 #define IS_EMPTY 0
 #define DEFAULT_ID 1
+#define VIEW_EXPORT_FILE "patients_view.txt"
+#define ROOM_USAGE_FILE "room_usage.txt"
+#define READMISSION_REPORT_FILE "readmission_report.txt"
+#define ACTIVITY_REPORT_FILE "activity_report.txt"
+#define STAY_REPORT_FILE "length_of_stay_report.txt"
+#define ROOM_USAGE_LINE_SIZE 12 // A room number and newline
+#define MAX_TIMEFRAME_DAYS 31   // Days in the longest report timeframe
+#define DATE_TEXT_SIZE 11       // "YYYY-MM-DD" and terminator
+#define MAX_ACTIVITY_PERIODS 366
+#define DAYS_PER_WEEK 7
+#define SECONDS_PER_HOUR 3600
+#define HOURS_PER_DAY 24.0
+#define STAY_LABEL_SIZE 32
+
+// Sort keys for viewPatientRecords
+#define SORT_BY_ID 1
+#define SORT_BY_NAME 2
+#define SORT_BY_ROOM 3
+#define SORT_BY_ADMISSION 4
 
 static const int PATIENT_NOT_FOUND        = -1;
 static const int INVALID_ID               = 0;
 static const int REMOVE_PATIENT_ARRAY_MAX = 49;
 static const int NEXT_INDEX_OFFSET        = 1;
 static const int ROOM_UNOCCUPIED          = -1;
+static const int RESULTS_PAGE_SIZE        = 10;
+static const int NAME_SEARCH_MAX_EDITS    = 2;
+static const int VIEW_PAGE_SIZE           = 20;  // Patients per screen
+static const int EXPORT_PAGE_SIZE         = 256; // Patients per write when exporting
+static const int PAGE_FOOTER_SIZE         = 128;
+
+/*
+ * One group's row in the length-of-stay report.
+ */
+typedef struct
+{
+    char             label[STAY_LABEL_SIZE];
+    const StayStats *stats;
+} StayRow;
+
+/*
+ * Room numbers on their way to room_usage.txt.
+ */
+typedef struct
+{
+    int  fd;
+    char lines[]; // ROOM_USAGE_LINE_SIZE per discharged patient
+} RoomUsageLog;
+
+/*
+ * The report timeframe shared with the report engine filters: the local
+ * days it covers, as the instants each starts at, and their dates as
+ * text. Filtering and formatting a record then compares timestamps,
+ * without converting each one to a local date.
+ */
+typedef struct
+{
+    time_t    now;
+    struct tm currentTime;
+    int       timeframe;
+    int       dayCount;
+    time_t    dayStarts[MAX_TIMEFRAME_DAYS + 1]; // The last is the end of today
+    char      dayTexts[MAX_TIMEFRAME_DAYS][DATE_TEXT_SIZE];
+} ReportTimeframe;
+
+/*
+ * A periodic snapshot handed to the background checkpoint thread: the
+ * pinned patients and the active indexes copied into memory.
+ */
+typedef struct
+{
+    CheckpointState  state;
+    PatientSnapshot *patients;
+    char            *nameIndex;
+    size_t           nameIndexLength;
+    char            *diagnosisIndex;
+    size_t           diagnosisIndexLength;
+} BackgroundCheckpoint;
 
-// Global patient data
-static PatientNode *patientHead      = NULL;
-static int          totalPatients    = IS_EMPTY;
-static int          patientIDCounter = DEFAULT_ID;
+/*
+ * State shared with the export visitors while streaming rows.
+ */
+typedef struct
+{
+    ExportWriter    exporter;
+    ReportTimeframe window;
+} ExportScan;
+
+// Global patient data. patientStoreLock guards the list, totalPatients,
+// roomOccupants and the in-memory indexes and totals updated with them:
+// index lookups share it, while admissions, discharges and transfers hold
+// it exclusively and publish each change as a new patient snapshot. Views,
+// reports and lookups by ID read a snapshot instead, so they never wait on
+// a writer. IDs are handed out atomically, outside the lock.
+static PatientNode     *patientHead      = NULL;
+static PatientNode     *patientTail      = NULL;
+static int              totalPatients    = IS_EMPTY;
+static atomic_int       patientIDCounter = DEFAULT_ID;
+static pthread_rwlock_t patientStoreLock = PTHREAD_RWLOCK_INITIALIZER;
+
+// ID of the patient in each room, 0 when vacant (index 0 unused)
+static int roomOccupants[MAX_ROOMS + 1];
+
+// Nodes restored from a checkpoint share one allocation, freed as a whole
+static PatientNode *restoredNodes     = NULL;
+static int          restoredNodeCount = 0;
+
+// Set when the last publish failed, so the patient snapshot lags the list
+static int snapshotBehind = 0;
+
+// patients.dat as the delta log describes it, once every queued admission
+// is written, so a snapshot can record it without flushing the admission
+// log. Kept under patientStoreLock while a checkpoint is logged.
+static FileStamp        loggedFile;
+static RecordFileHeader loggedFileHeader;
+
+// The periodic snapshot being written in the background
+static BackgroundCheckpoint backgroundCheckpoint;
+static pthread_t            checkpointThread;
+static int                  checkpointRunning  = 0; // Started and not yet joined
+static atomic_int           checkpointFinished = 0;
 
 // Function prototypes for internal helper functions
 static char        *getPatientName(char patientName[]);
 static int          getPatientAge(int *patientAge);
 static char        *getPatientDiagnosis(char patientDiagnosis[]);
 static int          getRoomNumber(int *roomNumber);
-static Patient     *getPatientToDischarge(void);
-static int          confirmDischarge(Patient *patient);
-static void         removePatientFromSystem(Patient *patient);
+static int          getPatientToDischarge(void);
+static int          confirmDischarge(const Patient *patient);
+static int          dischargeRecords(DischargedPatient records[], int count);
+static void         removePatientsFromSystem(const DischargedPatient records[], int count);
+static void         unlinkPatients(const int sortedIds[], int count);
+static void         freePatientNode(PatientNode *node);
 static Patient     *getPatientFromList(int id);
-static void         writePatientToFile(Patient newPatient);
+static int          copyActivePatient(int id, Patient *patient);
+static int          getActivePatientCount(void);
+static int          allocatePatientId(void);
+static void         loadPatientStore(void);
+static int          restoreCheckpoint(int matchReadmissions);
+static int          restoreSections(const CheckpointMap *map);
+static int          replayStoreChange(const CheckpointDelta *delta, void *context);
+static void         growPatientsFileStamp(FileStamp *stamp, const RecordFileHeader *header, const Patient *patient);
+static void         writeStoreCheckpoint(void);
+static int          trackPatientsFile(void);
+static void         startStoreCheckpoint(void);
+static int          copyIndexSections(BackgroundCheckpoint *checkpoint);
+static void        *writeBackgroundCheckpoint(void *argument);
+static int          writeCheckpointPatient(const Patient *patient, void *context);
+static void         waitForStoreCheckpoint(void);
+static void         logStoreChange(int type, const Patient *patient);
+static void         resetPatientStore(void);
+static void         clearPatientStore(void);
+static void         publishPatientChange(int published);
+static void         writePatientToFile(const Patient *newPatient, PendingAdmission *commit);
+static void         awaitPatientWrite(PendingAdmission *admission);
 static void         updatePatientsFile(void);
-static PatientNode *insertPatientAtEndOfList(PatientNode *head, Patient data);
-static int          isRoomOccupiedInList(int roomNumber, PatientNode *head);
+static PatientNode *insertPatientAtEndOfList(Patient data);
+static int          getRoomOccupant(int roomNumber);
+static void         rebuildRoomOccupancy(void);
+static void         replayTransfers(time_t since);
+static int          applyTransfer(const TransferRecord *transfer, void *context);
 static int          computeNextPatientId(void);
 static int          countPatientsByTimeframe(int timeframe);
-static void         logRoomUsage(int roomNumber);
+static void         logRoomUsage(const DischargedPatient records[], int count);
+static void         finishRoomUsageLog(int result, void *context);
 static void         clearBinaryFile(const char* fileName);
 static int          countDischargedPatientsByTimeframe(int timeframe);
+static void         initializeTimeframe(ReportTimeframe *window, int timeframe);
+static int          isWithinTimeframe(time_t timestamp, const ReportTimeframe *window);
+static const char  *getTimeframeDateText(const ReportTimeframe *window, time_t timestamp);
+static int          comparePatientIds(const void *a, const void *b);
+static int          getViewSortKey(void);
+static const Patient **buildPatientView(const PatientSnapshot *snapshot, int sortKey, int *count);
+static size_t       renderPatientPage(const Patient *view[], int count, char buffer[]);
+static int          writeBlock(FILE *stream, const char buffer[], size_t length);
+static void         pagePatientView(const Patient *view[], int count);
+static void         exportPatientView(const Patient *view[], int count);
+static int          compareViewById(const void *a, const void *b);
+static int          compareViewByName(const void *a, const void *b);
+static int          compareViewByRoom(const void *a, const void *b);
+static int          compareViewByAdmission(const void *a, const void *b);
+static void         syncReportAggregates(void);
+static int          rebuildDischargeTotals(const DischargedPatient *dischargedPatient, void *context);
+static int          getTimeframeFirstDay(const struct tm *currentTime, int timeframe);
+static ActivityCount countActivityPeriod(int granularity, time_t now, int periodsBack, char label[], size_t labelSize);
+static ActivityCount countDayActivity(int firstDay, int lastDay);
+static void         printStaySection(ReportWriter *writer, const char *title, const StayRow rows[], int rowCount);
+static int          isAdmittedWithinTimeframe(const Patient *patient, const void *context);
+static int          isDischargedWithinTimeframe(const DischargedPatient *dischargedPatient, const void *context);
+static int          getDischargedDiagnosis(const DischargedPatient *dischargedPatient, const void *context);
+static void         printDischargedRecord(ReportWriter *writer,
+                                          const DischargedPatient *dischargedPatient,
+                                          const ReportTimeframe *window);
+static int          exportAdmittedPatient(const Patient *patient, void *context);
+static int          exportDischargedRecord(const DischargedPatient *dischargedPatient, void *context);
 
 /*
  * Initializes the patient management system.
- * Attempts to load patient data from patients.dat file.
+ * Restores the store from its checkpoint, or loads it from patients.dat
+ * when there is no usable checkpoint.
  */
 void initializePatientSystem(void)
 {
-    clearMemory();
-
-    FILE *file = fopen("patients.dat", "rb");
-
-    if (file == NULL)
+    pthread_rwlock_wrlock(&patientStoreLock);
+    if(!restoreCheckpoint(1))
     {
-        puts("Error reading patients.dat. Initializing with default setting.");
-        initializePatientSystemDefault();
-        return;
+        loadPatientStore();
     }
+    pthread_rwlock_unlock(&patientStoreLock);
+}
 
-    if (fgetc(file) == EOF)
+/*
+ * Replaces the store with the contents of patients.dat. Must be called
+ * with patientStoreLock held exclusively.
+ */
+static void loadPatientStore(void)
+{
+    // Queued admissions are in the list, but not yet in the file
+    flushAdmissionLog();
+    clearPatientStore();
+
+    RecordReader reader;
+
+    if (!openRecordReader(&reader, "patients.dat", PATIENT_FILE_MAGIC))
     {
-        fclose(file);
-        puts("patients.dat is empty. Initializing with default setting.");
-        initializePatientSystemDefault();
+        puts("Unable to read patients.dat or file is empty. Initializing with default setting.");
+        resetPatientStore();
         return;
     }
-    rewind(file);
 
     // Populate Linked List
-    Patient tempPatient;
+    Patient          tempPatient;
+    ReadmissionMatch readmission;
+    time_t           writtenAt = reader.header.baseTime;
     int foundData = 0;
 
-    while (fread(&tempPatient, sizeof(Patient), 1, file) == 1)
+    while (readPatientRecord(&reader, &tempPatient))
     {
         foundData = 1;
-        patientHead = insertPatientAtEndOfList(patientHead, tempPatient);
-        if (patientHead == NULL)
+        if (insertPatientAtEndOfList(tempPatient) == NULL)
         {
             puts("Error: Unable to populate linked list from patients.dat.");
-            fclose(file);
-            initializePatientSystemDefault();
+            closeRecordReader(&reader);
+            resetPatientStore();
             return;
         }
         totalPatients++;
+        addToDiagnosisIndex(INDEX_SCOPE_ACTIVE, tempPatient.patientId, tempPatient.diagnosisId);
+        addToNameIndex(tempPatient.patientId, tempPatient.name);
+        matchReadmission(&tempPatient, &readmission);
     }
 
-    fclose(file);
+    closeRecordReader(&reader);
 
     if (!foundData)
     {
         puts("Warning: patients.dat contained no valid patient records.");
         // Clear File If Only Invalid Data Found
         clearBinaryFile("patients.dat");
-        initializePatientSystemDefault();
+        resetPatientStore();
     }
     else
     {
         patientIDCounter = computeNextPatientId();
+        replayTransfers(writtenAt);
+        rebuildRoomOccupancy();
         puts("Patients successfully loaded from file.");
+        syncReportAggregates();
+        publishPatientChange(publishPatientList(patientHead));
+        writeStoreCheckpoint();
     }
 }
 
 /*
- * Clears the contents of a binary file by opening it in write mode.
- * This effectively erases all data in the file.
+ * Delta log state while a checkpoint is restored.
+ */
+typedef struct
+{
+    RecordFileHeader header;         // Of patients.dat, to size replayed admissions
+    FileStamp        expected;       // What patients.dat should look like
+    int             *dischargedIds;  // Unlinked in one pass after the replay
+    int              dischargedCount;
+    int              dischargedCapacity;
+    int              nextPatientId;
+} CheckpointReplay;
+
+/*
+ * Replaces the store with its checkpoint: the snapshot's sections, then
+ * the delta log and the transfers made since. Nothing is indexed patient
+ * by patient, and readmissions are only matched when asked for, since a
+ * running system has matched every patient already. Must be called with
+ * patientStoreLock held exclusively.
  *
- * fileName: The name of the file to clear
+ * Returns 1 on success, or 0 with the store empty if there is no
+ * checkpoint or it is out of date with patients.dat.
  */
-static void clearBinaryFile(const char* fileName)
+static int restoreCheckpoint(int matchReadmissions)
 {
-    FILE *clearFile = fopen(fileName, "wb");
-    if (clearFile == NULL)
+    CheckpointMap    map;
+    CheckpointReplay replay;
+    RecordReader     reader;
+    FileStamp        actual;
+    int              entryCount;
+
+    // Queued admissions are in the list, but not yet in the file
+    flushAdmissionLog();
+    waitForStoreCheckpoint();
+    clearPatientStore();
+
+    if(!mapCheckpoint(&map))
     {
-        puts("Error: Unable to clear patients.dat.");
+        return 0;
     }
-    else
+    if(!openRecordReader(&reader, "patients.dat", PATIENT_FILE_MAGIC))
+    {
+        unmapCheckpoint(&map);
+        return 0;
+    }
+    closeRecordReader(&reader);
+
+    memset(&replay, 0, sizeof(replay));
+    replay.header        = reader.header;
+    replay.expected      = map.state->patientsFile;
+    replay.nextPatientId = map.state->nextPatientId;
+    time_t takenAt       = map.state->takenAt;
+
+    int restored = restoreSections(&map) &&
+                   scanCheckpointDelta(map.state->generation, replayStoreChange, &replay, &entryCount);
+    unmapCheckpoint(&map);
+
+    if(restored && replay.dischargedCount > 0)
+    {
+        qsort(replay.dischargedIds, (size_t) replay.dischargedCount, sizeof(int), comparePatientIds);
+        unlinkPatients(replay.dischargedIds, replay.dischargedCount);
+    }
+    free(replay.dischargedIds);
+
+    if(!restored || !stampFile("patients.dat", &actual) || actual.device != replay.expected.device ||
+       actual.inode != replay.expected.inode || actual.size != replay.expected.size)
+    {
+        if(restored)
+        {
+            puts("Patient checkpoint is out of date with patients.dat. Loading patients.dat instead.");
+        }
+        discardCheckpoint();
+        clearPatientStore();
+        return 0;
+    }
+
+    patientIDCounter = replay.nextPatientId;
+    loggedFile       = replay.expected;
+    loggedFileHeader = replay.header;
+    replayTransfers(takenAt);
+    rebuildRoomOccupancy();
+
+    if(matchReadmissions)
     {
-        fclose(clearFile);
+        ReadmissionMatch readmission;
+        for(PatientNode *current = patientHead; current != NULL; current = current->nextNode)
+        {
+            matchReadmission(&current->data, &readmission);
+        }
     }
+
+    printf("Patients restored from checkpoint (%d change(s) since it was taken).\n", entryCount);
+    syncReportAggregates();
+    publishPatientChange(publishPatientList(patientHead));
+    return 1;
 }
 
 /*
- * Initializes the patient management system with default settings.
- * Called when patients.dat cannot be read or is empty.
+ * Copies the patients out of a mapped snapshot into one block of nodes
+ * and loads the active indexes saved with them.
+ *
+ * Returns 1 on success, 0 if a section is missing or malformed.
  */
-void initializePatientSystemDefault(void)
+static int restoreSections(const CheckpointMap *map)
 {
-    patientHead      = NULL;
-    totalPatients    = IS_EMPTY;
-    patientIDCounter = DEFAULT_ID;
-    puts("Patient system initialized with default settings using linked list.");
-}
+    size_t         patientsLength;
+    size_t         nameLength;
+    size_t         diagnosisLength;
+    const Patient *patients      = getCheckpointSection(map, CHECKPOINT_SECTION_PATIENTS, &patientsLength);
+    const void    *nameIndex     = getCheckpointSection(map, CHECKPOINT_SECTION_NAME_INDEX, &nameLength);
+    const void    *diagnosisData = getCheckpointSection(map, CHECKPOINT_SECTION_DIAGNOSIS_INDEX, &diagnosisLength);
+    int            count         = map->state->patientCount;
+
+    if(patients == NULL || nameIndex == NULL || diagnosisData == NULL || count < 0 ||
+       patientsLength != sizeof(Patient) * (size_t) count)
+    {
+        return 0;
+    }
+
+    if(count > 0)
+    {
+        restoredNodes = malloc(sizeof(PatientNode) * (size_t) count);
+        if(restoredNodes == NULL)
+        {
+            return 0;
+        }
+        restoredNodeCount = count;
+
+        for(int i = 0; i < count; i++)
+        {
+            restoredNodes[i].data     = patients[i];
+            restoredNodes[i].nextNode = i + 1 < count ? &restoredNodes[i + 1] : NULL;
+        }
+        patientHead   = &restoredNodes[0];
+        patientTail   = &restoredNodes[count - 1];
+        totalPatients = count;
+    }
 
+    return loadNameIndex(nameIndex, nameLength) &&
+           loadDiagnosisIndexScope(INDEX_SCOPE_ACTIVE, diagnosisData, diagnosisLength);
+}
 
 /*
- * Adds a new patient record to the system after validating input fields.
+ * Applies one delta log entry to the restored store. Admissions grow the
+ * expected size of patients.dat by their encoded record, and stamp entries
+ * replace it. Discharged patients leave the indexes at once and the list
+ * in one pass at the end.
  */
-void addPatientRecord(void)
+static int replayStoreChange(const CheckpointDelta *delta, void *context)
 {
-    char patientName[MAX_PATIENT_NAME_LENGTH];
-    int  patientAge;
-    char patientDiagnosis[MAX_DIAGNOSIS_LENGTH];
-    int  roomNumber;
+    CheckpointReplay *replay  = context;
+    const Patient    *patient = &delta->patient;
 
-    getPatientName(patientName);
-    getPatientAge(&patientAge);
-    getPatientDiagnosis(patientDiagnosis);
-    getRoomNumber(&roomNumber);
+    if(delta->type == DELTA_FILE_STAMP)
+    {
+        replay->expected = delta->stamp;
+        return 1;
+    }
 
-    // Create and store new patient record
-    Patient newPatient = createPatient(patientName, patientAge, patientDiagnosis, roomNumber, patientIDCounter);
-    patientHead        = insertPatientAtEndOfList(patientHead, newPatient);
-    totalPatients++;
-    patientIDCounter++;
+    if(delta->type == DELTA_DISCHARGE)
+    {
+        if(replay->dischargedCount == replay->dischargedCapacity)
+        {
+            int  newCapacity = replay->dischargedCapacity == 0 ? INITIAL_CAPACITY * 64 : replay->dischargedCapacity * 2;
+            int *grown       = realloc(replay->dischargedIds, sizeof(int) * (size_t) newCapacity);
+            if(grown == NULL)
+            {
+                return 0;
+            }
+            replay->dischargedIds      = grown;
+            replay->dischargedCapacity = newCapacity;
+        }
+        replay->dischargedIds[replay->dischargedCount++] = patient->patientId;
+        removeFromDiagnosisIndex(INDEX_SCOPE_ACTIVE, patient->patientId, patient->diagnosisId);
+        removeFromNameIndex(patient->patientId, patient->name);
+        return 1;
+    }
 
-    writePatientToFile(newPatient);
+    if(insertPatientAtEndOfList(*patient) == NULL)
+    {
+        return 0;
+    }
+    totalPatients++;
+    addToDiagnosisIndex(INDEX_SCOPE_ACTIVE, patient->patientId, patient->diagnosisId);
+    addToNameIndex(patient->patientId, patient->name);
 
-    printf("--- Patient Added ---\n");
-    printPatient(newPatient);
+    if(patient->patientId >= replay->nextPatientId)
+    {
+        replay->nextPatientId = patient->patientId + 1;
+    }
+    growPatientsFileStamp(&replay->expected, &replay->header, patient);
+    return 1;
 }
 
-
 /*
- * Displays all patient records stored in the system.
+ * Grows the expected stamp of patients.dat by an admission's encoded
+ * record.
  */
-void viewPatientRecords(void)
+static void growPatientsFileStamp(FileStamp *stamp, const RecordFileHeader *header, const Patient *patient)
 {
-    if(patientHead == NULL)
-    {
-        puts("No patients admitted!");
-        return;
-    }
+    unsigned char record[MAX_ENCODED_RECORD_SIZE];
 
-    PatientNode *current = patientHead;
-    while(current != NULL)
+    if(stamp->size == 0)
     {
-        printPatient(current->data);
-        current = current->nextNode;
+        stamp->size = RECORD_HEADER_SIZE;
     }
+    stamp->size += (long long) encodePatientRecord(header, patient, 0, 0, record);
 }
 
 /*
- * Searches for a patient by ID and displays their details if found.
+ * Writes a new snapshot of the store and starts an empty delta log for
+ * it. patients.dat must hold every listed patient first, so the queued
+ * admissions are flushed. Must be called with patientStoreLock held
+ * exclusively.
  */
-void searchPatientById(void)
+static void writeStoreCheckpoint(void)
 {
-    int id, index;
+    CheckpointState  state;
+    CheckpointWriter writer;
 
-    if(patientHead == NULL)
+    flushAdmissionLog();
+    waitForStoreCheckpoint();
+
+    memset(&state, 0, sizeof(state));
+    state.takenAt       = time(NULL);
+    state.patientCount  = totalPatients;
+    state.nextPatientId = atomic_load(&patientIDCounter);
+
+    if(!trackPatientsFile())
     {
-        puts("No patients admitted!");
+        discardCheckpoint();
+        return;
+    }
+    state.patientsFile = loggedFile;
+    if(!beginCheckpoint(&writer, &state))
+    {
+        // The current checkpoint and its delta log are still valid
+        perror("Error creating the patient checkpoint");
         return;
     }
 
-    printf("Enter A Patient Id: ");
-    scanf("%d", &id);
-    clearInputBuffer();
+    FILE *file    = beginCheckpointSection(&writer, CHECKPOINT_SECTION_PATIENTS);
+    int   written = 1;
+    for(PatientNode *current = patientHead; written && current != NULL; current = current->nextNode)
+    {
+        written = fwrite(&current->data, sizeof(Patient), 1, file) == 1;
+    }
+    endCheckpointSection(&writer, written);
 
-    PatientNode *current = patientHead;
-    while(current != NULL)
+    file = beginCheckpointSection(&writer, CHECKPOINT_SECTION_NAME_INDEX);
+    endCheckpointSection(&writer, saveNameIndex(file));
+
+    file = beginCheckpointSection(&writer, CHECKPOINT_SECTION_DIAGNOSIS_INDEX);
+    endCheckpointSection(&writer, saveDiagnosisIndexScope(INDEX_SCOPE_ACTIVE, file));
+
+    if(!finishCheckpoint(&writer))
     {
-        if(current->data.patientId == id)
-        {
-            printPatient(current->data);
-            return;
-        }
-        current = current->nextNode;
+        puts("Error: Unable to write the patient checkpoint.");
+        discardCheckpoint();
     }
+}
 
-    puts("Patient doesn't exist!");
+/*
+ * Stamps patients.dat and reads the header its records are encoded
+ * against, as where the delta log starts describing it. patients.dat must
+ * hold every queued admission.
+ * Returns 1 on success, 0 if patients.dat is missing or unreadable.
+ */
+static int trackPatientsFile(void)
+{
+    RecordReader reader;
+
+    if(!stampFile("patients.dat", &loggedFile) || !openRecordReader(&reader, "patients.dat", PATIENT_FILE_MAGIC))
+    {
+        return 0;
+    }
+    closeRecordReader(&reader);
+    loggedFileHeader = reader.header;
+    return 1;
 }
 
 /*
- * Removes a patient from the system if they exist and discharge is confirmed.
+ * Starts a periodic snapshot on the background checkpoint thread, unless
+ * the last one is still being written. Under the lock this only pins the
+ * patient snapshot, copies the indexes into memory and switches the delta
+ * log; the thread writes and syncs the files. A snapshot that cannot be
+ * started is tried again on the next change. Must be called with
+ * patientStoreLock held exclusively.
  */
-void dischargePatient(void)
+static void startStoreCheckpoint(void)
 {
-    if(patientHead == NULL)
+    BackgroundCheckpoint *checkpoint = &backgroundCheckpoint;
+
+    if(snapshotBehind || (checkpointRunning && !atomic_load(&checkpointFinished)))
     {
-        puts("No patients to discharge!");
         return;
     }
+    waitForStoreCheckpoint();
 
-    Patient *patientToDischarge = getPatientToDischarge();
+    memset(checkpoint, 0, sizeof(*checkpoint));
+    checkpoint->state.takenAt       = time(NULL);
+    checkpoint->state.patientCount  = totalPatients;
+    checkpoint->state.nextPatientId = atomic_load(&patientIDCounter);
+    checkpoint->state.patientsFile  = loggedFile;
 
-    if(patientToDischarge == NULL)
+    if(!copyIndexSections(checkpoint))
     {
-        puts("Patient not found!");
+        free(checkpoint->nameIndex);
+        free(checkpoint->diagnosisIndex);
+        return;
+    }
+    if(!detachCheckpoint(&checkpoint->state))
+    {
+        puts("Error: Unable to start the patient checkpoint.");
+        free(checkpoint->nameIndex);
+        free(checkpoint->diagnosisIndex);
         return;
     }
 
-    if(confirmDischarge(patientToDischarge))
+    checkpoint->patients = takePatientSnapshot();
+    atomic_store(&checkpointFinished, 0);
+    checkpointRunning = pthread_create(&checkpointThread, NULL, writeBackgroundCheckpoint, checkpoint) == 0;
+    if(!checkpointRunning)
     {
-        // Save discharged patient data
-        DischargedPatient dischargedPatient;
-        dischargedPatient.patient       = *patientToDischarge;
-        dischargedPatient.dischargeDate = time(NULL); // Current time as discharge time
+        writeBackgroundCheckpoint(checkpoint); // Without a thread, write it here
+    }
+}
 
-        // Append to discharged patients file
-        FILE *file = fopen("discharged_patients.dat", "ab");
-        if(file == NULL)
-        {
-            perror("Error opening discharged_patients.dat");            
-            return;
-        }
+/*
+ * Saves the active indexes into memory for a background snapshot.
+ * Returns 1 on success, 0 if memory ran out.
+ */
+static int copyIndexSections(BackgroundCheckpoint *checkpoint)
+{
+    FILE *names     = open_memstream(&checkpoint->nameIndex, &checkpoint->nameIndexLength);
+    FILE *diagnoses = open_memstream(&checkpoint->diagnosisIndex, &checkpoint->diagnosisIndexLength);
+
+    int copied = names != NULL && diagnoses != NULL && saveNameIndex(names) &&
+                 saveDiagnosisIndexScope(INDEX_SCOPE_ACTIVE, diagnoses);
+    copied     = (names == NULL || fclose(names) == 0) && copied;
+    copied     = (diagnoses == NULL || fclose(diagnoses) == 0) && copied;
+    return copied;
+}
 
-        if(fwrite(&dischargedPatient, sizeof(DischargedPatient), 1, file) != 1)
-        {
-            perror("Error writing to discharged_patients.dat");
-            fclose(file);
-            return;
-        }
-        fclose(file);
+/*
+ * Background checkpoint thread: writes a detached snapshot from the pinned
+ * patients and copied indexes, puts it in place and releases them. A
+ * snapshot that fails is discarded when the next change is logged.
+ */
+static void *writeBackgroundCheckpoint(void *argument)
+{
+    BackgroundCheckpoint *checkpoint = argument;
+    CheckpointWriter      writer;
+
+    if(beginCheckpoint(&writer, &checkpoint->state))
+    {
+        FILE *file = beginCheckpointSection(&writer, CHECKPOINT_SECTION_PATIENTS);
+        visitSnapshotPatients(checkpoint->patients, writeCheckpointPatient, file);
+        endCheckpointSection(&writer, !ferror(file));
 
-        logRoomUsage(patientToDischarge->roomNumber); // Log the room usage
+        file = beginCheckpointSection(&writer, CHECKPOINT_SECTION_NAME_INDEX);
+        endCheckpointSection(&writer, fwrite(checkpoint->nameIndex, 1, checkpoint->nameIndexLength, file) ==
+                                          checkpoint->nameIndexLength);
 
-        // Remove from the active patient list
-        removePatientFromSystem(patientToDischarge); // Pass the pointer
-        printf("Patient has been discharged!\n");
+        file = beginCheckpointSection(&writer, CHECKPOINT_SECTION_DIAGNOSIS_INDEX);
+        endCheckpointSection(&writer, fwrite(checkpoint->diagnosisIndex, 1, checkpoint->diagnosisIndexLength, file) ==
+                                          checkpoint->diagnosisIndexLength);
     }
     else
     {
-        printf("Patient discharge cancelled.\n");
+        perror("Error creating the patient checkpoint");
     }
-}
+    finishCheckpoint(&writer);
 
-/*
- * Creates a backup of current patient records to patients.dat file.
- */
-void backupPatientSystem()
-{
-    updatePatientsFile();
+    releasePatientSnapshot(checkpoint->patients);
+    free(checkpoint->nameIndex);
+    free(checkpoint->diagnosisIndex);
+    atomic_store(&checkpointFinished, 1);
+    return NULL;
 }
 
 /*
- * Restores patient records from patients.dat file.
+ * Snapshot visitor: writes one patient to the snapshot's patients section.
  */
-void restoreDataFromFile()
+static int writeCheckpointPatient(const Patient *patient, void *context)
 {
-    initializePatientSystem();
+    return fwrite(patient, sizeof(Patient), 1, context) == 1;
 }
 
 /*
- * Frees allocated memory for patient data.
+ * Waits for the background snapshot, if one was started. Must be called
+ * with patientStoreLock held exclusively.
  */
-void clearMemory()
+static void waitForStoreCheckpoint(void)
 {
-    while(patientHead != NULL)
+    if(checkpointRunning)
     {
-        PatientNode *temp = patientHead;
-        patientHead       = patientHead->nextNode;
-        free(temp);
+        pthread_join(checkpointThread, NULL);
+        checkpointRunning = 0;
     }
-    patientHead      = NULL;
-    totalPatients    = IS_EMPTY;
-    patientIDCounter = DEFAULT_ID;
 }
 
 /*
- * Prints a formatted patient report to both console and file.
- *
- * Parameters:
- *   file: Output file stream (must be open)
- *   header: Report title text
- *   result: Total patient count for the report
- *   timeframe: Time period filter (1=Daily, 2=Weekly, 3=Monthly)
- *
- * Formats and displays the report header, patient count, and detailed
- * information for each matching patient. Output is mirrored to both
- * console and the specified file.
+ * Logs a change to the checkpoint's delta log, and keeps the expected
+ * stamp of patients.dat up to date with it. Once the log is long enough a
+ * new snapshot is started in the background. Discharges are logged before
+ * the list changes, so only admissions and stamps, which end a change, may
+ * start it. Stamps are synced: a lost stamp could otherwise let an older
+ * patients.dat pass for the logged one. Must be called with
+ * patientStoreLock held exclusively.
  */
-void printFormattedReport(FILE *file, const char *header, int result, int timeframe)
+static void logStoreChange(int type, const Patient *patient)
 {
-    // Get current time and format it as YYYY-MM-DD
-    time_t     now         = time(NULL);
-    struct tm *currentTime = localtime(&now);
-    char       currentTimeStr[20];
-    strftime(currentTimeStr, sizeof(currentTimeStr), "%Y-%m-%d", currentTime);
-
-    // Print report header to console
-    printf("%s - %s\n", header, currentTimeStr);
-    printf("=======================================\n");
-    printf("Total patients admitted: %d\n", result);
-    printf("---------------------------------------\n");
-
-    // Print same header to file
-    fprintf(file, "%s - %s\n", header, currentTimeStr);
-    fprintf(file, "=======================================\n");
-    fprintf(file, "Total patients admitted: %d\n", result);
-    fprintf(file, "---------------------------------------\n");
+    CheckpointDelta delta;
 
-    if(result == 0)
+    memset(&delta, 0, sizeof(delta));
+    delta.type = type;
+    if(patient != NULL)
     {
-        // Handle case when no patients match the timeframe
-        printf("| No patients admitted in this timeframe |\n");
-        printf("---------------------------------------\n");
-
-        fprintf(file, "| No patients admitted in this timeframe |\n");
-        fprintf(file, "---------------------------------------\n");
+        delta.patient = *patient;
     }
-    else
+    if(type == DELTA_FILE_STAMP)
     {
-        PatientNode *patient = patientHead;
-        struct tm   *admissionTime;
-        char         admissionDateStr[20];
-
-        while(patient != NULL)
+        if(!trackPatientsFile())
         {
-            // Get admission timestamp and convert to struct tm
-            time_t admissionTimestamp = patient->data.admissionDate;
-            admissionTime             = localtime(&admissionTimestamp);
-
-            // Calculate time difference in hours between now and admission
-            double secondsDiff = difftime(now, admissionTimestamp);
-            int    hoursDiff   = secondsDiff / 3600;
-
-            // Determine if patient falls within requested timeframe
-            int past24Hours = (hoursDiff <= 24);  // Within last 24 hours
-            int sameWeek    = (admissionTime->tm_year == currentTime->tm_year &&
-                            (currentTime->tm_yday - admissionTime->tm_yday) < 7);  // Same week (within 7 days)
-            int sameMonth =
-                    (admissionTime->tm_year == currentTime->tm_year && 
-                     admissionTime->tm_mon == currentTime->tm_mon);  // Same month
-
-            // Filter patients based on timeframe parameter (1=daily, 2=weekly, 3=monthly)
-            if((timeframe == 1 && past24Hours) || (timeframe == 2 && sameWeek) || (timeframe == 3 && sameMonth))
-            {
-                // Format admission date as YYYY-MM-DD
-                strftime(admissionDateStr, sizeof(admissionDateStr), "%Y-%m-%d", admissionTime);
-
-                // Print patient details to console with formatted columns
-                printf("| ID: %-5d Name: %-15s | Age: %-3d Room: %-5d Diagnosis: %-20s | Admitted: %-10s |\n",
-                       patient->data.patientId,
-                       patient->data.name,
-                       patient->data.ageInYears,
-                       patient->data.roomNumber,
-                       patient->data.diagnosis,
-                       admissionDateStr);
-                printf("---------------------------------------\n");
-
-                // Print same details to file with identical formatting
-                fprintf(file,
-                        "| ID: %-5d Name: %-15s | Age: %-3d Room: %-5d Diagnosis: %-20s | Admitted: %-10s |\n",
-                        patient->data.patientId,
-                        patient->data.name,
-                        patient->data.ageInYears,
-                        patient->data.roomNumber,
-                        patient->data.diagnosis,
-                        admissionDateStr);
-                fprintf(file, "---------------------------------------\n");
-            }
-
-            patient = patient->nextNode;  // Move to next patient in list
+            discardCheckpoint();
+            return;
         }
+        delta.stamp = loggedFile;
+    }
+    else if(type == DELTA_ADMIT)
+    {
+        growPatientsFileStamp(&loggedFile, &loggedFileHeader, patient);
+    }
+
+    int logged = appendCheckpointDelta(&delta, type == DELTA_FILE_STAMP);
+    if(type != DELTA_DISCHARGE && logged >= CHECKPOINT_DELTA_LIMIT)
+    {
+        startStoreCheckpoint();
     }
 }
 
 /*
- * Generates and displays a report of admitted patients
- * based on the selected timeframe.
+ * Takes a new snapshot of the store, unless the current one has nothing
+ * to replay, so the next start restores without replaying a delta log.
  */
-void displayPatientReport(int choice)
+void checkpointPatientSystem(void)
 {
-    int result = countPatientsByTimeframe(choice);
-
-    FILE *file = fopen("patient_reports.txt", "a");
-    if(file == NULL)
+    pthread_rwlock_wrlock(&patientStoreLock);
+    waitForStoreCheckpoint();
+    if(totalPatients > 0 && !isCheckpointCurrent())
     {
-        printf("Error opening file for writing!\n");
-        return;
+        writeStoreCheckpoint();
     }
-
-    fprintf(file, "\n");
-
-    printFormattedReport(file, "   Patient Admission Report - Daily", result, choice);
-
-    fclose(file);
-    printf("\nReport successfully written to patient_reports.txt\n");
+    pthread_rwlock_unlock(&patientStoreLock);
 }
 
 /*
- * Prints a formatted report of discharged patients within
- * the selected timeframe to both console and file.
+ * Loads the report totals and activity counters, rebuilding both from the
+ * active patients and the discharge archive when either file is missing
+ * or out of step with the loaded patients.
  */
-void printDischargedFormattedReport(FILE *file, const char *header, int result, int timeframe)
+static void syncReportAggregates(void)
 {
-    // Get current time for report header
-    time_t     now         = time(NULL);
-    struct tm *currentTime = localtime(&now);
-    char       currentTimeStr[20];
-    strftime(currentTimeStr, sizeof(currentTimeStr), "%Y-%m-%d", currentTime);
-
-    // Print report header to console
-    printf("%s - %s\n", header, currentTimeStr);
-    printf("=======================================\n");
-    printf("Total patients discharged: %d\n", result);
-    printf("---------------------------------------\n");
-
-    // Print report header to file
-    fprintf(file, "%s - %s\n", header, currentTimeStr);
-    fprintf(file, "=======================================\n");
-    fprintf(file, "Total patients discharged: %d\n", result);
-    fprintf(file, "---------------------------------------\n");
-
-    if(result == 0)
-    {
-        // Handle case when no patients were discharged in the timeframe
-        printf("| No patients discharged in this timeframe |\n");
-        printf("---------------------------------------\n");
+    int totalsLoaded   = loadReportAggregates() && getActivePatientTotal() == totalPatients;
+    int countersLoaded = loadActivityCounters();
 
-        fprintf(file, "| No patients discharged in this timeframe |\n");
-        fprintf(file, "---------------------------------------\n");
-    }
-    else
+    if(totalsLoaded && countersLoaded)
     {
-        // Open discharged patients data file for reading
-        FILE *fileRead = fopen("discharged_patients.dat", "rb");
-        if(fileRead == NULL)
+        ActivityCount total = countActivity(ACTIVITY_BY_MONTH, INT_MIN, INT_MAX);
+        if(total.admissions - total.discharges == totalPatients)
         {
-            printf("Error opening file to read discharged patients.\n");
             return;
         }
+    }
 
-        DischargedPatient dischargedPatient;
-        // Read each discharged patient record
-        while(fread(&dischargedPatient, sizeof(DischargedPatient), 1, fileRead) == 1)
-        {
-            // Format discharge date for display
-            time_t     dischargeTimestamp = dischargedPatient.dischargeDate;
-            struct tm *dischargeTime      = localtime(&dischargeTimestamp);
-            char       dischargeDateStr[20];
-            strftime(dischargeDateStr, sizeof(dischargeDateStr), "%Y-%m-%d", dischargeTime);
+    puts("Rebuilding report totals from patient records.");
+    resetReportAggregates();
+    resetActivityCounters();
+
+    for(PatientNode *current = patientHead; current != NULL; current = current->nextNode)
+    {
+        recordAdmissionTotals(&current->data);
+        recordAdmissionActivity(&current->data);
+    }
+    scanDischargeArchive(ARCHIVE_BEGINNING_OF_TIME, ARCHIVE_END_OF_TIME, rebuildDischargeTotals, NULL);
+
+    saveReportAggregates();
+    saveActivityCounters();
+}
+
+/*
+ * Counts one archived patient's admission and discharge.
+ */
+static int rebuildDischargeTotals(const DischargedPatient *dischargedPatient, void *context)
+{
+    (void) context;
 
-            // Calculate time difference for filtering
-            double secondsDiff = difftime(now, dischargeTimestamp);
-            int    hoursDiff   = secondsDiff / 3600;
+    recordAdmissionTotals(&dischargedPatient->patient);
+    recordDischargeTotals(dischargedPatient, 1);
+    recordAdmissionActivity(&dischargedPatient->patient);
+    recordDischargeActivity(dischargedPatient, 1);
+    return 1;
+}
 
-            // Determine if patient falls within selected timeframe
-            int past24Hours = (hoursDiff <= 24);  // Within last 24 hours
-            int sameWeek    = (dischargeTime->tm_year == currentTime->tm_year &&
-                            (currentTime->tm_yday - dischargeTime->tm_yday) < 7);  // Within last 7 days
-            int sameMonth =
-                    (dischargeTime->tm_year == currentTime->tm_year && 
-                     dischargeTime->tm_mon == currentTime->tm_mon);  // Within current month
+/*
+ * Clears the contents of a binary file by durably replacing it with an
+ * empty one. This effectively erases all data in the file.
+ *
+ * fileName: The name of the file to clear
+ */
+static void clearBinaryFile(const char* fileName)
+{
+    char tempName[FILENAME_MAX];
+
+    snprintf(tempName, sizeof(tempName), "%s.tmp", fileName);
+    FILE *clearFile = fopen(tempName, "wb");
+    if (clearFile == NULL || fclose(clearFile) != 0 || !replaceFile(tempName, fileName))
+    {
+        printf("Error: Unable to clear %s.\n", fileName);
+    }
+}
+
+/*
+ * Initializes the patient management system with default settings.
+ * Called when patients.dat cannot be read or is empty.
+ */
+void initializePatientSystemDefault(void)
+{
+    pthread_rwlock_wrlock(&patientStoreLock);
+    resetPatientStore();
+    pthread_rwlock_unlock(&patientStoreLock);
+}
+
+/*
+ * Empties the store and resets the ID counter. Must be called with
+ * patientStoreLock held exclusively.
+ */
+static void resetPatientStore(void)
+{
+    patientHead      = NULL;
+    patientTail      = NULL;
+    totalPatients    = IS_EMPTY;
+    patientIDCounter = DEFAULT_ID;
+    memset(roomOccupants, 0, sizeof(roomOccupants));
+    clearPatientSnapshots();
+    puts("Patient system initialized with default settings using linked list.");
+    syncReportAggregates();
+}
+
+
+/*
+ * Adds a new patient record to the system after validating input fields.
+ */
+void addPatientRecord(void)
+{
+    char patientName[MAX_PATIENT_NAME_LENGTH];
+    int  patientAge;
+    char patientDiagnosis[MAX_DIAGNOSIS_LENGTH];
+    int  roomNumber;
+
+    getPatientName(patientName);
+    getPatientAge(&patientAge);
+    getPatientDiagnosis(patientDiagnosis);
+    getRoomNumber(&roomNumber);
+
+    Patient          newPatient;
+    ReadmissionMatch readmission;
+
+    int result = admitPatient(patientName, patientAge, patientDiagnosis, roomNumber, &newPatient, &readmission, NULL);
+    if(result == ADMIT_ROOM_TAKEN)
+    {
+        // The room was free when chosen, but has been taken since
+        printf("Room %d was taken in the meantime. Patient not added.\n", roomNumber);
+        return;
+    }
+    if(result != ADMIT_SUCCESS)
+    {
+        puts("Error: Unable to record patient. Patient not added.");
+        return;
+    }
+
+    printf("--- Patient Added ---\n");
+    printPatient(newPatient);
+
+    if(readmission.previousPatientId != INVALID_ID)
+    {
+        char dischargeDateStr[20];
+        strftime(dischargeDateStr, sizeof(dischargeDateStr), "%Y-%m-%d", localtime(&readmission.previousDischargeDate));
+
+        printf("%s: previously discharged %s (%d day(s) ago) as patient ID %d, diagnosis: %s\n",
+               readmission.withinWindow ? "30-day readmission" : "Returning patient",
+               dischargeDateStr,
+               readmission.daysSinceDischarge,
+               readmission.previousPatientId,
+               getDiagnosisText(readmission.previousDiagnosisId));
+    }
+}
+
+
+/*
+ * Validates and admits a patient. The diagnosis is interned before taking
+ * the store's lock, and the room is checked again under it. The record is
+ * queued for patients.dat under the lock, so the file keeps list order, but
+ * waiting for it to be durable happens outside it, so that concurrent
+ * admissions share one sync.
+ */
+int admitPatient(const char patientName[],
+                 int patientAge,
+                 const char patientDiagnosis[],
+                 int roomNumber,
+                 Patient *admitted,
+                 ReadmissionMatch *readmission,
+                 PendingAdmission *commit)
+{
+    char             name[MAX_PATIENT_NAME_LENGTH];
+    char             diagnosis[MAX_DIAGNOSIS_LENGTH];
+    PendingAdmission ownCommit;
+
+    memset(readmission, 0, sizeof(*readmission));
+
+    if(strlen(patientName) >= sizeof(name) || strlen(patientDiagnosis) >= sizeof(diagnosis))
+    {
+        return ADMIT_INVALID;
+    }
+    strcpy(name, patientName);
+    strcpy(diagnosis, patientDiagnosis);
+
+    if(!validatePatientName(name) || !validatePatientAge(patientAge) ||
+       !validatePatientDiagnosis(diagnosis) || !validateRoomNumber(roomNumber))
+    {
+        return ADMIT_INVALID;
+    }
+
+    int diagnosisId = internDiagnosis(diagnosis);
+    if(diagnosisId == INVALID_DIAGNOSIS_ID)
+    {
+        return ADMIT_FAILURE;
+    }
+
+    pthread_rwlock_wrlock(&patientStoreLock);
+
+    if(getRoomOccupant(roomNumber) != ROOM_UNOCCUPIED)
+    {
+        pthread_rwlock_unlock(&patientStoreLock);
+        return ADMIT_ROOM_TAKEN;
+    }
+
+    // Create and store new patient record
+    Patient newPatient = createPatient(name, patientAge, diagnosisId, roomNumber, allocatePatientId());
+    if(insertPatientAtEndOfList(newPatient) == NULL)
+    {
+        pthread_rwlock_unlock(&patientStoreLock);
+        return ADMIT_FAILURE;
+    }
+    totalPatients++;
+    addToDiagnosisIndex(INDEX_SCOPE_ACTIVE, newPatient.patientId, newPatient.diagnosisId);
+    addToNameIndex(newPatient.patientId, newPatient.name);
+    recordAdmissionTotals(&newPatient);
+    recordAdmissionActivity(&newPatient);
+    roomOccupants[newPatient.roomNumber] = newPatient.patientId;
+    publishPatientChange(publishAdmission(&newPatient));
+
+    if(commit == NULL)
+    {
+        memset(&ownCommit, 0, sizeof(ownCommit));
+    }
+    writePatientToFile(&newPatient, commit != NULL ? commit : &ownCommit);
+    logStoreChange(DELTA_ADMIT, &newPatient);
+
+    if(!matchReadmission(&newPatient, readmission))
+    {
+        memset(readmission, 0, sizeof(*readmission));
+    }
+
+    pthread_rwlock_unlock(&patientStoreLock);
+
+    if(commit == NULL)
+    {
+        awaitPatientWrite(&ownCommit);
+    }
+
+    *admitted = newPatient;
+    return ADMIT_SUCCESS;
+}
+
+/*
+ * Copies an admitted patient's record from the current snapshot.
+ */
+int findActivePatient(int patientId, Patient *patient)
+{
+    return copyActivePatient(patientId, patient);
+}
+
+/*
+ * Displays all patient records stored in the system, either a page at a
+ * time on screen or written in full to VIEW_EXPORT_FILE.
+ */
+void viewPatientRecords(void)
+{
+    int destination;
+
+    if(getActivePatientCount() == 0)
+    {
+        puts("No patients admitted!");
+        return;
+    }
+
+    int sortKey = getViewSortKey();
+
+    printf("Show 1: On screen, 2: Save to %s\n", VIEW_EXPORT_FILE);
+    if(scanf("%d", &destination) != SUCCESSFUL_READ || (destination != 1 && destination != 2))
+    {
+        puts("Invalid choice.");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+
+    int              count;
+    PatientSnapshot *snapshot = takePatientSnapshot();
+    const Patient  **view     = buildPatientView(snapshot, sortKey, &count);
+    if(view == NULL)
+    {
+        releasePatientSnapshot(snapshot);
+        puts("Error: Unable to allocate patient view.");
+        return;
+    }
+
+    if(count == 0)
+    {
+        puts("No patients admitted!");
+    }
+    else if(destination == 1)
+    {
+        pagePatientView(view, count);
+    }
+    else
+    {
+        exportPatientView(view, count);
+    }
+
+    free(view);
+    releasePatientSnapshot(snapshot);
+}
+
+/*
+ * Searches for a patient by ID and displays their details if found.
+ */
+void searchPatientById(void)
+{
+    int               id;
+    Patient           patient;
+    DischargedPatient dischargedPatient;
+
+    if(getActivePatientCount() == 0 && getDischargedPatientTotal() == 0)
+    {
+        puts("No patients admitted!");
+        return;
+    }
+
+    printf("Enter A Patient Id: ");
+    scanf("%d", &id);
+    clearInputBuffer();
+
+    if(copyActivePatient(id, &patient))
+    {
+        printPatient(patient);
+        return;
+    }
+
+    // Not admitted, so check the discharge history
+    if(findDischargedPatient(id, &dischargedPatient))
+    {
+        char dischargeDateStr[20];
+        strftime(dischargeDateStr, sizeof(dischargeDateStr), "%Y-%m-%d", localtime(&dischargedPatient.dischargeDate));
+
+        printPatient(dischargedPatient.patient);
+        printf("Discharged: %s\n", dischargeDateStr);
+        return;
+    }
+
+    puts("Patient doesn't exist!");
+}
+
+/*
+ * Prompts for the order of the patient view.
+ * Anything other than a listed key keeps the default ID order.
+ */
+static int getViewSortKey(void)
+{
+    int sortKey = SORT_BY_ID;
+
+    printf("Sort by 1: ID, 2: Name, 3: Room, 4: Admission time\n");
+    if(scanf("%d", &sortKey) != SUCCESSFUL_READ || sortKey < SORT_BY_ID || sortKey > SORT_BY_ADMISSION)
+    {
+        sortKey = SORT_BY_ID;
+    }
+    clearInputBuffer();
+
+    return sortKey;
+}
+
+/*
+ * Returns pointers to every patient in a snapshot, ordered by the sort
+ * key. The pointers are only valid while the caller holds the snapshot;
+ * the caller frees the returned array.
+ */
+static const Patient **buildPatientView(const PatientSnapshot *snapshot, int sortKey, int *count)
+{
+    *count = getSnapshotPatientCount(snapshot);
+
+    const Patient **view = malloc(sizeof(Patient *) * (size_t) (*count > 0 ? *count : 1));
+    if(view == NULL)
+    {
+        return NULL;
+    }
+    getSnapshotPatients(snapshot, view);
+
+    int (*compare)(const void *, const void *) = compareViewById;
+    if(sortKey == SORT_BY_NAME)
+    {
+        compare = compareViewByName;
+    }
+    else if(sortKey == SORT_BY_ROOM)
+    {
+        compare = compareViewByRoom;
+    }
+    else if(sortKey == SORT_BY_ADMISSION)
+    {
+        compare = compareViewByAdmission;
+    }
+    qsort(view, (size_t) *count, sizeof(Patient *), compare);
+
+    return view;
+}
+
+/*
+ * Formats consecutive patients of a view back to back into one buffer,
+ * which must hold count * FORMATTED_PATIENT_SIZE bytes.
+ */
+static size_t renderPatientPage(const Patient *view[], int count, char buffer[])
+{
+    size_t length = 0;
+
+    for(int i = 0; i < count; i++)
+    {
+        length += (size_t) formatPatient(view[i], buffer + length);
+    }
+
+    return length;
+}
+
+/*
+ * Writes a whole buffer to a stream's descriptor, bypassing stdio so each
+ * page reaches the terminal or file in a single write where possible.
+ */
+static int writeBlock(FILE *stream, const char buffer[], size_t length)
+{
+    int descriptor = fileno(stream);
+
+    fflush(stream);
+    while(length > 0)
+    {
+        ssize_t written = write(descriptor, buffer, length);
+        if(written < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return 0;
+        }
+        buffer += written;
+        length -= (size_t) written;
+    }
+
+    return 1;
+}
+
+/*
+ * Shows a view a page at a time, moving the cursor on user request.
+ */
+static void pagePatientView(const Patient *view[], int patientCount)
+{
+    char *buffer = malloc((size_t) VIEW_PAGE_SIZE * FORMATTED_PATIENT_SIZE + (size_t) PAGE_FOOTER_SIZE);
+    if(buffer == NULL)
+    {
+        puts("Error: Unable to allocate page buffer.");
+        return;
+    }
+
+    int cursor = 0;
+    for(;;)
+    {
+        int    count  = patientCount - cursor < VIEW_PAGE_SIZE ? patientCount - cursor : VIEW_PAGE_SIZE;
+        size_t length = renderPatientPage(view + cursor, count, buffer);
+
+        length += (size_t) snprintf(buffer + length, (size_t) PAGE_FOOTER_SIZE,
+                                    "Showing patients %d-%d of %d\n", cursor + 1, cursor + count, patientCount);
+        writeBlock(stdout, buffer, length);
+
+        if(patientCount <= VIEW_PAGE_SIZE)
+        {
+            break;
+        }
+
+        printf("Enter for the next page, p for the previous page, q to stop: ");
+        int response = getchar();
+        if(response == EOF)
+        {
+            break;
+        }
+        if(response != '\n')
+        {
+            clearInputBuffer();
+        }
+
+        if(response == 'q' || response == 'Q')
+        {
+            break;
+        }
+        else if(response == 'p' || response == 'P')
+        {
+            cursor = cursor >= VIEW_PAGE_SIZE ? cursor - VIEW_PAGE_SIZE : 0;
+        }
+        else if(cursor + VIEW_PAGE_SIZE < patientCount)
+        {
+            cursor += VIEW_PAGE_SIZE;
+        }
+        else
+        {
+            break;
+        }
+    }
+
+    free(buffer);
+}
+
+/*
+ * Writes the whole view to VIEW_EXPORT_FILE, one write per
+ * EXPORT_PAGE_SIZE patients.
+ */
+static void exportPatientView(const Patient *view[], int patientCount)
+{
+    FILE *file   = fopen(VIEW_EXPORT_FILE, "w");
+    char *buffer = malloc((size_t) EXPORT_PAGE_SIZE * FORMATTED_PATIENT_SIZE);
+    int   ok     = file != NULL && buffer != NULL;
+
+    for(int cursor = 0; ok && cursor < patientCount; cursor += EXPORT_PAGE_SIZE)
+    {
+        int count = patientCount - cursor < EXPORT_PAGE_SIZE ? patientCount - cursor : EXPORT_PAGE_SIZE;
+        ok        = writeBlock(file, buffer, renderPatientPage(view + cursor, count, buffer));
+    }
+
+    if(file != NULL && fclose(file) != 0)
+    {
+        ok = 0;
+    }
+    free(buffer);
+
+    if(ok)
+    {
+        printf("%d patient(s) written to %s.\n", patientCount, VIEW_EXPORT_FILE);
+    }
+    else
+    {
+        perror("Error writing " VIEW_EXPORT_FILE);
+    }
+}
+
+/*
+ * One name search result, pointing into the search's snapshot so it can
+ * be shown after the lock is released.
+ */
+typedef struct
+{
+    const Patient *patient;
+    int            distance;
+} NameMatch;
+
+/*
+ * Name search results collected under the shared lock.
+ */
+typedef struct
+{
+    const PatientSnapshot *snapshot;
+    NameMatch             *matches;
+    int                    count;
+    int                    capacity;
+    int                    failed;
+} NameSearchResults;
+
+/*
+ * Adds one name search match to the results.
+ */
+static int collectNameMatch(int patientId, int distance, void *context)
+{
+    NameSearchResults *results = context;
+    const Patient     *patient = findSnapshotPatient(results->snapshot, patientId);
+
+    if(patient == NULL)
+    {
+        return 1;
+    }
+
+    if(results->count == results->capacity)
+    {
+        int        newCapacity = results->capacity == 0 ? RESULTS_PAGE_SIZE : results->capacity * 2;
+        NameMatch *grown       = realloc(results->matches, sizeof(NameMatch) * (size_t) newCapacity);
+        if(grown == NULL)
+        {
+            results->failed = 1;
+            return 0;
+        }
+        results->matches  = grown;
+        results->capacity = newCapacity;
+    }
+
+    results->matches[results->count].patient  = patient;
+    results->matches[results->count].distance = distance;
+    results->count++;
+
+    return 1;
+}
+
+/*
+ * Prints the name search results, pausing after every page.
+ */
+static void printNameMatches(const NameSearchResults *results)
+{
+    for(int i = 0; i < results->count; i++)
+    {
+        if(i > 0 && i % RESULTS_PAGE_SIZE == 0)
+        {
+            printf("Press Enter for more results, or q to stop: ");
+            int response = getchar();
+            if(response == EOF)
+            {
+                return;
+            }
+            if(response != '\n')
+            {
+                clearInputBuffer();
+            }
+            if(response == 'q' || response == 'Q')
+            {
+                return;
+            }
+        }
+
+        printPatient(*results->matches[i].patient);
+        if(results->matches[i].distance > 0)
+        {
+            printf("(%d spelling difference(s) from the search)\n", results->matches[i].distance);
+        }
+    }
+}
+
+/*
+ * Searches current patients by name prefix or by similar spelling and
+ * shows the results a page at a time.
+ */
+void searchPatientsByName(void)
+{
+    char name[MAX_PATIENT_NAME_LENGTH];
+    int  choice;
+
+    printf("Search 1: Names starting with, 2: Similar names (misspellings)\n");
+    if(scanf("%d", &choice) != SUCCESSFUL_READ || (choice != 1 && choice != 2))
+    {
+        puts("Invalid choice.");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+
+    printf("Enter Patient Name:\n");
+    if(fgets(name, sizeof(name), stdin) == NULL)
+    {
+        return;
+    }
+    name[strcspn(name, "\n")] = '\0';
+
+    NameSearchResults results = { NULL, NULL, 0, 0, 0 };
+    int               searched;
+
+    // The snapshot taken with the index matches it, and outlives the lock while paging
+    pthread_rwlock_rdlock(&patientStoreLock);
+    PatientSnapshot *snapshot = takePatientSnapshot();
+    results.snapshot          = snapshot;
+    if(choice == 1)
+    {
+        visitNamePrefix(name, collectNameMatch, &results);
+        searched = 1;
+    }
+    else
+    {
+        searched = visitSimilarNames(name, NAME_SEARCH_MAX_EDITS, collectNameMatch, &results) >= 0;
+    }
+    pthread_rwlock_unlock(&patientStoreLock);
+
+    if(!searched || results.failed)
+    {
+        puts("Error: Unable to complete the name search.");
+    }
+    else if(results.count == 0)
+    {
+        puts("No matching patients found.");
+    }
+    else
+    {
+        printNameMatches(&results);
+    }
+
+    free(results.matches);
+    releasePatientSnapshot(snapshot);
+}
+
+/*
+ * Removes a patient from the system if they exist and discharge is confirmed.
+ */
+void dischargePatient(void)
+{
+    Patient patientToDischarge;
+
+    if(getActivePatientCount() == 0)
+    {
+        puts("No patients to discharge!");
+        return;
+    }
+
+    int patientId = getPatientToDischarge();
+
+    if(!copyActivePatient(patientId, &patientToDischarge))
+    {
+        puts("Patient not found!");
+        return;
+    }
+
+    if(confirmDischarge(&patientToDischarge))
+    {
+        // Looked up again under the exclusive lock, in case it changed while confirming
+        if(dischargePatientsById(&patientId, 1) == 1)
+        {
+            printf("Patient has been discharged!\n");
+        }
+    }
+    else
+    {
+        printf("Patient discharge cancelled.\n");
+    }
+}
+
+/*
+ * Discharges every listed patient at the same time. IDs that are not
+ * admitted, and repeated IDs, are skipped.
+ */
+int dischargePatientsById(const int patientIds[], int count)
+{
+    if(count <= 0)
+    {
+        return 0;
+    }
+
+    int               *requested = malloc(sizeof(int) * (size_t) count);
+    char              *found     = calloc((size_t) count, 1);
+    DischargedPatient *records   = malloc(sizeof(DischargedPatient) * (size_t) count);
+    if(requested == NULL || found == NULL || records == NULL)
+    {
+        puts("Error: Unable to allocate batch discharge.");
+        free(requested);
+        free(found);
+        free(records);
+        return 0;
+    }
+
+    memcpy(requested, patientIds, sizeof(int) * (size_t) count);
+    qsort(requested, (size_t) count, sizeof(int), comparePatientIds);
+
+    // Drop repeated IDs so each patient is discharged once
+    int unique = 0;
+    for(int i = 0; i < count; i++)
+    {
+        if(unique == 0 || requested[i] != requested[unique - 1])
+        {
+            requested[unique++] = requested[i];
+        }
+    }
+    count = unique;
+
+    pthread_rwlock_wrlock(&patientStoreLock);
+
+    // One pass over the list picks up every requested patient
+    time_t now         = time(NULL);
+    int    recordCount = 0;
+
+    for(PatientNode *current = patientHead; current != NULL; current = current->nextNode)
+    {
+        int *match = bsearch(&current->data.patientId, requested, (size_t) count, sizeof(int), comparePatientIds);
+        if(match != NULL && !found[match - requested])
+        {
+            found[match - requested]             = 1;
+            records[recordCount].patient         = current->data;
+            records[recordCount].dischargeDate   = now;
+            recordCount++;
+        }
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        if(!found[i])
+        {
+            printf("Patient ID %d is not admitted, skipped.\n", requested[i]);
+        }
+    }
+
+    int discharged = recordCount > 0 && dischargeRecords(records, recordCount) ? recordCount : 0;
+
+    pthread_rwlock_unlock(&patientStoreLock);
+
+    free(requested);
+    free(found);
+    free(records);
+    return discharged;
+}
+
+/*
+ * Reads a list of patient IDs ended by 0 and discharges them together.
+ */
+void dischargePatientBatch(void)
+{
+    int  *patientIds = NULL;
+    int   count      = 0;
+    int   capacity   = 0;
+    int   patientId;
+    char  confirm;
+
+    if(getActivePatientCount() == 0)
+    {
+        puts("No patients to discharge!");
+        return;
+    }
+
+    printf("Enter the IDs of the patients to discharge, separated by spaces or new lines, then 0:\n");
+    while(scanf("%d", &patientId) == SUCCESSFUL_READ && patientId != 0)
+    {
+        if(count == capacity)
+        {
+            int  newCapacity = capacity == 0 ? RESULTS_PAGE_SIZE : capacity * 2;
+            int *grown       = realloc(patientIds, sizeof(int) * (size_t) newCapacity);
+            if(grown == NULL)
+            {
+                puts("Error: Unable to allocate batch discharge.");
+                free(patientIds);
+                clearInputBuffer();
+                return;
+            }
+            patientIds = grown;
+            capacity   = newCapacity;
+        }
+        patientIds[count++] = patientId;
+    }
+    clearInputBuffer();
+
+    if(count == 0)
+    {
+        puts("No patient IDs entered.");
+        return;
+    }
+
+    printf("Are you sure you want to discharge %d patient(s)? (y/n)\n", count);
+    scanf(" %c", &confirm);
+    clearInputBuffer();
+
+    if(confirm == 'y')
+    {
+        printf("%d patient(s) discharged.\n", dischargePatientsById(patientIds, count));
+    }
+    else
+    {
+        printf("Batch discharge cancelled.\n");
+    }
+
+    free(patientIds);
+}
+
+/*
+ * Archives a group of discharged patients with one archive append, then
+ * updates the indexes, room log and totals and removes the patients with
+ * one rewrite of patients.dat. Must be called with patientStoreLock held
+ * exclusively.
+ */
+static int dischargeRecords(DischargedPatient records[], int count)
+{
+    ArchiveLocation *locations = malloc(sizeof(ArchiveLocation) * (size_t) count);
+    if(locations == NULL)
+    {
+        puts("Error: Unable to allocate discharge records.");
+        return 0;
+    }
+
+    // Append to discharged patients archive and record where each went
+    if(!appendDischargedPatients(records, count, locations))
+    {
+        free(locations);
+        return 0;
+    }
+    addToDischargeIndex(records, locations, count);
+    free(locations);
+
+    logRoomUsage(records, count); // Log the room usage
+    recordDischargeTotals(records, count);
+    recordDischargeActivity(records, count);
+
+    for(int i = 0; i < count; i++)
+    {
+        const Patient *patient = &records[i].patient;
+
+        addDischargeToReadmissionIndex(&records[i]);
+        logStoreChange(DELTA_DISCHARGE, patient);
+
+        // Move the patient to the discharged side of the diagnosis index
+        removeFromDiagnosisIndex(INDEX_SCOPE_ACTIVE, patient->patientId, patient->diagnosisId);
+        addToDiagnosisIndex(INDEX_SCOPE_DISCHARGED, patient->patientId, patient->diagnosisId);
+        removeFromNameIndex(patient->patientId, patient->name);
+    }
+
+    // Remove from the active patient list
+    removePatientsFromSystem(records, count);
+    return 1;
+}
+
+/*
+ * Moves an admitted patient to another room in place. The move is
+ * persisted as one record appended to the transfer log, so patients.dat
+ * is not rewritten and the patient keeps their ID.
+ */
+void transferPatient(void)
+{
+    int     patientId;
+    int     newRoom;
+    Patient current;
+
+    if(getActivePatientCount() == 0)
+    {
+        puts("No patients admitted!");
+        return;
+    }
+
+    printf("Enter ID of patient to transfer:\n");
+    if(scanf("%d", &patientId) != SUCCESSFUL_READ)
+    {
+        puts("Invalid input.");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+
+    if(!copyActivePatient(patientId, &current))
+    {
+        puts("Patient not found!");
+        return;
+    }
+
+    printf("Patient %s is in room %d.\n", current.name, current.roomNumber);
+    getRoomNumber(&newRoom);
+
+    pthread_rwlock_wrlock(&patientStoreLock);
+
+    // The patient or the room may have changed while the room was chosen
+    Patient *patient = getPatientFromList(patientId);
+    if(patient == NULL || getRoomOccupant(newRoom) != ROOM_UNOCCUPIED)
+    {
+        pthread_rwlock_unlock(&patientStoreLock);
+        puts(patient == NULL ? "Patient not found!" : "Room was taken in the meantime. Patient not moved.");
+        return;
+    }
+
+    TransferRecord transfer;
+    transfer.patientId    = patient->patientId;
+    transfer.fromRoom     = patient->roomNumber;
+    transfer.toRoom       = newRoom;
+    transfer.transferDate = time(NULL);
+
+    if(!appendTransferRecord(&transfer))
+    {
+        pthread_rwlock_unlock(&patientStoreLock);
+        puts("Error: Unable to record transfer. Patient not moved.");
+        return;
+    }
+
+    if(transfer.fromRoom >= 1 && transfer.fromRoom <= MAX_ROOMS && roomOccupants[transfer.fromRoom] == patient->patientId)
+    {
+        roomOccupants[transfer.fromRoom] = 0;
+    }
+    roomOccupants[newRoom] = patient->patientId;
+    patient->roomNumber    = newRoom;
+    recordTransferTotals(transfer.fromRoom, transfer.toRoom);
+    publishPatientChange(publishPatientUpdate(patient));
+
+    pthread_rwlock_unlock(&patientStoreLock);
+
+    printf("Patient %s transferred from room %d to room %d.\n", current.name, transfer.fromRoom, newRoom);
+}
+
+/*
+ * Creates a backup of current patient records to patients.dat file.
+ */
+void backupPatientSystem()
+{
+    // Exclusive, so two rewrites of patients.dat never overlap
+    pthread_rwlock_wrlock(&patientStoreLock);
+    updatePatientsFile();
+    pthread_rwlock_unlock(&patientStoreLock);
+}
+
+/*
+ * Restores patient records from the checkpoint, or from patients.dat
+ * file when there is no usable checkpoint.
+ */
+void restoreDataFromFile()
+{
+    pthread_rwlock_wrlock(&patientStoreLock);
+    if(!restoreCheckpoint(0))
+    {
+        loadPatientStore();
+    }
+    pthread_rwlock_unlock(&patientStoreLock);
+}
+
+/*
+ * Frees allocated memory for patient data.
+ */
+void clearMemory()
+{
+    pthread_rwlock_wrlock(&patientStoreLock);
+    clearPatientStore();
+    pthread_rwlock_unlock(&patientStoreLock);
+}
+
+/*
+ * Frees the patient list and clears the active indexes. Must be called
+ * with patientStoreLock held exclusively.
+ */
+static void clearPatientStore(void)
+{
+    while(patientHead != NULL)
+    {
+        PatientNode *temp = patientHead;
+        patientHead       = patientHead->nextNode;
+        freePatientNode(temp);
+    }
+    free(restoredNodes);
+    restoredNodes     = NULL;
+    restoredNodeCount = 0;
+
+    patientHead      = NULL;
+    patientTail      = NULL;
+    totalPatients    = IS_EMPTY;
+    patientIDCounter = DEFAULT_ID;
+    memset(roomOccupants, 0, sizeof(roomOccupants));
+    clearDiagnosisIndexScope(INDEX_SCOPE_ACTIVE);
+    clearNameIndex();
+    clearPatientSnapshots();
+}
+
+/*
+ * Falls back to rebuilding the snapshot from the whole list when
+ * publishing a single change ran out of memory. Must be called with
+ * patientStoreLock held exclusively, after the list has been changed.
+ */
+static void publishPatientChange(int published)
+{
+    snapshotBehind = !published && !publishPatientList(patientHead);
+    if(snapshotBehind)
+    {
+        puts("Error: Unable to update the patient snapshot. Reports may be out of date.");
+    }
+}
+
+/*
+ * Prints a formatted patient report to both console and file.
+ *
+ * Parameters:
+ *   file: Output file stream (must be open)
+ *   header: Report title text
+ *   result: Total patient count for the report
+ *   timeframe: Time period filter (1=Daily, 2=Weekly, 3=Monthly)
+ *
+ * Formats and displays the report header, patient count, and detailed
+ * information for each matching patient. Output is mirrored to both
+ * console and the specified file.
+ */
+void printFormattedReport(ReportWriter *writer, const char *header, int result, int timeframe)
+{
+    // Get current time and format it as YYYY-MM-DD
+    ReportTimeframe window;
+    initializeTimeframe(&window, timeframe);
+    char currentTimeStr[20];
+    strftime(currentTimeStr, sizeof(currentTimeStr), "%Y-%m-%d", &window.currentTime);
+
+    // Print report header
+    reportPrintf(writer,
+                 "%s - %s\n"
+                 "=======================================\n"
+                 "Total patients admitted: %d\n"
+                 "---------------------------------------\n",
+                 header, currentTimeStr, result);
+
+    if(result == 0)
+    {
+        // Handle case when no patients match the timeframe
+        reportPrintf(writer,
+                     "| No patients admitted in this timeframe |\n"
+                     "---------------------------------------\n");
+    }
+    else
+    {
+        int              viewCount  = 0;
+        PatientSnapshot *snapshot   = takePatientSnapshot();
+        const Patient  **view       = buildPatientView(snapshot, SORT_BY_ID, &viewCount);
+        const Patient  **matches    = NULL;
+        int              matchCount = 0;
+
+        // Filter in parallel over a snapshot of the patients, so admissions carry on meanwhile
+        if(view == NULL ||
+           !collectActivePatients(view, viewCount, isAdmittedWithinTimeframe, &window, &matches, &matchCount))
+        {
+            puts("Error: Unable to allocate admission report.");
+        }
+
+        for(int i = 0; i < matchCount; i++)
+        {
+            const Patient *patient = matches[i];
+
+            // Print patient details with formatted columns
+            reportPrintf(writer,
+                         "| ID: %-5d Name: %-15s | Age: %-3d Room: %-5d Diagnosis: %-20s | Admitted: %-10s |\n"
+                         "---------------------------------------\n",
+                         patient->patientId,
+                         patient->name,
+                         patient->ageInYears,
+                         patient->roomNumber,
+                         getDiagnosisText(patient->diagnosisId),
+                         getTimeframeDateText(&window, patient->admissionDate));
+        }
+
+        free(matches);
+        free(view);
+        releasePatientSnapshot(snapshot);
+    }
+}
+
+/*
+ * Generates and displays a report of admitted patients
+ * based on the selected timeframe.
+ */
+void displayPatientReport(int choice)
+{
+    int          result = countPatientsByTimeframe(choice);
+    ReportWriter writer;
+
+    FILE *file = fopen("patient_reports.txt", "a");
+    if(file == NULL)
+    {
+        printf("Error opening file for writing!\n");
+        return;
+    }
+
+    if(!openReportWriter(&writer))
+    {
+        puts("Error: Unable to allocate report buffer.");
+        fclose(file);
+        return;
+    }
+
+    fprintf(file, "\n");
+
+    // Format once, send to both the console and the report file
+    addConsoleSink(&writer);
+    addFileSink(&writer, file);
+    printFormattedReport(&writer, "   Patient Admission Report - Daily", result, choice);
+
+    int written = closeReportWriter(&writer);
+    if(fclose(file) != 0 || !written)
+    {
+        printf("\nError writing patient_reports.txt\n");
+        return;
+    }
+    printf("\nReport successfully written to patient_reports.txt\n");
+}
+
+/*
+ * Prints one archived patient as a report row.
+ */
+static void printDischargedRecord(ReportWriter *writer,
+                                  const DischargedPatient *dischargedPatient,
+                                  const ReportTimeframe *window)
+{
+    // Print patient details with formatted columns
+    reportPrintf(writer,
+                 "| ID: %-5d Name: %-15s | Age: %-3d Room: %-5d Diagnosis: %-20s | Discharged: %-10s |\n"
+                 "---------------------------------------\n",
+                 dischargedPatient->patient.patientId,
+                 dischargedPatient->patient.name,
+                 dischargedPatient->patient.ageInYears,
+                 dischargedPatient->patient.roomNumber,
+                 getDiagnosisText(dischargedPatient->patient.diagnosisId),
+                 getTimeframeDateText(window, dischargedPatient->dischargeDate));
+}
+
+/*
+ * Prints a formatted report of discharged patients within
+ * the selected timeframe to both console and file.
+ */
+void printDischargedFormattedReport(ReportWriter *writer, const char *header, int result, int timeframe)
+{
+    ReportTimeframe window;
+    initializeTimeframe(&window, timeframe);
+
+    // Get current time for report header
+    char currentTimeStr[20];
+    strftime(currentTimeStr, sizeof(currentTimeStr), "%Y-%m-%d", &window.currentTime);
+
+    // Print report header
+    reportPrintf(writer,
+                 "%s - %s\n"
+                 "=======================================\n"
+                 "Total patients discharged: %d\n"
+                 "---------------------------------------\n",
+                 header, currentTimeStr, result);
+
+    if(result == 0)
+    {
+        // Handle case when no patients were discharged in the timeframe
+        reportPrintf(writer,
+                     "| No patients discharged in this timeframe |\n"
+                     "---------------------------------------\n");
+    }
+    else
+    {
+        DischargeResults results;
+
+        if(!collectDischargedPatients(window.dayStarts[0],
+                                      ARCHIVE_END_OF_TIME,
+                                      isDischargedWithinTimeframe,
+                                      &window,
+                                      &results))
+        {
+            puts("Error: Unable to allocate discharge report.");
+        }
+
+        for(int i = 0; i < results.count; i++)
+        {
+            printDischargedRecord(writer, results.records[i], &window);
+        }
+        freeDischargeResults(&results);
+    }
+}
+
+/*
+ * Generates and displays a report of discharged
+ * patients based on the selected timeframe.
+ */
+void displayDischargedPatientReport(int choice)
+{
+    int          result = countDischargedPatientsByTimeframe(choice);
+    ReportWriter writer;
+
+    FILE *file = fopen("discharged_reports.txt", "a");
+    if(file == NULL)
+    {
+        printf("Error opening file for writing!\n");
+        return;
+    }
+
+    if(!openReportWriter(&writer))
+    {
+        puts("Error: Unable to allocate report buffer.");
+        fclose(file);
+        return;
+    }
+
+    fprintf(file, "\n");
+
+    // Format once, send to both the console and the report file
+    addConsoleSink(&writer);
+    addFileSink(&writer, file);
+    printDischargedFormattedReport(&writer, "   Discharged Patient Report - Weekly", result, choice);
+
+    int written = closeReportWriter(&writer);
+    if(fclose(file) != 0 || !written)
+    {
+        printf("\nError writing discharged_reports.txt\n");
+        return;
+    }
+    printf("\nDischarge Report successfully written to discharged_reports.txt\n");
+}
+
+/*
+ * Displays a usage report showing how many times each
+ * valid room (1-50) was used, from the running room totals.
+ */
+void displayRoomUsageReport(void)
+{
+    int totalDischarges = 0;
+    int usage[MAX_ROOMS + 1];
+
+    pthread_rwlock_rdlock(&patientStoreLock);
+    for(int i = 1; i <= MAX_ROOMS; i++)
+    {
+        usage[i] = getRoomDischargeTotal(i);
+    }
+    pthread_rwlock_unlock(&patientStoreLock);
+
+    printf("\n--- Room Usage Report ---\n");
+    printf("Room | Usage Count\n");
+    printf("-----|------------\n");
+
+    for(int i = 1; i <= MAX_ROOMS; i++)
+    {
+        if(usage[i] > 0)
+        {
+            printf("%-4d | %d\n", i, usage[i]);
+            totalDischarges += usage[i];
+        }
+    }
+
+    if(totalDischarges == 0)
+    {
+        printf("No room usage has been logged yet.\n");
+    }
+
+    printf("-------------------------\n");
+    printf("Total discharges logged: %d\n", totalDischarges);
+    printf("-------------------------\n");
+}
+
+/*
+ * Streams admitted patients within the timeframe as CSV or JSON rows,
+ * straight from a snapshot of the active patients.
+ */
+void exportAdmissionReport(ReportWriter *writer, int format, int timeframe)
+{
+    static const char *const columns[] = { "patient_id", "name", "age", "room", "diagnosis", "admitted" };
+
+    ExportScan       scan;
+    PatientSnapshot *snapshot = takePatientSnapshot();
+
+    initializeTimeframe(&scan.window, timeframe);
+
+    beginExport(&scan.exporter, writer, format, columns, 6);
+    visitSnapshotPatients(snapshot, exportAdmittedPatient, &scan);
+    endExport(&scan.exporter);
+
+    releasePatientSnapshot(snapshot);
+}
+
+/*
+ * Writes one active patient if they were admitted within the timeframe.
+ */
+static int exportAdmittedPatient(const Patient *patient, void *context)
+{
+    ExportScan *scan = context;
+
+    if(!isWithinTimeframe(patient->admissionDate, &scan->window))
+    {
+        return 1;
+    }
+
+    exportInteger(&scan->exporter, patient->patientId);
+    exportText(&scan->exporter, patient->name);
+    exportInteger(&scan->exporter, patient->ageInYears);
+    exportInteger(&scan->exporter, patient->roomNumber);
+    exportText(&scan->exporter, getDiagnosisText(patient->diagnosisId));
+    exportTimestamp(&scan->exporter, patient->admissionDate);
+    endExportRow(&scan->exporter);
+
+    return 1;
+}
+
+/*
+ * Writes one archived patient if they were discharged within the timeframe.
+ */
+static int exportDischargedRecord(const DischargedPatient *dischargedPatient, void *context)
+{
+    ExportScan    *scan    = context;
+    const Patient *patient = &dischargedPatient->patient;
+
+    if(!isWithinTimeframe(dischargedPatient->dischargeDate, &scan->window))
+    {
+        return 1;
+    }
+
+    exportInteger(&scan->exporter, patient->patientId);
+    exportText(&scan->exporter, patient->name);
+    exportInteger(&scan->exporter, patient->ageInYears);
+    exportInteger(&scan->exporter, patient->roomNumber);
+    exportText(&scan->exporter, getDiagnosisText(patient->diagnosisId));
+    exportTimestamp(&scan->exporter, patient->admissionDate);
+    exportTimestamp(&scan->exporter, dischargedPatient->dischargeDate);
+    endExportRow(&scan->exporter);
+
+    return 1;
+}
+
+/*
+ * Streams patients discharged within the timeframe as CSV or JSON rows,
+ * straight from the archive scan, in discharge order.
+ */
+void exportDischargeReport(ReportWriter *writer, int format, int timeframe)
+{
+    static const char *const columns[] = { "patient_id", "name", "age", "room", "diagnosis", "admitted", "discharged" };
+
+    ExportScan scan;
+
+    initializeTimeframe(&scan.window, timeframe);
+
+    beginExport(&scan.exporter, writer, format, columns, 7);
+
+    // A missing archive only means no one has been discharged yet
+    if(!scanDischargeArchive(scan.window.dayStarts[0], ARCHIVE_END_OF_TIME, exportDischargedRecord, &scan) &&
+       access(ARCHIVE_FILE, F_OK) == 0)
+    {
+        failReportWriter(writer);
+    }
+
+    endExport(&scan.exporter);
+}
+
+/*
+ * Writes the room usage counts as CSV or JSON rows.
+ */
+void exportRoomUsageReport(ReportWriter *writer, int format)
+{
+    static const char *const columns[] = { "room", "usage_count" };
+
+    ExportWriter exporter;
+    int          usage[MAX_ROOMS + 1];
+
+    pthread_rwlock_rdlock(&patientStoreLock);
+    for(int room = 1; room <= MAX_ROOMS; room++)
+    {
+        usage[room] = getRoomDischargeTotal(room);
+    }
+    pthread_rwlock_unlock(&patientStoreLock);
+
+    beginExport(&exporter, writer, format, columns, 2);
+
+    for(int room = 1; room <= MAX_ROOMS; room++)
+    {
+        if(usage[room] > 0)
+        {
+            exportInteger(&exporter, room);
+            exportInteger(&exporter, usage[room]);
+            endExportRow(&exporter);
+        }
+    }
+
+    endExport(&exporter);
+}
+
+/*
+ * Displays how many active and discharged patients share each diagnosis.
+ * Patients are grouped by interned diagnosis ID, so no text is compared.
+ */
+void displayDiagnosisReport(void)
+{
+    int diagnosisCount = getDiagnosisCount();
+
+    printf("\n--- Patients by Diagnosis Report ---\n");
+
+    if(diagnosisCount == 0)
+    {
+        printf("No diagnoses recorded.\n");
+        return;
+    }
+
+    int *activeCounts     = calloc((size_t) diagnosisCount, sizeof(int));
+    int *dischargedCounts = calloc((size_t) diagnosisCount, sizeof(int));
+    if(activeCounts == NULL || dischargedCounts == NULL)
+    {
+        puts("Error: Unable to allocate diagnosis report.");
+        free(activeCounts);
+        free(dischargedCounts);
+        return;
+    }
+
+    PatientSnapshot *snapshot     = takePatientSnapshot();
+    int              patientCount = getSnapshotPatientCount(snapshot);
+    const Patient  **patients     = malloc(sizeof(Patient *) * (size_t) (patientCount > 0 ? patientCount : 1));
+    if(patients == NULL)
+    {
+        puts("Error: Unable to allocate diagnosis report.");
+        releasePatientSnapshot(snapshot);
+        free(activeCounts);
+        free(dischargedCounts);
+        return;
+    }
+
+    getSnapshotPatients(snapshot, patients);
+    for(int i = 0; i < patientCount; i++)
+    {
+        if(patients[i]->diagnosisId >= 0 && patients[i]->diagnosisId < diagnosisCount)
+        {
+            activeCounts[patients[i]->diagnosisId]++;
+        }
+    }
+    free(patients);
+    releasePatientSnapshot(snapshot);
+
+    countDischargedPatients(ARCHIVE_BEGINNING_OF_TIME, ARCHIVE_END_OF_TIME, getDischargedDiagnosis, NULL,
+                            dischargedCounts, diagnosisCount);
+
+    printf("%-30s | %-6s | %-10s\n", "Diagnosis", "Active", "Discharged");
+    printf("-------------------------------|--------|-----------\n");
+
+    for(int id = 0; id < diagnosisCount; id++)
+    {
+        if(activeCounts[id] > 0 || dischargedCounts[id] > 0)
+        {
+            printf("%-30s | %-6d | %-10d\n", getDiagnosisText(id), activeCounts[id], dischargedCounts[id]);
+        }
+    }
+
+    printf("-------------------------------------------------\n");
+
+    free(activeCounts);
+    free(dischargedCounts);
+}
+
+/*
+ * Prints the 30-day readmission rate for each diagnosis to the console
+ * and readmission_report.txt. Rates are by the diagnosis of the stay the
+ * patient was discharged from.
+ */
+void displayReadmissionReport(void)
+{
+    int          diagnosisCount  = getDiagnosisCount();
+    int          totalDischarges = 0;
+    int          totalReadmitted = 0;
+    ReportWriter writer;
+
+    FILE *file = fopen(READMISSION_REPORT_FILE, "w");
+    if(file == NULL)
+    {
+        printf("Error opening file for writing!\n");
+        return;
+    }
+
+    if(!openReportWriter(&writer))
+    {
+        puts("Error: Unable to allocate report buffer.");
+        fclose(file);
+        return;
+    }
+
+    addConsoleSink(&writer);
+    addFileSink(&writer, file);
+
+    reportPrintf(&writer,
+                 "\n--- %d-Day Readmission Report ---\n"
+                 "%-30s | %-10s | %-10s | %-6s\n"
+                 "-------------------------------|------------|------------|-------\n",
+                 READMISSION_WINDOW_DAYS, "Diagnosis", "Discharges", "Readmitted", "Rate");
+
+    for(int id = 0; id < diagnosisCount; id++)
+    {
+        int discharges;
+        int readmissions;
+
+        pthread_rwlock_rdlock(&patientStoreLock);
+        getReadmissionTotals(id, &discharges, &readmissions);
+        pthread_rwlock_unlock(&patientStoreLock);
+
+        if(discharges > 0)
+        {
+            reportPrintf(&writer, "%-30s | %-10d | %-10d | %5.1f%%\n",
+                         getDiagnosisText(id), discharges, readmissions, 100.0 * readmissions / discharges);
+            totalDischarges += discharges;
+            totalReadmitted += readmissions;
+        }
+    }
+
+    if(totalDischarges == 0)
+    {
+        reportPrintf(&writer, "No discharges recorded.\n");
+    }
+    else
+    {
+        reportPrintf(&writer, "-------------------------------|------------|------------|-------\n"
+                              "%-30s | %-10d | %-10d | %5.1f%%\n",
+                     "All diagnoses", totalDischarges, totalReadmitted, 100.0 * totalReadmitted / totalDischarges);
+    }
+
+    int written = closeReportWriter(&writer);
+    if(fclose(file) != 0 || !written)
+    {
+        printf("\nError writing %s\n", READMISSION_REPORT_FILE);
+        return;
+    }
+    printf("\nReport successfully written to %s\n", READMISSION_REPORT_FILE);
+}
+
+/*
+ * Displays length-of-stay statistics overall and by diagnosis, room and
+ * month of discharge, from one pass over the discharge archive, and writes
+ * them to length_of_stay_report.txt.
+ */
+void displayLengthOfStayReport(void)
+{
+    ReportWriter writer;
+
+    StayAnalytics *analytics = analyzeLengthsOfStay();
+    if(analytics == NULL)
+    {
+        puts("Error: Unable to allocate length of stay report.");
+        return;
+    }
+
+    int      maxRows = analytics->diagnosisCount > STAY_MONTHS + 1 ? analytics->diagnosisCount : STAY_MONTHS + 1;
+    StayRow *rows    = malloc(sizeof(StayRow) * (size_t) (maxRows > MAX_ROOMS + 1 ? maxRows : MAX_ROOMS + 1));
+    if(rows == NULL)
+    {
+        puts("Error: Unable to allocate length of stay report.");
+        free(analytics);
+        return;
+    }
+
+    FILE *file = fopen(STAY_REPORT_FILE, "w");
+    if(file == NULL)
+    {
+        printf("Error opening file for writing!\n");
+        free(rows);
+        free(analytics);
+        return;
+    }
+
+    if(!openReportWriter(&writer))
+    {
+        puts("Error: Unable to allocate report buffer.");
+        fclose(file);
+        free(rows);
+        free(analytics);
+        return;
+    }
+
+    addConsoleSink(&writer);
+    addFileSink(&writer, file);
+
+    time_t    now = time(NULL);
+    struct tm currentTime;
+    char      currentTimeStr[20];
+    localtime_r(&now, &currentTime);
+    strftime(currentTimeStr, sizeof(currentTimeStr), "%Y-%m-%d", &currentTime);
+
+    reportPrintf(&writer,
+                 "\n--- Length of Stay Report - %s ---\n"
+                 "Stays are in days. Median and percentiles are estimates within %.0f%%.\n",
+                 currentTimeStr, STAY_RELATIVE_ERROR * 100.0);
+
+    if(analytics->overall.count == 0)
+    {
+        reportPrintf(&writer, "No discharges recorded.\n");
+    }
+    else
+    {
+        snprintf(rows[0].label, STAY_LABEL_SIZE, "All discharges");
+        rows[0].stats = &analytics->overall;
+        printStaySection(&writer, "Overall", rows, 1);
+
+        int rowCount = 0;
+        for(int id = 0; id < analytics->diagnosisCount; id++)
+        {
+            snprintf(rows[rowCount].label, STAY_LABEL_SIZE, "%s", getDiagnosisText(id));
+            rows[rowCount++].stats = &analytics->diagnoses[id];
+        }
+        printStaySection(&writer, "By diagnosis", rows, rowCount);
+
+        rowCount = 0;
+        for(int room = 1; room <= MAX_ROOMS; room++)
+        {
+            snprintf(rows[rowCount].label, STAY_LABEL_SIZE, "Room %d", room);
+            rows[rowCount++].stats = &analytics->rooms[room];
+        }
+        printStaySection(&writer, "By room", rows, rowCount);
+
+        rowCount = 0;
+        snprintf(rows[rowCount].label, STAY_LABEL_SIZE, "Earlier");
+        rows[rowCount++].stats = &analytics->earlierMonths;
+        for(int i = 0; i < STAY_MONTHS; i++)
+        {
+            int month = analytics->firstMonth + i;
+            snprintf(rows[rowCount].label, STAY_LABEL_SIZE, "%04d-%02d", 1970 + month / 12, month % 12 + 1);
+            rows[rowCount++].stats = &analytics->months[i];
+        }
+        printStaySection(&writer, "By month of discharge", rows, rowCount);
+    }
+
+    free(rows);
+    free(analytics);
+
+    int written = closeReportWriter(&writer);
+    if(fclose(file) != 0 || !written)
+    {
+        printf("\nError writing %s\n", STAY_REPORT_FILE);
+        return;
+    }
+    printf("\nReport successfully written to %s\n", STAY_REPORT_FILE);
+}
+
+/*
+ * Prints a section of the length-of-stay report: a table of averages and
+ * quantiles, then a histogram table, each with a row per group that has
+ * any stays.
+ */
+static void printStaySection(ReportWriter *writer, const char *title, const StayRow rows[], int rowCount)
+{
+    reportPrintf(writer,
+                 "\n%s\n"
+                 "%-30s | %-8s | %-7s | %-7s | %-7s | %-7s | %-7s\n"
+                 "-------------------------------|----------|---------|---------|---------|---------|--------\n",
+                 title, "Group", "Stays", "Mean", "Median", "P90", "P95", "Max");
+
+    for(int i = 0; i < rowCount; i++)
+    {
+        const StayStats *stats = rows[i].stats;
+        if(stats->count > 0)
+        {
+            reportPrintf(writer, "%-30s | %-8lld | %-7.1f | %-7.1f | %-7.1f | %-7.1f | %-7.1f\n",
+                         rows[i].label, stats->count,
+                         getStayMean(stats) / HOURS_PER_DAY,
+                         getStayQuantile(stats, 0.5) / HOURS_PER_DAY,
+                         getStayQuantile(stats, 0.9) / HOURS_PER_DAY,
+                         getStayQuantile(stats, 0.95) / HOURS_PER_DAY,
+                         stats->maxHours / HOURS_PER_DAY);
+        }
+    }
+
+    reportPrintf(writer, "\n%-30s", "Stays by length");
+    for(int bin = 0; bin < STAY_HISTOGRAM_BINS; bin++)
+    {
+        reportPrintf(writer, " | %-7s", getStayHistogramLabel(bin));
+    }
+    reportPrintf(writer, "\n-------------------------------");
+    for(int bin = 0; bin < STAY_HISTOGRAM_BINS; bin++)
+    {
+        reportPrintf(writer, "|---------");
+    }
+    reportPrintf(writer, "\n");
+
+    for(int i = 0; i < rowCount; i++)
+    {
+        const StayStats *stats = rows[i].stats;
+        if(stats->count == 0)
+        {
+            continue;
+        }
+
+        reportPrintf(writer, "%-30s", rows[i].label);
+        for(int bin = 0; bin < STAY_HISTOGRAM_BINS; bin++)
+        {
+            reportPrintf(writer, " | %-7u", stats->histogram[bin]);
+        }
+        reportPrintf(writer, "\n");
+    }
+}
+
+/*
+ * Displays the admissions and discharges in each of the last few hours,
+ * days, weeks or months, oldest first. Hours and months are one window
+ * query on the activity counters, and days and weeks are summed from the
+ * report totals.
+ */
+void displayActivityReport(void)
+{
+    static const char *const titles[] = { "Hourly", "Daily", "Weekly", "Monthly" };
+
+    int           granularity;
+    int           periods;
+    ActivityCount total = { 0, 0 };
+    ReportWriter  writer;
+
+    printf("Show activity 1: Hourly, 2: Daily, 3: Weekly, 4: Monthly\n");
+    if(scanf("%d", &granularity) != SUCCESSFUL_READ || granularity < 1 || granularity > 4)
+    {
+        puts("Invalid choice.");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+
+    printf("Number of periods to show (1-%d):\n", MAX_ACTIVITY_PERIODS);
+    if(scanf("%d", &periods) != SUCCESSFUL_READ || periods < 1 || periods > MAX_ACTIVITY_PERIODS)
+    {
+        puts("Invalid number of periods.");
+        clearInputBuffer();
+        return;
+    }
+    clearInputBuffer();
+
+    FILE *file = fopen(ACTIVITY_REPORT_FILE, "w");
+    if(file == NULL)
+    {
+        printf("Error opening file for writing!\n");
+        return;
+    }
+
+    if(!openReportWriter(&writer))
+    {
+        puts("Error: Unable to allocate report buffer.");
+        fclose(file);
+        return;
+    }
+
+    addConsoleSink(&writer);
+    addFileSink(&writer, file);
+
+    time_t    now = time(NULL);
+    struct tm currentTime;
+    char      currentTimeStr[20];
+    localtime_r(&now, &currentTime);
+    strftime(currentTimeStr, sizeof(currentTimeStr), "%Y-%m-%d %H:%M", &currentTime);
+
+    reportPrintf(&writer,
+                 "\n--- %s Activity Report - %s ---\n"
+                 "%-24s | %-10s | %-10s\n"
+                 "-------------------------|------------|-----------\n",
+                 titles[granularity - 1], currentTimeStr, "Period", "Admissions", "Discharges");
+
+    for(int i = periods - 1; i >= 0; i--)
+    {
+        char          label[32];
+        ActivityCount count = countActivityPeriod(granularity, now, i, label, sizeof(label));
+
+        reportPrintf(&writer, "%-24s | %-10d | %-10d\n", label, count.admissions, count.discharges);
+        total.admissions += count.admissions;
+        total.discharges += count.discharges;
+    }
 
-            // Filter discharged patients by timeframe (1=daily, 2=weekly, 3=monthly)
-            if((timeframe == 1 && past24Hours) || (timeframe == 2 && sameWeek) || (timeframe == 3 && sameMonth))
-            {
-                // Print patient details to console with formatted columns
-                printf("| ID: %-5d Name: %-15s | Age: %-3d Room: %-5d Diagnosis: %-20s | Discharged: %-10s |\n",
-                       dischargedPatient.patient.patientId,
-                       dischargedPatient.patient.name,
-                       dischargedPatient.patient.ageInYears,
-                       dischargedPatient.patient.roomNumber,
-                       dischargedPatient.patient.diagnosis,
-                       dischargeDateStr);
-                
-                // Print same patient details to file
-                fprintf(file,
-                        "| ID: %-5d Name: %-15s | Age: %-3d Room: %-5d Diagnosis: %-20s | Discharged: %-10s |\n",
-                        dischargedPatient.patient.patientId,
-                        dischargedPatient.patient.name,
-                        dischargedPatient.patient.ageInYears,
-                        dischargedPatient.patient.roomNumber,
-                        dischargedPatient.patient.diagnosis,
-                        dischargeDateStr);
-
-                // Add separator after each patient entry
-                printf("---------------------------------------\n");
-                fprintf(file, "---------------------------------------\n");
-            }
-        }
+    reportPrintf(&writer, "-------------------------|------------|-----------\n"
+                          "%-24s | %-10d | %-10d\n",
+                 "Total", total.admissions, total.discharges);
 
-        fclose(fileRead);
+    int written = closeReportWriter(&writer);
+    if(fclose(file) != 0 || !written)
+    {
+        printf("\nError writing %s\n", ACTIVITY_REPORT_FILE);
+        return;
     }
+    printf("\nReport successfully written to %s\n", ACTIVITY_REPORT_FILE);
 }
 
 /*
- * Generates and displays a report of discharged
- * patients based on the selected timeframe.
+ * State shared with printMatchingDischargedRecord while scanning the archive.
  */
-void displayDischargedPatientReport(int choice)
+typedef struct
 {
-    int result = countDischargedPatientsByTimeframe(choice);
+    const int *patientIds;
+    int        matchCount;
+} DiagnosisSearchScan;
 
-    FILE *file = fopen("discharged_reports.txt", "a");
-    if(file == NULL)
+/*
+ * Prints one archived patient if their ID is among the search matches.
+ */
+static int printMatchingDischargedRecord(const DischargedPatient *dischargedPatient, void *context)
+{
+    DiagnosisSearchScan *scan = context;
+    int                  id   = dischargedPatient->patient.patientId;
+
+    if(bsearch(&id, scan->patientIds, (size_t) scan->matchCount, sizeof(int), comparePatientIds) == NULL)
     {
-        printf("Error opening file for writing!\n");
-        return;
+        return 1;
     }
 
-    fprintf(file, "\n");
+    time_t dischargeTimestamp = dischargedPatient->dischargeDate;
+    char   dischargeDateStr[20];
+    strftime(dischargeDateStr, sizeof(dischargeDateStr), "%Y-%m-%d", localtime(&dischargeTimestamp));
 
-    printDischargedFormattedReport(file, "   Discharged Patient Report - Weekly", result, choice);
+    printPatient(dischargedPatient->patient);
+    printf("Discharged: %s\n", dischargeDateStr);
 
-    fclose(file);
-    printf("\nDischarge Report successfully written to discharged_reports.txt\n");
+    return 1;
 }
 
 /*
- * Reads room_usage.txt and displays a usage report
- * showing how many times each valid room (1-50) was used.
+ * Prompts for a diagnosis query and lists the matching active or
+ * discharged patients, answered from the diagnosis index.
  */
-void displayRoomUsageReport(void)
+void searchPatientsByDiagnosis(void)
 {
-    FILE *file = fopen("room_usage.txt", "r");
-    int   roomCounts[50 + 1] = { 0 }; // Array to store counts (index 0 unused)
-    int   roomNumber;
-    int   totalEntries = 0;
-    int   validEntries = 0;
-
-    printf("\n--- Room Usage Report ---\n");
-
-    if(file == NULL)
+    char            query[MAX_DIAGNOSIS_LENGTH];
+    int             scope;
+    int            *patientIds;
+    int             matchCount;
+    struct timespec start;
+    struct timespec end;
+
+    printf("Search 1: Current patients, 2: Discharged patients\n");
+    if(scanf("%d", &scope) != SUCCESSFUL_READ || (scope != 1 && scope != 2))
     {
-        printf("Error opening room_usage.txt for reading");
+        puts("Invalid choice.");
+        clearInputBuffer();
         return;
     }
+    clearInputBuffer();
+    scope = scope == 1 ? INDEX_SCOPE_ACTIVE : INDEX_SCOPE_DISCHARGED;
 
-    // Read each room number from the file
-    while(fscanf(file, "%d", &roomNumber) == 1)
+    printf("Enter diagnosis search (e.g. \"viral pneu* OR flu\"):\n");
+    if(fgets(query, sizeof(query), stdin) == NULL)
     {
-        totalEntries++;
-        // Validate the room number and increment the count
-        if(roomNumber >= 1 && roomNumber <= 50)
-        {
-            roomCounts[roomNumber]++;
-            validEntries++;
-        }
-        else
-        {
-            fprintf(stderr, "Warning: Found invalid room number '%d' in room_usage.txt\n", roomNumber);
-        }
+        return;
     }
+    query[strcspn(query, "\n")] = '\0';
 
-    fclose(file);
+    pthread_rwlock_rdlock(&patientStoreLock);
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int result = queryDiagnosisIndex(scope, query, &patientIds, &matchCount);
+    clock_gettime(CLOCK_MONOTONIC, &end);
 
-    printf("Room | Usage Count\n");
-    printf("-----|------------\n");
+    // The snapshot taken with the index matches it once writers are let back in
+    PatientSnapshot *snapshot = takePatientSnapshot();
+    pthread_rwlock_unlock(&patientStoreLock);
+
+    if(!result)
+    {
+        releasePatientSnapshot(snapshot);
+        puts("Please enter at least one search term.");
+        return;
+    }
+
+    printf("%d matching patient(s) found in %ld microseconds.\n",
+           matchCount,
+           (long) ((end.tv_sec - start.tv_sec) * 1000000L + (end.tv_nsec - start.tv_nsec) / 1000));
 
-    int roomsReported = 0;
-    for(int i = 1; i <= 50; i++)
+    if(matchCount > 0 && scope == INDEX_SCOPE_ACTIVE)
     {
-        if(roomCounts[i] > 0)
+        for(int i = 0; i < matchCount; i++)
         {
-            printf("%-4d | %d\n", i, roomCounts[i]);
-            roomsReported++;
+            const Patient *patient = findSnapshotPatient(snapshot, patientIds[i]);
+            if(patient != NULL)
+            {
+                printPatient(*patient);
+            }
         }
     }
-
-    if(roomsReported == 0 && validEntries == 0)
+    else if(matchCount > 0)
     {
-        printf("No valid room usage data found in the file.\n");
+        DiagnosisSearchScan scan = { patientIds, matchCount };
+        scanDischargeArchive(ARCHIVE_BEGINNING_OF_TIME, ARCHIVE_END_OF_TIME, printMatchingDischargedRecord, &scan);
     }
 
-    printf("-------------------------\n");
-    printf("Total entries read: %d\n", totalEntries);
-    printf("Valid rooms logged: %d\n", validEntries);
-    printf("-------------------------\n");
+    free(patientIds);
+    releasePatientSnapshot(snapshot);
 }
 
 /*
@@ -721,8 +2787,12 @@ static int getRoomNumber(int *roomNumber)
             continue;
         }
 
-        // Check if the room is already occupied by traversing the linked list.
-        if(isRoomOccupiedInList(*roomNumber, patientHead) != ROOM_UNOCCUPIED)
+        // Check if the room is already occupied.
+        pthread_rwlock_rdlock(&patientStoreLock);
+        int occupant = getRoomOccupant(*roomNumber);
+        pthread_rwlock_unlock(&patientStoreLock);
+
+        if(occupant != ROOM_UNOCCUPIED)
         {
             printf("Room already occupied. Please choose another room.\n");
             isValid = IS_NOT_VALID;
@@ -734,21 +2804,21 @@ static int getRoomNumber(int *roomNumber)
 }
 
 /*
- * Prompts user for a patient ID and returns their index in the system.
+ * Prompts user for the ID of the patient to discharge.
  */
-static Patient *getPatientToDischarge(void)
+static int getPatientToDischarge(void)
 {
-    int patientId;
+    int patientId = INVALID_ID;
     printf("Enter ID of patient to discharge:\n");
     scanf("%d", &patientId);
     clearInputBuffer();
-    return getPatientFromList(patientId);
+    return patientId;
 }
 
 /*
  * Asks the user to confirm the discharge of a patient.
  */
-static int confirmDischarge(Patient *patient)
+static int confirmDischarge(const Patient *patient)
 {
     char confirm;
     printf("Patient ID: %d\n", patient->patientId);
@@ -760,60 +2830,98 @@ static int confirmDischarge(Patient *patient)
 }
 
 /*
- * Removes a patient from the system by unlinking the corresponding node from the linked list.
+ * Removes discharged patients from the system by unlinking their nodes
+ * from the linked list in one pass, then rewrites patients.dat once.
  */
-static void removePatientFromSystem(Patient *patient)
+static void removePatientsFromSystem(const DischargedPatient records[], int count)
 {
-    if(patientHead == NULL || patient == NULL)
+    int *removedIds = malloc(sizeof(int) * (size_t) count);
+    if(removedIds == NULL)
     {
+        puts("Error: Unable to allocate patient removal.");
         return;
     }
 
-    PatientNode *current  = patientHead;
-    PatientNode *prevNode = NULL;
+    for(int i = 0; i < count; i++)
+    {
+        const Patient *patient = &records[i].patient;
+
+        removedIds[i] = patient->patientId;
+        if(patient->roomNumber >= 1 && patient->roomNumber <= MAX_ROOMS &&
+           roomOccupants[patient->roomNumber] == patient->patientId)
+        {
+            roomOccupants[patient->roomNumber] = 0;
+        }
+    }
+    qsort(removedIds, (size_t) count, sizeof(int), comparePatientIds);
+    unlinkPatients(removedIds, count);
+
+    publishPatientChange(publishDischarges(removedIds, count));
+    free(removedIds);
+    updatePatientsFile();
+}
 
-    if(current != NULL && current->data.patientId == patient->patientId)
+/*
+ * Unlinks and frees the patients with the given sorted IDs in one pass
+ * over the list.
+ */
+static void unlinkPatients(const int sortedIds[], int count)
+{
+    if(count == 0)
     {
-        patientHead = current->nextNode;
-        free(current);
-        totalPatients--;
-        updatePatientsFile();
         return;
     }
 
-    // Search for the patient to remove
-    while(current != NULL && current->data.patientId != patient->patientId)
+    PatientNode **link = &patientHead;
+    patientTail        = NULL;
+    while(*link != NULL)
     {
-        prevNode = current;
-        current  = current->nextNode;
+        PatientNode *current = *link;
+        if(bsearch(&current->data.patientId, sortedIds, (size_t) count, sizeof(int), comparePatientIds) != NULL)
+        {
+            // Unlink the node and free memory
+            *link = current->nextNode;
+            freePatientNode(current);
+            totalPatients--;
+        }
+        else
+        {
+            patientTail = current;
+            link        = &current->nextNode;
+        }
     }
+}
 
-    // If patient was not found
-    if(current == NULL)
+/*
+ * Frees a node, unless it belongs to the block restored from a checkpoint,
+ * which clearPatientStore frees as a whole.
+ */
+static void freePatientNode(PatientNode *node)
+{
+    if(node < restoredNodes || node >= restoredNodes + restoredNodeCount)
     {
-        return;
+        free(node);
     }
-
-    // Unlink the node and free memory
-    prevNode->nextNode = current->nextNode;
-    free(current);
-    totalPatients--;
-
-    updatePatientsFile();
 }
 
 
 /**
  * Rewrites the patients.dat file with current patient data.
- * Opens file in write binary mode and writes all active patient records.
+ * Writes all active patient records to patients.tmp and durably replaces
+ * patients.dat with it.
  */
 static void updatePatientsFile(void)
 {
-    FILE *pTemp;
-    pTemp = fopen("patients.tmp", "wb");
-    if(pTemp == NULL)
+    RecordWriter writer;
+    int          baseId = patientHead != NULL ? patientHead->data.patientId : DEFAULT_ID;
+
+    // Appends to the old file must finish before it is replaced
+    flushAdmissionLog();
+
+    if(!openRecordWriter(&writer, "patients.tmp", PATIENT_FILE_MAGIC, 1, baseId))
     {
         perror("Error creating temporary backup file");
+        discardCheckpoint();
         return; // Keep original patients.dat
     }
 
@@ -825,7 +2933,7 @@ static void updatePatientsFile(void)
 
     while(current != NULL)
     {
-        if(fwrite(&(current->data), sizeof(Patient), 1, pTemp) != 1)
+        if(!writePatientRecord(&writer, &(current->data)))
         {
             perror("Error writing patient to temporary file");
             write_error = 1;
@@ -834,7 +2942,7 @@ static void updatePatientsFile(void)
         current = current->nextNode;
     }
 
-    if(fclose(pTemp) != 0)
+    if(!closeRecordWriter(&writer))
     { // Also check fclose error
         perror("Error closing temporary backup file");
         write_error = 1;
@@ -843,17 +2951,11 @@ static void updatePatientsFile(void)
     if(!write_error)
     {
         // Only replace original if temp write was fully successful
-        if(remove("patients.dat") != 0 && errno != ENOENT)
-        {
-            perror("Error removing old patients.dat");
-        }
-        if(rename("patients.tmp", "patients.dat") != 0)
-        {
-            perror("Error renaming temporary file to patients.dat");
-        }
-        else
+        if(replaceFile("patients.tmp", "patients.dat"))
         {
             puts("patients.dat updated successfully."); // Success message only after rename
+            logStoreChange(DELTA_FILE_STAMP, NULL);
+            return;
         }
     }
     else
@@ -861,6 +2963,9 @@ static void updatePatientsFile(void)
         puts("Backup failed. Original patients.dat remains unchanged.");
         remove("patients.tmp"); // Clean up failed temp file
     }
+
+    // The list may no longer match patients.dat in a way the delta log cannot describe
+    discardCheckpoint();
 }
 
 /*
@@ -886,37 +2991,153 @@ static Patient *getPatientFromList(int id)
 }
 
 /**
- * Appends a single patient record to the patients.dat file.
- * Opens file in append binary mode, writes patient data, and handles errors.
+ * Queues a single patient record to be appended to the patients.dat file
+ * with the next group commit. Must be called with patientStoreLock held
+ * exclusively.
+ */
+static void writePatientToFile(const Patient *newPatient, PendingAdmission *commit)
+{
+    queueAdmission(commit, newPatient);
+}
+
+/*
+ * Waits for a queued patient record to be durable. The admission log has
+ * already reported a failed write.
+ */
+static void awaitPatientWrite(PendingAdmission *admission)
+{
+    if(waitForAdmission(admission))
+    {
+        puts("\nPatient successfully added to file.\n");
+    }
+}
+
+/*
+ * Copies an active patient from the current snapshot.
+ * Returns 1 if the patient is admitted, 0 otherwise.
  */
-static void writePatientToFile(Patient newPatient)
+static int copyActivePatient(int id, Patient *patient)
 {
-    FILE *pPatients = fopen("patients.dat", "ab");
+    PatientSnapshot *snapshot = takePatientSnapshot();
 
-    if(pPatients == NULL)
+    const Patient *found = findSnapshotPatient(snapshot, id);
+    if(found != NULL)
     {
-        puts("\nUnable to find patients.dat. Patient not added to file.");
-        return;
+        *patient = *found;
     }
 
-    fwrite(&newPatient, sizeof(Patient), 1, pPatients);
-    fclose(pPatients);
-    puts("\nPatient successfully added to file.\n");
+    releasePatientSnapshot(snapshot);
+    return found != NULL;
 }
 
 /*
- * Checks if a room is currently occupied.
+ * Returns the number of admitted patients in the current snapshot.
  */
-static int isRoomOccupiedInList(int roomNumber, PatientNode *head)
+static int getActivePatientCount(void)
 {
-    PatientNode *current = head;
-    while(current != NULL)
+    PatientSnapshot *snapshot = takePatientSnapshot();
+    int              count    = getSnapshotPatientCount(snapshot);
+    releasePatientSnapshot(snapshot);
+
+    return count;
+}
+
+/*
+ * Hands out the next patient ID. The counter is atomic, so concurrent
+ * admissions never receive the same ID.
+ */
+static int allocatePatientId(void)
+{
+    return atomic_fetch_add(&patientIDCounter, 1);
+}
+
+/*
+ * Returns the ID of the patient in a room, or ROOM_UNOCCUPIED.
+ */
+static int getRoomOccupant(int roomNumber)
+{
+    if(roomNumber < 1 || roomNumber > MAX_ROOMS || roomOccupants[roomNumber] == 0)
     {
-        if(current->data.roomNumber == roomNumber)
-            return 1;
-        current = current->nextNode;
+        return ROOM_UNOCCUPIED;
+    }
+    return roomOccupants[roomNumber];
+}
+
+/*
+ * Fills the room occupancy table from the patient list.
+ */
+static void rebuildRoomOccupancy(void)
+{
+    memset(roomOccupants, 0, sizeof(roomOccupants));
+
+    for(PatientNode *current = patientHead; current != NULL; current = current->nextNode)
+    {
+        if(current->data.roomNumber >= 1 && current->data.roomNumber <= MAX_ROOMS)
+        {
+            roomOccupants[current->data.roomNumber] = current->data.patientId;
+        }
+    }
+}
+
+/*
+ * Patients sorted by ID, built on the first transfer replayed.
+ */
+typedef struct
+{
+    Patient **patients;
+    int       count;
+    int       built;
+} TransferReplay;
+
+/*
+ * Re-applies the transfers logged since patients.dat was last written in
+ * full, since transfers only append to the transfer log. Replaying a
+ * transfer that is already reflected is harmless.
+ */
+static void replayTransfers(time_t since)
+{
+    TransferReplay replay = { NULL, 0, 0 };
+
+    scanTransfersSince(since, applyTransfer, &replay);
+    free(replay.patients);
+}
+
+/*
+ * Moves one loaded patient to the room a logged transfer put them in.
+ */
+static int applyTransfer(const TransferRecord *transfer, void *context)
+{
+    TransferReplay *replay = context;
+
+    if(!replay->built)
+    {
+        replay->built    = 1;
+        replay->patients = malloc(sizeof(Patient *) * (size_t) (totalPatients > 0 ? totalPatients : 1));
+        if(replay->patients == NULL)
+        {
+            return 0;
+        }
+        for(PatientNode *current = patientHead; current != NULL; current = current->nextNode)
+        {
+            replay->patients[replay->count++] = &current->data;
+        }
+        qsort(replay->patients, (size_t) replay->count, sizeof(Patient *), compareViewById);
     }
-    return ROOM_UNOCCUPIED;
+    if(replay->patients == NULL)
+    {
+        return 0;
+    }
+
+    Patient   key    = { .patientId = transfer->patientId };
+    Patient  *keyPtr = &key;
+    Patient **found  = bsearch(&keyPtr, replay->patients, (size_t) replay->count, sizeof(Patient *),
+                               compareViewById);
+    if(found != NULL)
+    {
+        (*found)->roomNumber = transfer->toRoom;
+    }
+
+    return 1;
 }
 
 /*
@@ -925,7 +3146,7 @@ static int isRoomOccupiedInList(int roomNumber, PatientNode *head)
  */
 static int computeNextPatientId(void)
 {
-    int          maxId   = 0;
+    int          maxId   = getHighestDischargedId(); // Never reuse a discharged patient's ID
     PatientNode *current = patientHead;
     while(current != NULL)
     {
@@ -939,158 +3160,364 @@ static int computeNextPatientId(void)
 }
 
 /*
- * Inserts a new patient node at the end of the linked list.
+ * Inserts a new patient node at the end of the linked list, found through
+ * the tail pointer so loading n patients stays linear. Returns the new
+ * node, or NULL if it could not be allocated.
  */
-static PatientNode *insertPatientAtEndOfList(PatientNode *head, Patient data)
+static PatientNode *insertPatientAtEndOfList(Patient data)
 {
     PatientNode *newNode = malloc(sizeof(PatientNode));
     if(newNode == NULL)
     {
-        free(newNode);
         return NULL;
     }
 
     newNode->data     = data;
     newNode->nextNode = NULL;
 
-    if(head == NULL)
+    if(patientHead == NULL)
     {
+        patientHead = newNode;
+        patientTail = newNode;
         return newNode;
     }
 
-    PatientNode *current = head;
-    while(current->nextNode != NULL)
-    {
-        current = current->nextNode;
-    }
-    current->nextNode = newNode;
+    patientTail->nextNode = newNode;
+    patientTail           = newNode;
 
     puts("Patient inserted at end of list.");
-    return head;
+    return newNode;
 }
 
 /*
- * Counts the number of patients admitted within
+ * Counts the patients still admitted who were admitted within
  * the specified timeframe (daily, weekly, or monthly).
  */
 static int countPatientsByTimeframe(int timeframe)
 {
-    if(patientHead == NULL)
+    if(getActivePatientCount() == 0)
     {
         printf("No patients admitted!\n");
         return 0;
     }
 
-    int        count       = 0;
-    time_t     now         = time(NULL);
-    struct tm *currentTime = localtime(&now);
+    time_t    now         = time(NULL);
+    struct tm currentTime = *localtime(&now);
 
-    // Extract current year, day of year, and month
-    int currentYear      = currentTime->tm_year;
-    int currentDayOfYear = currentTime->tm_yday;
-    int currentMonth     = currentTime->tm_mon;
+    pthread_rwlock_rdlock(&patientStoreLock);
+    int total = sumActiveAdmissions(getTimeframeFirstDay(&currentTime, timeframe), getDayNumberOfDate(&currentTime));
+    pthread_rwlock_unlock(&patientStoreLock);
 
-    PatientNode *current = patientHead;
-    while(current != NULL)
-    {
-        time_t     admissionTimestamp = current->data.admissionDate;
-        struct tm *admissionTime      = localtime(&admissionTimestamp);
+    return total;
+}
 
-        // Extract admission year, day of year, and month
-        int admissionYear      = admissionTime->tm_year;
-        int admissionDayOfYear = admissionTime->tm_yday;
-        int admissionMonth     = admissionTime->tm_mon;
+/*
+ * Counts the patients discharged within the specified timeframe.
+ */
+static int countDischargedPatientsByTimeframe(int timeframe)
+{
+    time_t    now         = time(NULL);
+    struct tm currentTime = *localtime(&now);
 
-        // Calculate the difference in hours directly
-        double secondsDiff = difftime(now, admissionTimestamp);
-        int    hoursDiff   = (int) (secondsDiff / 3600);
+    pthread_rwlock_rdlock(&patientStoreLock);
+    int total = sumDischarges(getTimeframeFirstDay(&currentTime, timeframe), getDayNumberOfDate(&currentTime));
+    pthread_rwlock_unlock(&patientStoreLock);
+
+    return total;
+}
+
+/*
+ * Works out the calendar days of a report timeframe, matching the day
+ * ranges the report totals are summed over, with the instant each day
+ * starts at and its date as text.
+ */
+static void initializeTimeframe(ReportTimeframe *window, int timeframe)
+{
+    window->now = time(NULL);
+    localtime_r(&window->now, &window->currentTime);
+    window->timeframe = timeframe;
 
-        // Adjusted time conditions
-        int past24Hours = (hoursDiff <= 24);
-        int sameWeek    = (admissionYear == currentYear && (currentDayOfYear - admissionDayOfYear) < 7);
-        int sameMonth   = (admissionYear == currentYear && admissionMonth == currentMonth);
+    window->dayCount = getDayNumberOfDate(&window->currentTime) - getTimeframeFirstDay(&window->currentTime, timeframe) + 1;
 
-        // Increment count based on timeframe
-        if((timeframe == 1 && past24Hours) || // Daily
-           (timeframe == 2 && sameWeek) ||    // Weekly
-           (timeframe == 3 && sameMonth))     // Monthly
+    for(int i = 0; i <= window->dayCount; i++)
+    {
+        struct tm day = window->currentTime;
+        day.tm_mday  -= window->dayCount - 1 - i;
+        day.tm_hour   = 0;
+        day.tm_min    = 0;
+        day.tm_sec    = 0;
+        day.tm_isdst  = -1;
+
+        // mktime normalizes the day, so the result names the date it landed on
+        window->dayStarts[i] = mktime(&day);
+        if(i < window->dayCount)
         {
-            count++;
+            strftime(window->dayTexts[i], DATE_TEXT_SIZE, "%Y-%m-%d", &day);
         }
+    }
+}
 
-        current = current->nextNode;
+/*
+ * Checks whether a timestamp falls on a calendar day within a report
+ * timeframe.
+ */
+static int isWithinTimeframe(time_t timestamp, const ReportTimeframe *window)
+{
+    return timestamp >= window->dayStarts[0] && timestamp < window->dayStarts[window->dayCount];
+}
+
+/*
+ * Returns the date of a timestamp within the timeframe as YYYY-MM-DD, by
+ * finding the last day that starts at or before it.
+ */
+static const char *getTimeframeDateText(const ReportTimeframe *window, time_t timestamp)
+{
+    int low  = 0;
+    int high = window->dayCount - 1;
+
+    while(low < high)
+    {
+        int middle = (low + high + 1) / 2;
+        if(window->dayStarts[middle] <= timestamp)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
     }
+    return window->dayTexts[low];
+}
 
-    return count;
+/*
+ * Report engine filters. They run on worker threads, so they only read
+ * the shared timeframe.
+ */
+static int isAdmittedWithinTimeframe(const Patient *patient, const void *context)
+{
+    const ReportTimeframe *window = context;
+    return isWithinTimeframe(patient->admissionDate, window);
+}
+
+static int isDischargedWithinTimeframe(const DischargedPatient *dischargedPatient, const void *context)
+{
+    const ReportTimeframe *window = context;
+    return isWithinTimeframe(dischargedPatient->dischargeDate, window);
 }
 
 /*
- * Counts the number of discharged patients from a
- * binary file within the specified timeframe.
+ * Report engine key that counts archived patients by diagnosis.
  */
-static int countDischargedPatientsByTimeframe(int timeframe)
+static int getDischargedDiagnosis(const DischargedPatient *dischargedPatient, const void *context)
 {
-    FILE *file = fopen("discharged_patients.dat", "rb");
-    if(file == NULL)
+    (void) context;
+    return dischargedPatient->patient.diagnosisId;
+}
+
+/*
+ * Returns the first calendar day of a report timeframe (1=today,
+ * 2=the last 7 days of this year, 3=this calendar month).
+ */
+static int getTimeframeFirstDay(const struct tm *currentTime, int timeframe)
+{
+    int today = getDayNumberOfDate(currentTime);
+
+    switch(timeframe)
     {
-        printf("No discharged patients found!\n");
-        return 0;
+        case 2:
+            // Seven days back, but never before January 1st of this year
+            return today - (currentTime->tm_yday < 6 ? currentTime->tm_yday : 6);
+        case 3:
+            return today - (currentTime->tm_mday - 1);
+        default:
+            return today;
     }
+}
+
+/*
+ * Counts the activity in one period of an activity report (1=hour,
+ * 2=day, 3=seven days, 4=calendar month), periodsBack periods before the
+ * current one, and labels it. Local dates are stepped with mktime, which
+ * normalizes days and months that run past the start of the month or
+ * year.
+ */
+static ActivityCount countActivityPeriod(int granularity, time_t now, int periodsBack, char label[], size_t labelSize)
+{
+    struct tm start;
 
-    int        count       = 0;
-    time_t     now         = time(NULL);
-    struct tm *currentTime = localtime(&now);
+    localtime_r(&now, &start);
+    start.tm_hour  = granularity == 1 ? start.tm_hour : 0;
+    start.tm_min   = 0;
+    start.tm_sec   = 0;
+    start.tm_isdst = -1;
 
-    DischargedPatient dischargedPatient;
-    while(fread(&dischargedPatient, sizeof(DischargedPatient), 1, file) == 1)
+    switch(granularity)
     {
-        time_t     dischargeTimestamp = dischargedPatient.dischargeDate;
-        struct tm *dischargeTime      = localtime(&dischargeTimestamp);
+        case 1:
+        {
+            // Hours are counted in UTC, so step back whole hours from now
+            time_t hourStart = now - now % SECONDS_PER_HOUR - (time_t) periodsBack * SECONDS_PER_HOUR;
+            localtime_r(&hourStart, &start);
+            strftime(label, labelSize, "%Y-%m-%d %H:%M", &start);
 
-        double secondsDiff = difftime(now, dischargeTimestamp);
-        int    hoursDiff   = secondsDiff / 3600;
+            int hour = getHourNumber(hourStart);
+            return countActivity(ACTIVITY_BY_HOUR, hour, hour);
+        }
+        case 2:
+        {
+            start.tm_mday -= periodsBack;
+            mktime(&start);
+            strftime(label, labelSize, "%Y-%m-%d", &start);
 
-        int past24Hours = (hoursDiff <= 24);
-        int sameWeek =
-                (dischargeTime->tm_year == currentTime->tm_year && (currentTime->tm_yday - dischargeTime->tm_yday) < 7);
-        int sameMonth =
-                (dischargeTime->tm_year == currentTime->tm_year && dischargeTime->tm_mon == currentTime->tm_mon);
+            int day = getDayNumberOfDate(&start);
+            return countDayActivity(day, day);
+        }
+        case 3:
+        {
+            // Seven-day windows ending today, like the weekly reports
+            start.tm_mday -= periodsBack * DAYS_PER_WEEK + DAYS_PER_WEEK - 1;
+            mktime(&start);
+            strftime(label, labelSize, "Week of %Y-%m-%d", &start);
 
-        if((timeframe == 1 && past24Hours) || (timeframe == 2 && sameWeek) || (timeframe == 3 && sameMonth))
+            int firstDay = getDayNumberOfDate(&start);
+            return countDayActivity(firstDay, firstDay + DAYS_PER_WEEK - 1);
+        }
+        default:
         {
-            count++;
+            start.tm_mday  = 1;
+            start.tm_mon  -= periodsBack;
+            mktime(&start);
+            strftime(label, labelSize, "%Y-%m", &start);
+
+            int month = getMonthNumberOfDate(&start);
+            return countActivity(ACTIVITY_BY_MONTH, month, month);
         }
     }
+}
 
-    fclose(file);
-    return count;
+/*
+ * Totals the admissions and discharges over a day range from the report
+ * totals, which keep the count for each day.
+ */
+static ActivityCount countDayActivity(int firstDay, int lastDay)
+{
+    ActivityCount total;
+
+    pthread_rwlock_rdlock(&patientStoreLock);
+    total.admissions = sumAdmissions(firstDay, lastDay);
+    total.discharges = sumDischarges(firstDay, lastDay);
+    pthread_rwlock_unlock(&patientStoreLock);
+
+    return total;
 }
 
 
 
 /*
- * Appends the given room number to the
- * room_usage.txt file for logging purposes.
+ * Appends the room number of each discharged
+ * patient to the room_usage.txt file for logging purposes.
+ * The append is handed to the asynchronous writer, so the discharge does
+ * not wait for it; finishRoomUsageLog releases the file and buffer.
  */
-static void logRoomUsage(int roomNumber)
+static void logRoomUsage(const DischargedPatient records[], int count)
 {
-    FILE *file = fopen("room_usage.txt", "a"); // Open in append mode
+    RoomUsageLog *log = malloc(sizeof(RoomUsageLog) + (size_t) count * ROOM_USAGE_LINE_SIZE);
 
-    if(file == NULL)
+    if(log == NULL)
+    {
+        puts("Error: Unable to allocate the room usage log.");
+        return;
+    }
+
+    // Write each room number followed by a newline
+    size_t length = 0;
+    for(int i = 0; i < count; i++)
+    {
+        length += (size_t) snprintf(log->lines + length, ROOM_USAGE_LINE_SIZE, "%d\n", records[i].patient.roomNumber);
+    }
+
+    log->fd = open(ROOM_USAGE_FILE, O_WRONLY | O_APPEND | O_CREAT | O_CLOEXEC, 0644); // Open in append mode
+    if(log->fd < 0)
     {
         perror("Error opening room_usage.txt for logging");
         // Decide if this is a critical error or just a warning.
         // For now, we'll print an error and continue.
+        free(log);
         return;
     }
 
-    // Write the room number followed by a newline
-    fprintf(file, "%d\n", roomNumber);
+    int sync = getFileDurability(ROOM_USAGE_FILE) == DURABILITY_SYNC;
+    if(!submitWrite(log->fd, log->lines, length, 0, sync, finishRoomUsageLog, log))
+    {
+        ssize_t written = write(log->fd, log->lines, length);
+        finishRoomUsageLog(written == (ssize_t) length ? 0 : -EIO, log);
+    }
+}
+
+/*
+ * Completion of a room usage append: reports a failure, then closes the
+ * file and frees the lines.
+ */
+static void finishRoomUsageLog(int result, void *context)
+{
+    RoomUsageLog *log = context;
+
+    if(result != 0)
+    {
+        printf("Error writing room_usage.txt: %s\n", strerror(-result));
+    }
+
+    close(log->fd);
+    free(log);
+}
+
+/*
+ * qsort/bsearch comparator for patient IDs.
+ */
+static int comparePatientIds(const void *a, const void *b)
+{
+    int left  = *(const int *) a;
+    int right = *(const int *) b;
+    return (left > right) - (left < right);
+}
 
-    fclose(file);
-    // Optional: Add a confirmation message here if desired
-    // printf("Room %d usage logged.\n", roomNumber);
+/*
+ * qsort comparators for the patient view. Ties fall back to ID order.
+ */
+static int compareViewById(const void *a, const void *b)
+{
+    const Patient *left  = *(const Patient *const *) a;
+    const Patient *right = *(const Patient *const *) b;
+    return (left->patientId > right->patientId) - (left->patientId < right->patientId);
 }
 
+static int compareViewByName(const void *a, const void *b)
+{
+    const Patient *left   = *(const Patient *const *) a;
+    const Patient *right  = *(const Patient *const *) b;
+    int            result = strcasecmp(left->name, right->name);
+    return result != 0 ? result : compareViewById(a, b);
+}
 
+static int compareViewByRoom(const void *a, const void *b)
+{
+    const Patient *left  = *(const Patient *const *) a;
+    const Patient *right = *(const Patient *const *) b;
+    if(left->roomNumber != right->roomNumber)
+    {
+        return left->roomNumber < right->roomNumber ? -1 : 1;
+    }
+    return compareViewById(a, b);
+}
 
+static int compareViewByAdmission(const void *a, const void *b)
+{
+    const Patient *left  = *(const Patient *const *) a;
+    const Patient *right = *(const Patient *const *) b;
+    if(left->admissionDate != right->admissionDate)
+    {
+        return left->admissionDate < right->admissionDate ? -1 : 1;
+    }
+    return compareViewById(a, b);
+}
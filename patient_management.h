@@ -7,6 +7,7 @@
 #ifndef PATIENT_MANAGEMENT_H
 #define PATIENT_MANAGEMENT_H
 #include "patient_data.h"
+#include "report_writer.h"
 #include <stdio.h>
 
 typedef struct PatientNode
@@ -20,6 +21,15 @@ typedef struct DischargedPatient {
     time_t dischargeDate;  // Time of discharge
 } DischargedPatient;
 
+struct ReadmissionMatch;  // See readmission.h
+struct PendingAdmission; // See admission_log.h
+
+// Results of admitPatient
+#define ADMIT_SUCCESS 1
+#define ADMIT_FAILURE 0
+#define ADMIT_INVALID (-1)
+#define ADMIT_ROOM_TAKEN (-2)
+
 /*
  * Function: initializePatientSystem
  * --------------------------------
@@ -43,10 +53,51 @@ void initializePatientSystemDefault(void);
  */
 void addPatientRecord(void);
 
+/*
+ * Function: admitPatient
+ * ----------------------
+ * Admits a patient from given details without prompting, recording them
+ * in "patients.dat", the indexes and the report totals. The record joins
+ * the next group commit of patients.dat.
+ *
+ * patientName: The patient's name
+ * patientAge: The patient's age in years
+ * patientDiagnosis: The diagnosis text
+ * roomNumber: A vacant room
+ * admitted: Receives the new patient record
+ * readmission: Receives the earlier stay the patient was matched to, with
+ *              previousPatientId 0 for a first stay
+ * commit: NULL to return once the record is durable, or storage with its
+ *         onCommit callback set to return at once and be called back when
+ *         it is; only used on ADMIT_SUCCESS
+ *
+ * Returns: ADMIT_SUCCESS, ADMIT_INVALID if a detail fails validation,
+ *          ADMIT_ROOM_TAKEN if the room is occupied, or ADMIT_FAILURE if
+ *          memory ran out
+ */
+int admitPatient(const char patientName[],
+                 int patientAge,
+                 const char patientDiagnosis[],
+                 int roomNumber,
+                 Patient *admitted,
+                 struct ReadmissionMatch *readmission,
+                 struct PendingAdmission *commit);
+
+/*
+ * Function: findActivePatient
+ * ---------------------------
+ * Copies an admitted patient's record.
+ *
+ * Returns: 1 if the patient is admitted, 0 otherwise
+ */
+int findActivePatient(int patientId, Patient *patient);
+
 /*
  * Function: viewPatientRecords
  * ----------------------------
- * Displays all patient records currently stored in the system.
+ * Displays all patient records currently stored in the system, optionally
+ * sorted by name, room or admission time. Records are shown a page at a
+ * time on screen or saved in full to patients_view.txt.
  */
 void viewPatientRecords(void);
 
@@ -57,6 +108,14 @@ void viewPatientRecords(void);
  */
 void searchPatientById(void);
 
+/*
+ * Function: searchPatientsByName
+ * ------------------------------
+ * Searches current patients by name, either by prefix or allowing a few
+ * misspelled letters, ignoring case. Results are shown a page at a time.
+ */
+void searchPatientsByName(void);
+
 /*
  * Function: dischargePatient
  * --------------------------
@@ -64,6 +123,35 @@ void searchPatientById(void);
  */
 void dischargePatient(void);
 
+/*
+ * Function: dischargePatientBatch
+ * -------------------------------
+ * Prompts for a list of patient IDs and, after one confirmation,
+ * discharges them all together.
+ */
+void dischargePatientBatch(void);
+
+/*
+ * Function: dischargePatientsById
+ * -------------------------------
+ * Discharges several patients at once with a single archive append and a
+ * single rewrite of "patients.dat". IDs that are not admitted are skipped.
+ *
+ * patientIds: The IDs to discharge, in any order
+ * count: The number of IDs
+ *
+ * Returns: The number of patients discharged
+ */
+int dischargePatientsById(const int patientIds[], int count);
+
+/*
+ * Function: transferPatient
+ * -------------------------
+ * Prompts for a patient and a vacant room and moves the patient there,
+ * logging the move to "transfers.dat".
+ */
+void transferPatient(void);
+
 /*
  * Function: backupPatientSystem
  * -----------------------------
@@ -74,10 +162,20 @@ void backupPatientSystem(void);
 /*
  * Function: restoreDataFromFile
  * -----------------------------
- * Restores patient records from a previously backed-up file.
+ * Restores patient records from a previously backed-up file. The store's
+ * checkpoint is used when it is up to date with the file, which avoids
+ * re-reading and re-indexing every patient.
  */
 void restoreDataFromFile(void);
 
+/*
+ * Function: checkpointPatientSystem
+ * ---------------------------------
+ * Writes a new checkpoint of the patient store (see store_checkpoint.h),
+ * so that the next start or restore does not replay a delta log.
+ */
+void checkpointPatientSystem(void);
+
 /*
  * Function: clearMemory
  * ---------------------
@@ -117,17 +215,86 @@ void displayDischargedPatientReport(int choice);
  */
 void displayRoomUsageReport(void);
 
+/*
+ * Function: exportAdmissionReport
+ * -------------------------------
+ * Streams the admission report for a timeframe as CSV or JSON rows.
+ *
+ * writer: Report writer with its sinks attached.
+ * format: EXPORT_FORMAT_CSV or EXPORT_FORMAT_JSON (see report_export.h).
+ * timeframe: Timeframe (1: Daily, 2: Weekly, 3: Monthly).
+ */
+void exportAdmissionReport(ReportWriter *writer, int format, int timeframe);
+
+/*
+ * Function: exportDischargeReport
+ * -------------------------------
+ * Streams the discharge report for a timeframe as CSV or JSON rows,
+ * reading the archive once without holding its records in memory.
+ */
+void exportDischargeReport(ReportWriter *writer, int format, int timeframe);
+
+/*
+ * Function: exportRoomUsageReport
+ * -------------------------------
+ * Writes the room usage counts as CSV or JSON rows.
+ */
+void exportRoomUsageReport(ReportWriter *writer, int format);
+
+/*
+ * Function: displayDiagnosisReport
+ * --------------------------------
+ * Displays a report of active and discharged patient counts per diagnosis.
+ */
+void displayDiagnosisReport(void);
+
+/*
+ * Function: displayReadmissionReport
+ * ----------------------------------
+ * Displays the 30-day readmission rate for each diagnosis and writes it
+ * to "readmission_report.txt".
+ */
+void displayReadmissionReport(void);
+
+/*
+ * Function: displayActivityReport
+ * -------------------------------
+ * Prompts for hourly, daily, weekly or monthly periods and how many to
+ * show, then displays the admissions and discharges in each of the most
+ * recent periods and writes them to "activity_report.txt".
+ */
+void displayActivityReport(void);
+
+/*
+ * Function: displayLengthOfStayReport
+ * -----------------------------------
+ * Displays the mean, median, 90th and 95th percentile and longest stay of
+ * discharged patients, with a histogram of stay lengths, overall and by
+ * diagnosis, room and month of discharge, and writes them to
+ * "length_of_stay_report.txt".
+ */
+void displayLengthOfStayReport(void);
+
+/*
+ * Function: searchPatientsByDiagnosis
+ * -----------------------------------
+ * Prompts for a diagnosis query (terms ANDed, OR for alternatives, trailing
+ * '*' for prefixes) and displays the matching current or discharged patients.
+ */
+void searchPatientsByDiagnosis(void);
+
 /*
  * Function: printFormattedReport
  * ------------------------------
- * Helper to print a patient report (admission/discharge) to console and file.
+ * Helper to format a patient admission report once for every sink of a
+ * report writer (e.g. console and file).
  *
- * file: Output file stream.
+ * writer: Report writer with its sinks attached.
  * header: Report title.
  * result: Total patient count for the report.
  * timeframe: Timeframe used for filtering patient details.
  */
-void printFormattedReport(FILE *file, const char *header, int result, int timeframe);
+void printFormattedReport(ReportWriter *writer, const char *header, int result, int timeframe);
 
 
 #endif // PATIENT_MANAGEMENT_H 
\ No newline at end of file
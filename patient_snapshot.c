@@ -0,0 +1,615 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the versioned patient snapshots.
+ *
+ *          A chunk is shared by every version that lists it and counts those
+ *          versions in its reference count. A chunk's slots are only ever
+ *          appended to, by the newest version, so older versions that list
+ *          fewer of its patients are not disturbed; removing or changing a
+ *          patient copies the chunk instead. snapshotLock only covers
+ *          swapping the current version and its reference count, so readers
+ *          and the writer never hold it for more than a few instructions.
+ */
+
+#include "patient_snapshot.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct
+{
+    atomic_int refCount; // Versions listing this chunk
+    int        filled;   // Slots written so far, read only by the writer
+    Patient    patients[SNAPSHOT_CHUNK_SIZE];
+} PatientChunk;
+
+typedef struct
+{
+    PatientChunk *chunk;
+    int           count;  // Patients of the chunk in this version
+    int           lastId; // ID of the last of them
+} ChunkEntry;
+
+struct PatientSnapshot
+{
+    int        refCount; // Guarded by snapshotLock
+    int        patientCount;
+    int        chunkCount;
+    int        sorted;   // IDs ascend through the whole version
+    ChunkEntry chunks[];
+};
+
+// The version new snapshots pin, NULL while there are no patients
+static PatientSnapshot *currentVersion = NULL;
+static pthread_mutex_t  snapshotLock   = PTHREAD_MUTEX_INITIALIZER;
+
+// Function prototypes for internal helper functions
+static PatientSnapshot *allocateVersion(int chunkCount);
+static void             publishVersion(PatientSnapshot *version);
+static void             freeVersion(PatientSnapshot *version);
+static PatientChunk    *copyChunk(const ChunkEntry *entry, const int removedIds[], int removedCount);
+static PatientSnapshot *packVersion(const PatientSnapshot *version);
+static int              findChunk(const PatientSnapshot *version, int patientId);
+static int              findSlot(const ChunkEntry *entry, int patientId);
+static int              isRemoved(int patientId, const int removedIds[], int removedCount);
+static int              compareIds(const void *a, const void *b);
+
+/*
+ * Adds a reference to the current version.
+ */
+PatientSnapshot *takePatientSnapshot(void)
+{
+    pthread_mutex_lock(&snapshotLock);
+
+    PatientSnapshot *snapshot = currentVersion;
+    if(snapshot != NULL)
+    {
+        snapshot->refCount++;
+    }
+
+    pthread_mutex_unlock(&snapshotLock);
+    return snapshot;
+}
+
+/*
+ * Drops a reference, freeing the version after the last one.
+ */
+void releasePatientSnapshot(PatientSnapshot *snapshot)
+{
+    if(snapshot == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&snapshotLock);
+    int unused = --snapshot->refCount == 0;
+    pthread_mutex_unlock(&snapshotLock);
+
+    if(unused)
+    {
+        freeVersion(snapshot);
+    }
+}
+
+/*
+ * Returns the number of patients in a snapshot.
+ */
+int getSnapshotPatientCount(const PatientSnapshot *snapshot)
+{
+    return snapshot != NULL ? snapshot->patientCount : 0;
+}
+
+/*
+ * Lists the patients chunk by chunk.
+ */
+void getSnapshotPatients(const PatientSnapshot *snapshot, const Patient *patients[])
+{
+    int position = 0;
+
+    for(int i = 0; snapshot != NULL && i < snapshot->chunkCount; i++)
+    {
+        for(int j = 0; j < snapshot->chunks[i].count; j++)
+        {
+            patients[position++] = &snapshot->chunks[i].chunk->patients[j];
+        }
+    }
+}
+
+/*
+ * Walks the chunks in order, as getSnapshotPatients does.
+ */
+void visitSnapshotPatients(const PatientSnapshot *snapshot, SnapshotVisitor visitor, void *context)
+{
+    for(int i = 0; snapshot != NULL && i < snapshot->chunkCount; i++)
+    {
+        for(int j = 0; j < snapshot->chunks[i].count; j++)
+        {
+            if(!visitor(&snapshot->chunks[i].chunk->patients[j], context))
+            {
+                return;
+            }
+        }
+    }
+}
+
+/*
+ * Finds the patient's chunk, then their slot in it.
+ */
+const Patient *findSnapshotPatient(const PatientSnapshot *snapshot, int patientId)
+{
+    if(snapshot == NULL)
+    {
+        return NULL;
+    }
+
+    int chunk = findChunk(snapshot, patientId);
+    if(chunk < 0)
+    {
+        return NULL;
+    }
+
+    return &snapshot->chunks[chunk].chunk->patients[findSlot(&snapshot->chunks[chunk], patientId)];
+}
+
+/*
+ * Copies the whole list into new, full chunks.
+ */
+int publishPatientList(const PatientNode *head)
+{
+    int patientCount = 0;
+    for(const PatientNode *current = head; current != NULL; current = current->nextNode)
+    {
+        patientCount++;
+    }
+
+    if(patientCount == 0)
+    {
+        publishVersion(NULL);
+        return SNAPSHOT_SUCCESS;
+    }
+
+    PatientSnapshot *version = allocateVersion((patientCount + SNAPSHOT_CHUNK_SIZE - 1) / SNAPSHOT_CHUNK_SIZE);
+    if(version == NULL)
+    {
+        return SNAPSHOT_FAILURE;
+    }
+    version->chunkCount = 0;
+
+    int                previousId = 0;
+    const PatientNode *current    = head;
+    while(current != NULL)
+    {
+        PatientChunk *chunk = malloc(sizeof(PatientChunk));
+        if(chunk == NULL)
+        {
+            freeVersion(version);
+            return SNAPSHOT_FAILURE;
+        }
+        atomic_init(&chunk->refCount, 1);
+        chunk->filled = 0;
+
+        for(; current != NULL && chunk->filled < SNAPSHOT_CHUNK_SIZE; current = current->nextNode)
+        {
+            if(version->patientCount > 0 && current->data.patientId <= previousId)
+            {
+                version->sorted = 0;
+            }
+            chunk->patients[chunk->filled++] = current->data;
+            previousId                       = current->data.patientId;
+            version->patientCount++;
+        }
+
+        ChunkEntry *entry = &version->chunks[version->chunkCount++];
+        entry->chunk      = chunk;
+        entry->count      = chunk->filled;
+        entry->lastId     = previousId;
+    }
+
+    publishVersion(version);
+    return SNAPSHOT_SUCCESS;
+}
+
+/*
+ * Shares every chunk of the current version, writing the patient into
+ * the last chunk's next free slot or into a new chunk.
+ */
+int publishAdmission(const Patient *patient)
+{
+    PatientSnapshot *old        = currentVersion;
+    int              oldChunks  = old != NULL ? old->chunkCount : 0;
+    ChunkEntry      *last       = oldChunks > 0 ? &old->chunks[oldChunks - 1] : NULL;
+    int              fitsInLast = last != NULL && last->count < SNAPSHOT_CHUNK_SIZE &&
+                                  last->count == last->chunk->filled;
+
+    PatientSnapshot *version = allocateVersion(fitsInLast ? oldChunks : oldChunks + 1);
+    if(version == NULL)
+    {
+        return SNAPSHOT_FAILURE;
+    }
+
+    if(oldChunks > 0)
+    {
+        memcpy(version->chunks, old->chunks, sizeof(ChunkEntry) * (size_t) oldChunks);
+        version->patientCount = old->patientCount;
+        version->sorted       = old->sorted && patient->patientId > last->lastId;
+    }
+    for(int i = 0; i < oldChunks; i++)
+    {
+        atomic_fetch_add(&version->chunks[i].chunk->refCount, 1);
+    }
+
+    ChunkEntry *entry;
+    if(fitsInLast)
+    {
+        entry = &version->chunks[oldChunks - 1];
+    }
+    else
+    {
+        PatientChunk *chunk = malloc(sizeof(PatientChunk));
+        if(chunk == NULL)
+        {
+            version->chunkCount = oldChunks;
+            freeVersion(version);
+            return SNAPSHOT_FAILURE;
+        }
+        atomic_init(&chunk->refCount, 1);
+        chunk->filled = 0;
+
+        entry        = &version->chunks[oldChunks];
+        entry->chunk = chunk;
+        entry->count = 0;
+    }
+
+    // No published version lists this slot yet, so readers never see it change
+    entry->chunk->patients[entry->count] = *patient;
+    entry->chunk->filled                 = entry->count + 1;
+    entry->count++;
+    entry->lastId = patient->patientId;
+    version->patientCount++;
+
+    publishVersion(version);
+    return SNAPSHOT_SUCCESS;
+}
+
+/*
+ * Marks the chunks that hold a removed patient, then builds a directory
+ * that shares the rest and holds trimmed copies of those. Neighbouring
+ * trimmed copies that fit in one chunk are merged, and a directory left
+ * more than twice as long as the patients need is packed into full chunks,
+ * so long-stay patients do not each keep a sparse chunk alive.
+ */
+int publishDischarges(const int patientIds[], int count)
+{
+    PatientSnapshot *old = currentVersion;
+    if(old == NULL || count <= 0)
+    {
+        return SNAPSHOT_SUCCESS;
+    }
+
+    char            *touched = calloc((size_t) old->chunkCount, 1);
+    PatientSnapshot *version = allocateVersion(old->chunkCount);
+    if(touched == NULL || version == NULL)
+    {
+        free(touched);
+        free(version);
+        return SNAPSHOT_FAILURE;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        int chunk = findChunk(old, patientIds[i]);
+        if(chunk >= 0)
+        {
+            touched[chunk] = 1;
+        }
+    }
+
+    version->chunkCount = 0;
+    version->sorted     = old->sorted;
+
+    int previousTrimmed = 0; // The last entry so far is a copy no version lists yet
+    for(int i = 0; i < old->chunkCount; i++)
+    {
+        ChunkEntry entry = old->chunks[i];
+
+        if(touched[i])
+        {
+            PatientChunk *trimmed = copyChunk(&entry, patientIds, count);
+            if(trimmed == NULL)
+            {
+                free(touched);
+                freeVersion(version);
+                return SNAPSHOT_FAILURE;
+            }
+            if(trimmed->filled == 0)
+            {
+                free(trimmed);
+                continue;
+            }
+
+            ChunkEntry *previous = previousTrimmed ? &version->chunks[version->chunkCount - 1] : NULL;
+            if(previous != NULL && previous->count + trimmed->filled <= SNAPSHOT_CHUNK_SIZE)
+            {
+                memcpy(&previous->chunk->patients[previous->count], trimmed->patients,
+                       sizeof(Patient) * (size_t) trimmed->filled);
+                previous->count        += trimmed->filled;
+                previous->chunk->filled = previous->count;
+                previous->lastId        = trimmed->patients[trimmed->filled - 1].patientId;
+                version->patientCount  += trimmed->filled;
+                free(trimmed);
+                continue;
+            }
+
+            entry.chunk  = trimmed;
+            entry.count  = trimmed->filled;
+            entry.lastId = trimmed->patients[trimmed->filled - 1].patientId;
+        }
+        else
+        {
+            atomic_fetch_add(&entry.chunk->refCount, 1);
+        }
+
+        version->chunks[version->chunkCount++] = entry;
+        version->patientCount += entry.count;
+        previousTrimmed        = touched[i];
+    }
+
+    free(touched);
+    if(version->patientCount == 0)
+    {
+        freeVersion(version);
+        version = NULL;
+    }
+    else if(version->chunkCount > 2 * ((version->patientCount + SNAPSHOT_CHUNK_SIZE - 1) / SNAPSHOT_CHUNK_SIZE))
+    {
+        // Staying unpacked only costs memory, so a failed pack is not an error
+        PatientSnapshot *packed = packVersion(version);
+        if(packed != NULL)
+        {
+            freeVersion(version);
+            version = packed;
+        }
+    }
+    publishVersion(version);
+
+    return SNAPSHOT_SUCCESS;
+}
+
+/*
+ * Shares every chunk but the patient's, which is copied with the new record.
+ */
+int publishPatientUpdate(const Patient *patient)
+{
+    PatientSnapshot *old   = currentVersion;
+    int              chunk = old != NULL ? findChunk(old, patient->patientId) : -1;
+    if(chunk < 0)
+    {
+        return SNAPSHOT_SUCCESS;
+    }
+
+    PatientSnapshot *version = allocateVersion(old->chunkCount);
+    PatientChunk    *copy    = copyChunk(&old->chunks[chunk], NULL, 0);
+    if(version == NULL || copy == NULL)
+    {
+        free(version);
+        free(copy);
+        return SNAPSHOT_FAILURE;
+    }
+
+    memcpy(version->chunks, old->chunks, sizeof(ChunkEntry) * (size_t) old->chunkCount);
+    version->patientCount = old->patientCount;
+    version->sorted       = old->sorted;
+
+    for(int i = 0; i < old->chunkCount; i++)
+    {
+        if(i != chunk)
+        {
+            atomic_fetch_add(&version->chunks[i].chunk->refCount, 1);
+        }
+    }
+
+    copy->patients[findSlot(&old->chunks[chunk], patient->patientId)] = *patient;
+    version->chunks[chunk].chunk                                       = copy;
+
+    publishVersion(version);
+    return SNAPSHOT_SUCCESS;
+}
+
+/*
+ * Unpublishes the current version.
+ */
+void clearPatientSnapshots(void)
+{
+    publishVersion(NULL);
+}
+
+/*
+ * Allocates an empty version with room for chunkCount directory entries.
+ */
+static PatientSnapshot *allocateVersion(int chunkCount)
+{
+    PatientSnapshot *version = malloc(sizeof(PatientSnapshot) + sizeof(ChunkEntry) * (size_t) chunkCount);
+    if(version == NULL)
+    {
+        return NULL;
+    }
+
+    version->refCount     = 1;
+    version->patientCount = 0;
+    version->chunkCount   = chunkCount;
+    version->sorted       = 1;
+    return version;
+}
+
+/*
+ * Makes a version current, dropping the publisher's reference to the one
+ * it replaces.
+ */
+static void publishVersion(PatientSnapshot *version)
+{
+    pthread_mutex_lock(&snapshotLock);
+    PatientSnapshot *old = currentVersion;
+    currentVersion       = version;
+    pthread_mutex_unlock(&snapshotLock);
+
+    releasePatientSnapshot(old);
+}
+
+/*
+ * Frees a version and every chunk no other version still lists.
+ */
+static void freeVersion(PatientSnapshot *version)
+{
+    for(int i = 0; i < version->chunkCount; i++)
+    {
+        if(atomic_fetch_sub(&version->chunks[i].chunk->refCount, 1) == 1)
+        {
+            free(version->chunks[i].chunk);
+        }
+    }
+    free(version);
+}
+
+/*
+ * Copies a chunk's patients in this version, leaving out removed IDs.
+ * The copy is listed by no version yet, with one reference for the caller.
+ */
+static PatientChunk *copyChunk(const ChunkEntry *entry, const int removedIds[], int removedCount)
+{
+    PatientChunk *copy = malloc(sizeof(PatientChunk));
+    if(copy == NULL)
+    {
+        return NULL;
+    }
+    atomic_init(&copy->refCount, 1);
+    copy->filled = 0;
+
+    for(int i = 0; i < entry->count; i++)
+    {
+        const Patient *patient = &entry->chunk->patients[i];
+        if(!isRemoved(patient->patientId, removedIds, removedCount))
+        {
+            copy->patients[copy->filled++] = *patient;
+        }
+    }
+
+    return copy;
+}
+
+/*
+ * Copies a version's patients, in order, into a new version of full
+ * chunks that no other version shares. Returns NULL if memory ran out.
+ */
+static PatientSnapshot *packVersion(const PatientSnapshot *version)
+{
+    PatientSnapshot *packed = allocateVersion((version->patientCount + SNAPSHOT_CHUNK_SIZE - 1) / SNAPSHOT_CHUNK_SIZE);
+    if(packed == NULL)
+    {
+        return NULL;
+    }
+    packed->chunkCount = 0;
+    packed->sorted     = version->sorted;
+
+    ChunkEntry *entry = NULL;
+    for(int i = 0; i < version->chunkCount; i++)
+    {
+        for(int j = 0; j < version->chunks[i].count; j++)
+        {
+            if(entry == NULL || entry->count == SNAPSHOT_CHUNK_SIZE)
+            {
+                PatientChunk *chunk = malloc(sizeof(PatientChunk));
+                if(chunk == NULL)
+                {
+                    freeVersion(packed);
+                    return NULL;
+                }
+                atomic_init(&chunk->refCount, 1);
+                chunk->filled = 0;
+
+                entry        = &packed->chunks[packed->chunkCount++];
+                entry->chunk = chunk;
+                entry->count = 0;
+            }
+
+            const Patient *patient                = &version->chunks[i].chunk->patients[j];
+            entry->chunk->patients[entry->count++] = *patient;
+            entry->chunk->filled                   = entry->count;
+            entry->lastId                          = patient->patientId;
+            packed->patientCount++;
+        }
+    }
+
+    return packed;
+}
+
+/*
+ * Returns the directory index of the chunk holding a patient, or -1.
+ * Sorted versions binary search the chunks' last IDs; others are scanned.
+ */
+static int findChunk(const PatientSnapshot *version, int patientId)
+{
+    if(!version->sorted)
+    {
+        for(int i = 0; i < version->chunkCount; i++)
+        {
+            if(findSlot(&version->chunks[i], patientId) >= 0)
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    int low  = 0;
+    int high = version->chunkCount;
+    while(low < high)
+    {
+        int middle = low + (high - low) / 2;
+        if(version->chunks[middle].lastId < patientId)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    return low < version->chunkCount && findSlot(&version->chunks[low], patientId) >= 0 ? low : -1;
+}
+
+/*
+ * Returns a patient's slot within a chunk, or -1.
+ */
+static int findSlot(const ChunkEntry *entry, int patientId)
+{
+    for(int i = 0; i < entry->count; i++)
+    {
+        if(entry->chunk->patients[i].patientId == patientId)
+        {
+            return i;
+        }
+    }
+    return -1;
+}
+
+/*
+ * Checks whether an ID is in the sorted removal list.
+ */
+static int isRemoved(int patientId, const int removedIds[], int removedCount)
+{
+    return removedCount > 0 &&
+           bsearch(&patientId, removedIds, (size_t) removedCount, sizeof(int), compareIds) != NULL;
+}
+
+/*
+ * qsort/bsearch comparator for patient IDs.
+ */
+static int compareIds(const void *a, const void *b)
+{
+    int left  = *(const int *) a;
+    int right = *(const int *) b;
+    return (left > right) - (left < right);
+}
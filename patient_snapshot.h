@@ -0,0 +1,140 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines versioned, read-only snapshots of the active
+ *          patients.
+ *
+ *          Each version is a directory of fixed-size chunks of patients in
+ *          list order. A change builds a new version that shares every chunk
+ *          it does not touch and copies only the chunks it does, so a reader
+ *          holding an older version keeps seeing it unchanged. Taking a
+ *          snapshot only adds a reference to the current version; a version,
+ *          and any chunk no other version shares, is freed when its last
+ *          reference is released.
+ *
+ *          Changes are published by the patient store while it holds its
+ *          exclusive lock, so there is a single writer.
+ */
+
+#ifndef PATIENT_SNAPSHOT_H
+#define PATIENT_SNAPSHOT_H
+
+#include "patient_management.h"
+
+#define SNAPSHOT_CHUNK_SIZE 256 // Patients per chunk
+
+#define SNAPSHOT_SUCCESS 1
+#define SNAPSHOT_FAILURE 0
+
+typedef struct PatientSnapshot PatientSnapshot;
+
+/*
+ * Callback invoked for each patient visited by visitSnapshotPatients.
+ * Returning 0 stops the visit early.
+ */
+typedef int (*SnapshotVisitor)(const Patient *patient, void *context);
+
+/*
+ * Function: takePatientSnapshot
+ * -----------------------------
+ * Pins the current version of the active patients. Costs the same however
+ * many patients there are, and never waits for a writer.
+ *
+ * Returns: The snapshot, to be passed to releasePatientSnapshot. NULL
+ *          stands for an empty store and is accepted by every function here.
+ */
+PatientSnapshot *takePatientSnapshot(void);
+
+/*
+ * Function: releasePatientSnapshot
+ * --------------------------------
+ * Drops a snapshot, freeing its version once no one else holds it.
+ */
+void releasePatientSnapshot(PatientSnapshot *snapshot);
+
+/*
+ * Function: getSnapshotPatientCount
+ * ---------------------------------
+ * Returns the number of patients in a snapshot.
+ */
+int getSnapshotPatientCount(const PatientSnapshot *snapshot);
+
+/*
+ * Function: getSnapshotPatients
+ * -----------------------------
+ * Fills an array with pointers to every patient in a snapshot, in list
+ * order. The pointers stay valid until the snapshot is released.
+ *
+ * patients: Receives getSnapshotPatientCount pointers
+ */
+void getSnapshotPatients(const PatientSnapshot *snapshot, const Patient *patients[]);
+
+/*
+ * Function: findSnapshotPatient
+ * -----------------------------
+ * Looks up a patient by ID in a snapshot.
+ *
+ * Returns: The patient, or NULL if they are not in the snapshot
+ */
+const Patient *findSnapshotPatient(const PatientSnapshot *snapshot, int patientId);
+
+/*
+ * Function: visitSnapshotPatients
+ * -------------------------------
+ * Visits every patient in a snapshot in list order, chunk by chunk, without
+ * collecting pointers to them first.
+ */
+void visitSnapshotPatients(const PatientSnapshot *snapshot, SnapshotVisitor visitor, void *context);
+
+/*
+ * Function: publishPatientList
+ * ----------------------------
+ * Replaces the current version with one built from the whole patient list.
+ * Used after loading or clearing the store.
+ *
+ * Returns: SNAPSHOT_SUCCESS, or SNAPSHOT_FAILURE if memory ran out
+ */
+int publishPatientList(const PatientNode *head);
+
+/*
+ * Function: publishAdmission
+ * --------------------------
+ * Publishes a version with a patient appended. The new patient goes into
+ * spare room in the last chunk when it has any, so admissions rarely copy
+ * a chunk.
+ *
+ * Returns: SNAPSHOT_SUCCESS, or SNAPSHOT_FAILURE if memory ran out
+ */
+int publishAdmission(const Patient *patient);
+
+/*
+ * Function: publishDischarges
+ * ---------------------------
+ * Publishes a version without the given patients, copying each chunk that
+ * loses a patient once.
+ *
+ * patientIds: The IDs to remove, sorted ascending
+ * count: The number of IDs
+ *
+ * Returns: SNAPSHOT_SUCCESS, or SNAPSHOT_FAILURE if memory ran out
+ */
+int publishDischarges(const int patientIds[], int count);
+
+/*
+ * Function: publishPatientUpdate
+ * ------------------------------
+ * Publishes a version with one patient's record replaced, matched by ID.
+ *
+ * Returns: SNAPSHOT_SUCCESS, or SNAPSHOT_FAILURE if memory ran out
+ */
+int publishPatientUpdate(const Patient *patient);
+
+/*
+ * Function: clearPatientSnapshots
+ * -------------------------------
+ * Drops the current version. Snapshots still held stay valid until
+ * released.
+ */
+void clearPatientSnapshots(void);
+
+#endif // PATIENT_SNAPSHOT_H
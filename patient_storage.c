@@ -0,0 +1,409 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the compact record encoding and the
+ *          buffered readers and writers for patient data files.
+ */
+
+#define _GNU_SOURCE // strnlen
+
+#include "patient_storage.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "durable_file.h"
+
+// Private constants
+#define MAGIC_LENGTH 4
+#define MAX_VARINT_BYTES 10
+#define STREAM_BUFFER_SIZE 65536
+
+// Function prototypes for internal helper functions
+static unsigned long long zigzagEncode(long long value);
+static long long          zigzagDecode(unsigned long long value);
+static int                readRecordPayload(FILE *file, unsigned char payload[], size_t *payloadLength);
+
+/*
+ * Writes an unsigned value as a base-128 varint, low bits first.
+ */
+size_t encodeVarint(unsigned long long value, unsigned char buffer[])
+{
+    size_t length = 0;
+
+    while(value >= 0x80)
+    {
+        buffer[length++] = (unsigned char) (value | 0x80);
+        value >>= 7;
+    }
+    buffer[length++] = (unsigned char) value;
+
+    return length;
+}
+
+/*
+ * Reads a base-128 varint and advances the position past it.
+ */
+int decodeVarint(const unsigned char buffer[], size_t length, size_t *position, unsigned long long *value)
+{
+    unsigned long long result = 0;
+    int                shift  = 0;
+
+    for(int i = 0; i < MAX_VARINT_BYTES && *position < length; i++)
+    {
+        unsigned char byte = buffer[(*position)++];
+        result |= (unsigned long long) (byte & 0x7F) << shift;
+
+        if((byte & 0x80) == 0)
+        {
+            *value = result;
+            return STORAGE_SUCCESS;
+        }
+        shift += 7;
+    }
+
+    return STORAGE_FAILURE;
+}
+
+/*
+ * Encodes a patient as a length-prefixed record.
+ */
+size_t encodePatientRecord(const RecordFileHeader *header,
+                           const Patient *patient,
+                           int includeDischarge,
+                           time_t dischargeDate,
+                           unsigned char buffer[])
+{
+    unsigned char payload[MAX_ENCODED_RECORD_SIZE];
+    size_t        length     = 0;
+    size_t        nameLength = strnlen(patient->name, MAX_PATIENT_NAME_LENGTH - 1);
+
+    length += encodeVarint(zigzagEncode((long long) patient->patientId - header->baseId), payload + length);
+
+    payload[length++] = (unsigned char) nameLength;
+    memcpy(payload + length, patient->name, nameLength);
+    length += nameLength;
+
+    length += encodeVarint((unsigned int) patient->ageInYears, payload + length);
+    length += encodeVarint((unsigned int) patient->diagnosisId, payload + length);
+    length += encodeVarint((unsigned int) patient->roomNumber, payload + length);
+    length += encodeVarint(zigzagEncode((long long) patient->admissionDate - header->baseTime), payload + length);
+
+    if(includeDischarge)
+    {
+        length += encodeVarint(zigzagEncode((long long) dischargeDate - patient->admissionDate), payload + length);
+    }
+
+    size_t prefixLength = encodeVarint(length, buffer);
+    memcpy(buffer + prefixLength, payload, length);
+
+    return prefixLength + length;
+}
+
+/*
+ * Decodes one record payload into a patient.
+ */
+int decodePatientRecord(const RecordFileHeader *header,
+                        const unsigned char payload[],
+                        size_t payloadLength,
+                        int includeDischarge,
+                        Patient *patient,
+                        time_t *dischargeDate)
+{
+    size_t             position = 0;
+    unsigned long long value;
+
+    memset(patient, 0, sizeof(Patient));
+
+    if(!decodeVarint(payload, payloadLength, &position, &value))
+    {
+        return STORAGE_FAILURE;
+    }
+    patient->patientId = (int) (header->baseId + zigzagDecode(value));
+
+    if(position >= payloadLength)
+    {
+        return STORAGE_FAILURE;
+    }
+    size_t nameLength = payload[position++];
+    if(nameLength >= MAX_PATIENT_NAME_LENGTH || position + nameLength > payloadLength)
+    {
+        return STORAGE_FAILURE;
+    }
+    memcpy(patient->name, payload + position, nameLength);
+    patient->name[nameLength] = '\0';
+    position += nameLength;
+
+    if(!decodeVarint(payload, payloadLength, &position, &value))
+    {
+        return STORAGE_FAILURE;
+    }
+    patient->ageInYears = (int) value;
+
+    if(!decodeVarint(payload, payloadLength, &position, &value))
+    {
+        return STORAGE_FAILURE;
+    }
+    patient->diagnosisId = (int) value;
+
+    if(!decodeVarint(payload, payloadLength, &position, &value))
+    {
+        return STORAGE_FAILURE;
+    }
+    patient->roomNumber = (int) value;
+
+    if(!decodeVarint(payload, payloadLength, &position, &value))
+    {
+        return STORAGE_FAILURE;
+    }
+    patient->admissionDate = (time_t) (header->baseTime + zigzagDecode(value));
+
+    if(includeDischarge)
+    {
+        if(!decodeVarint(payload, payloadLength, &position, &value))
+        {
+            return STORAGE_FAILURE;
+        }
+        *dischargeDate = (time_t) (patient->admissionDate + zigzagDecode(value));
+    }
+
+    return STORAGE_SUCCESS;
+}
+
+/*
+ * Opens a record file and validates its header.
+ */
+int openRecordReader(RecordReader *reader, const char fileName[], const char magic[])
+{
+    reader->file = fopen(fileName, "rb");
+    if(reader->file == NULL)
+    {
+        return STORAGE_FAILURE;
+    }
+
+    setvbuf(reader->file, NULL, _IOFBF, STREAM_BUFFER_SIZE);
+
+    if(!readRecordFileHeader(reader->file, magic, &reader->header))
+    {
+        fclose(reader->file);
+        reader->file = NULL;
+        return STORAGE_FAILURE;
+    }
+
+    return STORAGE_SUCCESS;
+}
+
+/*
+ * Reads the next active patient record.
+ */
+int readPatientRecord(RecordReader *reader, Patient *patient)
+{
+    unsigned char payload[MAX_ENCODED_RECORD_SIZE];
+    size_t        payloadLength;
+
+    if(!readRecordPayload(reader->file, payload, &payloadLength))
+    {
+        return STORAGE_FAILURE;
+    }
+
+    return decodePatientRecord(&reader->header, payload, payloadLength, 0, patient, NULL);
+}
+
+/*
+ * Closes a record reader.
+ */
+void closeRecordReader(RecordReader *reader)
+{
+    if(reader->file != NULL)
+    {
+        fclose(reader->file);
+        reader->file = NULL;
+    }
+}
+
+/*
+ * Opens a record file for appending, writing a new header when needed.
+ */
+int openRecordWriter(RecordWriter *writer,
+                     const char fileName[],
+                     const char magic[],
+                     int truncate,
+                     int baseId)
+{
+    writer->file = fopen(fileName, truncate ? "wb" : "ab+");
+    if(writer->file == NULL)
+    {
+        return STORAGE_FAILURE;
+    }
+
+    setvbuf(writer->file, NULL, _IOFBF, STREAM_BUFFER_SIZE);
+
+    // Existing files keep their header so earlier records still decode
+    if(!truncate)
+    {
+        fseek(writer->file, 0, SEEK_END);
+        if(ftell(writer->file) > 0)
+        {
+            rewind(writer->file);
+            if(!readRecordFileHeader(writer->file, magic, &writer->header))
+            {
+                fprintf(stderr, "Error: %s is not in the expected format.\n", fileName);
+                fclose(writer->file);
+                writer->file = NULL;
+                return STORAGE_FAILURE;
+            }
+            fseek(writer->file, 0, SEEK_END);
+            return STORAGE_SUCCESS;
+        }
+    }
+
+    writer->header.baseId   = baseId;
+    writer->header.baseTime = time(NULL);
+
+    if(!writeRecordFileHeader(writer->file, magic, &writer->header))
+    {
+        fclose(writer->file);
+        writer->file = NULL;
+        return STORAGE_FAILURE;
+    }
+
+    return STORAGE_SUCCESS;
+}
+
+/*
+ * Appends an active patient record.
+ */
+int writePatientRecord(RecordWriter *writer, const Patient *patient)
+{
+    unsigned char buffer[MAX_ENCODED_RECORD_SIZE + MAX_VARINT_BYTES];
+    size_t        length = encodePatientRecord(&writer->header, patient, 0, 0, buffer);
+
+    return fwrite(buffer, 1, length, writer->file) == length ? STORAGE_SUCCESS : STORAGE_FAILURE;
+}
+
+/*
+ * Flushes the stream, then syncs the file's data to disk.
+ */
+int syncRecordWriter(RecordWriter *writer, const char fileName[])
+{
+    return fflush(writer->file) == 0 && syncFile(fileno(writer->file), fileName) ? STORAGE_SUCCESS : STORAGE_FAILURE;
+}
+
+/*
+ * Flushes and closes a record writer.
+ */
+int closeRecordWriter(RecordWriter *writer)
+{
+    int result = fclose(writer->file) == 0 ? STORAGE_SUCCESS : STORAGE_FAILURE;
+    writer->file = NULL;
+    return result;
+}
+
+/*
+ * Maps signed values to unsigned so small negatives stay short as varints.
+ */
+static unsigned long long zigzagEncode(long long value)
+{
+    return ((unsigned long long) value << 1) ^ (unsigned long long) (value >> 63);
+}
+
+/*
+ * Reverses zigzagEncode.
+ */
+static long long zigzagDecode(unsigned long long value)
+{
+    return (long long) (value >> 1) ^ -(long long) (value & 1);
+}
+
+/*
+ * Stores a value in the given number of little-endian bytes.
+ */
+void storeLittleEndian(unsigned char buffer[], unsigned long long value, int byteCount)
+{
+    for(int i = 0; i < byteCount; i++)
+    {
+        buffer[i] = (unsigned char) (value >> (8 * i));
+    }
+}
+
+/*
+ * Loads a value from the given number of little-endian bytes.
+ */
+unsigned long long loadLittleEndian(const unsigned char buffer[], int byteCount)
+{
+    unsigned long long value = 0;
+
+    for(int i = 0; i < byteCount; i++)
+    {
+        value |= (unsigned long long) buffer[i] << (8 * i);
+    }
+
+    return value;
+}
+
+/*
+ * Reads and validates a file header.
+ * Layout: magic[4], version[1], baseId[4], baseTime[8], all little-endian.
+ */
+int readRecordFileHeader(FILE *file, const char magic[], RecordFileHeader *header)
+{
+    unsigned char bytes[RECORD_HEADER_SIZE];
+
+    if(fread(bytes, 1, RECORD_HEADER_SIZE, file) != RECORD_HEADER_SIZE ||
+       memcmp(bytes, magic, MAGIC_LENGTH) != 0 ||
+       bytes[MAGIC_LENGTH] != RECORD_FILE_VERSION)
+    {
+        return STORAGE_FAILURE;
+    }
+
+    header->baseId   = (int) (unsigned int) loadLittleEndian(bytes + 5, 4);
+    header->baseTime = (time_t) (long long) loadLittleEndian(bytes + 9, 8);
+
+    return STORAGE_SUCCESS;
+}
+
+/*
+ * Writes a file header.
+ */
+int writeRecordFileHeader(FILE *file, const char magic[], const RecordFileHeader *header)
+{
+    unsigned char bytes[RECORD_HEADER_SIZE];
+
+    memcpy(bytes, magic, MAGIC_LENGTH);
+    bytes[MAGIC_LENGTH] = RECORD_FILE_VERSION;
+    storeLittleEndian(bytes + 5, (unsigned int) header->baseId, 4);
+    storeLittleEndian(bytes + 9, (unsigned long long) (long long) header->baseTime, 8);
+
+    return fwrite(bytes, 1, RECORD_HEADER_SIZE, file) == RECORD_HEADER_SIZE ? STORAGE_SUCCESS : STORAGE_FAILURE;
+}
+
+/*
+ * Reads a varint length prefix and the payload that follows it.
+ */
+static int readRecordPayload(FILE *file, unsigned char payload[], size_t *payloadLength)
+{
+    unsigned long long length = 0;
+    int                shift  = 0;
+    int                byte;
+
+    do
+    {
+        byte = getc(file);
+        if(byte == EOF || shift >= 7 * MAX_VARINT_BYTES)
+        {
+            return STORAGE_FAILURE;
+        }
+        length |= (unsigned long long) (byte & 0x7F) << shift;
+        shift += 7;
+    }
+    while(byte & 0x80);
+
+    if(length > MAX_ENCODED_RECORD_SIZE ||
+       fread(payload, 1, (size_t) length, file) != (size_t) length)
+    {
+        return STORAGE_FAILURE;
+    }
+
+    *payloadLength = (size_t) length;
+    return STORAGE_SUCCESS;
+}
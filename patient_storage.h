@@ -0,0 +1,217 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the compact on-disk record encoding used for
+ *          patients.dat and the discharge archive, along with buffered
+ *          readers and writers for patients.dat.
+ *
+ *          Every file starts with a small header holding a magic tag, a
+ *          format version, and a base patient ID and timestamp. Each record
+ *          is a varint payload length followed by the payload:
+ *
+ *            zigzag varint  patientId - baseId
+ *            byte + bytes   name length and name (no terminator)
+ *            varint         ageInYears
+ *            varint         diagnosisId
+ *            varint         roomNumber
+ *            zigzag varint  admissionDate - baseTime
+ *            zigzag varint  dischargeDate - admissionDate (discharge archive only)
+ *
+ *          IDs and timestamps are delta-encoded against the header rather
+ *          than the previous record so records can be appended without
+ *          reading the file first.
+ */
+
+#ifndef PATIENT_STORAGE_H
+#define PATIENT_STORAGE_H
+
+#include <stdio.h>
+#include <time.h>
+#include "patient_management.h"
+
+#define PATIENT_FILE_MAGIC "HMSP"
+
+#define RECORD_FILE_VERSION 1
+#define RECORD_HEADER_SIZE 17
+#define MAX_ENCODED_RECORD_SIZE 192
+
+#define STORAGE_SUCCESS 1
+#define STORAGE_FAILURE 0
+
+/*
+ * Base values every record in a file is delta-encoded against.
+ */
+typedef struct
+{
+    int    baseId;
+    time_t baseTime;
+} RecordFileHeader;
+
+/*
+ * Sequential reader over a compact record file.
+ */
+typedef struct
+{
+    FILE            *file;
+    RecordFileHeader header;
+} RecordReader;
+
+/*
+ * Appending writer over a compact record file.
+ */
+typedef struct
+{
+    FILE            *file;
+    RecordFileHeader header;
+} RecordWriter;
+
+/*
+ * Function: storeLittleEndian
+ * ---------------------------
+ * Stores the low byteCount bytes of value in little-endian order.
+ */
+void storeLittleEndian(unsigned char buffer[], unsigned long long value, int byteCount);
+
+/*
+ * Function: loadLittleEndian
+ * --------------------------
+ * Loads byteCount little-endian bytes as an unsigned value.
+ */
+unsigned long long loadLittleEndian(const unsigned char buffer[], int byteCount);
+
+/*
+ * Function: encodeVarint
+ * ----------------------
+ * Writes an unsigned value as a little-endian base-128 varint.
+ *
+ * Returns: The number of bytes written (at most 10)
+ */
+size_t encodeVarint(unsigned long long value, unsigned char buffer[]);
+
+/*
+ * Function: decodeVarint
+ * ----------------------
+ * Reads a varint starting at *position, advancing *position past it.
+ *
+ * Returns: STORAGE_SUCCESS, or STORAGE_FAILURE if the varint runs past length
+ */
+int decodeVarint(const unsigned char buffer[], size_t length, size_t *position, unsigned long long *value);
+
+/*
+ * Function: encodePatientRecord
+ * -----------------------------
+ * Encodes a patient as a length-prefixed record into buffer, which must
+ * hold at least MAX_ENCODED_RECORD_SIZE bytes. dischargeDate is only
+ * written when includeDischarge is non-zero.
+ *
+ * Returns: The number of bytes written
+ */
+size_t encodePatientRecord(const RecordFileHeader *header,
+                           const Patient *patient,
+                           int includeDischarge,
+                           time_t dischargeDate,
+                           unsigned char buffer[]);
+
+/*
+ * Function: decodePatientRecord
+ * -----------------------------
+ * Decodes one record payload (without its length prefix).
+ *
+ * Returns: STORAGE_SUCCESS, or STORAGE_FAILURE if the payload is malformed
+ */
+int decodePatientRecord(const RecordFileHeader *header,
+                        const unsigned char payload[],
+                        size_t payloadLength,
+                        int includeDischarge,
+                        Patient *patient,
+                        time_t *dischargeDate);
+
+/*
+ * Function: readRecordFileHeader
+ * ------------------------------
+ * Reads a RECORD_HEADER_SIZE file header and checks its magic and version.
+ *
+ * Returns: STORAGE_SUCCESS, or STORAGE_FAILURE if the header does not match
+ */
+int readRecordFileHeader(FILE *file, const char magic[], RecordFileHeader *header);
+
+/*
+ * Function: writeRecordFileHeader
+ * -------------------------------
+ * Writes a RECORD_HEADER_SIZE file header at the current position.
+ *
+ * Returns: STORAGE_SUCCESS, or STORAGE_FAILURE on error
+ */
+int writeRecordFileHeader(FILE *file, const char magic[], const RecordFileHeader *header);
+
+/*
+ * Function: openRecordReader
+ * --------------------------
+ * Opens a record file for reading and validates its header.
+ *
+ * Returns: STORAGE_SUCCESS, or STORAGE_FAILURE if the file is missing,
+ *          empty, or not in the expected format
+ */
+int openRecordReader(RecordReader *reader, const char fileName[], const char magic[]);
+
+/*
+ * Function: readPatientRecord
+ * ---------------------------
+ * Reads the next record of a patients.dat reader.
+ *
+ * Returns: STORAGE_SUCCESS, or STORAGE_FAILURE at end of file or on error
+ */
+int readPatientRecord(RecordReader *reader, Patient *patient);
+
+/*
+ * Function: closeRecordReader
+ * ---------------------------
+ * Closes a record reader.
+ */
+void closeRecordReader(RecordReader *reader);
+
+/*
+ * Function: openRecordWriter
+ * --------------------------
+ * Opens a record file for writing. When truncate is non-zero, or the file
+ * is new or empty, a fresh header is written using baseId and the current
+ * time. Otherwise records are appended against the existing header.
+ *
+ * Returns: STORAGE_SUCCESS, or STORAGE_FAILURE on error
+ */
+int openRecordWriter(RecordWriter *writer,
+                     const char fileName[],
+                     const char magic[],
+                     int truncate,
+                     int baseId);
+
+/*
+ * Function: writePatientRecord
+ * ----------------------------
+ * Appends an active patient record.
+ *
+ * Returns: STORAGE_SUCCESS, or STORAGE_FAILURE on error
+ */
+int writePatientRecord(RecordWriter *writer, const Patient *patient);
+
+/*
+ * Function: syncRecordWriter
+ * --------------------------
+ * Flushes a record writer and, as fileName's durability level asks (see
+ * durable_file.h), waits until its data is on disk.
+ *
+ * Returns: STORAGE_SUCCESS, or STORAGE_FAILURE on error
+ */
+int syncRecordWriter(RecordWriter *writer, const char fileName[]);
+
+/*
+ * Function: closeRecordWriter
+ * ---------------------------
+ * Flushes and closes a record writer.
+ *
+ * Returns: STORAGE_SUCCESS, or STORAGE_FAILURE if buffered data could not
+ *          be written
+ */
+int closeRecordWriter(RecordWriter *writer);
+
+#endif // PATIENT_STORAGE_H
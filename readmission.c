@@ -0,0 +1,361 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the readmission engine.
+ *
+ *          Each distinct folded name owns a list of its completed stays in
+ *          discharge order, found through an open-addressing hash table.
+ *          Matching walks the list from the newest stay, so the usual case
+ *          of a name with one or two earlier stays takes a few comparisons.
+ */
+
+#include "readmission.h"
+#include <stdlib.h>
+#include <string.h>
+#include "discharge_archive.h"
+#include "name_index.h"
+#include "patient_data.h"
+
+// Private constants
+#define INITIAL_BUCKETS 1024u
+#define INITIAL_STAYS 2
+#define INITIAL_DIAGNOSES 64
+#define SECONDS_PER_DAY 86400
+#define SECONDS_PER_YEAR 31557600 // 365.25 days
+
+/*
+ * One completed stay.
+ */
+typedef struct
+{
+    int    patientId;
+    int    ageInYears;
+    int    diagnosisId;
+    int    readmitted; // Already counted as followed by a readmission
+    time_t admissionDate;
+    time_t dischargeDate;
+} Stay;
+
+/*
+ * The stays recorded under one folded name. An empty bucket has no name.
+ */
+typedef struct
+{
+    char        *name;
+    unsigned int hash;
+    Stay        *stays;
+    int          count;
+    int          capacity;
+} NameStays;
+
+// Engine data
+static NameStays   *buckets           = NULL;
+static unsigned int bucketCapacity    = 0;
+static unsigned int bucketCount       = 0;
+static int         *dischargeCounts   = NULL; // Indexed by diagnosis ID
+static int         *readmissionCounts = NULL;
+static int          diagnosisCapacity = 0;
+
+// Function prototypes for internal helper functions
+static int          loadArchivedStay(const DischargedPatient *dischargedPatient, void *context);
+static NameStays   *findNameStays(const char folded[], unsigned int hash);
+static NameStays   *addNameStays(const char folded[], unsigned int hash);
+static int          growBuckets(void);
+static int          ensureDiagnosisCapacity(int diagnosisId);
+static int          isPlausibleAge(const Stay *stay, const Patient *patient);
+static unsigned int hashName(const char folded[]);
+
+/*
+ * Rebuilds the stays from the archive.
+ */
+void initializeReadmissionIndex(void)
+{
+    clearReadmissionIndex();
+    scanDischargeArchive(ARCHIVE_BEGINNING_OF_TIME, ARCHIVE_END_OF_TIME, loadArchivedStay, NULL);
+}
+
+/*
+ * Walks the name's stays from the newest, taking the first one that ended
+ * before this admission and fits the patient's age.
+ */
+int matchReadmission(const Patient *patient, ReadmissionMatch *match)
+{
+    char folded[MAX_PATIENT_NAME_LENGTH];
+
+    foldPatientName(patient->name, folded);
+
+    NameStays *entry = findNameStays(folded, hashName(folded));
+    if(entry == NULL)
+    {
+        return READMISSION_NOT_FOUND;
+    }
+
+    for(int i = entry->count - 1; i >= 0; i--)
+    {
+        Stay *stay = &entry->stays[i];
+
+        if(stay->patientId == patient->patientId || stay->dischargeDate > patient->admissionDate ||
+           !isPlausibleAge(stay, patient))
+        {
+            continue;
+        }
+
+        match->previousPatientId     = stay->patientId;
+        match->previousDiagnosisId   = stay->diagnosisId;
+        match->previousDischargeDate = stay->dischargeDate;
+        match->daysSinceDischarge    = (int) ((patient->admissionDate - stay->dischargeDate) / SECONDS_PER_DAY);
+        match->withinWindow          = patient->admissionDate - stay->dischargeDate <=
+                                       (time_t) READMISSION_WINDOW_DAYS * SECONDS_PER_DAY;
+
+        if(match->withinWindow && !stay->readmitted && ensureDiagnosisCapacity(stay->diagnosisId))
+        {
+            stay->readmitted = 1;
+            readmissionCounts[stay->diagnosisId]++;
+        }
+
+        return READMISSION_FOUND;
+    }
+
+    return READMISSION_NOT_FOUND;
+}
+
+/*
+ * Appends a completed stay under its folded name.
+ */
+void addDischargeToReadmissionIndex(const DischargedPatient *dischargedPatient)
+{
+    const Patient *patient = &dischargedPatient->patient;
+    char           folded[MAX_PATIENT_NAME_LENGTH];
+
+    foldPatientName(patient->name, folded);
+
+    unsigned int hash  = hashName(folded);
+    NameStays   *entry = findNameStays(folded, hash);
+    if(entry == NULL)
+    {
+        entry = addNameStays(folded, hash);
+    }
+    if(entry == NULL || !ensureDiagnosisCapacity(patient->diagnosisId))
+    {
+        return;
+    }
+
+    if(entry->count == entry->capacity)
+    {
+        int   newCapacity = entry->capacity == 0 ? INITIAL_STAYS : entry->capacity * 2;
+        Stay *grown       = realloc(entry->stays, sizeof(Stay) * (size_t) newCapacity);
+        if(grown == NULL)
+        {
+            return;
+        }
+        entry->stays    = grown;
+        entry->capacity = newCapacity;
+    }
+
+    Stay *stay          = &entry->stays[entry->count++];
+    stay->patientId     = patient->patientId;
+    stay->ageInYears    = patient->ageInYears;
+    stay->diagnosisId   = patient->diagnosisId;
+    stay->readmitted    = 0;
+    stay->admissionDate = patient->admissionDate;
+    stay->dischargeDate = dischargedPatient->dischargeDate;
+
+    dischargeCounts[patient->diagnosisId]++;
+}
+
+/*
+ * Returns the discharge and readmission counts for a diagnosis.
+ */
+void getReadmissionTotals(int diagnosisId, int *discharges, int *readmissions)
+{
+    int known = diagnosisId >= 0 && diagnosisId < diagnosisCapacity;
+
+    *discharges   = known ? dischargeCounts[diagnosisId] : 0;
+    *readmissions = known ? readmissionCounts[diagnosisId] : 0;
+}
+
+/*
+ * Frees every name, stay list and counter.
+ */
+void clearReadmissionIndex(void)
+{
+    for(unsigned int i = 0; i < bucketCapacity; i++)
+    {
+        free(buckets[i].name);
+        free(buckets[i].stays);
+    }
+    free(buckets);
+    free(dischargeCounts);
+    free(readmissionCounts);
+
+    buckets           = NULL;
+    bucketCapacity    = 0;
+    bucketCount       = 0;
+    dischargeCounts   = NULL;
+    readmissionCounts = NULL;
+    diagnosisCapacity = 0;
+}
+
+/*
+ * Archive scan callback. Records arrive in discharge order, so every stay
+ * that could precede this one is already loaded.
+ */
+static int loadArchivedStay(const DischargedPatient *dischargedPatient, void *context)
+{
+    ReadmissionMatch match;
+
+    (void) context;
+
+    matchReadmission(&dischargedPatient->patient, &match);
+    addDischargeToReadmissionIndex(dischargedPatient);
+    return 1;
+}
+
+/*
+ * Finds the bucket for a folded name, or NULL if the name has no stays.
+ */
+static NameStays *findNameStays(const char folded[], unsigned int hash)
+{
+    if(bucketCapacity == 0)
+    {
+        return NULL;
+    }
+
+    for(unsigned int i = hash & (bucketCapacity - 1); buckets[i].name != NULL; i = (i + 1) & (bucketCapacity - 1))
+    {
+        if(buckets[i].hash == hash && strcmp(buckets[i].name, folded) == 0)
+        {
+            return &buckets[i];
+        }
+    }
+
+    return NULL;
+}
+
+/*
+ * Claims an empty bucket for a new folded name, growing the table first
+ * if it would become more than half full.
+ */
+static NameStays *addNameStays(const char folded[], unsigned int hash)
+{
+    if((bucketCount + 1) * 2 > bucketCapacity && !growBuckets())
+    {
+        return NULL;
+    }
+
+    unsigned int i = hash & (bucketCapacity - 1);
+    while(buckets[i].name != NULL)
+    {
+        i = (i + 1) & (bucketCapacity - 1);
+    }
+
+    buckets[i].name = malloc(strlen(folded) + 1);
+    if(buckets[i].name == NULL)
+    {
+        return NULL;
+    }
+    strcpy(buckets[i].name, folded);
+    buckets[i].hash = hash;
+    bucketCount++;
+
+    return &buckets[i];
+}
+
+/*
+ * Doubles the hash table, moving every bucket to its new slot.
+ */
+static int growBuckets(void)
+{
+    unsigned int newCapacity = bucketCapacity == 0 ? INITIAL_BUCKETS : bucketCapacity * 2;
+    NameStays   *grown       = calloc(newCapacity, sizeof(NameStays));
+    if(grown == NULL)
+    {
+        return 0;
+    }
+
+    for(unsigned int i = 0; i < bucketCapacity; i++)
+    {
+        if(buckets[i].name != NULL)
+        {
+            unsigned int j = buckets[i].hash & (newCapacity - 1);
+            while(grown[j].name != NULL)
+            {
+                j = (j + 1) & (newCapacity - 1);
+            }
+            grown[j] = buckets[i];
+        }
+    }
+
+    free(buckets);
+    buckets        = grown;
+    bucketCapacity = newCapacity;
+    return 1;
+}
+
+/*
+ * Grows the per-diagnosis counters to cover a diagnosis ID.
+ */
+static int ensureDiagnosisCapacity(int diagnosisId)
+{
+    if(diagnosisId < 0)
+    {
+        return 0;
+    }
+    if(diagnosisId < diagnosisCapacity)
+    {
+        return 1;
+    }
+
+    int newCapacity = diagnosisCapacity == 0 ? INITIAL_DIAGNOSES : diagnosisCapacity;
+    while(newCapacity <= diagnosisId)
+    {
+        newCapacity *= 2;
+    }
+
+    int *grownDischarges   = realloc(dischargeCounts, sizeof(int) * (size_t) newCapacity);
+    if(grownDischarges == NULL)
+    {
+        return 0;
+    }
+    dischargeCounts = grownDischarges;
+
+    int *grownReadmissions = realloc(readmissionCounts, sizeof(int) * (size_t) newCapacity);
+    if(grownReadmissions == NULL)
+    {
+        return 0;
+    }
+    readmissionCounts = grownReadmissions;
+
+    memset(dischargeCounts + diagnosisCapacity, 0, sizeof(int) * (size_t) (newCapacity - diagnosisCapacity));
+    memset(readmissionCounts + diagnosisCapacity, 0, sizeof(int) * (size_t) (newCapacity - diagnosisCapacity));
+    diagnosisCapacity = newCapacity;
+
+    return 1;
+}
+
+/*
+ * Checks that the patient's age fits the earlier stay: no younger, and
+ * older by no more than the whole years since that admission plus one.
+ */
+static int isPlausibleAge(const Stay *stay, const Patient *patient)
+{
+    long yearsElapsed = (long) ((patient->admissionDate - stay->admissionDate) / SECONDS_PER_YEAR);
+
+    return patient->ageInYears >= stay->ageInYears &&
+           patient->ageInYears <= stay->ageInYears + yearsElapsed + 1;
+}
+
+/*
+ * FNV-1a hash of a folded name.
+ */
+static unsigned int hashName(const char folded[])
+{
+    unsigned int hash = 2166136261u;
+
+    for(const unsigned char *p = (const unsigned char *) folded; *p != '\0'; p++)
+    {
+        hash = (hash ^ *p) * 16777619u;
+    }
+
+    return hash;
+}
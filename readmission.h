@@ -0,0 +1,81 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the readmission engine, which matches new
+ *          admissions against discharge history and keeps 30-day
+ *          readmission rates by diagnosis.
+ *
+ *          A returning patient gets a new patient ID, so stays are matched
+ *          by folded name (see foldPatientName) and an age consistent with
+ *          the time since the earlier stay. Stays are held in a hash table
+ *          keyed by folded name, so a check costs one lookup and a walk over
+ *          that name's few stays, however large the archive grows.
+ */
+
+#ifndef READMISSION_H
+#define READMISSION_H
+
+#include <time.h>
+#include "patient_management.h"
+
+#define READMISSION_WINDOW_DAYS 30
+
+#define READMISSION_FOUND 1
+#define READMISSION_NOT_FOUND 0
+
+/*
+ * The earlier stay a new admission was matched to.
+ */
+typedef struct ReadmissionMatch
+{
+    int    previousPatientId; // 0 when there is no earlier stay
+    int    previousDiagnosisId;
+    time_t previousDischargeDate;
+    int    daysSinceDischarge;
+    int    withinWindow; // Readmitted within READMISSION_WINDOW_DAYS
+} ReadmissionMatch;
+
+/*
+ * Function: initializeReadmissionIndex
+ * ------------------------------------
+ * Loads every stay in the discharge archive, matching each against the
+ * stays before it. Active patients are matched as they are loaded.
+ */
+void initializeReadmissionIndex(void);
+
+/*
+ * Function: matchReadmission
+ * --------------------------
+ * Finds the latest earlier stay by the same patient. A match within
+ * READMISSION_WINDOW_DAYS counts that stay as readmitted, once.
+ *
+ * patient: The newly admitted or loaded patient
+ * match: Receives the earlier stay when found
+ *
+ * Returns: READMISSION_FOUND, or READMISSION_NOT_FOUND for a first stay
+ */
+int matchReadmission(const Patient *patient, ReadmissionMatch *match);
+
+/*
+ * Function: addDischargeToReadmissionIndex
+ * ----------------------------------------
+ * Adds a completed stay so later admissions can be matched to it.
+ */
+void addDischargeToReadmissionIndex(const DischargedPatient *dischargedPatient);
+
+/*
+ * Function: getReadmissionTotals
+ * ------------------------------
+ * Returns the stays discharged with a diagnosis and how many of them were
+ * followed by a readmission within READMISSION_WINDOW_DAYS.
+ */
+void getReadmissionTotals(int diagnosisId, int *discharges, int *readmissions);
+
+/*
+ * Function: clearReadmissionIndex
+ * -------------------------------
+ * Frees all memory used by the readmission engine.
+ */
+void clearReadmissionIndex(void);
+
+#endif // READMISSION_H
@@ -0,0 +1,748 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the persisted report totals.
+ *
+ *          File layout (all values little-endian 4-byte integers):
+ *            header:  magic[4], version[1], reserved[3]
+ *            rooms:   (MAX_ROOMS + 1) x { occupants, admissions, discharges }
+ *            doctors: MAX_TRACKED_DOCTORS x { doctorId, shifts }
+ *            days:    dayCount, then dayCount x { day, admissions,
+ *                     activeAdmissions, discharges } in day order
+ *
+ *          Every record has a fixed offset, so an update rewrites only the
+ *          few records it touched. Only a day that sorts before existing
+ *          days forces the whole file to be rewritten.
+ */
+
+#include "report_aggregates.h"
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "durable_file.h"
+#include "patient_data.h"
+#include "patient_storage.h"
+
+// Private constants
+#define AGGREGATES_FILE_VERSION 1
+#define AGGREGATES_TEMP_FILE "report_aggregates.tmp"
+#define MAGIC_LENGTH 4
+#define MAX_TRACKED_DOCTORS 8
+#define NO_DOCTOR 0
+#define NOT_FOUND (-1)
+#define INITIAL_CAPACITY 64
+
+#define HEADER_SIZE 8
+#define ROOM_RECORD_SIZE 12
+#define DOCTOR_RECORD_SIZE 8
+#define DAY_RECORD_SIZE 16
+#define ROOMS_OFFSET HEADER_SIZE
+#define DOCTORS_OFFSET (ROOMS_OFFSET + (MAX_ROOMS + 1) * ROOM_RECORD_SIZE)
+#define DAY_COUNT_OFFSET (DOCTORS_OFFSET + MAX_TRACKED_DOCTORS * DOCTOR_RECORD_SIZE)
+#define DAYS_OFFSET (DAY_COUNT_OFFSET + 4)
+
+typedef struct
+{
+    int occupants;
+    int admissions;
+    int discharges;
+} RoomTotals;
+
+typedef struct
+{
+    int doctorId;
+    int shifts;
+} DoctorTotals;
+
+typedef struct
+{
+    int day;
+    int admissions;
+    int activeAdmissions;
+    int discharges;
+} DayTotals;
+
+// Running totals
+static RoomTotals   rooms[MAX_ROOMS + 1]; // Index 0 collects out-of-range rooms
+static DoctorTotals doctors[MAX_TRACKED_DOCTORS];
+static DayTotals   *days          = NULL;
+static int          dayCount      = 0;
+static int          dayCapacity   = 0;
+static FILE        *totalsFile    = NULL; // NULL while updates are kept in memory
+static int          needsFullSave = 0;
+
+// The patient store's lock orders the patient totals, but doctor totals
+// change with the schedule, so every public function also holds totalsLock
+// over the totals it touches and the file they share
+static pthread_mutex_t totalsLock = PTHREAD_MUTEX_INITIALIZER;
+
+// Function prototypes for internal helper functions
+static int  getRoomIndex(int roomNumber);
+static int  findDoctor(int doctorId, int create);
+static int  findDay(int day);
+static int  getDayBucket(int day);
+static void writeRoom(int index);
+static void writeDoctor(int index);
+static void writeDay(int index);
+static void writeValues(long offset, const int values[], int count);
+static int  readValues(FILE *file, int values[], int count);
+static int  daysFromCivil(int year, int month, int dayOfMonth);
+static void finishUpdate(void);
+static int  saveTotals(void);
+static void clearTotals(void);
+
+/*
+ * Reads the whole totals file and keeps it open for in-place updates.
+ */
+int loadReportAggregates(void)
+{
+    unsigned char header[HEADER_SIZE];
+    int           values[4];
+
+    pthread_mutex_lock(&totalsLock);
+    clearTotals();
+
+    FILE *file = fopen(AGGREGATES_FILE, "r+b");
+    if(file == NULL)
+    {
+        pthread_mutex_unlock(&totalsLock);
+        return AGGREGATES_FAILURE;
+    }
+
+    int ok = fread(header, 1, HEADER_SIZE, file) == HEADER_SIZE &&
+             memcmp(header, AGGREGATES_FILE_MAGIC, MAGIC_LENGTH) == 0 &&
+             header[MAGIC_LENGTH] == AGGREGATES_FILE_VERSION;
+
+    for(int i = 0; ok && i <= MAX_ROOMS; i++)
+    {
+        ok                  = readValues(file, values, 3);
+        rooms[i].occupants  = values[0];
+        rooms[i].admissions = values[1];
+        rooms[i].discharges = values[2];
+    }
+
+    for(int i = 0; ok && i < MAX_TRACKED_DOCTORS; i++)
+    {
+        ok                  = readValues(file, values, 2);
+        doctors[i].doctorId = values[0];
+        doctors[i].shifts   = values[1];
+    }
+
+    ok             = ok && readValues(file, values, 1) && values[0] >= 0;
+    int storedDays = ok ? values[0] : 0;
+    if(storedDays > 0)
+    {
+        days        = malloc(sizeof(DayTotals) * (size_t) storedDays);
+        ok          = days != NULL;
+        dayCapacity = ok ? storedDays : 0;
+    }
+
+    for(int i = 0; ok && i < storedDays; i++)
+    {
+        ok = readValues(file, values, 4) && (dayCount == 0 || values[0] > days[dayCount - 1].day);
+        if(ok)
+        {
+            days[dayCount].day              = values[0];
+            days[dayCount].admissions       = values[1];
+            days[dayCount].activeAdmissions = values[2];
+            days[dayCount].discharges       = values[3];
+            dayCount++;
+        }
+    }
+
+    if(!ok)
+    {
+        fclose(file);
+        clearTotals();
+        pthread_mutex_unlock(&totalsLock);
+        return AGGREGATES_FAILURE;
+    }
+
+    totalsFile = file;
+    pthread_mutex_unlock(&totalsLock);
+    return AGGREGATES_SUCCESS;
+}
+
+/*
+ * Clears the patient totals and defers writes until the next save. Doctor
+ * totals follow the schedule rather than the patient records, so they stay.
+ */
+void resetReportAggregates(void)
+{
+    DoctorTotals keptDoctors[MAX_TRACKED_DOCTORS];
+
+    pthread_mutex_lock(&totalsLock);
+    memcpy(keptDoctors, doctors, sizeof(doctors));
+    clearTotals();
+    memcpy(doctors, keptDoctors, sizeof(doctors));
+    pthread_mutex_unlock(&totalsLock);
+}
+
+/*
+ * Rewrites the totals file.
+ */
+int saveReportAggregates(void)
+{
+    pthread_mutex_lock(&totalsLock);
+    int saved = saveTotals();
+    pthread_mutex_unlock(&totalsLock);
+
+    return saved;
+}
+
+/*
+ * Rewrites the totals file through a temporary file and reopens it for
+ * in-place updates. Must be called with totalsLock held.
+ */
+static int saveTotals(void)
+{
+    unsigned char header[HEADER_SIZE] = { 0 };
+    int           values[4];
+
+    if(totalsFile != NULL)
+    {
+        fclose(totalsFile);
+        totalsFile = NULL;
+    }
+    needsFullSave = 0;
+
+    FILE *file = fopen(AGGREGATES_TEMP_FILE, "wb");
+    if(file == NULL)
+    {
+        perror("Error creating " AGGREGATES_TEMP_FILE);
+        return AGGREGATES_FAILURE;
+    }
+
+    memcpy(header, AGGREGATES_FILE_MAGIC, MAGIC_LENGTH);
+    header[MAGIC_LENGTH] = AGGREGATES_FILE_VERSION;
+    fwrite(header, 1, HEADER_SIZE, file);
+
+    // Reuse the in-place writer by pointing it at the new file
+    totalsFile = file;
+    for(int i = 0; i <= MAX_ROOMS; i++)
+    {
+        writeRoom(i);
+    }
+    for(int i = 0; i < MAX_TRACKED_DOCTORS; i++)
+    {
+        writeDoctor(i);
+    }
+    values[0] = dayCount;
+    writeValues(DAY_COUNT_OFFSET, values, 1);
+    for(int i = 0; i < dayCount; i++)
+    {
+        writeDay(i);
+    }
+    totalsFile = NULL;
+
+    int failed = ferror(file);
+    failed    |= fclose(file) != 0;
+    if(failed)
+    {
+        perror("Error saving " AGGREGATES_FILE);
+        remove(AGGREGATES_TEMP_FILE);
+        return AGGREGATES_FAILURE;
+    }
+    if(!replaceFile(AGGREGATES_TEMP_FILE, AGGREGATES_FILE))
+    {
+        return AGGREGATES_FAILURE;
+    }
+
+    totalsFile = fopen(AGGREGATES_FILE, "r+b");
+    return totalsFile != NULL ? AGGREGATES_SUCCESS : AGGREGATES_FAILURE;
+}
+
+/*
+ * Counts an admission.
+ */
+void recordAdmissionTotals(const Patient *patient)
+{
+    pthread_mutex_lock(&totalsLock);
+
+    int room   = getRoomIndex(patient->roomNumber);
+    int bucket = getDayBucket(getDayNumber(patient->admissionDate));
+
+    rooms[room].occupants++;
+    rooms[room].admissions++;
+    writeRoom(room);
+
+    if(bucket != NOT_FOUND)
+    {
+        days[bucket].admissions++;
+        days[bucket].activeAdmissions++;
+        writeDay(bucket);
+    }
+
+    finishUpdate();
+    pthread_mutex_unlock(&totalsLock);
+}
+
+/*
+ * Counts a group of discharges, pushing them to the file together.
+ */
+void recordDischargeTotals(const DischargedPatient records[], int count)
+{
+    pthread_mutex_lock(&totalsLock);
+
+    for(int i = 0; i < count; i++)
+    {
+        int room = getRoomIndex(records[i].patient.roomNumber);
+
+        rooms[room].occupants--;
+        rooms[room].discharges++;
+        writeRoom(room);
+
+        int admitted = getDayBucket(getDayNumber(records[i].patient.admissionDate));
+        if(admitted != NOT_FOUND)
+        {
+            days[admitted].activeAdmissions--;
+            writeDay(admitted);
+        }
+
+        // Looked up after the admission day, which may have shifted the buckets
+        int discharged = getDayBucket(getDayNumber(records[i].dischargeDate));
+        if(discharged != NOT_FOUND)
+        {
+            days[discharged].discharges++;
+            writeDay(discharged);
+        }
+    }
+
+    finishUpdate();
+    pthread_mutex_unlock(&totalsLock);
+}
+
+/*
+ * Moves an occupant between rooms.
+ */
+void recordTransferTotals(int fromRoom, int toRoom)
+{
+    pthread_mutex_lock(&totalsLock);
+
+    int from = getRoomIndex(fromRoom);
+    int to   = getRoomIndex(toRoom);
+
+    rooms[from].occupants--;
+    rooms[to].occupants++;
+    writeRoom(from);
+    writeRoom(to);
+
+    finishUpdate();
+    pthread_mutex_unlock(&totalsLock);
+}
+
+/*
+ * Moves a shift between doctors.
+ */
+void recordShiftChange(int oldDoctorId, int newDoctorId)
+{
+    pthread_mutex_lock(&totalsLock);
+
+    int oldIndex = findDoctor(oldDoctorId, 0);
+    int newIndex = findDoctor(newDoctorId, 1);
+
+    if(oldIndex != NOT_FOUND)
+    {
+        doctors[oldIndex].shifts--;
+        writeDoctor(oldIndex);
+    }
+    if(newIndex != NOT_FOUND)
+    {
+        doctors[newIndex].shifts++;
+        writeDoctor(newIndex);
+    }
+
+    finishUpdate();
+    pthread_mutex_unlock(&totalsLock);
+}
+
+/*
+ * Sets a doctor's shift count.
+ */
+void setDoctorShiftTotal(int doctorId, int shiftCount)
+{
+    pthread_mutex_lock(&totalsLock);
+
+    int index = findDoctor(doctorId, shiftCount > 0);
+    if(index != NOT_FOUND && doctors[index].shifts != shiftCount)
+    {
+        doctors[index].shifts = shiftCount;
+        writeDoctor(index);
+        finishUpdate();
+    }
+
+    pthread_mutex_unlock(&totalsLock);
+}
+
+/*
+ * Converts a timestamp to its local calendar day number.
+ */
+int getDayNumber(time_t timestamp)
+{
+    struct tm localTime;
+
+    localtime_r(&timestamp, &localTime);
+    return getDayNumberOfDate(&localTime);
+}
+
+/*
+ * Converts a broken-down local date to its day number.
+ */
+int getDayNumberOfDate(const struct tm *localTime)
+{
+    return daysFromCivil(localTime->tm_year + 1900, localTime->tm_mon + 1, localTime->tm_mday);
+}
+
+/*
+ * Sums admissions over a day range.
+ */
+int sumAdmissions(int firstDay, int lastDay)
+{
+    int total = 0;
+
+    for(int i = dayCount - 1; i >= 0 && days[i].day >= firstDay; i--)
+    {
+        if(days[i].day <= lastDay)
+        {
+            total += days[i].admissions;
+        }
+    }
+
+    return total;
+}
+
+/*
+ * Sums still-active admissions over a day range.
+ */
+int sumActiveAdmissions(int firstDay, int lastDay)
+{
+    int total = 0;
+
+    for(int i = dayCount - 1; i >= 0 && days[i].day >= firstDay; i--)
+    {
+        if(days[i].day <= lastDay)
+        {
+            total += days[i].activeAdmissions;
+        }
+    }
+
+    return total;
+}
+
+/*
+ * Sums discharges over a day range.
+ */
+int sumDischarges(int firstDay, int lastDay)
+{
+    int total = 0;
+
+    for(int i = dayCount - 1; i >= 0 && days[i].day >= firstDay; i--)
+    {
+        if(days[i].day <= lastDay)
+        {
+            total += days[i].discharges;
+        }
+    }
+
+    return total;
+}
+
+/*
+ * Returns the number of occupants across all rooms.
+ */
+int getActivePatientTotal(void)
+{
+    int total = 0;
+
+    for(int i = 0; i <= MAX_ROOMS; i++)
+    {
+        total += rooms[i].occupants;
+    }
+
+    return total;
+}
+
+/*
+ * Returns a room's discharge count.
+ */
+int getRoomDischargeTotal(int roomNumber)
+{
+    return roomNumber >= 1 && roomNumber <= MAX_ROOMS ? rooms[roomNumber].discharges : 0;
+}
+
+/*
+ * Returns a doctor's shift count.
+ */
+int getDoctorShiftTotal(int doctorId)
+{
+    pthread_mutex_lock(&totalsLock);
+    int index  = findDoctor(doctorId, 0);
+    int shifts = index != NOT_FOUND ? doctors[index].shifts : 0;
+    pthread_mutex_unlock(&totalsLock);
+
+    return shifts;
+}
+
+/*
+ * Closes the file and zeroes all totals.
+ */
+void clearReportAggregates(void)
+{
+    pthread_mutex_lock(&totalsLock);
+    clearTotals();
+    pthread_mutex_unlock(&totalsLock);
+}
+
+/*
+ * Closes the file and zeroes all totals. Must be called with totalsLock
+ * held.
+ */
+static void clearTotals(void)
+{
+    if(totalsFile != NULL)
+    {
+        fclose(totalsFile);
+        totalsFile = NULL;
+    }
+
+    free(days);
+    days          = NULL;
+    dayCount      = 0;
+    dayCapacity   = 0;
+    needsFullSave = 0;
+
+    memset(rooms, 0, sizeof(rooms));
+    memset(doctors, 0, sizeof(doctors));
+}
+
+/*
+ * Maps a room number to its totals slot.
+ */
+static int getRoomIndex(int roomNumber)
+{
+    return roomNumber >= 1 && roomNumber <= MAX_ROOMS ? roomNumber : 0;
+}
+
+/*
+ * Returns a doctor's slot, claiming a free one if create is set.
+ */
+static int findDoctor(int doctorId, int create)
+{
+    int freeSlot = NOT_FOUND;
+
+    if(doctorId == NO_DOCTOR)
+    {
+        return NOT_FOUND;
+    }
+
+    for(int i = 0; i < MAX_TRACKED_DOCTORS; i++)
+    {
+        if(doctors[i].doctorId == doctorId)
+        {
+            return i;
+        }
+        if(doctors[i].doctorId == NO_DOCTOR && freeSlot == NOT_FOUND)
+        {
+            freeSlot = i;
+        }
+    }
+
+    if(!create || freeSlot == NOT_FOUND)
+    {
+        return NOT_FOUND;
+    }
+
+    doctors[freeSlot].doctorId = doctorId;
+    doctors[freeSlot].shifts   = 0;
+    return freeSlot;
+}
+
+/*
+ * Binary searches the day buckets.
+ */
+static int findDay(int day)
+{
+    int low  = 0;
+    int high = dayCount - 1;
+
+    while(low <= high)
+    {
+        int middle = (low + high) / 2;
+        if(days[middle].day == day)
+        {
+            return middle;
+        }
+        if(days[middle].day < day)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    return NOT_FOUND;
+}
+
+/*
+ * Returns the bucket for a day, adding it in order if needed. Today's
+ * bucket is almost always the last one, so that case is checked first.
+ */
+static int getDayBucket(int day)
+{
+    if(dayCount > 0 && days[dayCount - 1].day == day)
+    {
+        return dayCount - 1;
+    }
+
+    int index = findDay(day);
+    if(index != NOT_FOUND)
+    {
+        return index;
+    }
+
+    if(dayCount == dayCapacity)
+    {
+        int        newCapacity = dayCapacity == 0 ? INITIAL_CAPACITY : dayCapacity * 2;
+        DayTotals *grown       = realloc(days, sizeof(DayTotals) * (size_t) newCapacity);
+        if(grown == NULL)
+        {
+            return NOT_FOUND;
+        }
+        days        = grown;
+        dayCapacity = newCapacity;
+    }
+
+    index = dayCount;
+    while(index > 0 && days[index - 1].day > day)
+    {
+        index--;
+    }
+    memmove(days + index + 1, days + index, sizeof(DayTotals) * (size_t) (dayCount - index));
+    memset(&days[index], 0, sizeof(DayTotals));
+    days[index].day = day;
+    dayCount++;
+
+    if(index < dayCount - 1)
+    {
+        // Later buckets moved, so their file offsets changed
+        needsFullSave = 1;
+    }
+    else
+    {
+        int count = dayCount;
+        writeValues(DAY_COUNT_OFFSET, &count, 1);
+        writeDay(index);
+    }
+
+    return index;
+}
+
+/*
+ * Writes one room record in place.
+ */
+static void writeRoom(int index)
+{
+    int values[3] = { rooms[index].occupants, rooms[index].admissions, rooms[index].discharges };
+    writeValues(ROOMS_OFFSET + (long) index * ROOM_RECORD_SIZE, values, 3);
+}
+
+/*
+ * Writes one doctor record in place.
+ */
+static void writeDoctor(int index)
+{
+    int values[2] = { doctors[index].doctorId, doctors[index].shifts };
+    writeValues(DOCTORS_OFFSET + (long) index * DOCTOR_RECORD_SIZE, values, 2);
+}
+
+/*
+ * Writes one day record in place.
+ */
+static void writeDay(int index)
+{
+    int values[4] = { days[index].day, days[index].admissions, days[index].activeAdmissions, days[index].discharges };
+    writeValues(DAYS_OFFSET + (long) index * DAY_RECORD_SIZE, values, 4);
+}
+
+/*
+ * Writes little-endian integers at a file offset. Does nothing while
+ * updates are deferred or a full save is pending.
+ */
+static void writeValues(long offset, const int values[], int count)
+{
+    unsigned char bytes[4 * 4];
+
+    if(totalsFile == NULL || needsFullSave)
+    {
+        return;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        storeLittleEndian(bytes + 4 * i, (unsigned int) values[i], 4);
+    }
+
+    if(fseek(totalsFile, offset, SEEK_SET) != 0 ||
+       fwrite(bytes, 1, (size_t) (4 * count), totalsFile) != (size_t) (4 * count))
+    {
+        perror("Error updating " AGGREGATES_FILE);
+    }
+}
+
+/*
+ * Reads little-endian integers from the current file position.
+ */
+static int readValues(FILE *file, int values[], int count)
+{
+    unsigned char bytes[4 * 4];
+
+    if(fread(bytes, 1, (size_t) (4 * count), file) != (size_t) (4 * count))
+    {
+        return 0;
+    }
+
+    for(int i = 0; i < count; i++)
+    {
+        values[i] = (int) (unsigned int) loadLittleEndian(bytes + 4 * i, 4);
+    }
+
+    return 1;
+}
+
+/*
+ * Days since 1970-01-01 of a proleptic Gregorian date.
+ */
+static int daysFromCivil(int year, int month, int dayOfMonth)
+{
+    year -= month <= 2;
+
+    int era       = (year >= 0 ? year : year - 399) / 400;
+    int yearOfEra = year - era * 400;
+    int dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + dayOfMonth - 1;
+    int dayOfEra  = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+
+    return era * 146097 + dayOfEra - 719468;
+}
+
+/*
+ * Pushes in-place writes to the file, or rewrites it if buckets moved.
+ */
+static void finishUpdate(void)
+{
+    if(totalsFile == NULL)
+    {
+        return;
+    }
+
+    if(needsFullSave)
+    {
+        saveTotals();
+    }
+    else
+    {
+        fflush(totalsFile);
+    }
+}
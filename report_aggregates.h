@@ -0,0 +1,164 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the running totals behind the reports, kept
+ *          up to date as patients are admitted and discharged and as doctors
+ *          are assigned, and persisted in report_aggregates.dat:
+ *
+ *          - per local calendar day: admissions, admissions still active,
+ *            and discharges, which also answer the activity report's days
+ *            and weeks
+ *          - per room: current occupants, admissions and discharges
+ *          - per doctor: shifts covered in the weekly schedule
+ *
+ *          Report totals for a day range sum at most one bucket per day, so
+ *          headers no longer need to walk the patient list or the archive.
+ */
+
+#ifndef REPORT_AGGREGATES_H
+#define REPORT_AGGREGATES_H
+
+#include <time.h>
+#include "patient_management.h"
+
+#define AGGREGATES_FILE "report_aggregates.dat"
+#define AGGREGATES_FILE_MAGIC "HMSG"
+
+#define AGGREGATES_SUCCESS 1
+#define AGGREGATES_FAILURE 0
+
+/*
+ * Function: loadReportAggregates
+ * ------------------------------
+ * Loads the totals from AGGREGATES_FILE.
+ *
+ * Returns: AGGREGATES_SUCCESS, or AGGREGATES_FAILURE if the file is missing
+ *          or invalid, in which case the caller should rebuild the totals
+ */
+int loadReportAggregates(void);
+
+/*
+ * Function: resetReportAggregates
+ * -------------------------------
+ * Clears the admission, discharge and room totals ahead of a rebuild; doctor
+ * totals are kept. Updates are kept in memory until
+ * saveReportAggregates is called.
+ */
+void resetReportAggregates(void);
+
+/*
+ * Function: saveReportAggregates
+ * ------------------------------
+ * Writes all totals to AGGREGATES_FILE. Later updates are written in
+ * place as they happen.
+ *
+ * Returns: AGGREGATES_SUCCESS, or AGGREGATES_FAILURE on a write error
+ */
+int saveReportAggregates(void);
+
+/*
+ * Function: recordAdmissionTotals
+ * -------------------------------
+ * Counts a new admission on its admission day and in its room.
+ */
+void recordAdmissionTotals(const Patient *patient);
+
+/*
+ * Function: recordDischargeTotals
+ * -------------------------------
+ * Counts each discharge on its discharge day and in its room, and removes
+ * the patient from the still-active admissions of their admission day.
+ * The whole group is written to the file at once.
+ */
+void recordDischargeTotals(const DischargedPatient records[], int count);
+
+/*
+ * Function: recordTransferTotals
+ * ------------------------------
+ * Moves one occupant between rooms.
+ */
+void recordTransferTotals(int fromRoom, int toRoom);
+
+/*
+ * Function: recordShiftChange
+ * ---------------------------
+ * Moves one shift from a doctor to another when a schedule slot is
+ * reassigned. Either ID may be 0 for an empty slot.
+ */
+void recordShiftChange(int oldDoctorId, int newDoctorId);
+
+/*
+ * Function: setDoctorShiftTotal
+ * -----------------------------
+ * Sets a doctor's shift count directly, e.g. to match a loaded schedule.
+ */
+void setDoctorShiftTotal(int doctorId, int shiftCount);
+
+/*
+ * Function: getDayNumber
+ * ----------------------
+ * Returns the local calendar day of a timestamp as a count of days since
+ * January 1st, 1970, so consecutive days have consecutive numbers.
+ */
+int getDayNumber(time_t timestamp);
+
+/*
+ * Function: getDayNumberOfDate
+ * ----------------------------
+ * Returns the day number of a broken-down local date, as from localtime_r.
+ */
+int getDayNumberOfDate(const struct tm *localTime);
+
+/*
+ * Function: sumAdmissions
+ * -----------------------
+ * Returns how many patients were admitted between two days (inclusive),
+ * whether or not they have since been discharged.
+ */
+int sumAdmissions(int firstDay, int lastDay);
+
+/*
+ * Function: sumActiveAdmissions
+ * -----------------------------
+ * Returns how many patients admitted between two days (inclusive) are
+ * still admitted.
+ */
+int sumActiveAdmissions(int firstDay, int lastDay);
+
+/*
+ * Function: sumDischarges
+ * -----------------------
+ * Returns how many patients were discharged between two days (inclusive).
+ */
+int sumDischarges(int firstDay, int lastDay);
+
+/*
+ * Function: getActivePatientTotal
+ * -------------------------------
+ * Returns the number of patients currently admitted across all rooms.
+ */
+int getActivePatientTotal(void);
+
+/*
+ * Function: getRoomDischargeTotal
+ * -------------------------------
+ * Returns how many patients have been discharged from a room, which is
+ * the room's usage count.
+ */
+int getRoomDischargeTotal(int roomNumber);
+
+/*
+ * Function: getDoctorShiftTotal
+ * -----------------------------
+ * Returns how many weekly schedule slots a doctor covers.
+ */
+int getDoctorShiftTotal(int doctorId);
+
+/*
+ * Function: clearReportAggregates
+ * -------------------------------
+ * Closes the totals file and frees the day buckets.
+ */
+void clearReportAggregates(void);
+
+#endif // REPORT_AGGREGATES_H
@@ -0,0 +1,648 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the parallel report engine.
+ *
+ *          A job is a set of numbered chunks and a task that processes one
+ *          chunk into that chunk's own partial result. Workers take the next
+ *          unclaimed chunk until none remain, so a slow chunk does not hold
+ *          up the others; the caller sleeps until the last one finishes and
+ *          then merges the partials in chunk order.
+ */
+
+#include "report_engine.h"
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "discharge_archive.h"
+
+// Private constants
+#define MAX_CHUNKS (MAX_REPORT_WORKERS * CHUNKS_PER_WORKER)
+#define MIN_SLICE_SIZE 4096 // Smaller active patient slices cost more to hand out than to filter
+#define INITIAL_RESULTS 64
+
+/*
+ * Processes one chunk of a job.
+ */
+typedef void (*ChunkTask)(void *job, int chunkIndex);
+
+/*
+ * The records one archive chunk kept, sorted by patient ID once complete.
+ */
+typedef struct
+{
+    DischargedPatient *records;
+    int                count;
+    int                capacity;
+    int                failed;
+} DischargePartial;
+
+typedef struct
+{
+    time_t           fromTime;
+    time_t           toTime;
+    DischargeFilter  filter;
+    const void      *context;
+    ArchiveChunk     chunks[MAX_CHUNKS];
+    DischargePartial partials[MAX_CHUNKS];
+} DischargeCollectJob;
+
+/*
+ * State for one chunk's scan while collecting records.
+ */
+typedef struct
+{
+    const DischargeCollectJob *job;
+    DischargePartial          *partial;
+} CollectScan;
+
+typedef struct
+{
+    time_t       fromTime;
+    time_t       toTime;
+    DischargeKey key;
+    const void  *context;
+    int          countLength;
+    ArchiveChunk chunks[MAX_CHUNKS];
+    int         *partialCounts; // chunkCount rows of countLength counters
+} DischargeCountJob;
+
+/*
+ * State for one chunk's scan while counting records.
+ */
+typedef struct
+{
+    const DischargeCountJob *job;
+    int                     *counts;
+} CountScan;
+
+typedef struct
+{
+    time_t         fromTime;
+    time_t         toTime;
+    DischargeFold  fold;
+    const void    *context;
+    size_t         partialSize;
+    ArchiveChunk   chunks[MAX_CHUNKS];
+    unsigned char *partials; // chunkCount partials of partialSize bytes
+} DischargeFoldJob;
+
+/*
+ * State for one chunk's scan while folding records.
+ */
+typedef struct
+{
+    const DischargeFoldJob *job;
+    void                   *partial;
+} FoldScan;
+
+/*
+ * Each slice writes its matches to its own stretch of matches, starting at
+ * the slice's first index, so slices never share memory.
+ */
+typedef struct
+{
+    const Patient **patients;
+    int             count;
+    int             sliceSize;
+    PatientFilter   filter;
+    const void     *context;
+    const Patient **matches;
+    int             matchCounts[MAX_CHUNKS];
+} ActiveCollectJob;
+
+// Worker pool, guarded by poolLock. jobLock lets one job run at a time.
+static pthread_t       workers[MAX_REPORT_WORKERS];
+static int             workerCount = 0;
+static int             poolStarted = 0;
+static int             stopping    = 0;
+static pthread_mutex_t jobLock     = PTHREAD_MUTEX_INITIALIZER;
+static pthread_mutex_t poolLock    = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  workReady   = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t  workDone    = PTHREAD_COND_INITIALIZER;
+static ChunkTask       currentTask = NULL;
+static void           *currentJob  = NULL;
+static int             nextChunk   = 0;
+static int             chunkTotal  = 0;
+static int             chunksDone  = 0;
+
+// Function prototypes for internal helper functions
+static int   startWorkers(void);
+static void *runWorker(void *unused);
+static void  runChunks(ChunkTask task, void *job, int chunkCount);
+static void  collectChunk(void *job, int chunkIndex);
+static int   keepDischargedRecord(const DischargedPatient *dischargedPatient, void *context);
+static void  countChunk(void *job, int chunkIndex);
+static int   countDischargedRecord(const DischargedPatient *dischargedPatient, void *context);
+static void  foldChunk(void *job, int chunkIndex);
+static int   foldDischargedRecord(const DischargedPatient *dischargedPatient, void *context);
+static void  filterSlice(void *job, int chunkIndex);
+static int   mergePartials(DischargePartial partials[], int chunkCount, DischargeResults *results);
+static int   compareDischargedById(const void *a, const void *b);
+
+/*
+ * Starts the pool if needed and returns its size.
+ */
+int getReportWorkerCount(void)
+{
+    pthread_mutex_lock(&jobLock);
+    int count = startWorkers();
+    pthread_mutex_unlock(&jobLock);
+
+    return count;
+}
+
+/*
+ * Splits the archive, has each worker keep its chunk's matches, then merges
+ * the sorted partials by patient ID.
+ */
+int collectDischargedPatients(time_t fromTime,
+                              time_t toTime,
+                              DischargeFilter filter,
+                              const void *context,
+                              DischargeResults *results)
+{
+    memset(results, 0, sizeof(DischargeResults));
+
+    DischargeCollectJob *job = calloc(1, sizeof(DischargeCollectJob));
+    if(job == NULL)
+    {
+        return REPORT_ENGINE_FAILURE;
+    }
+
+    job->fromTime = fromTime;
+    job->toTime   = toTime;
+    job->filter   = filter;
+    job->context  = context;
+
+    int maxChunks  = getReportWorkerCount() * CHUNKS_PER_WORKER;
+    int chunkCount = splitDischargeArchive(fromTime, toTime, job->chunks, maxChunks > 0 ? maxChunks : 1);
+
+    runChunks(collectChunk, job, chunkCount);
+
+    // The results take over the partials' records
+    int result = mergePartials(job->partials, chunkCount, results);
+    for(int i = 0; i < chunkCount; i++)
+    {
+        results->chunkRecords[i] = job->partials[i].records;
+    }
+    free(job);
+
+    return result;
+}
+
+/*
+ * Frees the ordered pointers and the chunk arrays they point into.
+ */
+void freeDischargeResults(DischargeResults *results)
+{
+    free(results->records);
+    for(int i = 0; i < MAX_CHUNKS; i++)
+    {
+        free(results->chunkRecords[i]);
+    }
+    memset(results, 0, sizeof(DischargeResults));
+}
+
+/*
+ * Gives each chunk its own row of counters, then sums the rows.
+ */
+int countDischargedPatients(time_t fromTime,
+                            time_t toTime,
+                            DischargeKey key,
+                            const void *context,
+                            int counts[],
+                            int countLength)
+{
+    DischargeCountJob *job = calloc(1, sizeof(DischargeCountJob));
+    if(job == NULL)
+    {
+        return REPORT_ENGINE_FAILURE;
+    }
+
+    job->fromTime    = fromTime;
+    job->toTime      = toTime;
+    job->key         = key;
+    job->context     = context;
+    job->countLength = countLength;
+
+    int maxChunks  = getReportWorkerCount() * CHUNKS_PER_WORKER;
+    int chunkCount = splitDischargeArchive(fromTime, toTime, job->chunks, maxChunks > 0 ? maxChunks : 1);
+
+    job->partialCounts = calloc((size_t) (chunkCount > 0 ? chunkCount : 1) * (size_t) countLength, sizeof(int));
+    if(job->partialCounts == NULL)
+    {
+        free(job);
+        return REPORT_ENGINE_FAILURE;
+    }
+
+    runChunks(countChunk, job, chunkCount);
+
+    for(int i = 0; i < chunkCount; i++)
+    {
+        const int *row = job->partialCounts + (size_t) i * (size_t) countLength;
+        for(int j = 0; j < countLength; j++)
+        {
+            counts[j] += row[j];
+        }
+    }
+
+    free(job->partialCounts);
+    free(job);
+
+    return REPORT_ENGINE_SUCCESS;
+}
+
+/*
+ * Gives each chunk its own zeroed partial, then merges the partials in
+ * chunk order.
+ */
+int foldDischargedPatients(time_t fromTime,
+                           time_t toTime,
+                           DischargeFold fold,
+                           PartialMerge merge,
+                           const void *context,
+                           void *result,
+                           size_t resultSize)
+{
+    DischargeFoldJob *job = calloc(1, sizeof(DischargeFoldJob));
+    if(job == NULL)
+    {
+        return REPORT_ENGINE_FAILURE;
+    }
+
+    job->fromTime    = fromTime;
+    job->toTime      = toTime;
+    job->fold        = fold;
+    job->context     = context;
+    job->partialSize = resultSize;
+
+    int maxChunks  = getReportWorkerCount() * CHUNKS_PER_WORKER;
+    int chunkCount = splitDischargeArchive(fromTime, toTime, job->chunks, maxChunks > 0 ? maxChunks : 1);
+
+    job->partials = calloc((size_t) (chunkCount > 0 ? chunkCount : 1), resultSize);
+    if(job->partials == NULL)
+    {
+        free(job);
+        return REPORT_ENGINE_FAILURE;
+    }
+
+    runChunks(foldChunk, job, chunkCount);
+
+    for(int i = 0; i < chunkCount; i++)
+    {
+        merge(result, job->partials + (size_t) i * resultSize, context);
+    }
+
+    free(job->partials);
+    free(job);
+
+    return REPORT_ENGINE_SUCCESS;
+}
+
+/*
+ * Cuts the view into equal slices, filters them in parallel, then closes
+ * the gaps between the slices' matches.
+ */
+int collectActivePatients(const Patient *patients[],
+                          int count,
+                          PatientFilter filter,
+                          const void *context,
+                          const Patient ***matches,
+                          int *matchCount)
+{
+    ActiveCollectJob job;
+
+    job.patients = patients;
+    job.count    = count;
+    job.filter   = filter;
+    job.context  = context;
+    job.matches  = malloc(sizeof(Patient *) * (size_t) (count > 0 ? count : 1));
+    if(job.matches == NULL)
+    {
+        return REPORT_ENGINE_FAILURE;
+    }
+
+    int sliceCount = getReportWorkerCount() * CHUNKS_PER_WORKER;
+    if(sliceCount > count / MIN_SLICE_SIZE)
+    {
+        sliceCount = count / MIN_SLICE_SIZE;
+    }
+    if(sliceCount < 1)
+    {
+        sliceCount = 1;
+    }
+    job.sliceSize = (count + sliceCount - 1) / sliceCount;
+
+    runChunks(filterSlice, &job, count > 0 ? sliceCount : 0);
+
+    int total = 0;
+    for(int i = 0; i < sliceCount && count > 0; i++)
+    {
+        memmove(job.matches + total, job.matches + (size_t) i * (size_t) job.sliceSize,
+                sizeof(Patient *) * (size_t) job.matchCounts[i]);
+        total += job.matchCounts[i];
+    }
+
+    *matches    = job.matches;
+    *matchCount = total;
+
+    return REPORT_ENGINE_SUCCESS;
+}
+
+/*
+ * Wakes the workers to exit and waits for them.
+ */
+void stopReportEngine(void)
+{
+    pthread_mutex_lock(&jobLock);
+
+    pthread_mutex_lock(&poolLock);
+    stopping = 1;
+    pthread_cond_broadcast(&workReady);
+    pthread_mutex_unlock(&poolLock);
+
+    for(int i = 0; i < workerCount; i++)
+    {
+        pthread_join(workers[i], NULL);
+    }
+
+    workerCount = 0;
+    poolStarted = 0;
+    stopping    = 0;
+
+    pthread_mutex_unlock(&jobLock);
+}
+
+/*
+ * Starts one worker per online CPU the first time it is called. Must be
+ * called with jobLock held. Returns the number of workers running.
+ */
+static int startWorkers(void)
+{
+    if(poolStarted)
+    {
+        return workerCount;
+    }
+    poolStarted = 1;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int  wanted = cpus < 1 ? 1 : cpus > MAX_REPORT_WORKERS ? MAX_REPORT_WORKERS : (int) cpus;
+
+    while(workerCount < wanted && pthread_create(&workers[workerCount], NULL, runWorker, NULL) == 0)
+    {
+        workerCount++;
+    }
+
+    return workerCount;
+}
+
+/*
+ * Worker loop: claims chunks of the current job until told to stop.
+ */
+static void *runWorker(void *unused)
+{
+    (void) unused;
+
+    pthread_mutex_lock(&poolLock);
+    for(;;)
+    {
+        while(!stopping && nextChunk >= chunkTotal)
+        {
+            pthread_cond_wait(&workReady, &poolLock);
+        }
+        if(stopping)
+        {
+            break;
+        }
+
+        int       chunkIndex = nextChunk++;
+        ChunkTask task       = currentTask;
+        void     *job        = currentJob;
+
+        pthread_mutex_unlock(&poolLock);
+        task(job, chunkIndex);
+        pthread_mutex_lock(&poolLock);
+
+        if(++chunksDone == chunkTotal)
+        {
+            pthread_cond_signal(&workDone);
+        }
+    }
+    pthread_mutex_unlock(&poolLock);
+
+    return NULL;
+}
+
+/*
+ * Hands a job's chunks to the pool and waits for all of them. A single
+ * chunk, or a pool that could not start, runs on the calling thread.
+ */
+static void runChunks(ChunkTask task, void *job, int chunkCount)
+{
+    pthread_mutex_lock(&jobLock);
+
+    if(chunkCount <= 1 || startWorkers() == 0)
+    {
+        for(int i = 0; i < chunkCount; i++)
+        {
+            task(job, i);
+        }
+        pthread_mutex_unlock(&jobLock);
+        return;
+    }
+
+    pthread_mutex_lock(&poolLock);
+    currentTask = task;
+    currentJob  = job;
+    nextChunk   = 0;
+    chunkTotal  = chunkCount;
+    chunksDone  = 0;
+    pthread_cond_broadcast(&workReady);
+
+    while(chunksDone < chunkTotal)
+    {
+        pthread_cond_wait(&workDone, &poolLock);
+    }
+    pthread_mutex_unlock(&poolLock);
+
+    pthread_mutex_unlock(&jobLock);
+}
+
+/*
+ * Scans one archive chunk, keeping the records the filter accepts, and
+ * sorts them by ID ready for the merge.
+ */
+static void collectChunk(void *job, int chunkIndex)
+{
+    DischargeCollectJob *collect = job;
+    CollectScan          scan    = { collect, &collect->partials[chunkIndex] };
+
+    scanDischargeChunk(&collect->chunks[chunkIndex], collect->fromTime, collect->toTime,
+                       keepDischargedRecord, &scan);
+
+    qsort(scan.partial->records, (size_t) scan.partial->count, sizeof(DischargedPatient), compareDischargedById);
+}
+
+/*
+ * Chunk scan callback. Appends the record to the chunk's partial if the
+ * filter keeps it.
+ */
+static int keepDischargedRecord(const DischargedPatient *dischargedPatient, void *context)
+{
+    CollectScan      *scan    = context;
+    DischargePartial *partial = scan->partial;
+
+    if(scan->job->filter != NULL && !scan->job->filter(dischargedPatient, scan->job->context))
+    {
+        return 1;
+    }
+
+    if(partial->count == partial->capacity)
+    {
+        int                newCapacity = partial->capacity == 0 ? INITIAL_RESULTS : partial->capacity * 2;
+        DischargedPatient *grown       = realloc(partial->records, sizeof(DischargedPatient) * (size_t) newCapacity);
+        if(grown == NULL)
+        {
+            partial->failed = 1;
+            return 0;
+        }
+        partial->records  = grown;
+        partial->capacity = newCapacity;
+    }
+
+    partial->records[partial->count++] = *dischargedPatient;
+    return 1;
+}
+
+/*
+ * Scans one archive chunk into its row of counters.
+ */
+static void countChunk(void *job, int chunkIndex)
+{
+    DischargeCountJob *count = job;
+    CountScan          scan  = { count, count->partialCounts + (size_t) chunkIndex * (size_t) count->countLength };
+
+    scanDischargeChunk(&count->chunks[chunkIndex], count->fromTime, count->toTime, countDischargedRecord, &scan);
+}
+
+/*
+ * Chunk scan callback. Adds the record to the counter its key selects.
+ */
+static int countDischargedRecord(const DischargedPatient *dischargedPatient, void *context)
+{
+    CountScan *scan  = context;
+    int        index = scan->job->key(dischargedPatient, scan->job->context);
+
+    if(index >= 0 && index < scan->job->countLength)
+    {
+        scan->counts[index]++;
+    }
+
+    return 1;
+}
+
+/*
+ * Scans one archive chunk into its partial.
+ */
+static void foldChunk(void *job, int chunkIndex)
+{
+    DischargeFoldJob *fold = job;
+    FoldScan          scan = { fold, fold->partials + (size_t) chunkIndex * fold->partialSize };
+
+    scanDischargeChunk(&fold->chunks[chunkIndex], fold->fromTime, fold->toTime, foldDischargedRecord, &scan);
+}
+
+/*
+ * Chunk scan callback. Folds the record into the chunk's partial.
+ */
+static int foldDischargedRecord(const DischargedPatient *dischargedPatient, void *context)
+{
+    FoldScan *scan = context;
+
+    scan->job->fold(dischargedPatient, scan->partial, scan->job->context);
+    return 1;
+}
+
+/*
+ * Filters one slice of the active patient view.
+ */
+static void filterSlice(void *job, int chunkIndex)
+{
+    ActiveCollectJob *collect = job;
+    int               first   = chunkIndex * collect->sliceSize;
+    int               last    = first + collect->sliceSize < collect->count ? first + collect->sliceSize
+                                                                             : collect->count;
+    int               kept    = 0;
+
+    for(int i = first; i < last; i++)
+    {
+        if(collect->filter == NULL || collect->filter(collect->patients[i], collect->context))
+        {
+            collect->matches[first + kept++] = collect->patients[i];
+        }
+    }
+
+    collect->matchCounts[chunkIndex] = kept;
+}
+
+/*
+ * Merges the sorted partials into one array in patient ID order. Equal IDs
+ * are taken from the earlier chunk first, so the order is always the same.
+ */
+static int mergePartials(DischargePartial partials[], int chunkCount, DischargeResults *results)
+{
+    int total = 0;
+
+    for(int i = 0; i < chunkCount; i++)
+    {
+        if(partials[i].failed)
+        {
+            return REPORT_ENGINE_FAILURE;
+        }
+        total += partials[i].count;
+    }
+
+    const DischargedPatient **merged = malloc(sizeof(DischargedPatient *) * (size_t) (total > 0 ? total : 1));
+    if(merged == NULL)
+    {
+        return REPORT_ENGINE_FAILURE;
+    }
+
+    int positions[MAX_CHUNKS] = { 0 };
+    for(int i = 0; i < total; i++)
+    {
+        int next = -1;
+        for(int chunk = 0; chunk < chunkCount; chunk++)
+        {
+            if(positions[chunk] < partials[chunk].count &&
+               (next < 0 || compareDischargedById(&partials[chunk].records[positions[chunk]],
+                                                  &partials[next].records[positions[next]]) < 0))
+            {
+                next = chunk;
+            }
+        }
+        merged[i] = &partials[next].records[positions[next]++];
+    }
+
+    results->records = merged;
+    results->count   = total;
+    return REPORT_ENGINE_SUCCESS;
+}
+
+/*
+ * Orders records by patient ID, then by discharge time.
+ */
+static int compareDischargedById(const void *a, const void *b)
+{
+    const DischargedPatient *left  = a;
+    const DischargedPatient *right = b;
+
+    if(left->patient.patientId != right->patient.patientId)
+    {
+        return (left->patient.patientId > right->patient.patientId) -
+               (left->patient.patientId < right->patient.patientId);
+    }
+    return (left->dischargeDate > right->dischargeDate) - (left->dischargeDate < right->dischargeDate);
+}
@@ -0,0 +1,173 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the report engine, which runs report scans on
+ *          a pool of worker threads.
+ *
+ *          The discharge archive is split into runs of blocks and the active
+ *          patients into slices; each worker filters or counts its chunk into
+ *          results of its own, with no shared state. The partial results are
+ *          then merged on the calling thread, matching records in patient ID
+ *          order, so output does not depend on how the work was scheduled.
+ *          Filters and keys run on the workers and must only read their
+ *          context.
+ */
+
+#ifndef REPORT_ENGINE_H
+#define REPORT_ENGINE_H
+
+#include <time.h>
+#include "patient_management.h"
+
+#define MAX_REPORT_WORKERS 16
+#define CHUNKS_PER_WORKER 4 // Spare chunks let fast workers pick up the slack
+
+#define REPORT_ENGINE_SUCCESS 1
+#define REPORT_ENGINE_FAILURE 0
+
+/*
+ * Decides whether a discharged patient belongs in a report.
+ * Returns 1 to keep the record, 0 to skip it.
+ */
+typedef int (*DischargeFilter)(const DischargedPatient *dischargedPatient, const void *context);
+
+/*
+ * Discharged patients kept by collectDischargedPatients. records points
+ * into the arrays each chunk collected its matches in, so putting them in
+ * order copies no record.
+ */
+typedef struct
+{
+    const DischargedPatient **records; // In patient ID order
+    int                       count;
+    DischargedPatient        *chunkRecords[MAX_REPORT_WORKERS * CHUNKS_PER_WORKER];
+} DischargeResults;
+
+/*
+ * Decides whether an active patient belongs in a report.
+ * Returns 1 to keep the patient, 0 to skip them.
+ */
+typedef int (*PatientFilter)(const Patient *patient, const void *context);
+
+/*
+ * Maps a discharged patient to the counter it adds to.
+ * Returns the counter index, or -1 to leave the record uncounted.
+ */
+typedef int (*DischargeKey)(const DischargedPatient *dischargedPatient, const void *context);
+
+/*
+ * Adds a discharged patient to a chunk's partial result.
+ */
+typedef void (*DischargeFold)(const DischargedPatient *dischargedPatient, void *partial, const void *context);
+
+/*
+ * Adds one chunk's partial result into the overall result.
+ */
+typedef void (*PartialMerge)(void *result, const void *partial, const void *context);
+
+/*
+ * Function: getReportWorkerCount
+ * ------------------------------
+ * Returns the number of worker threads, starting the pool on first use.
+ * The pool has one worker per online CPU, up to MAX_REPORT_WORKERS.
+ */
+int getReportWorkerCount(void);
+
+/*
+ * Function: collectDischargedPatients
+ * -----------------------------------
+ * Scans the archive blocks overlapping [fromTime, toTime] in parallel and
+ * returns every record the filter keeps, ordered by patient ID.
+ *
+ * filter: Record filter, or NULL to keep every record
+ * context: Passed to the filter
+ * results: Receives the matching records, to be released with
+ *          freeDischargeResults whatever the outcome
+ *
+ * Returns: REPORT_ENGINE_SUCCESS, or REPORT_ENGINE_FAILURE if memory ran
+ *          out (a missing archive gives no records)
+ */
+int collectDischargedPatients(time_t fromTime,
+                              time_t toTime,
+                              DischargeFilter filter,
+                              const void *context,
+                              DischargeResults *results);
+
+/*
+ * Function: freeDischargeResults
+ * ------------------------------
+ * Frees the records of a collectDischargedPatients call.
+ */
+void freeDischargeResults(DischargeResults *results);
+
+/*
+ * Function: countDischargedPatients
+ * ---------------------------------
+ * Scans the archive blocks overlapping [fromTime, toTime] in parallel and
+ * adds one to counts[key(record)] for each record.
+ *
+ * counts: Counters to add to, countLength entries
+ *
+ * Returns: REPORT_ENGINE_SUCCESS, or REPORT_ENGINE_FAILURE if memory ran
+ *          out, in which case counts is unchanged
+ */
+int countDischargedPatients(time_t fromTime,
+                            time_t toTime,
+                            DischargeKey key,
+                            const void *context,
+                            int counts[],
+                            int countLength);
+
+/*
+ * Function: foldDischargedPatients
+ * --------------------------------
+ * Scans the archive blocks overlapping [fromTime, toTime] in parallel,
+ * folding each chunk's records into a partial result of its own, then
+ * merges the partials into result in chunk order on the calling thread.
+ * Memory use grows with the number of chunks, not the number of records.
+ *
+ * fold: Adds a record to a partial; partials start as resultSize zero bytes
+ * merge: Adds a finished partial into result
+ * context: Passed to fold and merge
+ * result: The result to merge into, already initialized by the caller
+ * resultSize: The size in bytes of result and of each partial
+ *
+ * Returns: REPORT_ENGINE_SUCCESS, or REPORT_ENGINE_FAILURE if memory ran
+ *          out, in which case result is unchanged
+ */
+int foldDischargedPatients(time_t fromTime,
+                           time_t toTime,
+                           DischargeFold fold,
+                           PartialMerge merge,
+                           const void *context,
+                           void *result,
+                           size_t resultSize);
+
+/*
+ * Function: collectActivePatients
+ * -------------------------------
+ * Filters a view of the active patients in parallel slices, keeping the
+ * view's order.
+ *
+ * patients: The patients to filter, usually sorted by ID
+ * count: The number of patients
+ * matches: Receives the patients the filter keeps; the caller frees it
+ * matchCount: Receives the number of matches
+ *
+ * Returns: REPORT_ENGINE_SUCCESS, or REPORT_ENGINE_FAILURE if memory ran out
+ */
+int collectActivePatients(const Patient *patients[],
+                          int count,
+                          PatientFilter filter,
+                          const void *context,
+                          const Patient ***matches,
+                          int *matchCount);
+
+/*
+ * Function: stopReportEngine
+ * --------------------------
+ * Stops and joins the worker threads.
+ */
+void stopReportEngine(void);
+
+#endif // REPORT_ENGINE_H
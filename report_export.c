@@ -0,0 +1,203 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the streaming CSV and JSON export writer.
+ */
+
+#include "report_export.h"
+#include <stdio.h>
+#include <string.h>
+
+// Function prototypes for internal helper functions
+static void beginField(ExportWriter *exporter);
+static void writeCsvText(ReportWriter *writer, const char text[]);
+static void writeJsonText(ReportWriter *writer, const char text[]);
+
+/*
+ * Starts an export.
+ */
+void beginExport(ExportWriter *exporter,
+                 ReportWriter *writer,
+                 int format,
+                 const char *const columns[],
+                 int columnCount)
+{
+    exporter->writer      = writer;
+    exporter->format      = format;
+    exporter->columns     = columns;
+    exporter->columnCount = columnCount;
+    exporter->column      = 0;
+    exporter->rowCount    = 0;
+
+    if(format == EXPORT_FORMAT_JSON)
+    {
+        reportWrite(writer, "[", 1);
+        return;
+    }
+
+    for(int i = 0; i < columnCount; i++)
+    {
+        if(i > 0)
+        {
+            reportWrite(writer, ",", 1);
+        }
+        writeCsvText(writer, columns[i]);
+    }
+    reportWrite(writer, "\n", 1);
+}
+
+/*
+ * Writes a numeric field.
+ */
+void exportInteger(ExportWriter *exporter, long long value)
+{
+    beginField(exporter);
+    reportPrintf(exporter->writer, "%lld", value);
+}
+
+/*
+ * Writes a text field.
+ */
+void exportText(ExportWriter *exporter, const char text[])
+{
+    beginField(exporter);
+
+    if(exporter->format == EXPORT_FORMAT_JSON)
+    {
+        writeJsonText(exporter->writer, text);
+    }
+    else
+    {
+        writeCsvText(exporter->writer, text);
+    }
+}
+
+/*
+ * Writes a timestamp field as ISO 8601 local time.
+ */
+void exportTimestamp(ExportWriter *exporter, time_t timestamp)
+{
+    struct tm localTime;
+    char      timeStr[32];
+
+    localtime_r(&timestamp, &localTime);
+    strftime(timeStr, sizeof(timeStr), "%Y-%m-%dT%H:%M:%S", &localTime);
+    exportText(exporter, timeStr);
+}
+
+/*
+ * Closes the current CSV line or JSON object.
+ */
+void endExportRow(ExportWriter *exporter)
+{
+    if(exporter->format == EXPORT_FORMAT_JSON)
+    {
+        reportWrite(exporter->writer, "}", 1);
+    }
+    else
+    {
+        reportWrite(exporter->writer, "\n", 1);
+    }
+
+    exporter->column = 0;
+    exporter->rowCount++;
+}
+
+/*
+ * Closes the JSON array. CSV needs no trailer.
+ */
+void endExport(ExportWriter *exporter)
+{
+    if(exporter->format == EXPORT_FORMAT_JSON)
+    {
+        reportPrintf(exporter->writer, exporter->rowCount > 0 ? "\n]\n" : "]\n");
+    }
+}
+
+/*
+ * Writes the separator and, for JSON, the key that precede a field.
+ */
+static void beginField(ExportWriter *exporter)
+{
+    ReportWriter *writer = exporter->writer;
+
+    if(exporter->format == EXPORT_FORMAT_JSON)
+    {
+        if(exporter->column == 0)
+        {
+            reportPrintf(writer, exporter->rowCount > 0 ? ",\n{" : "\n{");
+        }
+        else
+        {
+            reportWrite(writer, ",", 1);
+        }
+
+        const char *key = exporter->column < exporter->columnCount ? exporter->columns[exporter->column] : "";
+        writeJsonText(writer, key);
+        reportWrite(writer, ":", 1);
+    }
+    else if(exporter->column > 0)
+    {
+        reportWrite(writer, ",", 1);
+    }
+
+    exporter->column++;
+}
+
+/*
+ * Writes a CSV field, quoting it when it holds a comma, quote or line
+ * break and doubling any quotes inside.
+ */
+static void writeCsvText(ReportWriter *writer, const char text[])
+{
+    if(strpbrk(text, ",\"\r\n") == NULL)
+    {
+        reportWrite(writer, text, strlen(text));
+        return;
+    }
+
+    reportWrite(writer, "\"", 1);
+    for(const char *quote; (quote = strchr(text, '"')) != NULL; text = quote + 1)
+    {
+        reportWrite(writer, text, (size_t) (quote - text + 1));
+        reportWrite(writer, "\"", 1);
+    }
+    reportWrite(writer, text, strlen(text));
+    reportWrite(writer, "\"", 1);
+}
+
+/*
+ * Writes a JSON string, copying runs of plain characters at once and
+ * escaping quotes, backslashes and control characters.
+ */
+static void writeJsonText(ReportWriter *writer, const char text[])
+{
+    const char *run = text;
+
+    reportWrite(writer, "\"", 1);
+    for(const char *p = text; *p != '\0'; p++)
+    {
+        unsigned char character = (unsigned char) *p;
+        if(character != '"' && character != '\\' && character >= 0x20)
+        {
+            continue;
+        }
+
+        reportWrite(writer, run, (size_t) (p - run));
+        if(character == '"' || character == '\\')
+        {
+            reportPrintf(writer, "\\%c", character);
+        }
+        else if(character == '\n')
+        {
+            reportWrite(writer, "\\n", 2);
+        }
+        else
+        {
+            reportPrintf(writer, "\\u%04x", character);
+        }
+        run = p + 1;
+    }
+    reportWrite(writer, run, strlen(run));
+    reportWrite(writer, "\"", 1);
+}
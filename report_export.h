@@ -0,0 +1,88 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the streaming CSV and JSON export writer.
+ *          Rows are written field by field straight into a report writer,
+ *          so an export holds no more than one buffer of output in memory
+ *          however many rows it produces.
+ *
+ *          CSV output starts with a header row of column names. JSON output
+ *          is an array with one object per row, keyed by column name.
+ */
+
+#ifndef REPORT_EXPORT_H
+#define REPORT_EXPORT_H
+
+#include <time.h>
+#include "report_writer.h"
+
+// Export formats
+#define EXPORT_FORMAT_CSV 1
+#define EXPORT_FORMAT_JSON 2
+
+typedef struct
+{
+    ReportWriter      *writer;
+    int                format;
+    const char *const *columns;
+    int                columnCount;
+    int                column;   // Next column of the current row
+    long long          rowCount;
+} ExportWriter;
+
+/*
+ * Function: beginExport
+ * ---------------------
+ * Starts an export and writes the CSV header row or the opening of the
+ * JSON array.
+ *
+ * exporter: Export state to initialize
+ * writer: Report writer that receives the output
+ * format: EXPORT_FORMAT_CSV or EXPORT_FORMAT_JSON
+ * columns: Column names, which must outlive the export
+ * columnCount: Number of columns
+ */
+void beginExport(ExportWriter *exporter,
+                 ReportWriter *writer,
+                 int format,
+                 const char *const columns[],
+                 int columnCount);
+
+/*
+ * Function: exportInteger
+ * -----------------------
+ * Writes the next field of the current row as a number.
+ */
+void exportInteger(ExportWriter *exporter, long long value);
+
+/*
+ * Function: exportText
+ * --------------------
+ * Writes the next field of the current row as a string, quoted and
+ * escaped as the format requires.
+ */
+void exportText(ExportWriter *exporter, const char text[]);
+
+/*
+ * Function: exportTimestamp
+ * -------------------------
+ * Writes the next field of the current row as an ISO 8601 local time
+ * (YYYY-MM-DDTHH:MM:SS).
+ */
+void exportTimestamp(ExportWriter *exporter, time_t timestamp);
+
+/*
+ * Function: endExportRow
+ * ----------------------
+ * Finishes the current row.
+ */
+void endExportRow(ExportWriter *exporter);
+
+/*
+ * Function: endExport
+ * -------------------
+ * Finishes the export. The report writer still needs to be closed.
+ */
+void endExport(ExportWriter *exporter);
+
+#endif // REPORT_EXPORT_H
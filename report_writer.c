@@ -0,0 +1,234 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the buffered, multi-sink report writer.
+ */
+
+#include "report_writer.h"
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+// Function prototypes for internal helper functions
+static int  writeToStream(void *target, const char data[], size_t length);
+static int  writeToString(void *target, const char data[], size_t length);
+static void deliver(ReportWriter *writer, const char data[], size_t length);
+
+/*
+ * Allocates the writer's buffer.
+ */
+int openReportWriter(ReportWriter *writer)
+{
+    memset(writer, 0, sizeof(ReportWriter));
+
+    writer->buffer = malloc(REPORT_BUFFER_SIZE);
+    return writer->buffer != NULL ? REPORT_SUCCESS : REPORT_FAILURE;
+}
+
+/*
+ * Attaches a sink.
+ */
+int addReportSink(ReportWriter *writer, ReportSinkWrite write, void *target)
+{
+    if(writer->sinkCount == MAX_REPORT_SINKS)
+    {
+        return REPORT_FAILURE;
+    }
+
+    writer->sinks[writer->sinkCount].write  = write;
+    writer->sinks[writer->sinkCount].target = target;
+    writer->sinkCount++;
+
+    return REPORT_SUCCESS;
+}
+
+/*
+ * Attaches standard output.
+ */
+int addConsoleSink(ReportWriter *writer)
+{
+    return addReportSink(writer, writeToStream, stdout);
+}
+
+/*
+ * Attaches an open file.
+ */
+int addFileSink(ReportWriter *writer, FILE *file)
+{
+    return addReportSink(writer, writeToStream, file);
+}
+
+/*
+ * Attaches an in-memory string.
+ */
+int addStringSink(ReportWriter *writer, ReportString *string)
+{
+    return addReportSink(writer, writeToString, string);
+}
+
+/*
+ * Formats directly into the free end of the buffer. Text that does not
+ * fit triggers a flush and is formatted again into the empty buffer;
+ * text longer than the whole buffer is formatted on the heap instead.
+ */
+void reportPrintf(ReportWriter *writer, const char *format, ...)
+{
+    va_list arguments;
+    size_t  available = REPORT_BUFFER_SIZE - writer->length;
+
+    va_start(arguments, format);
+    int length = vsnprintf(writer->buffer + writer->length, available, format, arguments);
+    va_end(arguments);
+
+    if(length < 0)
+    {
+        writer->failed = 1;
+        return;
+    }
+    if((size_t) length < available)
+    {
+        writer->length += (size_t) length;
+        return;
+    }
+
+    flushReportWriter(writer);
+
+    if((size_t) length < REPORT_BUFFER_SIZE)
+    {
+        va_start(arguments, format);
+        vsnprintf(writer->buffer, REPORT_BUFFER_SIZE, format, arguments);
+        va_end(arguments);
+        writer->length = (size_t) length;
+        return;
+    }
+
+    char *text = malloc((size_t) length + 1);
+    if(text == NULL)
+    {
+        writer->failed = 1;
+        return;
+    }
+    va_start(arguments, format);
+    vsnprintf(text, (size_t) length + 1, format, arguments);
+    va_end(arguments);
+
+    deliver(writer, text, (size_t) length);
+    free(text);
+}
+
+/*
+ * Copies text into the buffer, passing large blocks straight to the sinks.
+ */
+void reportWrite(ReportWriter *writer, const char data[], size_t length)
+{
+    if(length > REPORT_BUFFER_SIZE - writer->length)
+    {
+        flushReportWriter(writer);
+
+        if(length >= REPORT_BUFFER_SIZE)
+        {
+            deliver(writer, data, length);
+            return;
+        }
+    }
+
+    memcpy(writer->buffer + writer->length, data, length);
+    writer->length += length;
+}
+
+/*
+ * Sends the buffered text to every sink and empties the buffer.
+ */
+int flushReportWriter(ReportWriter *writer)
+{
+    if(writer->length > 0)
+    {
+        deliver(writer, writer->buffer, writer->length);
+        writer->length = 0;
+    }
+
+    return writer->failed ? REPORT_FAILURE : REPORT_SUCCESS;
+}
+
+/*
+ * Flushes and frees the buffer.
+ */
+int closeReportWriter(ReportWriter *writer)
+{
+    int result = flushReportWriter(writer);
+
+    free(writer->buffer);
+    writer->buffer = NULL;
+
+    return result;
+}
+
+/*
+ * Sets the failed flag, as a failed sink write would.
+ */
+void failReportWriter(ReportWriter *writer)
+{
+    writer->failed = 1;
+}
+
+/*
+ * Frees a string sink's text.
+ */
+void freeReportString(ReportString *string)
+{
+    free(string->text);
+    memset(string, 0, sizeof(ReportString));
+}
+
+/*
+ * Sink write for stdio streams.
+ */
+static int writeToStream(void *target, const char data[], size_t length)
+{
+    return fwrite(data, 1, length, (FILE *) target) == length ? REPORT_SUCCESS : REPORT_FAILURE;
+}
+
+/*
+ * Sink write for in-memory strings; the text stays null-terminated.
+ */
+static int writeToString(void *target, const char data[], size_t length)
+{
+    ReportString *string = target;
+
+    if(string->length + length + 1 > string->capacity)
+    {
+        size_t newCapacity = string->capacity == 0 ? REPORT_BUFFER_SIZE : string->capacity;
+        while(newCapacity < string->length + length + 1)
+        {
+            newCapacity *= 2;
+        }
+
+        char *grown = realloc(string->text, newCapacity);
+        if(grown == NULL)
+        {
+            return REPORT_FAILURE;
+        }
+        string->text     = grown;
+        string->capacity = newCapacity;
+    }
+
+    memcpy(string->text + string->length, data, length);
+    string->length              += length;
+    string->text[string->length] = '\0';
+
+    return REPORT_SUCCESS;
+}
+
+/*
+ * Hands one block to every sink, remembering any failure.
+ */
+static void deliver(ReportWriter *writer, const char data[], size_t length)
+{
+    for(int i = 0; i < writer->sinkCount; i++)
+    {
+        if(!writer->sinks[i].write(writer->sinks[i].target, data, length))
+        {
+            writer->failed = 1;
+        }
+    }
+}
@@ -0,0 +1,140 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the report writer, which formats report text
+ *          once into a buffer and hands each full buffer to every attached
+ *          sink (console, file, in-memory string, or any other target).
+ */
+
+#ifndef REPORT_WRITER_H
+#define REPORT_WRITER_H
+
+#include <stddef.h>
+#include <stdio.h>
+
+#define REPORT_BUFFER_SIZE 65536
+#define MAX_REPORT_SINKS 4
+
+#define REPORT_SUCCESS 1
+#define REPORT_FAILURE 0
+
+/*
+ * Delivers a block of report text to a target.
+ * Returns REPORT_SUCCESS or REPORT_FAILURE.
+ */
+typedef int (*ReportSinkWrite)(void *target, const char data[], size_t length);
+
+typedef struct
+{
+    ReportSinkWrite write;
+    void           *target;
+} ReportSink;
+
+typedef struct
+{
+    char      *buffer;
+    size_t     length;
+    ReportSink sinks[MAX_REPORT_SINKS];
+    int        sinkCount;
+    int        failed;
+} ReportWriter;
+
+/*
+ * Growable string that collects report text in memory.
+ */
+typedef struct
+{
+    char  *text;
+    size_t length;
+    size_t capacity;
+} ReportString;
+
+/*
+ * Function: openReportWriter
+ * --------------------------
+ * Prepares a writer with no sinks.
+ *
+ * Returns: REPORT_SUCCESS, or REPORT_FAILURE if the buffer cannot be allocated
+ */
+int openReportWriter(ReportWriter *writer);
+
+/*
+ * Function: addReportSink
+ * -----------------------
+ * Attaches a target that receives every block the writer flushes.
+ *
+ * Returns: REPORT_SUCCESS, or REPORT_FAILURE if MAX_REPORT_SINKS are attached
+ */
+int addReportSink(ReportWriter *writer, ReportSinkWrite write, void *target);
+
+/*
+ * Function: addConsoleSink
+ * ------------------------
+ * Attaches standard output.
+ */
+int addConsoleSink(ReportWriter *writer);
+
+/*
+ * Function: addFileSink
+ * ---------------------
+ * Attaches an open file. The caller keeps ownership of the file.
+ */
+int addFileSink(ReportWriter *writer, FILE *file);
+
+/*
+ * Function: addStringSink
+ * -----------------------
+ * Attaches an in-memory string, which must start zeroed and is freed with
+ * freeReportString.
+ */
+int addStringSink(ReportWriter *writer, ReportString *string);
+
+/*
+ * Function: reportPrintf
+ * ----------------------
+ * Formats text once into the writer's buffer, flushing it to the sinks
+ * first if the text does not fit.
+ */
+void reportPrintf(ReportWriter *writer, const char *format, ...);
+
+/*
+ * Function: reportWrite
+ * ---------------------
+ * Appends preformatted text to the writer's buffer.
+ */
+void reportWrite(ReportWriter *writer, const char data[], size_t length);
+
+/*
+ * Function: flushReportWriter
+ * ---------------------------
+ * Hands the buffered text to every sink.
+ *
+ * Returns: REPORT_SUCCESS, or REPORT_FAILURE if any write so far has failed
+ */
+int flushReportWriter(ReportWriter *writer);
+
+/*
+ * Function: closeReportWriter
+ * ---------------------------
+ * Flushes the writer and frees its buffer. Sinks are not closed.
+ *
+ * Returns: REPORT_SUCCESS, or REPORT_FAILURE if any write failed
+ */
+int closeReportWriter(ReportWriter *writer);
+
+/*
+ * Function: failReportWriter
+ * --------------------------
+ * Marks a report as failed for a reason outside the writer, such as data
+ * that could not be read, so closeReportWriter returns REPORT_FAILURE.
+ */
+void failReportWriter(ReportWriter *writer);
+
+/*
+ * Function: freeReportString
+ * --------------------------
+ * Frees the text collected by a string sink.
+ */
+void freeReportString(ReportString *string);
+
+#endif // REPORT_WRITER_H
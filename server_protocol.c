@@ -0,0 +1,330 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the message encoding and framing of the
+ *          server protocol.
+ */
+
+#include "server_protocol.h"
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "diagnosis_dictionary.h"
+#include "patient_storage.h"
+
+// Private constants
+#define INITIAL_MESSAGE_CAPACITY 256
+#define MAX_VARINT_SIZE 10
+#define MAX_FRAME_LENGTH 0xFFFFFFFFULL // The largest length a frame header holds
+
+// Function prototypes for internal helper functions
+static int reserveMessage(ProtocolMessage *message, size_t extra);
+static int writeAll(int socketFd, const unsigned char data[], size_t length);
+static int readAll(int socketFd, unsigned char data[], size_t length);
+
+/*
+ * Reads the socket path from the environment, if set.
+ */
+const char *getSocketPath(void)
+{
+    const char *path = getenv(SOCKET_PATH_VARIABLE);
+    return path != NULL && path[0] != '\0' ? path : DEFAULT_SOCKET_PATH;
+}
+
+/*
+ * Empties a message.
+ */
+void resetMessage(ProtocolMessage *message)
+{
+    message->length = 0;
+    message->failed = 0;
+}
+
+/*
+ * Frees a message's buffer.
+ */
+void freeMessage(ProtocolMessage *message)
+{
+    free(message->data);
+    message->data     = NULL;
+    message->length   = 0;
+    message->capacity = 0;
+    message->failed   = 0;
+}
+
+/*
+ * Appends one byte.
+ */
+void putByte(ProtocolMessage *message, int value)
+{
+    unsigned char byte = (unsigned char) value;
+    putBytes(message, &byte, 1);
+}
+
+/*
+ * Appends an unsigned varint.
+ */
+void putVarint(ProtocolMessage *message, unsigned long long value)
+{
+    unsigned char bytes[MAX_VARINT_SIZE];
+    putBytes(message, bytes, encodeVarint(value, bytes));
+}
+
+/*
+ * Appends a length-prefixed string.
+ */
+void putString(ProtocolMessage *message, const char text[])
+{
+    size_t length = strlen(text);
+
+    putVarint(message, length);
+    putBytes(message, text, length);
+}
+
+/*
+ * Appends raw bytes, growing the buffer as needed.
+ */
+void putBytes(ProtocolMessage *message, const void *data, size_t length)
+{
+    if(length == 0 || !reserveMessage(message, length))
+    {
+        return;
+    }
+
+    memcpy(message->data + message->length, data, length);
+    message->length += length;
+}
+
+/*
+ * Appends a patient with their diagnosis as text.
+ */
+void putPatient(ProtocolMessage *message, const Patient *patient)
+{
+    putVarint(message, (unsigned long long) patient->patientId);
+    putString(message, patient->name);
+    putVarint(message, (unsigned long long) patient->ageInYears);
+    putString(message, getDiagnosisText(patient->diagnosisId));
+    putVarint(message, (unsigned long long) patient->roomNumber);
+    putVarint(message, (unsigned long long) patient->admissionDate);
+}
+
+/*
+ * Starts reading a message.
+ */
+void openReader(ProtocolReader *reader, const ProtocolMessage *message)
+{
+    reader->data     = message->data;
+    reader->length   = message->length;
+    reader->position = 0;
+    reader->failed   = 0;
+}
+
+/*
+ * Reads one byte.
+ */
+int getByte(ProtocolReader *reader)
+{
+    if(reader->failed || reader->position >= reader->length)
+    {
+        reader->failed = 1;
+        return 0;
+    }
+
+    return reader->data[reader->position++];
+}
+
+/*
+ * Reads an unsigned varint.
+ */
+unsigned long long getVarint(ProtocolReader *reader)
+{
+    unsigned long long value = 0;
+
+    if(reader->failed || !decodeVarint(reader->data, reader->length, &reader->position, &value))
+    {
+        reader->failed = 1;
+        return 0;
+    }
+
+    return value;
+}
+
+/*
+ * Reads a length-prefixed string into a terminated buffer.
+ */
+void getString(ProtocolReader *reader, char text[], size_t size)
+{
+    unsigned long long length = getVarint(reader);
+
+    if(reader->failed || length >= size || length > reader->length - reader->position)
+    {
+        reader->failed = 1;
+        text[0]        = '\0';
+        return;
+    }
+
+    memcpy(text, reader->data + reader->position, (size_t) length);
+    text[length]      = '\0';
+    reader->position += (size_t) length;
+}
+
+/*
+ * Reads a patient written by putPatient.
+ */
+void getPatient(ProtocolReader *reader, ProtocolPatient *patient)
+{
+    patient->patientId = (int) getVarint(reader);
+    getString(reader, patient->name, sizeof(patient->name));
+    patient->ageInYears = (int) getVarint(reader);
+    getString(reader, patient->diagnosis, sizeof(patient->diagnosis));
+    patient->roomNumber    = (int) getVarint(reader);
+    patient->admissionDate = (time_t) getVarint(reader);
+}
+
+/*
+ * Appends the frame header and the message.
+ */
+void appendFrame(ProtocolMessage *stream, const ProtocolMessage *message)
+{
+    unsigned char header[FRAME_HEADER_SIZE];
+
+    if(message->length > MAX_FRAME_LENGTH)
+    {
+        stream->failed = 1;
+        return;
+    }
+
+    storeLittleEndian(header, message->length, FRAME_HEADER_SIZE);
+    putBytes(stream, header, FRAME_HEADER_SIZE);
+    putBytes(stream, message->data, message->length);
+}
+
+/*
+ * Writes the frame header and the message.
+ */
+int sendMessage(int socketFd, const ProtocolMessage *message)
+{
+    unsigned char header[FRAME_HEADER_SIZE];
+
+    if(message->length > MAX_FRAME_LENGTH)
+    {
+        return PROTOCOL_FAILURE;
+    }
+
+    storeLittleEndian(header, message->length, FRAME_HEADER_SIZE);
+    return writeAll(socketFd, header, FRAME_HEADER_SIZE) &&
+           writeAll(socketFd, message->data, message->length);
+}
+
+/*
+ * Reads the frame header, then exactly the message it announces.
+ */
+int receiveMessage(int socketFd, ProtocolMessage *message, size_t maxLength)
+{
+    unsigned char header[FRAME_HEADER_SIZE];
+
+    resetMessage(message);
+    if(!readAll(socketFd, header, FRAME_HEADER_SIZE))
+    {
+        return PROTOCOL_FAILURE;
+    }
+
+    size_t length = (size_t) loadLittleEndian(header, FRAME_HEADER_SIZE);
+    if(length > maxLength || !reserveMessage(message, length))
+    {
+        return PROTOCOL_FAILURE;
+    }
+
+    if(!readAll(socketFd, message->data, length))
+    {
+        return PROTOCOL_FAILURE;
+    }
+    message->length = length;
+
+    return PROTOCOL_SUCCESS;
+}
+
+/*
+ * Makes room for extra more bytes, doubling the buffer.
+ * Returns 1 on success, 0 (and marks the message failed) otherwise.
+ */
+static int reserveMessage(ProtocolMessage *message, size_t extra)
+{
+    if(message->failed)
+    {
+        return 0;
+    }
+
+    if(message->length + extra <= message->capacity)
+    {
+        return 1;
+    }
+
+    size_t capacity = message->capacity > 0 ? message->capacity : INITIAL_MESSAGE_CAPACITY;
+    while(capacity < message->length + extra)
+    {
+        capacity *= 2;
+    }
+
+    unsigned char *grown = realloc(message->data, capacity);
+    if(grown == NULL)
+    {
+        message->failed = 1;
+        return 0;
+    }
+
+    message->data     = grown;
+    message->capacity = capacity;
+    return 1;
+}
+
+/*
+ * Writes a whole buffer, retrying short and interrupted writes. A peer
+ * that has gone away fails the write instead of raising SIGPIPE.
+ */
+static int writeAll(int socketFd, const unsigned char data[], size_t length)
+{
+    while(length > 0)
+    {
+        ssize_t written = send(socketFd, data, length, MSG_NOSIGNAL);
+        if(written < 0)
+        {
+            if(errno == EINTR)
+            {
+                continue;
+            }
+            return PROTOCOL_FAILURE;
+        }
+
+        data   += written;
+        length -= (size_t) written;
+    }
+
+    return PROTOCOL_SUCCESS;
+}
+
+/*
+ * Reads exactly length bytes, failing at end of stream.
+ */
+static int readAll(int socketFd, unsigned char data[], size_t length)
+{
+    while(length > 0)
+    {
+        ssize_t received = read(socketFd, data, length);
+        if(received < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if(received <= 0)
+        {
+            return PROTOCOL_FAILURE;
+        }
+
+        data   += received;
+        length -= (size_t) received;
+    }
+
+    return PROTOCOL_SUCCESS;
+}
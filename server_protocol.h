@@ -0,0 +1,240 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the binary protocol spoken between the
+ *          hospital server and its clients over a Unix domain socket.
+ *
+ *          Every message is a frame: a 4-byte little-endian length, then
+ *          that many bytes of message. A message starts with a type byte
+ *          (a REQUEST_* in requests, a RESPONSE_* status in responses) and a
+ *          varint tag the client picks and the server echoes, followed by
+ *          the fields of that type. Integers are varints (see
+ *          patient_storage.h) and strings are a varint length followed by
+ *          the bytes, without a terminator:
+ *
+ *            REQUEST_ADMIT      string name, varint age, string diagnosis,
+ *                               varint room
+ *              RESPONSE_OK      patient, varint previousPatientId (0 for a
+ *                               first stay), varint daysSinceDischarge,
+ *                               byte withinWindow
+ *            REQUEST_DISCHARGE  varint count, count x varint patientId
+ *              RESPONSE_OK      varint discharged
+ *            REQUEST_LOOKUP     varint patientId
+ *              RESPONSE_OK      byte discharged, patient, and the varint
+ *                               discharge time if discharged
+ *            REQUEST_REPORT     byte report, byte format, byte timeframe
+ *              RESPONSE_OK      the report text, to the end of the message
+ *            REQUEST_ASSIGN     varint doctorId, byte day, byte time,
+ *                               byte replace
+ *              RESPONSE_OK      no fields
+ *
+ *          A patient is sent as varint patientId, string name, varint age,
+ *          string diagnosis, varint room and varint admission time, so
+ *          clients need no diagnosis dictionary of their own. Any other
+ *          status carries no fields.
+ *
+ *          Clients may send several requests without waiting for answers.
+ *          Reports are answered when they finish, so responses can arrive
+ *          in a different order than their requests; match them by tag.
+ */
+
+#ifndef SERVER_PROTOCOL_H
+#define SERVER_PROTOCOL_H
+
+#include <stddef.h>
+#include <time.h>
+#include "patient_data.h"
+
+#define DEFAULT_SOCKET_PATH "hospital.sock"
+#define SOCKET_PATH_VARIABLE "HOSPITAL_SOCKET" // Overrides the default path
+
+#define FRAME_HEADER_SIZE 4
+#define MAX_REQUEST_SIZE 4096                 // Fits the largest admit or discharge request
+#define MAX_RESPONSE_SIZE (256 * 1024 * 1024) // Reports are sent whole; larger ones fail
+#define MAX_DISCHARGE_REQUEST_IDS 512
+
+// Request types
+#define REQUEST_ADMIT 1
+#define REQUEST_DISCHARGE 2
+#define REQUEST_LOOKUP 3
+#define REQUEST_REPORT 4
+#define REQUEST_ASSIGN 5
+
+// Response statuses
+#define RESPONSE_OK 0
+#define RESPONSE_NOT_FOUND 1   // No such patient
+#define RESPONSE_INVALID 2     // A detail failed validation
+#define RESPONSE_CONFLICT 3    // The room or shift is taken
+#define RESPONSE_FAILED 4      // The server ran out of memory, could not write, or a report was too large
+#define RESPONSE_BAD_REQUEST 5 // The message could not be decoded
+
+// Reports for REQUEST_REPORT, formats as in report_export.h
+#define PROTOCOL_REPORT_ADMISSIONS 1
+#define PROTOCOL_REPORT_DISCHARGES 2
+#define PROTOCOL_REPORT_ROOM_USAGE 3
+#define PROTOCOL_REPORT_DOCTOR_UTILIZATION 4
+
+#define PROTOCOL_SUCCESS 1
+#define PROTOCOL_FAILURE 0
+
+/*
+ * A message being built or received. Writes that run out of memory set
+ * failed, so a message can be built without checking every field.
+ */
+typedef struct
+{
+    unsigned char *data;
+    size_t         length;
+    size_t         capacity;
+    int            failed;
+} ProtocolMessage;
+
+/*
+ * Reads fields from a received message in order. Reads past the end or
+ * of malformed fields set failed and return zeroes.
+ */
+typedef struct
+{
+    const unsigned char *data;
+    size_t               length;
+    size_t               position;
+    int                  failed;
+} ProtocolReader;
+
+/*
+ * A patient as sent over the wire, with the diagnosis as text.
+ */
+typedef struct
+{
+    int    patientId;
+    char   name[MAX_PATIENT_NAME_LENGTH];
+    int    ageInYears;
+    char   diagnosis[MAX_DIAGNOSIS_LENGTH];
+    int    roomNumber;
+    time_t admissionDate;
+} ProtocolPatient;
+
+/*
+ * Function: getSocketPath
+ * -----------------------
+ * Returns the server socket path: SOCKET_PATH_VARIABLE when set, otherwise
+ * DEFAULT_SOCKET_PATH in the working directory.
+ */
+const char *getSocketPath(void);
+
+/*
+ * Function: resetMessage
+ * ----------------------
+ * Empties a message, keeping its buffer. A zeroed message is empty.
+ */
+void resetMessage(ProtocolMessage *message);
+
+/*
+ * Function: freeMessage
+ * ---------------------
+ * Frees a message's buffer.
+ */
+void freeMessage(ProtocolMessage *message);
+
+/*
+ * Function: putByte
+ * -----------------
+ * Appends one byte.
+ */
+void putByte(ProtocolMessage *message, int value);
+
+/*
+ * Function: putVarint
+ * -------------------
+ * Appends an unsigned varint.
+ */
+void putVarint(ProtocolMessage *message, unsigned long long value);
+
+/*
+ * Function: putString
+ * -------------------
+ * Appends a length-prefixed string.
+ */
+void putString(ProtocolMessage *message, const char text[]);
+
+/*
+ * Function: putBytes
+ * ------------------
+ * Appends raw bytes with no length prefix.
+ */
+void putBytes(ProtocolMessage *message, const void *data, size_t length);
+
+/*
+ * Function: putPatient
+ * --------------------
+ * Appends a patient, looking up the text of their diagnosis.
+ */
+void putPatient(ProtocolMessage *message, const Patient *patient);
+
+/*
+ * Function: openReader
+ * --------------------
+ * Starts reading a received message from its first byte.
+ */
+void openReader(ProtocolReader *reader, const ProtocolMessage *message);
+
+/*
+ * Function: getByte
+ * -----------------
+ * Reads one byte.
+ */
+int getByte(ProtocolReader *reader);
+
+/*
+ * Function: getVarint
+ * -------------------
+ * Reads an unsigned varint.
+ */
+unsigned long long getVarint(ProtocolReader *reader);
+
+/*
+ * Function: getString
+ * -------------------
+ * Reads a length-prefixed string into a buffer of size bytes. A string
+ * that does not fit, terminator included, fails the reader.
+ */
+void getString(ProtocolReader *reader, char text[], size_t size);
+
+/*
+ * Function: getPatient
+ * --------------------
+ * Reads a patient written by putPatient.
+ */
+void getPatient(ProtocolReader *reader, ProtocolPatient *patient);
+
+/*
+ * Function: appendFrame
+ * ---------------------
+ * Appends a message as one frame to an outgoing byte stream. A message too
+ * long for a frame header fails the stream instead.
+ */
+void appendFrame(ProtocolMessage *stream, const ProtocolMessage *message);
+
+/*
+ * Function: sendMessage
+ * ---------------------
+ * Writes a message as one frame to a blocking socket.
+ *
+ * Returns: PROTOCOL_SUCCESS, or PROTOCOL_FAILURE if the peer went away or
+ *          the message is too long for a frame
+ */
+int sendMessage(int socketFd, const ProtocolMessage *message);
+
+/*
+ * Function: receiveMessage
+ * ------------------------
+ * Reads one frame from a blocking socket into a message.
+ *
+ * maxLength: Frames longer than this are refused
+ *
+ * Returns: PROTOCOL_SUCCESS, or PROTOCOL_FAILURE at end of stream, on a
+ *          read error or on an oversized frame
+ */
+int receiveMessage(int socketFd, ProtocolMessage *message, size_t maxLength);
+
+#endif // SERVER_PROTOCOL_H
@@ -0,0 +1,342 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the length-of-stay analytics.
+ *
+ *          Sketch bucket 0 counts stays under an hour, and bucket k counts
+ *          stays from GAMMA^(k-1) up to GAMMA^k hours, where GAMMA is
+ *          (1 + STAY_RELATIVE_ERROR) / (1 - STAY_RELATIVE_ERROR). Reading a
+ *          bucket back as 2 * GAMMA^k / (GAMMA + 1) hours is then never
+ *          further than STAY_RELATIVE_ERROR from any stay it counted. The
+ *          bucket bounds are worked out once per pass, so placing a stay is
+ *          a binary search rather than a logarithm.
+ */
+
+#include "stay_analytics.h"
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "activity_counters.h"
+#include "diagnosis_dictionary.h"
+#include "discharge_archive.h"
+#include "report_engine.h"
+
+// Private constants
+#define SECONDS_PER_HOUR 3600.0
+#define HOURS_PER_DAY 24.0
+#define NOT_FOUND (-1)
+
+// Upper bounds in days of every histogram bin but the last
+static const double HISTOGRAM_BOUNDS[STAY_HISTOGRAM_BINS - 1] = { 1, 2, 3, 7, 14, 30 };
+
+static const char *const HISTOGRAM_LABELS[STAY_HISTOGRAM_BINS] = { "<1d",  "1-2d",   "2-3d", "3-7d",
+                                                                   "7-14d", "14-30d", "30d+" };
+
+/*
+ * What the workers share: the size of the result, the sketch's bucket
+ * bounds and the instant each month starts, so grouping a stay needs no
+ * logarithm or date conversion.
+ */
+typedef struct
+{
+    int    diagnosisCount;
+    double bucketBounds[STAY_SKETCH_BUCKETS];  // Upper bound in hours of each bucket
+    time_t monthStarts[STAY_MONTHS + 1];       // The last is the start of next month
+} StayScope;
+
+// Function prototypes for internal helper functions
+static void   foldStay(const DischargedPatient *dischargedPatient, void *partial, const void *context);
+static void   mergeStays(void *result, const void *partial, const void *context);
+static void   addStay(StayStats *stats, double hours, int bucket, int bin);
+static void   mergeStayStats(StayStats *into, const StayStats *from);
+static int    findSketchBucket(const StayScope *scope, double hours);
+static int    findHistogramBin(double hours);
+static int    findMonth(const StayScope *scope, time_t timestamp);
+static double getGamma(void);
+
+/*
+ * Works out the bucket bounds and month starts, then folds the whole
+ * archive on the report workers.
+ */
+StayAnalytics *analyzeLengthsOfStay(void)
+{
+    StayScope scope;
+    struct tm currentTime;
+    time_t    now   = time(NULL);
+    double    gamma = getGamma();
+    double    bound = 1.0;
+
+    scope.diagnosisCount = getDiagnosisCount();
+    for(int i = 0; i < STAY_SKETCH_BUCKETS; i++)
+    {
+        scope.bucketBounds[i] = bound;
+        bound                *= gamma;
+    }
+
+    localtime_r(&now, &currentTime);
+    for(int i = 0; i <= STAY_MONTHS; i++)
+    {
+        struct tm start = currentTime;
+        start.tm_mon   += i - (STAY_MONTHS - 1);
+        start.tm_mday   = 1;
+        start.tm_hour   = 0;
+        start.tm_min    = 0;
+        start.tm_sec    = 0;
+        start.tm_isdst  = -1;
+
+        // mktime normalizes the month, stepping back across years
+        scope.monthStarts[i] = mktime(&start);
+    }
+
+    size_t         size      = sizeof(StayAnalytics) + sizeof(StayStats) * (size_t) scope.diagnosisCount;
+    StayAnalytics *analytics = calloc(1, size);
+    if(analytics == NULL)
+    {
+        return NULL;
+    }
+    analytics->firstMonth     = getMonthNumberOfDate(&currentTime) - (STAY_MONTHS - 1);
+    analytics->diagnosisCount = scope.diagnosisCount;
+
+    if(!foldDischargedPatients(ARCHIVE_BEGINNING_OF_TIME, ARCHIVE_END_OF_TIME, foldStay, mergeStays, &scope,
+                               analytics, size))
+    {
+        free(analytics);
+        return NULL;
+    }
+
+    return analytics;
+}
+
+/*
+ * The exact mean, from the running total.
+ */
+double getStayMean(const StayStats *stats)
+{
+    return stats->count > 0 ? stats->totalHours / (double) stats->count : 0.0;
+}
+
+/*
+ * Walks the sketch to the bucket holding the quantile's rank and reads it
+ * back at the bucket's midpoint in relative terms, never past the longest
+ * stay seen.
+ */
+double getStayQuantile(const StayStats *stats, double quantile)
+{
+    if(stats->count == 0)
+    {
+        return 0.0;
+    }
+
+    quantile             = quantile < 0.0 ? 0.0 : quantile > 1.0 ? 1.0 : quantile;
+    double    rank       = quantile * (double) (stats->count - 1);
+    long long cumulative = 0;
+    int       bucket     = 0;
+
+    while(bucket < STAY_SKETCH_BUCKETS - 1)
+    {
+        cumulative += stats->sketch[bucket];
+        if((double) cumulative > rank)
+        {
+            break;
+        }
+        bucket++;
+    }
+
+    if(bucket == 0)
+    {
+        return stats->maxHours < 0.5 ? stats->maxHours : 0.5;
+    }
+
+    double gamma = getGamma();
+    double upper = 1.0;
+    for(int i = 0; i < bucket; i++)
+    {
+        upper *= gamma;
+    }
+
+    double estimate = 2.0 * upper / (gamma + 1.0);
+    return estimate < stats->maxHours ? estimate : stats->maxHours;
+}
+
+/*
+ * Returns a histogram bin's label.
+ */
+const char *getStayHistogramLabel(int bin)
+{
+    return bin >= 0 && bin < STAY_HISTOGRAM_BINS ? HISTOGRAM_LABELS[bin] : "";
+}
+
+/*
+ * Report engine fold. Adds one stay to every group it belongs to in a
+ * chunk's partial.
+ */
+static void foldStay(const DischargedPatient *dischargedPatient, void *partial, const void *context)
+{
+    const StayScope *scope     = context;
+    StayAnalytics   *analytics = partial;
+    const Patient   *patient   = &dischargedPatient->patient;
+
+    double hours = difftime(dischargedPatient->dischargeDate, patient->admissionDate) / SECONDS_PER_HOUR;
+    hours        = hours > 0.0 ? hours : 0.0;
+
+    int bucket = findSketchBucket(scope, hours);
+    int bin    = findHistogramBin(hours);
+    int room   = patient->roomNumber >= 1 && patient->roomNumber <= MAX_ROOMS ? patient->roomNumber : 0;
+    int month  = findMonth(scope, dischargedPatient->dischargeDate);
+
+    addStay(&analytics->overall, hours, bucket, bin);
+    addStay(&analytics->rooms[room], hours, bucket, bin);
+
+    if(patient->diagnosisId >= 0 && patient->diagnosisId < scope->diagnosisCount)
+    {
+        addStay(&analytics->diagnoses[patient->diagnosisId], hours, bucket, bin);
+    }
+
+    if(month != NOT_FOUND)
+    {
+        addStay(&analytics->months[month], hours, bucket, bin);
+    }
+    else if(dischargedPatient->dischargeDate < scope->monthStarts[0])
+    {
+        addStay(&analytics->earlierMonths, hours, bucket, bin);
+    }
+}
+
+/*
+ * Report engine merge. Adds a chunk's groups into the result's.
+ */
+static void mergeStays(void *result, const void *partial, const void *context)
+{
+    const StayScope     *scope = context;
+    StayAnalytics       *into  = result;
+    const StayAnalytics *from  = partial;
+
+    mergeStayStats(&into->overall, &from->overall);
+    mergeStayStats(&into->earlierMonths, &from->earlierMonths);
+    for(int i = 0; i <= MAX_ROOMS; i++)
+    {
+        mergeStayStats(&into->rooms[i], &from->rooms[i]);
+    }
+    for(int i = 0; i < STAY_MONTHS; i++)
+    {
+        mergeStayStats(&into->months[i], &from->months[i]);
+    }
+    for(int i = 0; i < scope->diagnosisCount; i++)
+    {
+        mergeStayStats(&into->diagnoses[i], &from->diagnoses[i]);
+    }
+}
+
+/*
+ * Counts one stay in a group.
+ */
+static void addStay(StayStats *stats, double hours, int bucket, int bin)
+{
+    stats->count++;
+    stats->totalHours += hours;
+    stats->maxHours    = hours > stats->maxHours ? hours : stats->maxHours;
+    stats->histogram[bin]++;
+    stats->sketch[bucket]++;
+}
+
+/*
+ * Adds one group's stays to another's.
+ */
+static void mergeStayStats(StayStats *into, const StayStats *from)
+{
+    if(from->count == 0)
+    {
+        return;
+    }
+
+    into->count      += from->count;
+    into->totalHours += from->totalHours;
+    into->maxHours    = from->maxHours > into->maxHours ? from->maxHours : into->maxHours;
+    for(int i = 0; i < STAY_HISTOGRAM_BINS; i++)
+    {
+        into->histogram[i] += from->histogram[i];
+    }
+    for(int i = 0; i < STAY_SKETCH_BUCKETS; i++)
+    {
+        into->sketch[i] += from->sketch[i];
+    }
+}
+
+/*
+ * Binary searches for the first bucket whose upper bound is above the
+ * stay. Stays past the last bound share the last bucket.
+ */
+static int findSketchBucket(const StayScope *scope, double hours)
+{
+    int low  = 0;
+    int high = STAY_SKETCH_BUCKETS - 1;
+
+    while(low < high)
+    {
+        int middle = (low + high) / 2;
+        if(hours < scope->bucketBounds[middle])
+        {
+            high = middle;
+        }
+        else
+        {
+            low = middle + 1;
+        }
+    }
+
+    return low;
+}
+
+/*
+ * Returns the histogram bin of a stay.
+ */
+static int findHistogramBin(double hours)
+{
+    double days = hours / HOURS_PER_DAY;
+    int    bin  = 0;
+
+    while(bin < STAY_HISTOGRAM_BINS - 1 && days >= HISTOGRAM_BOUNDS[bin])
+    {
+        bin++;
+    }
+
+    return bin;
+}
+
+/*
+ * Binary searches the month starts for the month a discharge fell in.
+ * Returns NOT_FOUND outside the months grouped separately.
+ */
+static int findMonth(const StayScope *scope, time_t timestamp)
+{
+    if(timestamp < scope->monthStarts[0] || timestamp >= scope->monthStarts[STAY_MONTHS])
+    {
+        return NOT_FOUND;
+    }
+
+    int low  = 0;
+    int high = STAY_MONTHS - 1;
+
+    while(low < high)
+    {
+        int middle = (low + high + 1) / 2;
+        if(scope->monthStarts[middle] <= timestamp)
+        {
+            low = middle;
+        }
+        else
+        {
+            high = middle - 1;
+        }
+    }
+
+    return low;
+}
+
+/*
+ * The factor by which sketch bucket bounds grow.
+ */
+static double getGamma(void)
+{
+    return (1.0 + STAY_RELATIVE_ERROR) / (1.0 - STAY_RELATIVE_ERROR);
+}
@@ -0,0 +1,91 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the length-of-stay analytics: how long
+ *          discharged patients stayed, overall and by diagnosis, room and
+ *          month of discharge, with the mean, quantiles and a histogram of
+ *          each group.
+ *
+ *          Everything comes from one parallel pass over the discharge
+ *          archive. Quantiles come from a log-bucketed sketch: stays are
+ *          counted in buckets whose bounds grow by a constant factor, so any
+ *          quantile is read back within STAY_RELATIVE_ERROR of the true
+ *          stay, and sketches from different archive chunks merge by adding
+ *          their buckets. Every group has a fixed size, so memory depends on
+ *          the number of diagnoses, never on the number of discharges.
+ */
+
+#ifndef STAY_ANALYTICS_H
+#define STAY_ANALYTICS_H
+
+#include "patient_management.h"
+
+#define STAY_RELATIVE_ERROR 0.02
+#define STAY_SKETCH_BUCKETS 320 // Stays up to about 39 years
+#define STAY_HISTOGRAM_BINS 7
+#define STAY_MONTHS 120 // Months of discharges grouped separately, up to this one
+
+/*
+ * Lengths of stay for one group of discharged patients.
+ */
+typedef struct
+{
+    long long    count;
+    double       totalHours;
+    double       maxHours;
+    unsigned int histogram[STAY_HISTOGRAM_BINS];
+    unsigned int sketch[STAY_SKETCH_BUCKETS]; // Bucket 0 holds stays under an hour
+} StayStats;
+
+/*
+ * The result of analyzeLengthsOfStay. months[STAY_MONTHS - 1] is the
+ * current month, and discharges before months[0] are in earlierMonths.
+ */
+typedef struct
+{
+    int       firstMonth; // Month number of months[0], as from getMonthNumberOfDate
+    int       diagnosisCount;
+    StayStats overall;
+    StayStats earlierMonths;
+    StayStats rooms[MAX_ROOMS + 1]; // Index 0 collects out-of-range rooms
+    StayStats months[STAY_MONTHS];
+    StayStats diagnoses[];          // diagnosisCount entries, by diagnosis ID
+} StayAnalytics;
+
+/*
+ * Function: analyzeLengthsOfStay
+ * ------------------------------
+ * Computes length-of-stay statistics over the whole discharge archive.
+ *
+ * Returns: The statistics, to be freed by the caller, or NULL if memory
+ *          ran out
+ */
+StayAnalytics *analyzeLengthsOfStay(void);
+
+/*
+ * Function: getStayMean
+ * ---------------------
+ * Returns: The mean stay of a group in hours, or 0 for an empty group
+ */
+double getStayMean(const StayStats *stats);
+
+/*
+ * Function: getStayQuantile
+ * -------------------------
+ * Estimates a quantile of a group's stays from its sketch.
+ *
+ * quantile: Between 0 and 1, e.g. 0.5 for the median
+ *
+ * Returns: The stay in hours, within STAY_RELATIVE_ERROR of the true
+ *          quantile for stays of an hour or more, or 0 for an empty group
+ */
+double getStayQuantile(const StayStats *stats, double quantile);
+
+/*
+ * Function: getStayHistogramLabel
+ * -------------------------------
+ * Returns: The range of stays a histogram bin counts, e.g. "3-7d"
+ */
+const char *getStayHistogramLabel(int bin);
+
+#endif // STAY_ANALYTICS_H
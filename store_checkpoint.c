@@ -0,0 +1,581 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the snapshot and delta log files of the
+ *          patient store checkpoint.
+ */
+
+#define _GNU_SOURCE // O_CLOEXEC, MAP_POPULATE
+
+#include "store_checkpoint.h"
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "durable_file.h"
+
+// Private constants
+#define CHECKPOINT_MAGIC "HMSC"
+#define DELTA_MAGIC "HMSD"
+#define MAGIC_LENGTH 4
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_ALIGNMENT 64
+#define CHECKPOINT_TEMP_FILE "patients.snap.tmp"
+#define DELTA_TEMP_FILE "patients.delta.tmp"
+#define DELTA_DETACHED_FILE "patients.delta.next" // The log of a snapshot still being written
+#define STREAM_BUFFER_SIZE (1 << 20)
+#define FNV_OFFSET_BASIS 1469598103934665603ULL
+#define FNV_PRIME 1099511628211ULL
+
+/*
+ * Where one section lies in the snapshot.
+ */
+typedef struct
+{
+    int       id;
+    int       reserved;
+    long long offset;
+    long long length;
+} CheckpointSection;
+
+/*
+ * The snapshot header. The sizes pin the layout of the records stored
+ * as-is, so a snapshot from a different build is rejected, not misread.
+ */
+typedef struct
+{
+    char              magic[MAGIC_LENGTH];
+    int               version;
+    int               patientSize;
+    int               stateSize;
+    int               sectionCount;
+    int               reserved;
+    CheckpointState   state;
+    CheckpointSection sections[MAX_CHECKPOINT_SECTIONS];
+} CheckpointHeader;
+
+typedef struct
+{
+    char               magic[MAGIC_LENGTH];
+    int                version;
+    unsigned long long generation;
+} DeltaHeader;
+
+/*
+ * One delta log entry as stored, checksummed so a torn write is noticed.
+ */
+typedef struct
+{
+    int                type;
+    int                reserved;
+    Patient            patient;
+    FileStamp          stamp;
+    unsigned long long checksum;
+} DeltaRecord;
+
+// The snapshot new entries are logged against (0 for none) and its log
+static unsigned long long currentGeneration = 0;
+static int                deltaCount        = 0;
+static FILE              *deltaFile         = NULL;
+
+// A detached snapshot still being written (0 for none), and whether one
+// failed. filesLock keeps a discard from interleaving with it putting its
+// files in place.
+static unsigned long long detachedGeneration = 0;
+static atomic_int         detachFailed       = 0;
+static pthread_mutex_t    filesLock          = PTHREAD_MUTEX_INITIALIZER;
+
+// Function prototypes for internal helper functions
+static unsigned long long nextGeneration(void);
+static void               dropFailedDetach(void);
+static int                startDeltaLog(unsigned long long generation);
+static unsigned long long checksumRecord(const DeltaRecord *record);
+static void               closeDeltaLog(void);
+
+/*
+ * Reads a file's device, inode and size.
+ */
+int stampFile(const char fileName[], FileStamp *stamp)
+{
+    struct stat status;
+
+    if(stat(fileName, &status) != 0)
+    {
+        memset(stamp, 0, sizeof(FileStamp));
+        return CHECKPOINT_FAILURE;
+    }
+
+    stamp->device = (long long) status.st_dev;
+    stamp->inode  = (long long) status.st_ino;
+    stamp->size   = (long long) status.st_size;
+    return CHECKPOINT_SUCCESS;
+}
+
+/*
+ * Starts the detached snapshot's log in place of the current one.
+ */
+int detachCheckpoint(CheckpointState *state)
+{
+    DeltaHeader header;
+
+    dropFailedDetach();
+    state->generation = nextGeneration();
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DELTA_MAGIC, MAGIC_LENGTH);
+    header.version    = CHECKPOINT_VERSION;
+    header.generation = state->generation;
+
+    FILE *file = fopen(DELTA_DETACHED_FILE, "wb");
+    if(file == NULL || fwrite(&header, sizeof(header), 1, file) != 1 || fflush(file) != 0)
+    {
+        if(file != NULL)
+        {
+            fclose(file);
+        }
+        remove(DELTA_DETACHED_FILE);
+        discardCheckpoint();
+        return CHECKPOINT_FAILURE;
+    }
+
+    closeDeltaLog();
+    deltaFile         = file;
+    currentGeneration = state->generation;
+    deltaCount        = 0;
+
+    pthread_mutex_lock(&filesLock);
+    detachedGeneration = state->generation;
+    pthread_mutex_unlock(&filesLock);
+
+    return CHECKPOINT_SUCCESS;
+}
+
+/*
+ * Opens the temporary snapshot and reserves room for the header.
+ */
+int beginCheckpoint(CheckpointWriter *writer, const CheckpointState *state)
+{
+    CheckpointHeader placeholder;
+
+    memset(writer, 0, sizeof(CheckpointWriter));
+    writer->state            = *state;
+    writer->detached         = state->generation != 0;
+    writer->state.generation = writer->detached ? state->generation : nextGeneration();
+
+    writer->file = fopen(CHECKPOINT_TEMP_FILE, "wb");
+    if(writer->file == NULL)
+    {
+        return CHECKPOINT_FAILURE;
+    }
+    setvbuf(writer->file, NULL, _IOFBF, STREAM_BUFFER_SIZE);
+
+    memset(&placeholder, 0, sizeof(placeholder));
+    writer->failed = fwrite(&placeholder, sizeof(placeholder), 1, writer->file) != 1;
+    return CHECKPOINT_SUCCESS;
+}
+
+/*
+ * Pads the file to the next aligned offset and records where the section
+ * starts.
+ */
+FILE *beginCheckpointSection(CheckpointWriter *writer, int sectionId)
+{
+    static const char padding[CHECKPOINT_ALIGNMENT] = { 0 };
+
+    long offset = ftell(writer->file);
+    if(offset < 0 || writer->sectionCount == MAX_CHECKPOINT_SECTIONS)
+    {
+        writer->failed = 1;
+        return writer->file;
+    }
+
+    size_t gap = (CHECKPOINT_ALIGNMENT - (size_t) offset % CHECKPOINT_ALIGNMENT) % CHECKPOINT_ALIGNMENT;
+    if(fwrite(padding, 1, gap, writer->file) != gap)
+    {
+        writer->failed = 1;
+    }
+
+    writer->sectionIds[writer->sectionCount]     = sectionId;
+    writer->sectionOffsets[writer->sectionCount] = (long long) (offset + (long) gap);
+    return writer->file;
+}
+
+/*
+ * Records the section's length.
+ */
+void endCheckpointSection(CheckpointWriter *writer, int written)
+{
+    long end = ftell(writer->file);
+
+    if(!written || end < 0 || writer->sectionCount == MAX_CHECKPOINT_SECTIONS)
+    {
+        writer->failed = 1;
+        return;
+    }
+
+    writer->sectionLengths[writer->sectionCount] = (long long) end - writer->sectionOffsets[writer->sectionCount];
+    writer->sectionCount++;
+}
+
+/*
+ * Fills in the header, replaces the snapshot and resets the delta log.
+ */
+int finishCheckpoint(CheckpointWriter *writer)
+{
+    CheckpointHeader header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, CHECKPOINT_MAGIC, MAGIC_LENGTH);
+    header.version      = CHECKPOINT_VERSION;
+    header.patientSize  = (int) sizeof(Patient);
+    header.stateSize    = (int) sizeof(CheckpointState);
+    header.sectionCount = writer->sectionCount;
+    header.state        = writer->state;
+    for(int i = 0; i < writer->sectionCount; i++)
+    {
+        header.sections[i].id     = writer->sectionIds[i];
+        header.sections[i].offset = writer->sectionOffsets[i];
+        header.sections[i].length = writer->sectionLengths[i];
+    }
+
+    int written = writer->file != NULL && !writer->failed && fseek(writer->file, 0, SEEK_SET) == 0 &&
+                  fwrite(&header, sizeof(header), 1, writer->file) == 1;
+    written      = writer->file != NULL && fclose(writer->file) == 0 && written;
+    writer->file = NULL;
+
+    if(writer->detached)
+    {
+        // The snapshot goes first: with the old log it is merely out of date
+        pthread_mutex_lock(&filesLock);
+        int current = detachedGeneration == header.state.generation;
+        int placed  = written && current && replaceFile(CHECKPOINT_TEMP_FILE, CHECKPOINT_FILE) &&
+                      replaceFile(DELTA_DETACHED_FILE, CHECKPOINT_DELTA_FILE);
+        if(!placed)
+        {
+            remove(CHECKPOINT_TEMP_FILE);
+            remove(DELTA_DETACHED_FILE);
+            atomic_store(&detachFailed, current);
+        }
+        detachedGeneration = 0;
+        pthread_mutex_unlock(&filesLock);
+        return placed ? CHECKPOINT_SUCCESS : CHECKPOINT_FAILURE;
+    }
+
+    if(!written)
+    {
+        remove(CHECKPOINT_TEMP_FILE);
+        return CHECKPOINT_FAILURE;
+    }
+
+    // The old log must not outlive its snapshot, so it goes first
+    closeDeltaLog();
+    currentGeneration = 0;
+    remove(CHECKPOINT_DELTA_FILE);
+
+    if(!replaceFile(CHECKPOINT_TEMP_FILE, CHECKPOINT_FILE) || !startDeltaLog(header.state.generation))
+    {
+        return CHECKPOINT_FAILURE;
+    }
+
+    currentGeneration = header.state.generation;
+    deltaCount        = 0;
+    atomic_store(&detachFailed, 0);
+    return CHECKPOINT_SUCCESS;
+}
+
+/*
+ * Maps the snapshot and validates its header and section table.
+ */
+int mapCheckpoint(CheckpointMap *map)
+{
+    struct stat status;
+
+    memset(map, 0, sizeof(CheckpointMap));
+
+    int fd = open(CHECKPOINT_FILE, O_RDONLY | O_CLOEXEC);
+    if(fd < 0)
+    {
+        return CHECKPOINT_FAILURE;
+    }
+    if(fstat(fd, &status) != 0 || (size_t) status.st_size < sizeof(CheckpointHeader))
+    {
+        close(fd);
+        return CHECKPOINT_FAILURE;
+    }
+
+    // Populated up front: every page is read during the restore anyway
+    void *memory = mmap(NULL, (size_t) status.st_size, PROT_READ, MAP_PRIVATE | MAP_POPULATE, fd, 0);
+    close(fd);
+    if(memory == MAP_FAILED)
+    {
+        return CHECKPOINT_FAILURE;
+    }
+
+    const CheckpointHeader *header = memory;
+    int valid = memcmp(header->magic, CHECKPOINT_MAGIC, MAGIC_LENGTH) == 0 &&
+                header->version == CHECKPOINT_VERSION && header->patientSize == (int) sizeof(Patient) &&
+                header->stateSize == (int) sizeof(CheckpointState) && header->state.generation != 0 &&
+                header->sectionCount >= 0 && header->sectionCount <= MAX_CHECKPOINT_SECTIONS;
+
+    for(int i = 0; valid && i < header->sectionCount; i++)
+    {
+        const CheckpointSection *section = &header->sections[i];
+        valid = section->offset >= (long long) sizeof(CheckpointHeader) && section->length >= 0 &&
+                section->offset % CHECKPOINT_ALIGNMENT == 0 &&
+                section->offset + section->length <= (long long) status.st_size;
+    }
+
+    if(!valid)
+    {
+        munmap(memory, (size_t) status.st_size);
+        return CHECKPOINT_FAILURE;
+    }
+
+    map->memory = memory;
+    map->size   = (size_t) status.st_size;
+    map->state  = &header->state;
+    return CHECKPOINT_SUCCESS;
+}
+
+/*
+ * Looks a section up in the header.
+ */
+const void *getCheckpointSection(const CheckpointMap *map, int sectionId, size_t *length)
+{
+    const CheckpointHeader *header = map->memory;
+
+    for(int i = 0; i < header->sectionCount; i++)
+    {
+        if(header->sections[i].id == sectionId)
+        {
+            *length = (size_t) header->sections[i].length;
+            return (const unsigned char *) map->memory + header->sections[i].offset;
+        }
+    }
+
+    *length = 0;
+    return NULL;
+}
+
+/*
+ * Unmaps a snapshot.
+ */
+void unmapCheckpoint(CheckpointMap *map)
+{
+    if(map->memory != NULL)
+    {
+        munmap(map->memory, map->size);
+    }
+    memset(map, 0, sizeof(CheckpointMap));
+}
+
+/*
+ * Replays the log, cutting off a torn tail so later appends follow the
+ * last whole entry.
+ */
+int scanCheckpointDelta(unsigned long long generation,
+                        CheckpointDeltaVisitor visitor,
+                        void *context,
+                        int *count)
+{
+    DeltaHeader     header;
+    DeltaRecord     record;
+    CheckpointDelta delta;
+
+    *count = 0;
+    closeDeltaLog();
+    currentGeneration = 0;
+
+    FILE *file = fopen(CHECKPOINT_DELTA_FILE, "rb");
+    if(file == NULL)
+    {
+        return CHECKPOINT_FAILURE;
+    }
+    setvbuf(file, NULL, _IOFBF, STREAM_BUFFER_SIZE);
+
+    if(fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, DELTA_MAGIC, MAGIC_LENGTH) != 0 ||
+       header.version != CHECKPOINT_VERSION || header.generation != generation)
+    {
+        fclose(file);
+        return CHECKPOINT_FAILURE;
+    }
+
+    long long goodLength = (long long) sizeof(header);
+    while(fread(&record, sizeof(record), 1, file) == 1)
+    {
+        if(record.checksum != checksumRecord(&record) || record.type < DELTA_ADMIT || record.type > DELTA_FILE_STAMP)
+        {
+            break;
+        }
+
+        delta.type    = record.type;
+        delta.patient = record.patient;
+        delta.stamp   = record.stamp;
+        if(!visitor(&delta, context))
+        {
+            fclose(file);
+            return CHECKPOINT_FAILURE;
+        }
+
+        goodLength += (long long) sizeof(record);
+        (*count)++;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long length = ftell(file);
+    fclose(file);
+
+    if(length > goodLength && truncate(CHECKPOINT_DELTA_FILE, (off_t) goodLength) != 0)
+    {
+        return CHECKPOINT_FAILURE;
+    }
+
+    currentGeneration = generation;
+    deltaCount        = *count;
+    return CHECKPOINT_SUCCESS;
+}
+
+/*
+ * Appends and flushes one entry, opening the log on first use.
+ */
+int appendCheckpointDelta(const CheckpointDelta *delta, int sync)
+{
+    DeltaRecord record;
+
+    dropFailedDetach();
+    if(currentGeneration == 0)
+    {
+        return 0;
+    }
+
+    if(deltaFile == NULL)
+    {
+        deltaFile = fopen(CHECKPOINT_DELTA_FILE, "ab");
+    }
+
+    memset(&record, 0, sizeof(record));
+    record.type     = delta->type;
+    record.patient  = delta->patient;
+    record.stamp    = delta->stamp;
+    record.checksum = checksumRecord(&record);
+
+    if(deltaFile == NULL || fwrite(&record, sizeof(record), 1, deltaFile) != 1 || fflush(deltaFile) != 0 ||
+       (sync && !syncFile(fileno(deltaFile), CHECKPOINT_DELTA_FILE)))
+    {
+        puts("Error: Unable to write the checkpoint delta log. Discarding the checkpoint.");
+        discardCheckpoint();
+        return 0;
+    }
+
+    return ++deltaCount;
+}
+
+/*
+ * Checks for a snapshot with an empty delta log.
+ */
+int isCheckpointCurrent(void)
+{
+    dropFailedDetach();
+    return currentGeneration != 0 && deltaCount == 0;
+}
+
+/*
+ * Forgets the current snapshot and removes it.
+ */
+void discardCheckpoint(void)
+{
+    pthread_mutex_lock(&filesLock);
+    closeDeltaLog();
+    currentGeneration  = 0;
+    deltaCount         = 0;
+    detachedGeneration = 0;
+    remove(CHECKPOINT_FILE);
+    pthread_mutex_unlock(&filesLock);
+}
+
+/*
+ * Returns a generation number unlikely to repeat, never 0.
+ */
+static unsigned long long nextGeneration(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    unsigned long long generation = (unsigned long long) now.tv_sec * 1000000000ULL + (unsigned long long) now.tv_nsec;
+    generation ^= (unsigned long long) getpid() << 48;
+    return generation != 0 ? generation : 1;
+}
+
+/*
+ * Discards the checkpoint if a detached snapshot failed, since nothing on
+ * disk matches the log being written.
+ */
+static void dropFailedDetach(void)
+{
+    if(atomic_exchange(&detachFailed, 0))
+    {
+        puts("Error: The patient checkpoint could not be written. Discarding it.");
+        discardCheckpoint();
+    }
+}
+
+/*
+ * Durably replaces the delta log with an empty one for a generation.
+ * Returns 1 on success, 0 otherwise.
+ */
+static int startDeltaLog(unsigned long long generation)
+{
+    DeltaHeader header;
+
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DELTA_MAGIC, MAGIC_LENGTH);
+    header.version    = CHECKPOINT_VERSION;
+    header.generation = generation;
+
+    FILE *file = fopen(DELTA_TEMP_FILE, "wb");
+    if(file == NULL)
+    {
+        return 0;
+    }
+
+    int written = fwrite(&header, sizeof(header), 1, file) == 1;
+    written     = fclose(file) == 0 && written;
+    if(!written)
+    {
+        remove(DELTA_TEMP_FILE);
+        return 0;
+    }
+    return replaceFile(DELTA_TEMP_FILE, CHECKPOINT_DELTA_FILE);
+}
+
+/*
+ * FNV-1a over a record, up to its checksum.
+ */
+static unsigned long long checksumRecord(const DeltaRecord *record)
+{
+    const unsigned char *bytes    = (const unsigned char *) record;
+    unsigned long long   checksum = FNV_OFFSET_BASIS;
+
+    for(size_t i = 0; i < offsetof(DeltaRecord, checksum); i++)
+    {
+        checksum = (checksum ^ bytes[i]) * FNV_PRIME;
+    }
+    return checksum;
+}
+
+/*
+ * Closes the delta log if it is open.
+ */
+static void closeDeltaLog(void)
+{
+    if(deltaFile != NULL)
+    {
+        fclose(deltaFile);
+        deltaFile = NULL;
+    }
+}
@@ -0,0 +1,274 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the patient store checkpoint: a binary
+ *          snapshot of the active patients and their indexes in
+ *          patients.snap, plus a delta log in patients.delta of every
+ *          change made since.
+ *
+ *          The snapshot is a fixed header followed by sections, each a flat
+ *          block at an aligned offset that its owner can use straight from
+ *          the mapped file: the patients as an array, and the name and
+ *          diagnosis indexes in their in-memory layouts with pointers turned
+ *          into offsets. Restoring maps the file and copies each section out
+ *          in bulk, then replays the delta log, so no index is rebuilt
+ *          patient by patient.
+ *
+ *          The delta log holds fixed-size, checksummed entries for
+ *          admissions and discharges. Transfers are already kept in the
+ *          transfer log, so a restore replays those made since the snapshot
+ *          was taken, as a full load does for patients.dat. A snapshot and
+ *          its delta log share a generation number, so a log is never
+ *          replayed onto the wrong snapshot. Both also track patients.dat by
+ *          its device, inode and size (a file stamp): the snapshot records
+ *          the stamp it was taken against, a stamp entry follows every
+ *          rewrite, and admissions grow the size by their encoded records. A
+ *          checkpoint whose stamp no longer matches patients.dat is out of
+ *          date and the store falls back to reading patients.dat.
+ *
+ *          Calls are serialized by the caller; the patient store makes them
+ *          under its exclusive lock. The one exception is a detached
+ *          snapshot: once detachCheckpoint has switched new entries to a log
+ *          of their own, the snapshot is written and finished on another
+ *          thread while the caller goes on logging.
+ */
+
+#ifndef STORE_CHECKPOINT_H
+#define STORE_CHECKPOINT_H
+
+#include <stdio.h>
+#include <time.h>
+#include "patient_data.h"
+
+#define CHECKPOINT_FILE "patients.snap"
+#define CHECKPOINT_DELTA_FILE "patients.delta"
+#define CHECKPOINT_DELTA_LIMIT 65536 // Delta entries before a new snapshot is taken
+#define MAX_CHECKPOINT_SECTIONS 8
+
+// Snapshot sections
+#define CHECKPOINT_SECTION_PATIENTS 1
+#define CHECKPOINT_SECTION_NAME_INDEX 2
+#define CHECKPOINT_SECTION_DIAGNOSIS_INDEX 3
+
+// Delta entry types
+#define DELTA_ADMIT 1
+#define DELTA_DISCHARGE 2
+#define DELTA_FILE_STAMP 3
+
+#define CHECKPOINT_SUCCESS 1
+#define CHECKPOINT_FAILURE 0
+
+/*
+ * Identifies one version of a file.
+ */
+typedef struct
+{
+    long long device;
+    long long inode;
+    long long size;
+} FileStamp;
+
+/*
+ * The patient store's own state, kept in the snapshot header.
+ */
+typedef struct
+{
+    unsigned long long generation; // Set by beginCheckpoint
+    time_t             takenAt;
+    FileStamp          patientsFile;
+    int                patientCount;
+    int                nextPatientId;
+} CheckpointState;
+
+/*
+ * A change to the store. Admissions and discharges use patient, file
+ * stamps only use stamp.
+ */
+typedef struct
+{
+    int       type;
+    Patient   patient;
+    FileStamp stamp;
+} CheckpointDelta;
+
+/*
+ * Callback invoked for each entry visited by scanCheckpointDelta.
+ * Returning 0 stops the scan early.
+ */
+typedef int (*CheckpointDeltaVisitor)(const CheckpointDelta *delta, void *context);
+
+/*
+ * A snapshot being written.
+ */
+typedef struct
+{
+    FILE           *file;
+    CheckpointState state;
+    int             sectionCount;
+    int             sectionIds[MAX_CHECKPOINT_SECTIONS];
+    long long       sectionOffsets[MAX_CHECKPOINT_SECTIONS];
+    long long       sectionLengths[MAX_CHECKPOINT_SECTIONS];
+    int             failed;
+    int             detached; // Finished without the caller's lock
+} CheckpointWriter;
+
+/*
+ * A snapshot mapped for restoring.
+ */
+typedef struct
+{
+    void                  *memory;
+    size_t                 size;
+    const CheckpointState *state;
+} CheckpointMap;
+
+/*
+ * Function: stampFile
+ * -------------------
+ * Reads a file's stamp.
+ *
+ * Returns: CHECKPOINT_SUCCESS, or CHECKPOINT_FAILURE if the file is missing
+ */
+int stampFile(const char fileName[], FileStamp *stamp);
+
+/*
+ * Function: detachCheckpoint
+ * --------------------------
+ * Gives a snapshot that is about to be written a new generation and logs
+ * every later change against it, in a log of its own, so it can be written
+ * and finished on another thread. The current snapshot and its log stay in
+ * place until then. If the snapshot is never finished, the next entry
+ * logged discards the checkpoint. Writes but does not sync.
+ *
+ * state: Receives the generation; pass it to beginCheckpoint
+ *
+ * Returns: CHECKPOINT_SUCCESS, or CHECKPOINT_FAILURE with the checkpoint
+ *          discarded if the log could not be created
+ */
+int detachCheckpoint(CheckpointState *state);
+
+/*
+ * Function: beginCheckpoint
+ * -------------------------
+ * Starts writing a new snapshot to a temporary file, giving it a new
+ * generation unless detachCheckpoint already has. May be called without
+ * the caller's lock for a detached snapshot; on failure that snapshot
+ * must still be passed to finishCheckpoint.
+ *
+ * Returns: CHECKPOINT_SUCCESS, or CHECKPOINT_FAILURE if the file could not
+ *          be created
+ */
+int beginCheckpoint(CheckpointWriter *writer, const CheckpointState *state);
+
+/*
+ * Function: beginCheckpointSection
+ * --------------------------------
+ * Starts a section at the next aligned offset.
+ *
+ * Returns: The stream to write the section to
+ */
+FILE *beginCheckpointSection(CheckpointWriter *writer, int sectionId);
+
+/*
+ * Function: endCheckpointSection
+ * ------------------------------
+ * Ends the current section.
+ *
+ * written: 0 if the section's owner failed to write it, which fails the
+ *          whole snapshot
+ */
+void endCheckpointSection(CheckpointWriter *writer, int written);
+
+/*
+ * Function: finishCheckpoint
+ * --------------------------
+ * Writes the header, durably replaces CHECKPOINT_FILE with the new
+ * snapshot and starts an empty delta log for it, or for a detached
+ * snapshot puts the log started by detachCheckpoint in place. On failure
+ * the previous checkpoint stays in place, though after a detached snapshot
+ * its log no longer continues it and it is discarded as detachCheckpoint
+ * describes.
+ *
+ * Returns: CHECKPOINT_SUCCESS, or CHECKPOINT_FAILURE on error
+ */
+int finishCheckpoint(CheckpointWriter *writer);
+
+/*
+ * Function: mapCheckpoint
+ * -----------------------
+ * Maps CHECKPOINT_FILE read-only and checks that it was written by this
+ * build for the same record layout.
+ *
+ * Returns: CHECKPOINT_SUCCESS, or CHECKPOINT_FAILURE if there is no usable
+ *          snapshot
+ */
+int mapCheckpoint(CheckpointMap *map);
+
+/*
+ * Function: getCheckpointSection
+ * ------------------------------
+ * Finds a section of a mapped snapshot.
+ *
+ * length: Receives the section's length in bytes
+ *
+ * Returns: The section's first byte, or NULL if the snapshot lacks it
+ */
+const void *getCheckpointSection(const CheckpointMap *map, int sectionId, size_t *length);
+
+/*
+ * Function: unmapCheckpoint
+ * -------------------------
+ * Releases a mapped snapshot.
+ */
+void unmapCheckpoint(CheckpointMap *map);
+
+/*
+ * Function: scanCheckpointDelta
+ * -----------------------------
+ * Visits every entry in the delta log of a snapshot, oldest first, and
+ * makes that snapshot the one new entries are logged against. A torn
+ * entry at the end, left by a crash, ends the log and is cut off. A caller
+ * that finds the result out of date discards the checkpoint.
+ *
+ * generation: The mapped snapshot's generation
+ * count: Receives the number of entries visited
+ *
+ * Returns: CHECKPOINT_SUCCESS, or CHECKPOINT_FAILURE if the log is missing,
+ *          belongs to another snapshot or the visitor stopped the scan
+ */
+int scanCheckpointDelta(unsigned long long generation,
+                        CheckpointDeltaVisitor visitor,
+                        void *context,
+                        int *count);
+
+/*
+ * Function: appendCheckpointDelta
+ * -------------------------------
+ * Logs a change against the current snapshot, if there is one. The entry
+ * is flushed to the operating system, and also synced when sync is
+ * non-zero and the delta log's durability level asks for it. If the entry
+ * cannot be written, the checkpoint is discarded.
+ *
+ * Returns: The number of entries logged since the snapshot, or 0 if there
+ *          is no snapshot to log against
+ */
+int appendCheckpointDelta(const CheckpointDelta *delta, int sync);
+
+/*
+ * Function: isCheckpointCurrent
+ * -----------------------------
+ * Returns: 1 if there is a snapshot and nothing has been logged since it
+ *          was taken, 0 otherwise
+ */
+int isCheckpointCurrent(void);
+
+/*
+ * Function: discardCheckpoint
+ * ---------------------------
+ * Removes the checkpoint and stops logging, for when the store changed in
+ * a way the delta log cannot describe. Nothing is logged again until the
+ * next snapshot.
+ */
+void discardCheckpoint(void);
+
+#endif // STORE_CHECKPOINT_H
@@ -0,0 +1,179 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file implements the room transfer history.
+ *
+ *          File layout (little-endian):
+ *            header:  magic[4], version[1], reserved[3]
+ *            records: { patientId[4], fromRoom[4], toRoom[4], reserved[4],
+ *                     transferDate[8] }, in the order they were made
+ */
+
+#include "transfer_log.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include "durable_file.h"
+#include "patient_storage.h"
+
+// Private constants
+#define TRANSFER_LOG_VERSION 1
+#define MAGIC_LENGTH 4
+#define LOG_HEADER_SIZE 8
+#define TRANSFER_RECORD_SIZE 24
+
+// Function prototypes for internal helper functions
+static int  readTransferAt(FILE *file, long recordIndex, TransferRecord *transfer);
+static void encodeTransfer(const TransferRecord *transfer, unsigned char bytes[]);
+static void decodeTransfer(const unsigned char bytes[], TransferRecord *transfer);
+
+/*
+ * Appends a record after the last whole record, dropping any partial
+ * record left by an interrupted write.
+ */
+int appendTransferRecord(const TransferRecord *transfer)
+{
+    unsigned char bytes[TRANSFER_RECORD_SIZE];
+
+    FILE *file = fopen(TRANSFER_LOG_FILE, "r+b");
+    if(file == NULL)
+    {
+        file = fopen(TRANSFER_LOG_FILE, "w+b");
+    }
+    if(file == NULL)
+    {
+        perror("Error opening " TRANSFER_LOG_FILE);
+        return TRANSFER_FAILURE;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long fileEnd = ftell(file);
+    int  ok      = 1;
+
+    if(fileEnd < LOG_HEADER_SIZE)
+    {
+        unsigned char header[LOG_HEADER_SIZE] = { 0 };
+
+        memcpy(header, TRANSFER_LOG_MAGIC, MAGIC_LENGTH);
+        header[MAGIC_LENGTH] = TRANSFER_LOG_VERSION;
+        ok                   = fseek(file, 0, SEEK_SET) == 0 &&
+                               fwrite(header, 1, LOG_HEADER_SIZE, file) == LOG_HEADER_SIZE;
+        fileEnd              = LOG_HEADER_SIZE;
+    }
+    else if((fileEnd - LOG_HEADER_SIZE) % TRANSFER_RECORD_SIZE != 0)
+    {
+        fileEnd -= (fileEnd - LOG_HEADER_SIZE) % TRANSFER_RECORD_SIZE;
+        ok       = fflush(file) == 0 && ftruncate(fileno(file), fileEnd) == 0;
+    }
+
+    encodeTransfer(transfer, bytes);
+    ok = ok && fseek(file, fileEnd, SEEK_SET) == 0 &&
+         fwrite(bytes, 1, TRANSFER_RECORD_SIZE, file) == TRANSFER_RECORD_SIZE &&
+         fflush(file) == 0 && syncFile(fileno(file), TRANSFER_LOG_FILE);
+
+    if(fclose(file) != 0 || !ok)
+    {
+        perror("Error writing to " TRANSFER_LOG_FILE);
+        return TRANSFER_FAILURE;
+    }
+
+    return TRANSFER_SUCCESS;
+}
+
+/*
+ * Binary searches for the first record at or after fromTime, then reads
+ * forward from there.
+ */
+int scanTransfersSince(time_t fromTime, TransferVisitor visitor, void *context)
+{
+    unsigned char  header[LOG_HEADER_SIZE];
+    TransferRecord transfer;
+
+    FILE *file = fopen(TRANSFER_LOG_FILE, "rb");
+    if(file == NULL)
+    {
+        return TRANSFER_FAILURE;
+    }
+
+    if(fread(header, 1, LOG_HEADER_SIZE, file) != LOG_HEADER_SIZE ||
+       memcmp(header, TRANSFER_LOG_MAGIC, MAGIC_LENGTH) != 0 ||
+       header[MAGIC_LENGTH] != TRANSFER_LOG_VERSION)
+    {
+        fclose(file);
+        return TRANSFER_FAILURE;
+    }
+
+    fseek(file, 0, SEEK_END);
+    long recordCount = (ftell(file) - LOG_HEADER_SIZE) / TRANSFER_RECORD_SIZE;
+    long low         = 0;
+    long high        = recordCount;
+
+    while(low < high)
+    {
+        long middle = low + (high - low) / 2;
+        if(readTransferAt(file, middle, &transfer) && transfer.transferDate < fromTime)
+        {
+            low = middle + 1;
+        }
+        else
+        {
+            high = middle;
+        }
+    }
+
+    int keepScanning = readTransferAt(file, low, &transfer);
+    for(long i = low; i < recordCount && keepScanning; i++)
+    {
+        unsigned char bytes[TRANSFER_RECORD_SIZE];
+
+        if(i > low)
+        {
+            keepScanning = fread(bytes, 1, TRANSFER_RECORD_SIZE, file) == TRANSFER_RECORD_SIZE;
+            decodeTransfer(bytes, &transfer);
+        }
+        keepScanning = keepScanning && visitor(&transfer, context);
+    }
+
+    fclose(file);
+    return TRANSFER_SUCCESS;
+}
+
+/*
+ * Reads the record at an index, leaving the file positioned after it.
+ */
+static int readTransferAt(FILE *file, long recordIndex, TransferRecord *transfer)
+{
+    unsigned char bytes[TRANSFER_RECORD_SIZE];
+
+    if(fseek(file, LOG_HEADER_SIZE + recordIndex * TRANSFER_RECORD_SIZE, SEEK_SET) != 0 ||
+       fread(bytes, 1, TRANSFER_RECORD_SIZE, file) != TRANSFER_RECORD_SIZE)
+    {
+        return 0;
+    }
+
+    decodeTransfer(bytes, transfer);
+    return 1;
+}
+
+/*
+ * Converts a record to its on-disk bytes.
+ */
+static void encodeTransfer(const TransferRecord *transfer, unsigned char bytes[])
+{
+    storeLittleEndian(bytes, (unsigned int) transfer->patientId, 4);
+    storeLittleEndian(bytes + 4, (unsigned int) transfer->fromRoom, 4);
+    storeLittleEndian(bytes + 8, (unsigned int) transfer->toRoom, 4);
+    storeLittleEndian(bytes + 12, 0, 4);
+    storeLittleEndian(bytes + 16, (unsigned long long) (long long) transfer->transferDate, 8);
+}
+
+/*
+ * Converts on-disk bytes to a record.
+ */
+static void decodeTransfer(const unsigned char bytes[], TransferRecord *transfer)
+{
+    transfer->patientId    = (int) loadLittleEndian(bytes, 4);
+    transfer->fromRoom     = (int) loadLittleEndian(bytes + 4, 4);
+    transfer->toRoom       = (int) loadLittleEndian(bytes + 8, 4);
+    transfer->transferDate = (time_t) (long long) loadLittleEndian(bytes + 16, 8);
+}
@@ -0,0 +1,58 @@
+/*
+ * Author: Arsh M, Nathan O
+ * Date: Oct 16, 2026
+ * Purpose: This file defines the room transfer history stored in
+ *          transfers.dat.
+ *
+ *          Each transfer is one fixed-size record appended in time order,
+ *          so a transfer costs a single small write and the records after a
+ *          given time are found with a binary search. patients.dat is only
+ *          rewritten on discharge, so transfers logged since it was last
+ *          written are replayed onto the loaded patients.
+ */
+
+#ifndef TRANSFER_LOG_H
+#define TRANSFER_LOG_H
+
+#include <time.h>
+
+#define TRANSFER_LOG_FILE "transfers.dat"
+#define TRANSFER_LOG_MAGIC "HMST"
+
+#define TRANSFER_SUCCESS 1
+#define TRANSFER_FAILURE 0
+
+typedef struct
+{
+    int    patientId;
+    int    fromRoom;
+    int    toRoom;
+    time_t transferDate;
+} TransferRecord;
+
+/*
+ * Callback invoked for each record visited by scanTransfersSince.
+ * Returning 0 stops the scan early.
+ */
+typedef int (*TransferVisitor)(const TransferRecord *transfer, void *context);
+
+/*
+ * Function: appendTransferRecord
+ * ------------------------------
+ * Appends one transfer to TRANSFER_LOG_FILE, creating it if needed.
+ *
+ * Returns: TRANSFER_SUCCESS, or TRANSFER_FAILURE on error
+ */
+int appendTransferRecord(const TransferRecord *transfer);
+
+/*
+ * Function: scanTransfersSince
+ * ----------------------------
+ * Visits every transfer made at or after fromTime, oldest first.
+ *
+ * Returns: TRANSFER_SUCCESS, or TRANSFER_FAILURE if the log is missing
+ *          or unreadable
+ */
+int scanTransfersSince(time_t fromTime, TransferVisitor visitor, void *context);
+
+#endif // TRANSFER_LOG_H